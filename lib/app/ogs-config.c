@@ -266,6 +266,10 @@ int ogs_app_parse_global_conf(ogs_yaml_iter_t *parent)
                             "no_time_zone_information")) {
                     global_conf.parameter.no_time_zone_information =
                         ogs_yaml_iter_bool(&parameter_iter);
+                } else if (!strcmp(parameter_key, "timer_wheel")) {
+                    ogs_core()->timer.backend =
+                        ogs_yaml_iter_bool(&parameter_iter) ?
+                            OGS_TIMER_BACKEND_WHEEL : OGS_TIMER_BACKEND_RBTREE;
                 } else
                     ogs_warn("unknown key `%s`", parameter_key);
             }
@@ -36,6 +36,11 @@ typedef struct ogs_app_context_s {
 
     const char *db_uri;
 
+    struct {
+        int size;               /* 0 : disabled */
+        ogs_time_t ttl;         /* 0 : no expiry */
+    } db_cache;
+
     struct {
         ogs_log_ts_e timestamp;
     } logger_default;
@@ -45,6 +50,11 @@ typedef struct ogs_app_context_s {
         const char *level;
         const char *domain;
         ogs_log_ts_e timestamp;
+
+        struct {
+            size_t size;        /* 0 : disabled */
+            ogs_log_overflow_e overflow;
+        } async;
     } logger;
 
     ogs_queue_t *queue;
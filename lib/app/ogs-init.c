@@ -121,6 +121,12 @@ int ogs_app_initialize(
     ogs_log_set_timestamp(ogs_app()->logger_default.timestamp,
                           ogs_app()->logger.timestamp);
 
+    if (ogs_app()->logger.async.size) {
+        rv = ogs_log_async_start(ogs_app()->logger.async.size,
+                ogs_app()->logger.async.overflow);
+        if (rv != OGS_OK) return rv;
+    }
+
     /**************************************************************************
      * Stage 5 : Setup Database Module
      */
@@ -262,6 +268,9 @@ static int context_prepare(void)
 #define USRSCTP_LOCAL_UDP_PORT      9899
     ogs_app()->usrsctp.udp_port = USRSCTP_LOCAL_UDP_PORT;
 
+#define DB_CACHE_DEFAULT_TTL        60  /* 60 seconds */
+    ogs_app()->db_cache.ttl = ogs_time_from_sec(DB_CACHE_DEFAULT_TTL);
+
     rv = ogs_app_global_conf_prepare();
     if (rv != OGS_OK) return rv;
 
@@ -342,6 +351,22 @@ static int parse_config(void)
         ogs_assert(root_key);
         if (!strcmp(root_key, "db_uri")) {
             ogs_app()->db_uri = ogs_yaml_iter_value(&root_iter);
+        } else if (!strcmp(root_key, "db_cache")) {
+            ogs_yaml_iter_t db_cache_iter;
+            ogs_yaml_iter_recurse(&root_iter, &db_cache_iter);
+            while (ogs_yaml_iter_next(&db_cache_iter)) {
+                const char *db_cache_key = ogs_yaml_iter_key(&db_cache_iter);
+                ogs_assert(db_cache_key);
+                if (!strcmp(db_cache_key, "size")) {
+                    const char *v = ogs_yaml_iter_value(&db_cache_iter);
+                    if (v) ogs_app()->db_cache.size = atoi(v);
+                } else if (!strcmp(db_cache_key, "ttl")) {
+                    const char *v = ogs_yaml_iter_value(&db_cache_iter);
+                    if (v) ogs_app()->db_cache.ttl =
+                        ogs_time_from_sec(atoi(v));
+                } else
+                    ogs_warn("unknown key `%s`", db_cache_key);
+            }
         } else if (!strcmp(root_key, "logger")) {
             ogs_yaml_iter_t logger_iter;
             ogs_yaml_iter_recurse(&root_iter, &logger_iter);
@@ -355,6 +380,39 @@ static int parse_config(void)
                 } else if (!strcmp(logger_key, "domain")) {
                     ogs_app()->logger.domain =
                         ogs_yaml_iter_value(&logger_iter);
+                } else if (!strcmp(logger_key, "async")) {
+                    ogs_yaml_iter_t async_iter;
+                    ogs_yaml_iter_recurse(&logger_iter, &async_iter);
+                    while (ogs_yaml_iter_next(&async_iter)) {
+                        const char *async_key =
+                            ogs_yaml_iter_key(&async_iter);
+                        ogs_assert(async_key);
+                        if (!strcmp(async_key, "size")) {
+                            const char *v = ogs_yaml_iter_value(&async_iter);
+                            if (v && atoi(v) > 0)
+                                ogs_app()->logger.async.size =
+                                    (size_t)atoi(v) * 1024;
+                            else
+                                ogs_warn("invalid async size `%s`",
+                                        v ? v : "");
+                        } else if (!strcmp(async_key, "overflow")) {
+                            const char *v = ogs_yaml_iter_value(&async_iter);
+                            if (v && !strcmp(v, "block"))
+                                ogs_app()->logger.async.overflow =
+                                    OGS_LOG_OVERFLOW_BLOCK;
+                            else if (v && !strcmp(v, "drop"))
+                                ogs_app()->logger.async.overflow =
+                                    OGS_LOG_OVERFLOW_DROP;
+                            else
+                                ogs_warn("unknown overflow `%s`",
+                                        v ? v : "");
+                        } else
+                            ogs_warn("unknown key `%s`", async_key);
+                    }
+
+                    if (!ogs_app()->logger.async.size)
+                        ogs_warn("logger.async has no size, "
+                                "asynchronous logging is disabled");
                 }
             }
         } else if (!strcmp(root_key, "global")) {
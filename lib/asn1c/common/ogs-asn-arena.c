@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-asn-arena.h"
+
+#define ARENA_ALIGN 8
+#define ARENA_ALIGN_UP(__x) \
+    (((__x) + (ARENA_ALIGN - 1)) & ~((uintptr_t)ARENA_ALIGN - 1))
+
+/* Every allocation is preceded by its size, for REALLOC */
+#define ARENA_HEADER_SIZE ARENA_ALIGN_UP(sizeof(size_t))
+#define ARENA_SIZE(__ptr) (((size_t *)(__ptr))[-1])
+
+typedef struct ogs_asn_arena_s {
+    ogs_lnode_t lnode;
+
+    void *owner;
+    size_t owner_size;
+
+    ogs_list_t chunk_list;
+    ogs_pkbuf_t *chunk;         /* Chunk being filled */
+} ogs_asn_arena_t;
+
+static OGS_THREAD_LOCAL ogs_list_t arena_list;
+static OGS_THREAD_LOCAL ogs_asn_arena_t *current;
+static OGS_THREAD_LOCAL uint64_t alloc_count;
+
+/*
+ * Arena entered but not allocated from yet.
+ * Its first chunk is only taken on the first allocation,
+ * so an encode that needs no scratch memory costs nothing.
+ */
+static OGS_THREAD_LOCAL ogs_asn_arena_t pending;
+
+static ogs_pkbuf_t *chunk_alloc(size_t size)
+{
+    ogs_pkbuf_t *chunk = NULL;
+
+    if (size < OGS_ASN_ARENA_CHUNK_SIZE)
+        size = OGS_ASN_ARENA_CHUNK_SIZE;
+
+    chunk = ogs_pkbuf_alloc(NULL, size);
+    if (!chunk) {
+        ogs_fatal("ogs_pkbuf_alloc() failed [size=%d]", (int)size);
+        ogs_assert_if_reached();
+    }
+    alloc_count++;
+
+    return chunk;
+}
+
+static uint8_t *chunk_reserve(ogs_pkbuf_t *chunk, size_t size)
+{
+    uint8_t *ptr = (uint8_t *)ARENA_ALIGN_UP(
+            (uintptr_t)chunk->tail + ARENA_HEADER_SIZE);
+
+    if (ptr + size > chunk->end)
+        return NULL;
+
+    chunk->tail = ptr + size;
+    return ptr;
+}
+
+static ogs_asn_arena_t *arena_create(void *owner, size_t owner_size)
+{
+    ogs_asn_arena_t *arena = NULL;
+    ogs_pkbuf_t *chunk = NULL;
+
+    chunk = chunk_alloc(OGS_ASN_ARENA_CHUNK_SIZE);
+    arena = (ogs_asn_arena_t *)ARENA_ALIGN_UP((uintptr_t)chunk->tail);
+    chunk->tail = (uint8_t *)arena + sizeof(*arena);
+
+    memset(arena, 0, sizeof(*arena));
+    arena->owner = owner;
+    arena->owner_size = owner_size;
+
+    ogs_list_add(&arena->chunk_list, chunk);
+    arena->chunk = chunk;
+
+    ogs_list_add(&arena_list, arena);
+
+    return arena;
+}
+
+static void *arena_alloc(ogs_asn_arena_t *arena, size_t size)
+{
+    ogs_pkbuf_t *chunk = NULL;
+    uint8_t *ptr = NULL;
+
+    if (arena == &pending) {
+        arena = arena_create(pending.owner, pending.owner_size);
+        memset(&pending, 0, sizeof(pending));
+        current = arena;
+    }
+
+    ptr = chunk_reserve(arena->chunk, size);
+    if (!ptr) {
+        chunk = chunk_alloc(size + ARENA_HEADER_SIZE + ARENA_ALIGN);
+        ogs_list_add(&arena->chunk_list, chunk);
+
+        ptr = chunk_reserve(chunk, size);
+        ogs_assert(ptr);
+
+        /* Keep filling the chunk with the most room left */
+        if (chunk->end - chunk->tail >= arena->chunk->end - arena->chunk->tail)
+            arena->chunk = chunk;
+    }
+
+    ARENA_SIZE(ptr) = size;
+
+    return ptr;
+}
+
+static ogs_asn_arena_t *arena_find(const void *ptr)
+{
+    ogs_asn_arena_t *arena = NULL;
+    ogs_pkbuf_t *chunk = NULL;
+
+    ogs_list_for_each(&arena_list, arena) {
+        ogs_list_for_each(&arena->chunk_list, chunk) {
+            if ((const uint8_t *)ptr >= chunk->head &&
+                (const uint8_t *)ptr < chunk->end)
+                return arena;
+        }
+    }
+
+    return NULL;
+}
+
+void ogs_asn_arena_enter(void *owner, size_t owner_size)
+{
+    ogs_assert(owner);
+    ogs_assert(current == NULL);
+
+    /* The owner is being decoded again without being freed */
+    ogs_asn_arena_release(owner);
+
+    memset(&pending, 0, sizeof(pending));
+    pending.owner = owner;
+    pending.owner_size = owner_size;
+
+    current = &pending;
+}
+
+void ogs_asn_arena_leave(void)
+{
+    current = NULL;
+}
+
+bool ogs_asn_arena_release(void *owner)
+{
+    ogs_asn_arena_t *arena = NULL;
+    ogs_pkbuf_t *chunk = NULL, *next_chunk = NULL;
+    ogs_list_t chunk_list;
+
+    ogs_assert(owner);
+
+    /* Nothing was allocated, so there is no tree to walk either */
+    if (pending.owner == owner) {
+        if (current == &pending)
+            current = NULL;
+        if (pending.owner_size)
+            memset(owner, 0, pending.owner_size);
+        memset(&pending, 0, sizeof(pending));
+        return true;
+    }
+
+    ogs_list_for_each(&arena_list, arena) {
+        if (arena->owner == owner)
+            break;
+    }
+    if (!arena)
+        return false;
+
+    ogs_list_remove(&arena_list, arena);
+    if (current == arena)
+        current = NULL;
+
+    /* The tree is gone, so nothing must be left pointing into it */
+    if (arena->owner_size)
+        memset(owner, 0, arena->owner_size);
+
+    /* The arena itself lives in the first chunk */
+    chunk_list = arena->chunk_list;
+    ogs_list_for_each_safe(&chunk_list, next_chunk, chunk)
+        ogs_pkbuf_free(chunk);
+
+    return true;
+}
+
+uint64_t ogs_asn_alloc_count(void)
+{
+    return alloc_count;
+}
+
+void *ogs_asn_malloc(size_t size, const char *file_line)
+{
+    void *ptr = NULL;
+
+    if (current)
+        return arena_alloc(current, size);
+
+    ptr = ogs_malloc(size);
+    if (!ptr) {
+        ogs_fatal("asn_malloc() failed in `%s`", file_line);
+        ogs_assert_if_reached();
+    }
+    alloc_count++;
+
+    return ptr;
+}
+
+void *ogs_asn_calloc(size_t nmemb, size_t size, const char *file_line)
+{
+    void *ptr = NULL;
+
+    if (current) {
+        ptr = arena_alloc(current, nmemb * size);
+        memset(ptr, 0, nmemb * size);
+        return ptr;
+    }
+
+    ptr = ogs_calloc(nmemb, size);
+    if (!ptr) {
+        ogs_fatal("asn_calloc() failed in `%s`", file_line);
+        ogs_assert_if_reached();
+    }
+    alloc_count++;
+
+    return ptr;
+}
+
+void *ogs_asn_realloc(void *oldptr, size_t size, const char *file_line)
+{
+    ogs_asn_arena_t *arena = NULL;
+    void *ptr = NULL;
+    size_t oldsize;
+
+    if (!oldptr)
+        return ogs_asn_malloc(size, file_line);
+
+    arena = ogs_list_first(&arena_list) ? arena_find(oldptr) : NULL;
+    if (arena) {
+        oldsize = ARENA_SIZE(oldptr);
+        if (size <= oldsize)
+            return oldptr;
+
+        /* The last allocation in the chunk grows in place */
+        if ((uint8_t *)oldptr + oldsize == arena->chunk->tail &&
+            (uint8_t *)oldptr + size <= arena->chunk->end) {
+            arena->chunk->tail = (uint8_t *)oldptr + size;
+            ARENA_SIZE(oldptr) = size;
+            return oldptr;
+        }
+
+        ptr = arena_alloc(arena, size);
+        memcpy(ptr, oldptr, oldsize);
+        return ptr;
+    }
+
+    ptr = ogs_realloc(oldptr, size);
+    if (!ptr) {
+        ogs_fatal("asn_realloc() failed in `%s`", file_line);
+        ogs_assert_if_reached();
+    }
+    alloc_count++;
+
+    return ptr;
+}
+
+void ogs_asn_freemem(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    if (ogs_list_first(&arena_list) && arena_find(ptr))
+        return;
+
+    ogs_free(ptr);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGS_ASN_ARENA_H
+#define OGS_ASN_ARENA_H
+
+#include "ogs-core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Arena for the structure tree built by the asn1c decoder.
+ *
+ * While an arena is entered, every CALLOC/MALLOC/REALLOC in asn1c is
+ * carved out of a few chunks taken from the default pkbuf pool,
+ * and FREEMEM on a pointer inside a live arena does nothing.
+ * The first chunk is taken on the first allocation, not on entry.
+ * The whole tree is then given back at once by ogs_asn_arena_release(),
+ * instead of walking it node by node.
+ *
+ * An arena is identified by the structure the tree hangs from ('owner'),
+ * and the first 'owner_size' bytes of it are cleared on release.
+ * Arenas are kept per thread, so the tree must be released
+ * by the thread that decoded it.
+ */
+#define OGS_ASN_ARENA_CHUNK_SIZE 8192
+
+void ogs_asn_arena_enter(void *owner, size_t owner_size);
+void ogs_asn_arena_leave(void);
+bool ogs_asn_arena_release(void *owner);
+
+/* Number of allocations asn1c made from the heap or the pkbuf pool */
+uint64_t ogs_asn_alloc_count(void);
+
+void *ogs_asn_malloc(size_t size, const char *file_line);
+void *ogs_asn_calloc(size_t nmemb, size_t size, const char *file_line);
+void *ogs_asn_realloc(void *oldptr, size_t size, const char *file_line);
+void ogs_asn_freemem(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_ASN_ARENA_H */
@@ -19,6 +19,47 @@
 
 #include "message.h"
 
+/*
+ * Most NGAP/S1AP PDUs are a few hundred bytes, so encoding starts
+ * in a small pool buffer that only grows when the PDU does,
+ * rather than taking an OGS_MAX_SDU_LEN buffer for every PDU.
+ */
+#define OGS_ASN_ENCODE_MIN_SIZE 256
+
+static int encode_cb(const void *buffer, size_t size, void *key)
+{
+    ogs_pkbuf_t **pkbuf = key;
+    ogs_pkbuf_t *newbuf = NULL;
+    unsigned int newsize;
+
+    ogs_assert(pkbuf);
+    ogs_assert(*pkbuf);
+
+    if ((size_t)ogs_pkbuf_tailroom(*pkbuf) < size) {
+        newsize = (*pkbuf)->len + size;
+        if (newsize > OGS_MAX_SDU_LEN) {
+            ogs_error("ASN-PDU too large [%d]", newsize);
+            return -1;
+        }
+        newsize = ogs_max(newsize, ((*pkbuf)->end - (*pkbuf)->head) << 1);
+        newsize = ogs_min(newsize, OGS_MAX_SDU_LEN);
+
+        newbuf = ogs_pkbuf_alloc(NULL, newsize);
+        if (!newbuf) {
+            ogs_error("ogs_pkbuf_alloc() failed [size=%d]", newsize);
+            return -1;
+        }
+        ogs_pkbuf_put_data(newbuf, (*pkbuf)->data, (*pkbuf)->len);
+
+        ogs_pkbuf_free(*pkbuf);
+        *pkbuf = newbuf;
+    }
+
+    ogs_pkbuf_put_data(*pkbuf, buffer, size);
+
+    return 0;
+}
+
 ogs_pkbuf_t *ogs_asn_encode(const asn_TYPE_descriptor_t *td, void *sptr)
 {
     asn_enc_rval_t enc_ret = {0};
@@ -27,15 +68,18 @@ ogs_pkbuf_t *ogs_asn_encode(const asn_TYPE_descriptor_t *td, void *sptr)
     ogs_assert(td);
     ogs_assert(sptr);
 
-    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_ASN_ENCODE_MIN_SIZE);
     if (!pkbuf) {
         ogs_error("ogs_pkbuf_alloc() failed");
+        ogs_asn_free(td, sptr);
         return NULL;
     }
-    ogs_pkbuf_put(pkbuf, OGS_MAX_SDU_LEN);
 
-    enc_ret = aper_encode_to_buffer(td, NULL,
-                    sptr, pkbuf->data, OGS_MAX_SDU_LEN);
+    /* The encoder's own scratch buffers are dropped with the arena */
+    ogs_asn_arena_enter(&pkbuf, 0);
+    enc_ret = aper_encode(td, NULL, sptr, encode_cb, &pkbuf);
+    ogs_asn_arena_release(&pkbuf);
+
     ogs_asn_free(td, sptr);
 
     if (enc_ret.encoded < 0) {
@@ -62,12 +106,18 @@ int ogs_asn_decode(const asn_TYPE_descriptor_t *td,
     ogs_assert(pkbuf->len);
 
     memset(struct_ptr, 0, struct_size);
+
+    /* The whole tree is allocated from an arena owned by struct_ptr */
+    ogs_asn_arena_enter(struct_ptr, struct_size);
     dec_ret = aper_decode(NULL, td, (void **)&struct_ptr,
             pkbuf->data, pkbuf->len, 0, 0);
+    ogs_asn_arena_leave();
 
     if (dec_ret.code != RC_OK) {
         ogs_warn("Failed to decode ASN-PDU [code:%d,consumed:%d]",
                 dec_ret.code, (int)dec_ret.consumed);
+        /* Leaves struct_ptr zeroed, so ogs_asn_free() is still safe */
+        ogs_asn_arena_release(struct_ptr);
         return OGS_ERROR;
     }
 
@@ -79,5 +129,9 @@ void ogs_asn_free(const asn_TYPE_descriptor_t *td, void *sptr)
     ogs_assert(td);
     ogs_assert(sptr);
 
+    /* A decoded tree goes away at once with its arena */
+    if (ogs_asn_arena_release(sptr) == true)
+        return;
+
     ASN_STRUCT_FREE_CONTENTS_ONLY(*td, sptr);
 }
@@ -17,6 +17,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "core-config-private.h"
+
 #include "ogs-core.h"
 
 int __ogs_mem_domain;
@@ -34,6 +36,8 @@ static ogs_core_context_t self = {
     .pkbuf.config_pool = 8,
 
     .tlv.pool = 512,
+
+    .timer.backend = OGS_TIMER_BACKEND_DEFAULT,
 };
 
 void ogs_core_initialize(void)
@@ -99,7 +99,7 @@ static ogs_log_t *add_log(ogs_log_type_e type);
 static int file_cycle(ogs_log_t *log);
 
 static char *log_timestamp(char *buf, char *last,
-        int use_color);
+        struct timeval *tv, int use_color);
 static char *log_domain(char *buf, char *last,
         const char *name, int use_color);
 static char *log_content(char *buf, char *last,
@@ -111,6 +111,65 @@ static char *log_linefeed(char *buf, char *last);
 static void file_writer(
         ogs_log_t *log, ogs_log_level_e level, const char *string);
 
+/*
+ * Asynchronous mode
+ *
+ * Log lines are still formatted by the caller, except for the timestamp,
+ * but are only copied into a ring buffer and written out by a writer
+ * thread, which also turns the time of the call into text. Callers on
+ * any thread reserve room in the ring by moving 'head' with a CAS,
+ * copy the line, and then publish the record by setting its state.
+ * The writer consumes records in order from 'tail' and clears them,
+ * so that an unpublished record always reads as LOG_RECORD_EMPTY.
+ */
+#define LOG_RECORD_EMPTY    0
+#define LOG_RECORD_LINE     1
+#define LOG_RECORD_SKIP     2   /* Padding up to the end of the ring */
+
+#define LOG_RECORD_ALIGN    8
+#define LOG_RECORD_ALIGN_UP(__x) \
+    (((__x) + (LOG_RECORD_ALIGN - 1)) & ~((size_t)LOG_RECORD_ALIGN - 1))
+
+typedef struct log_record_s {
+    uint32_t state;
+    uint32_t len;           /* Size of the whole record */
+    ogs_log_t *log;         /* NULL for the stderr fallback */
+    ogs_log_level_e level;
+    struct timeval tv;
+    uint8_t timestamp;      /* 0, or 1 + use_color */
+    char string[];
+} log_record_t;
+
+static struct {
+    bool running;
+    ogs_log_overflow_e overflow;
+
+    uint8_t *ring;
+    size_t size;            /* Power of 2 */
+    uint64_t head;          /* Reserved by callers */
+    uint64_t tail;          /* Consumed by the writer */
+
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t dropped_reported;
+
+    ogs_thread_t *thread;
+    ogs_thread_mutex_t mutex;   /* Taken by the writer while writing */
+    ogs_thread_mutex_t wait_mutex;  /* Only held around the writer's wait */
+    ogs_thread_cond_t cond;
+    int sleeping;           /* ASYNC_AWAKE, ASYNC_BATCH or ASYNC_IDLE */
+    bool stop;
+} async;
+
+#define ASYNC_AWAKE 0
+#define ASYNC_BATCH 1       /* Letting lines pile up between batches */
+#define ASYNC_IDLE 2        /* Waiting for the next line */
+
+static OGS_THREAD_LOCAL bool log_writer_thread;
+
+static void async_write(ogs_log_t *log, ogs_log_level_e level,
+        struct timeval *tv, int use_color, const char *string, size_t len);
+
 void ogs_log_init(void)
 {
     ogs_pool_init(&log_pool, ogs_core()->log.pool);
@@ -125,6 +184,9 @@ void ogs_log_final(void)
     ogs_log_t *log, *saved_log;
     ogs_log_domain_t *domain, *saved_domain;
 
+    if (async.running)
+        ogs_log_async_stop();
+
     ogs_list_for_each_safe(&log_list, saved_log, log)
         ogs_log_remove(log);
     ogs_pool_final(&log_pool);
@@ -138,6 +200,9 @@ void ogs_log_cycle(void)
 {
     ogs_log_t *log = NULL;
 
+    if (async.running)
+        ogs_thread_mutex_lock(&async.mutex);
+
     ogs_list_for_each(&log_list, log) {
         switch(log->type) {
         case OGS_LOG_FILE_TYPE:
@@ -146,6 +211,9 @@ void ogs_log_cycle(void)
             break;
         }
     }
+
+    if (async.running)
+        ogs_thread_mutex_unlock(&async.mutex);
 }
 
 ogs_log_t *ogs_log_add_stderr(void)
@@ -189,6 +257,10 @@ void ogs_log_remove(ogs_log_t *log)
 {
     ogs_assert(log);
 
+    /* Records still in the ring may point to this log */
+    if (async.running)
+        ogs_log_async_flush();
+
     ogs_list_remove(&log_list, log);
 
     if (log->type == OGS_LOG_FILE_TYPE) {
@@ -408,8 +480,13 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
     char logstr[OGS_HUGE_LEN];
     char *p, *last;
 
+    struct timeval tv;
+    int deferred = async.running && !log_writer_thread;
     int wrote_stderr = 0;
 
+    if (!content_only)
+        ogs_gettimeofday(&tv);
+
     ogs_list_for_each(&log_list, log) {
         domain = ogs_pool_find(&domain_pool, id);
         if (!domain) {
@@ -423,8 +500,8 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
         last = logstr + OGS_HUGE_LEN;
 
         if (!content_only) {
-            if (log->print.timestamp)
-                p = log_timestamp(p, last, log->print.color);
+            if (log->print.timestamp && !deferred)
+                p = log_timestamp(p, last, &tv, log->print.color);
             if (log->print.domain)
                 p = log_domain(p, last, domain->name, log->print.color);
             if (log->print.level)
@@ -448,8 +525,13 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
                 p = log_linefeed(p, last);
         }
 
-        log->writer(log, level, logstr);
-        
+        if (deferred)
+            async_write(log, level,
+                    !content_only && log->print.timestamp ? &tv : NULL,
+                    log->print.color, logstr, p - logstr);
+        else
+            log->writer(log, level, logstr);
+
         if (log->type == OGS_LOG_STDERR_TYPE)
             wrote_stderr = 1;
     }
@@ -465,7 +547,8 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
         last = logstr + OGS_HUGE_LEN;
 
         if (!content_only) {
-            p = log_timestamp(p, last, use_color);
+            if (!deferred)
+                p = log_timestamp(p, last, &tv, use_color);
             p = log_level(p, last, level, use_color);
         }
         p = log_content(p, last, format, ap);
@@ -475,9 +558,18 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
             p = log_linefeed(p, last);
         }
 
-        fprintf(stderr, "%s", logstr);
-        fflush(stderr);
+        if (deferred) {
+            async_write(NULL, level, content_only ? NULL : &tv,
+                    use_color, logstr, p - logstr);
+        } else {
+            fprintf(stderr, "%s", logstr);
+            fflush(stderr);
+        }
     }
+
+    /* Make sure it is out before the process aborts */
+    if (level == OGS_LOG_FATAL && deferred)
+        ogs_log_async_flush();
 }
 
 void ogs_log_printf(ogs_log_level_e level, int id,
@@ -522,7 +614,320 @@ void ogs_log_hexdump_func(ogs_log_level_e level, int id,
         p = ogs_slprintf(p, last, "\n");
     }
 
-    ogs_log_print(level, "%s", dumpstr);
+    ogs_log_printf(level, id, 0, NULL, 0, NULL, 1, "%s", dumpstr);
+}
+
+/*
+ * While there are lines to write, the writer lets them pile up for
+ * LOG_ASYNC_INTERVAL between batches, and is only woken up early
+ * when the ring is half full. Once idle, it waits for the next line.
+ *
+ * Callers never take async.mutex, which the writer holds during I/O.
+ * Only the one that takes the writer out of 'sleeping' signals it,
+ * under async.wait_mutex.
+ */
+#define LOG_ASYNC_INTERVAL ogs_time_from_msec(10)
+#define LOG_ASYNC_IDLE_INTERVAL ogs_time_from_sec(1)
+
+static void async_signal(void)
+{
+    ogs_thread_mutex_lock(&async.wait_mutex);
+    ogs_thread_cond_signal(&async.cond);
+    ogs_thread_mutex_unlock(&async.wait_mutex);
+}
+
+static void async_wakeup(void)
+{
+    int sleeping;
+    uint64_t used;
+
+    sleeping = __atomic_load_n(&async.sleeping, __ATOMIC_SEQ_CST);
+    if (sleeping == ASYNC_AWAKE)
+        return;
+
+    if (sleeping == ASYNC_BATCH) {
+        used = __atomic_load_n(&async.head, __ATOMIC_RELAXED) -
+            __atomic_load_n(&async.tail, __ATOMIC_RELAXED);
+        if (used <= async.size / 2)
+            return;
+    }
+
+    if (__atomic_compare_exchange_n(&async.sleeping, &sleeping, ASYNC_AWAKE,
+                false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        async_signal();
+}
+
+static log_record_t *async_reserve(size_t need)
+{
+    uint64_t head, tail, pos;
+    size_t offset, pad;
+    log_record_t *record = NULL;
+
+    head = __atomic_load_n(&async.head, __ATOMIC_RELAXED);
+    do {
+        tail = __atomic_load_n(&async.tail, __ATOMIC_ACQUIRE);
+
+        /* A record never wraps around the end of the ring */
+        offset = head & (async.size - 1);
+        pad = 0;
+        if (offset + need > async.size)
+            pad = async.size - offset;
+
+        if (head + pad + need - tail > async.size)
+            return NULL;
+    } while (!__atomic_compare_exchange_n(&async.head, &head,
+                head + pad + need, true,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    pos = head;
+    if (pad) {
+        record = (log_record_t *)(async.ring + offset);
+        record->len = pad;
+        __atomic_store_n(&record->state, LOG_RECORD_SKIP, __ATOMIC_RELEASE);
+        pos += pad;
+    }
+
+    record = (log_record_t *)(async.ring + (pos & (async.size - 1)));
+    record->len = need;
+
+    return record;
+}
+
+static void async_write(ogs_log_t *log, ogs_log_level_e level,
+        struct timeval *tv, int use_color, const char *string, size_t len)
+{
+    size_t need;
+    log_record_t *record = NULL;
+
+    need = LOG_RECORD_ALIGN_UP(sizeof(*record) + len + 1);
+
+    while (!(record = async_reserve(need))) {
+        if (async.overflow == OGS_LOG_OVERFLOW_DROP) {
+            __atomic_fetch_add(&async.dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+
+        async_wakeup();
+        ogs_usleep(100);
+    }
+
+    record->log = log;
+    record->level = level;
+    record->timestamp = 0;
+    if (tv) {
+        record->tv = *tv;
+        record->timestamp = 1 + !!use_color;
+    }
+    memcpy(record->string, string, len);
+    record->string[len] = 0;
+
+    __atomic_store_n(&record->state, LOG_RECORD_LINE, __ATOMIC_SEQ_CST);
+
+    async_wakeup();
+}
+
+static void async_report_dropped(void)
+{
+    uint64_t dropped;
+    ogs_log_t *log = NULL;
+
+    dropped = __atomic_load_n(&async.dropped, __ATOMIC_RELAXED);
+    if (dropped == async.dropped_reported)
+        return;
+
+    ogs_list_for_each(&log_list, log)
+        fprintf(log->file.out, "[log] %llu messages dropped\n",
+                (unsigned long long)(dropped - async.dropped_reported));
+
+    async.dropped_reported = dropped;
+}
+
+/* Write out every published record. Called with async.mutex held */
+static int async_drain(void)
+{
+    int n = 0;
+    uint64_t tail;
+    uint32_t state;
+    size_t len;
+    log_record_t *record = NULL;
+    ogs_log_t *log = NULL;
+    FILE *out = NULL;
+    char timestr[64];
+
+    tail = __atomic_load_n(&async.tail, __ATOMIC_RELAXED);
+
+    while (1) {
+        record = (log_record_t *)(async.ring + (tail & (async.size - 1)));
+        state = __atomic_load_n(&record->state, __ATOMIC_ACQUIRE);
+        if (state == LOG_RECORD_EMPTY)
+            break;
+
+        len = record->len;
+        if (state == LOG_RECORD_LINE) {
+            out = record->log ? record->log->file.out : stderr;
+            if (record->timestamp) {
+                log_timestamp(timestr, timestr + sizeof(timestr),
+                        &record->tv, record->timestamp - 1);
+                fputs(timestr, out);
+            }
+            fputs(record->string, out);
+            n++;
+        }
+
+        memset(record, 0, len);
+        tail += len;
+        __atomic_store_n(&async.tail, tail, __ATOMIC_RELEASE);
+    }
+
+    if (n) {
+        __atomic_fetch_add(&async.written, n, __ATOMIC_RELAXED);
+
+        /* One flush per batch instead of one per line */
+        ogs_list_for_each(&log_list, log)
+            fflush(log->file.out);
+        fflush(stderr);
+    }
+
+    async_report_dropped();
+
+    return n;
+}
+
+static bool async_pending(void)
+{
+    uint64_t tail;
+    log_record_t *record = NULL;
+
+    tail = __atomic_load_n(&async.tail, __ATOMIC_RELAXED);
+    record = (log_record_t *)(async.ring + (tail & (async.size - 1)));
+
+    return __atomic_load_n(&record->state, __ATOMIC_SEQ_CST) !=
+        LOG_RECORD_EMPTY;
+}
+
+static void async_main(void *data)
+{
+    int n;
+    bool stop;
+
+    log_writer_thread = true;
+
+    ogs_thread_mutex_lock(&async.mutex);
+    while (1) {
+        n = async_drain();
+        stop = __atomic_load_n(&async.stop, __ATOMIC_ACQUIRE);
+        if (stop) {
+            if (n)
+                continue;
+            break;
+        }
+        ogs_thread_mutex_unlock(&async.mutex);
+
+        ogs_thread_mutex_lock(&async.wait_mutex);
+        /* A record published after this still sees 'sleeping' */
+        __atomic_store_n(&async.sleeping,
+                n ? ASYNC_BATCH : ASYNC_IDLE, __ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(&async.stop, __ATOMIC_ACQUIRE) &&
+            (n || !async_pending()))
+            ogs_thread_cond_timedwait(&async.cond, &async.wait_mutex,
+                    n ? LOG_ASYNC_INTERVAL : LOG_ASYNC_IDLE_INTERVAL);
+        __atomic_store_n(&async.sleeping, ASYNC_AWAKE, __ATOMIC_SEQ_CST);
+        ogs_thread_mutex_unlock(&async.wait_mutex);
+
+        ogs_thread_mutex_lock(&async.mutex);
+    }
+    ogs_thread_mutex_unlock(&async.mutex);
+}
+
+int ogs_log_async_start(size_t size, ogs_log_overflow_e overflow)
+{
+    ogs_assert(async.running == false);
+
+    /* Room for a few of the longest lines */
+    if (size < 8 * OGS_HUGE_LEN)
+        size = 8 * OGS_HUGE_LEN;
+    async.size = 1;
+    while (async.size < size)
+        async.size <<= 1;
+
+    async.ring = ogs_calloc(1, async.size);
+    if (!async.ring) {
+        ogs_error("ogs_calloc() failed");
+        return OGS_ERROR;
+    }
+
+    async.overflow = overflow;
+    async.head = async.tail = 0;
+    async.written = async.dropped = async.dropped_reported = 0;
+    async.sleeping = ASYNC_AWAKE;
+    async.stop = false;
+
+    ogs_thread_mutex_init(&async.mutex);
+    ogs_thread_mutex_init(&async.wait_mutex);
+    ogs_thread_cond_init(&async.cond);
+
+    async.running = true;
+
+    async.thread = ogs_thread_create(async_main, NULL);
+    if (!async.thread) {
+        async.running = false;
+        ogs_thread_cond_destroy(&async.cond);
+        ogs_thread_mutex_destroy(&async.wait_mutex);
+        ogs_thread_mutex_destroy(&async.mutex);
+        ogs_free(async.ring);
+        async.ring = NULL;
+        return OGS_ERROR;
+    }
+
+    return OGS_OK;
+}
+
+void ogs_log_async_stop(void)
+{
+    ogs_assert(async.running == true);
+
+    __atomic_store_n(&async.stop, true, __ATOMIC_RELEASE);
+    async_signal();
+
+    ogs_thread_destroy(async.thread);
+    async.thread = NULL;
+
+    /* Lines logged while the writer was exiting */
+    async.running = false;
+    async_drain();
+
+    ogs_thread_cond_destroy(&async.cond);
+    ogs_thread_mutex_destroy(&async.wait_mutex);
+    ogs_thread_mutex_destroy(&async.mutex);
+
+    ogs_free(async.ring);
+    async.ring = NULL;
+}
+
+void ogs_log_async_flush(void)
+{
+    uint64_t head;
+
+    if (!async.running || log_writer_thread)
+        return;
+
+    head = __atomic_load_n(&async.head, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&async.tail, __ATOMIC_ACQUIRE) < head) {
+        async_signal();
+        ogs_usleep(100);
+    }
+
+    /* The writer has let go of the files once it releases the mutex */
+    ogs_thread_mutex_lock(&async.mutex);
+    ogs_thread_mutex_unlock(&async.mutex);
+}
+
+void ogs_log_async_stats(uint64_t *written, uint64_t *dropped)
+{
+    if (written)
+        *written = __atomic_load_n(&async.written, __ATOMIC_RELAXED);
+    if (dropped)
+        *dropped = __atomic_load_n(&async.dropped, __ATOMIC_RELAXED);
 }
 
 static ogs_log_t *add_log(ogs_log_type_e type)
@@ -560,19 +965,17 @@ static int file_cycle(ogs_log_t *log)
 }
 
 static char *log_timestamp(char *buf, char *last,
-        int use_color)
+        struct timeval *tv, int use_color)
 {
-    struct timeval tv;
     struct tm tm;
     char nowstr[32];
 
-    ogs_gettimeofday(&tv);
-    ogs_localtime(tv.tv_sec, &tm);
+    ogs_localtime(tv->tv_sec, &tm);
     strftime(nowstr, sizeof nowstr, "%m/%d %H:%M:%S", &tm);
 
     buf = ogs_slprintf(buf, last, "%s%s.%03d%s: ",
             use_color ? TA_FGC_GREEN : "",
-            nowstr, (int)(tv.tv_usec/1000),
+            nowstr, (int)(tv->tv_usec/1000),
             use_color ? TA_NOR : "");
 
     return buf;
@@ -109,6 +109,25 @@ void ogs_log_printf(ogs_log_level_e level, int domain_id,
 void ogs_log_hexdump_func(ogs_log_level_e level, int domain_id,
     const unsigned char *data, size_t len);
 
+/*
+ * Asynchronous logging
+ *
+ * Once started, a log line is formatted by the caller and copied into
+ * a ring buffer of 'size' bytes, and a writer thread writes the lines
+ * out in batches. When the ring is full, the line is either dropped and
+ * counted, or the caller waits for the writer to make room.
+ * FATAL lines are written out before returning.
+ */
+typedef enum {
+    OGS_LOG_OVERFLOW_DROP,
+    OGS_LOG_OVERFLOW_BLOCK,
+} ogs_log_overflow_e;
+
+int ogs_log_async_start(size_t size, ogs_log_overflow_e overflow);
+void ogs_log_async_stop(void);
+void ogs_log_async_flush(void);
+void ogs_log_async_stats(uint64_t *written, uint64_t *dropped);
+
 #define ogs_assert(expr) \
     do { \
         if (ogs_likely(expr)) ; \
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+
+#define OGS_LPM_MAX_BITS 128
+#define OGS_LPM_MIN_SLOT 16
+
+/*
+ * A key is the masked prefix copied as is into two 64-bit words,
+ * so that masking and comparing do not depend on the byte order.
+ */
+typedef struct ogs_lpm_key_s {
+    uint64_t w[2];
+} ogs_lpm_key_t;
+
+typedef struct ogs_lpm_slot_s {
+    ogs_lpm_key_t key;
+    void *data;                 /* NULL : empty slot */
+} ogs_lpm_slot_t;
+
+typedef struct ogs_lpm_table_s {
+    ogs_lpm_slot_t *slot;
+    unsigned int mask;          /* number of slots - 1 */
+    unsigned int count;
+} ogs_lpm_table_t;
+
+struct ogs_lpm_s {
+    int bits;
+
+    ogs_lpm_key_t netmask[OGS_LPM_MAX_BITS+1];
+    ogs_lpm_table_t table[OGS_LPM_MAX_BITS+1];
+
+    /* Prefix lengths in use, longest first */
+    uint8_t len[OGS_LPM_MAX_BITS+1];
+    int num_of_len;
+
+    unsigned int count;
+};
+
+static ogs_inline void key_make(ogs_lpm_key_t *key,
+        const ogs_lpm_key_t *netmask, const void *prefix, int bytes)
+{
+    key->w[0] = key->w[1] = 0;
+    memcpy(key->w, prefix, bytes);
+    key->w[0] &= netmask->w[0];
+    key->w[1] &= netmask->w[1];
+}
+
+static ogs_inline unsigned int key_hash(const ogs_lpm_key_t *key)
+{
+    uint64_t h = key->w[0] * 0x9e3779b97f4a7c15ULL;
+    h ^= key->w[1] + (h << 6) + (h >> 2);
+    h *= 0xff51afd7ed558ccdULL;
+    return (unsigned int)(h ^ (h >> 32));
+}
+
+static ogs_inline bool key_equal(
+        const ogs_lpm_key_t *a, const ogs_lpm_key_t *b)
+{
+    return a->w[0] == b->w[0] && a->w[1] == b->w[1];
+}
+
+static ogs_lpm_slot_t *table_lookup(
+        ogs_lpm_table_t *table, const ogs_lpm_key_t *key)
+{
+    unsigned int i;
+
+    if (!table->slot)
+        return NULL;
+
+    for (i = key_hash(key) & table->mask;
+            table->slot[i].data; i = (i + 1) & table->mask) {
+        if (key_equal(&table->slot[i].key, key))
+            return &table->slot[i];
+    }
+
+    return NULL;
+}
+
+static void table_insert(ogs_lpm_table_t *table,
+        const ogs_lpm_key_t *key, void *data)
+{
+    unsigned int i;
+
+    for (i = key_hash(key) & table->mask;
+            table->slot[i].data; i = (i + 1) & table->mask)
+        /* nothing */;
+
+    table->slot[i].key = *key;
+    table->slot[i].data = data;
+    table->count++;
+}
+
+static int table_resize(ogs_lpm_table_t *table, unsigned int num_of_slot)
+{
+    ogs_lpm_slot_t *old = table->slot;
+    unsigned int i, old_num_of_slot = old ? table->mask + 1 : 0;
+
+    table->slot = ogs_calloc(num_of_slot, sizeof(ogs_lpm_slot_t));
+    if (!table->slot) {
+        ogs_error("ogs_calloc() failed");
+        table->slot = old;
+        return OGS_ERROR;
+    }
+    table->mask = num_of_slot - 1;
+    table->count = 0;
+
+    for (i = 0; i < old_num_of_slot; i++)
+        if (old[i].data)
+            table_insert(table, &old[i].key, old[i].data);
+
+    if (old)
+        ogs_free(old);
+
+    return OGS_OK;
+}
+
+/* Backward shift deletion keeps the probe sequences without tombstones */
+static void table_remove(ogs_lpm_table_t *table, ogs_lpm_slot_t *slot)
+{
+    unsigned int i, j, k;
+
+    i = j = slot - table->slot;
+
+    for (;;) {
+        j = (j + 1) & table->mask;
+        if (!table->slot[j].data)
+            break;
+
+        k = key_hash(&table->slot[j].key) & table->mask;
+        if ((j > i && (k <= i || k > j)) ||
+            (j < i && (k <= i && k > j))) {
+            table->slot[i] = table->slot[j];
+            i = j;
+        }
+    }
+
+    table->slot[i].data = NULL;
+    table->count--;
+}
+
+static void update_len(ogs_lpm_t *lpm)
+{
+    int i;
+
+    lpm->num_of_len = 0;
+    for (i = lpm->bits; i >= 0; i--)
+        if (lpm->table[i].count)
+            lpm->len[lpm->num_of_len++] = i;
+}
+
+ogs_lpm_t *ogs_lpm_create(int bits)
+{
+    ogs_lpm_t *lpm = NULL;
+    int i, j;
+
+    ogs_assert(bits == 32 || bits == 128);
+
+    lpm = ogs_calloc(1, sizeof(*lpm));
+    if (!lpm) {
+        ogs_error("ogs_calloc() failed");
+        return NULL;
+    }
+
+    lpm->bits = bits;
+
+    for (i = 0; i <= bits; i++) {
+        uint8_t netmask[OGS_LPM_MAX_BITS/8];
+
+        memset(netmask, 0, sizeof(netmask));
+        for (j = 0; j < i; j++)
+            netmask[j >> 3] |= 0x80 >> (j & 7);
+
+        memcpy(lpm->netmask[i].w, netmask, sizeof(netmask));
+    }
+
+    return lpm;
+}
+
+void ogs_lpm_destroy(ogs_lpm_t *lpm)
+{
+    int i;
+
+    ogs_assert(lpm);
+
+    for (i = 0; i <= lpm->bits; i++)
+        if (lpm->table[i].slot)
+            ogs_free(lpm->table[i].slot);
+
+    ogs_free(lpm);
+}
+
+int ogs_lpm_add(ogs_lpm_t *lpm, const void *prefix, int prefixlen, void *data)
+{
+    ogs_lpm_table_t *table = NULL;
+    ogs_lpm_slot_t *slot = NULL;
+    ogs_lpm_key_t key;
+
+    ogs_assert(lpm);
+    ogs_assert(prefix);
+    ogs_assert(prefixlen >= 0 && prefixlen <= lpm->bits);
+    ogs_assert(data);
+
+    table = &lpm->table[prefixlen];
+    key_make(&key, &lpm->netmask[prefixlen], prefix, lpm->bits >> 3);
+
+    slot = table_lookup(table, &key);
+    if (slot) {
+        slot->data = data;
+        return OGS_OK;
+    }
+
+    /* Keep the load factor under 1/2 */
+    if (!table->slot) {
+        if (table_resize(table, OGS_LPM_MIN_SLOT) != OGS_OK)
+            return OGS_ERROR;
+    } else if ((table->count + 1) * 2 > table->mask + 1) {
+        if (table_resize(table, (table->mask + 1) * 2) != OGS_OK)
+            return OGS_ERROR;
+    }
+
+    table_insert(table, &key, data);
+    lpm->count++;
+
+    if (table->count == 1)
+        update_len(lpm);
+
+    return OGS_OK;
+}
+
+void ogs_lpm_delete(ogs_lpm_t *lpm, const void *prefix, int prefixlen)
+{
+    ogs_lpm_table_t *table = NULL;
+    ogs_lpm_slot_t *slot = NULL;
+    ogs_lpm_key_t key;
+
+    ogs_assert(lpm);
+    ogs_assert(prefix);
+    ogs_assert(prefixlen >= 0 && prefixlen <= lpm->bits);
+
+    table = &lpm->table[prefixlen];
+    key_make(&key, &lpm->netmask[prefixlen], prefix, lpm->bits >> 3);
+
+    slot = table_lookup(table, &key);
+    if (!slot)
+        return;
+
+    table_remove(table, slot);
+    lpm->count--;
+
+    if (table->count == 0) {
+        ogs_free(table->slot);
+        table->slot = NULL;
+        table->mask = 0;
+
+        update_len(lpm);
+    }
+}
+
+void *ogs_lpm_find(ogs_lpm_t *lpm, const void *addr)
+{
+    ogs_lpm_slot_t *slot = NULL;
+    ogs_lpm_key_t full, key;
+    int i, len;
+
+    ogs_assert(lpm);
+    ogs_assert(addr);
+
+    full.w[0] = full.w[1] = 0;
+    memcpy(full.w, addr, lpm->bits >> 3);
+
+    for (i = 0; i < lpm->num_of_len; i++) {
+        len = lpm->len[i];
+
+        key.w[0] = full.w[0] & lpm->netmask[len].w[0];
+        key.w[1] = full.w[1] & lpm->netmask[len].w[1];
+
+        slot = table_lookup(&lpm->table[len], &key);
+        if (slot)
+            return slot->data;
+    }
+
+    return NULL;
+}
+
+void *ogs_lpm_find_exact(ogs_lpm_t *lpm, const void *prefix, int prefixlen)
+{
+    ogs_lpm_slot_t *slot = NULL;
+    ogs_lpm_key_t key;
+
+    ogs_assert(lpm);
+    ogs_assert(prefix);
+    ogs_assert(prefixlen >= 0 && prefixlen <= lpm->bits);
+
+    key_make(&key, &lpm->netmask[prefixlen], prefix, lpm->bits >> 3);
+
+    slot = table_lookup(&lpm->table[prefixlen], &key);
+
+    return slot ? slot->data : NULL;
+}
+
+unsigned int ogs_lpm_count(ogs_lpm_t *lpm)
+{
+    ogs_assert(lpm);
+    return lpm->count;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_CORE_INSIDE) && !defined(OGS_CORE_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_LPM_H
+#define OGS_LPM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Longest prefix match table for IPv4(32 bits) or IPv6(128 bits) prefixes.
+ *
+ * Prefixes of the same length live in one open-addressing hash table,
+ * and ogs_lpm_find() probes the lengths in use from the longest one.
+ * A lookup therefore costs one probe per distinct prefix length,
+ * typically one or two cache lines, whatever the number of prefixes.
+ *
+ * Addresses and prefixes are given in network byte order.
+ * The bits after 'prefixlen' are ignored. 'data' must not be NULL.
+ */
+typedef struct ogs_lpm_s ogs_lpm_t;
+
+ogs_lpm_t *ogs_lpm_create(int bits);
+void ogs_lpm_destroy(ogs_lpm_t *lpm);
+
+int ogs_lpm_add(ogs_lpm_t *lpm,
+        const void *prefix, int prefixlen, void *data);
+void ogs_lpm_delete(ogs_lpm_t *lpm, const void *prefix, int prefixlen);
+
+void *ogs_lpm_find(ogs_lpm_t *lpm, const void *addr);
+void *ogs_lpm_find_exact(ogs_lpm_t *lpm, const void *prefix, int prefixlen);
+
+unsigned int ogs_lpm_count(ogs_lpm_t *lpm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_LPM_H */
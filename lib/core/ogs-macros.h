@@ -76,6 +76,12 @@ extern "C" {
 #define OGS_GNUC_FALLTHROUGH
 #endif
 
+#if defined(_MSC_VER)
+#define OGS_THREAD_LOCAL __declspec(thread)
+#else
+#define OGS_THREAD_LOCAL __thread
+#endif
+
 #if defined(_WIN32)
 #define htole16(x) (x)
 #define htole32(x) (x)
@@ -86,6 +86,43 @@ static ogs_cluster_t *cluster_alloc(
 static void cluster_free(ogs_pkbuf_pool_t *pool, ogs_cluster_t *cluster);
 #endif
 
+#define OGS_MAX_NUM_OF_PKBUF_CACHE  4
+#define OGS_PKBUF_MAGAZINE_SIZE     32
+#define OGS_PKBUF_CACHE_ALIGN       64
+
+typedef struct ogs_pkbuf_cache_s {
+    int index;
+    unsigned int generation;
+
+    unsigned int size;
+    unsigned int stride;
+    int num;
+    unsigned char *slab;
+
+    ogs_thread_mutex_t mutex;
+    ogs_pkbuf_t **depot;
+    int avail;
+
+    int high_water;
+    uint64_t exhausted;
+} ogs_pkbuf_cache_t;
+
+typedef struct ogs_pkbuf_magazine_s {
+    unsigned int generation;
+    int num;
+    ogs_pkbuf_t *pkbuf[OGS_PKBUF_MAGAZINE_SIZE];
+} ogs_pkbuf_magazine_t;
+
+static ogs_thread_mutex_t cache_mutex;
+static ogs_pkbuf_cache_t *cache_array[OGS_MAX_NUM_OF_PKBUF_CACHE];
+static unsigned int cache_generation = 0;
+
+static OGS_THREAD_LOCAL ogs_pkbuf_magazine_t
+    magazine_array[OGS_MAX_NUM_OF_PKBUF_CACHE];
+
+static void cache_free(ogs_pkbuf_t *pkbuf);
+static ogs_pkbuf_t *cache_copy(ogs_pkbuf_t *pkbuf, const char *file_line);
+
 void *ogs_pkbuf_put_data(
         ogs_pkbuf_t *pkbuf, const void *data, unsigned int len)
 {
@@ -101,10 +138,12 @@ void ogs_pkbuf_init(void)
     ogs_pool_init(&pkbuf_pool, ogs_core()->pkbuf.pool);
 
 #endif
+    ogs_thread_mutex_init(&cache_mutex);
 }
 
 void ogs_pkbuf_final(void)
 {
+    ogs_thread_mutex_destroy(&cache_mutex);
 #if OGS_USE_TALLOC == 0
     ogs_pool_final(&pkbuf_pool);
 #endif
@@ -288,6 +327,11 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
 
 void ogs_pkbuf_free(ogs_pkbuf_t *pkbuf)
 {
+    if (pkbuf && pkbuf->cache) {
+        cache_free(pkbuf);
+        return;
+    }
+
 #if OGS_USE_TALLOC == 1
     ogs_talloc_free(pkbuf, OGS_FILE_LINE);
 #else
@@ -332,6 +376,9 @@ ogs_pkbuf_t *ogs_pkbuf_copy_debug(ogs_pkbuf_t *pkbuf, const char *file_line)
         return NULL;
     }
 
+    if (pkbuf->cache)
+        return cache_copy(pkbuf, file_line);
+
 #if OGS_USE_TALLOC == 1
     newbuf = ogs_pkbuf_alloc_debug(NULL, size, file_line);
     if (!newbuf) {
@@ -491,3 +538,244 @@ static void cluster_free(ogs_pkbuf_pool_t *pool, ogs_cluster_t *cluster)
     ogs_pool_free(&pool->cluster, cluster);
 }
 #endif
+
+ogs_pkbuf_cache_t *ogs_pkbuf_cache_create(unsigned int size, int num)
+{
+    ogs_pkbuf_cache_t *cache = NULL;
+    int i, index = -1;
+
+    ogs_assert(size);
+    ogs_assert(num > 0);
+
+    ogs_thread_mutex_lock(&cache_mutex);
+
+    for (i = 0; i < OGS_MAX_NUM_OF_PKBUF_CACHE; i++) {
+        if (!cache_array[i]) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        ogs_error("No more pkbuf cache [%d]", OGS_MAX_NUM_OF_PKBUF_CACHE);
+        ogs_thread_mutex_unlock(&cache_mutex);
+        return NULL;
+    }
+
+    /*
+     * Like ogs_pool_init(), the slab comes from the system malloc().
+     * Pages of the slab are not touched until a buffer is used.
+     */
+    cache = calloc(1, sizeof(*cache));
+    ogs_assert(cache);
+
+    cache->index = index;
+    if (++cache_generation == 0)
+        ++cache_generation;
+    cache->generation = cache_generation;
+
+    cache->size = size;
+    cache->stride = (sizeof(ogs_pkbuf_t) + size +
+            OGS_PKBUF_CACHE_ALIGN - 1) & ~(OGS_PKBUF_CACHE_ALIGN - 1);
+    cache->num = num;
+
+    cache->slab = malloc((size_t)cache->stride * num);
+    ogs_assert(cache->slab);
+    cache->depot = malloc(sizeof(ogs_pkbuf_t *) * num);
+    ogs_assert(cache->depot);
+
+    /* Hand out the buffers at the start of the slab first */
+    for (i = 0; i < num; i++)
+        cache->depot[i] = (ogs_pkbuf_t *)
+            (cache->slab + (size_t)cache->stride * (num - 1 - i));
+    cache->avail = num;
+
+    ogs_thread_mutex_init(&cache->mutex);
+
+    cache_array[index] = cache;
+
+    ogs_thread_mutex_unlock(&cache_mutex);
+
+    return cache;
+}
+
+static void magazine_spill(ogs_pkbuf_cache_t *cache,
+        ogs_pkbuf_magazine_t *magazine, int num)
+{
+    ogs_assert(num <= magazine->num);
+
+    ogs_thread_mutex_lock(&cache->mutex);
+
+    ogs_assert(cache->avail + num <= cache->num);
+    while (num--)
+        cache->depot[cache->avail++] = magazine->pkbuf[--magazine->num];
+
+    ogs_thread_mutex_unlock(&cache->mutex);
+}
+
+static void magazine_refill(ogs_pkbuf_cache_t *cache,
+        ogs_pkbuf_magazine_t *magazine)
+{
+    int num, in_use;
+
+    ogs_thread_mutex_lock(&cache->mutex);
+
+    num = ogs_min(cache->avail, OGS_PKBUF_MAGAZINE_SIZE / 2);
+    if (!num)
+        cache->exhausted++;
+
+    while (num--)
+        magazine->pkbuf[magazine->num++] = cache->depot[--cache->avail];
+
+    in_use = cache->num - cache->avail;
+    if (in_use > cache->high_water)
+        cache->high_water = in_use;
+
+    ogs_thread_mutex_unlock(&cache->mutex);
+}
+
+static ogs_pkbuf_magazine_t *magazine_get(ogs_pkbuf_cache_t *cache)
+{
+    ogs_pkbuf_magazine_t *magazine = &magazine_array[cache->index];
+
+    /* The slot was used by a cache that has been destroyed since */
+    if (ogs_unlikely(magazine->generation != cache->generation)) {
+        magazine->generation = cache->generation;
+        magazine->num = 0;
+    }
+
+    return magazine;
+}
+
+void ogs_pkbuf_cache_destroy(ogs_pkbuf_cache_t *cache)
+{
+    ogs_pkbuf_magazine_t *magazine = NULL;
+
+    ogs_assert(cache);
+
+    ogs_thread_mutex_lock(&cache_mutex);
+
+    magazine = magazine_get(cache);
+    if (magazine->num)
+        magazine_spill(cache, magazine, magazine->num);
+    magazine->generation = 0;
+
+    if (cache->avail != cache->num)
+        ogs_error("%d in 'pkbuf_cache[%d]' were not released.",
+                cache->num - cache->avail, cache->num);
+
+    cache_array[cache->index] = NULL;
+
+    ogs_thread_mutex_unlock(&cache_mutex);
+
+    ogs_thread_mutex_destroy(&cache->mutex);
+
+    free(cache->depot);
+    free(cache->slab);
+    free(cache);
+}
+
+ogs_pkbuf_t *ogs_pkbuf_cache_alloc_debug(
+        ogs_pkbuf_cache_t *cache, const char *file_line)
+{
+    ogs_pkbuf_magazine_t *magazine = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    ogs_assert(cache);
+
+    magazine = magazine_get(cache);
+    if (ogs_unlikely(magazine->num == 0)) {
+        magazine_refill(cache, magazine);
+        if (magazine->num == 0)
+            return ogs_pkbuf_alloc_debug(NULL, cache->size, file_line);
+    }
+
+    pkbuf = magazine->pkbuf[--magazine->num];
+
+    /* Only the header is cleared, the payload is left as it is */
+    memset(pkbuf, 0, sizeof(*pkbuf));
+
+    pkbuf->head = pkbuf->_data;
+    pkbuf->end = pkbuf->_data + cache->size;
+
+    pkbuf->data = pkbuf->_data;
+    pkbuf->tail = pkbuf->_data;
+
+    pkbuf->file_line = file_line; /* For debug */
+
+    pkbuf->cache = cache;
+
+    return pkbuf;
+}
+
+static void cache_free(ogs_pkbuf_t *pkbuf)
+{
+    ogs_pkbuf_cache_t *cache = pkbuf->cache;
+    ogs_pkbuf_magazine_t *magazine = NULL;
+
+    ogs_assert(cache);
+    ogs_assert((unsigned char *)pkbuf >= cache->slab &&
+            (unsigned char *)pkbuf <
+                cache->slab + (size_t)cache->stride * cache->num);
+
+    magazine = magazine_get(cache);
+    if (ogs_unlikely(magazine->num == OGS_PKBUF_MAGAZINE_SIZE))
+        magazine_spill(cache, magazine, OGS_PKBUF_MAGAZINE_SIZE / 2);
+
+    magazine->pkbuf[magazine->num++] = pkbuf;
+}
+
+static ogs_pkbuf_t *cache_copy(ogs_pkbuf_t *pkbuf, const char *file_line)
+{
+    ogs_pkbuf_t *newbuf = NULL;
+
+    newbuf = ogs_pkbuf_cache_alloc_debug(pkbuf->cache, file_line);
+    if (!newbuf) {
+        ogs_error("ogs_pkbuf_copy() failed [size=%d]", pkbuf->cache->size);
+        return NULL;
+    }
+
+    /* Nothing beyond the tail is worth copying */
+    memcpy(newbuf->head, pkbuf->head, pkbuf->tail - pkbuf->head);
+
+    newbuf->len = pkbuf->len;
+
+    newbuf->data = newbuf->head + (pkbuf->data - pkbuf->head);
+    newbuf->tail = newbuf->head + (pkbuf->tail - pkbuf->head);
+
+    return newbuf;
+}
+
+void ogs_pkbuf_cache_flush(void)
+{
+    int i;
+
+    ogs_thread_mutex_lock(&cache_mutex);
+
+    for (i = 0; i < OGS_MAX_NUM_OF_PKBUF_CACHE; i++) {
+        ogs_pkbuf_cache_t *cache = cache_array[i];
+        ogs_pkbuf_magazine_t *magazine = &magazine_array[i];
+
+        if (cache && magazine->generation == cache->generation &&
+                magazine->num)
+            magazine_spill(cache, magazine, magazine->num);
+    }
+
+    ogs_thread_mutex_unlock(&cache_mutex);
+}
+
+void ogs_pkbuf_cache_stat(
+        ogs_pkbuf_cache_t *cache, ogs_pkbuf_cache_stat_t *stat)
+{
+    ogs_assert(cache);
+    ogs_assert(stat);
+
+    ogs_thread_mutex_lock(&cache->mutex);
+
+    stat->size = cache->size;
+    stat->num = cache->num;
+    stat->in_use = cache->num - cache->avail;
+    stat->high_water = cache->high_water;
+    stat->exhausted = cache->exhausted;
+
+    ogs_thread_mutex_unlock(&cache->mutex);
+}
@@ -58,6 +58,7 @@ typedef struct ogs_pkbuf_s {
     const char *file_line;
     
     ogs_pkbuf_pool_t *pool;
+    struct ogs_pkbuf_cache_s *cache;
 
     unsigned char _data[0]; /*!< optional immediate data array */
 } ogs_pkbuf_t;
@@ -89,6 +90,42 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
         ogs_pkbuf_pool_t *pool, unsigned int size, const char *file_line);
 void ogs_pkbuf_free(ogs_pkbuf_t *pkbuf);
 
+/*
+ * Packet buffer cache
+ *
+ * Fixed-size buffers carved out of a single slab for hot packet paths.
+ * Each thread keeps a small magazine of free buffers per cache, so that
+ * the cache mutex is only taken to refill or spill a magazine.
+ * The header is initialized on allocation, but the payload is not zeroed.
+ *
+ * Buffers are released with ogs_pkbuf_free() like any other pkbuf.
+ * When the slab runs out, the allocation falls back to the default pool.
+ *
+ * A thread that used a cache should call ogs_pkbuf_cache_flush()
+ * before it exits so that its magazines are returned to the slab.
+ */
+typedef struct ogs_pkbuf_cache_s ogs_pkbuf_cache_t;
+
+typedef struct ogs_pkbuf_cache_stat_s {
+    unsigned int size;          /* Payload size of each buffer */
+    unsigned int num;           /* Number of buffers in the slab */
+    unsigned int in_use;        /* Taken from the slab, incl. magazines */
+    unsigned int high_water;    /* Highest in_use seen so far */
+    uint64_t exhausted;         /* Allocations served by the fallback */
+} ogs_pkbuf_cache_stat_t;
+
+ogs_pkbuf_cache_t *ogs_pkbuf_cache_create(unsigned int size, int num);
+void ogs_pkbuf_cache_destroy(ogs_pkbuf_cache_t *cache);
+
+#define ogs_pkbuf_cache_alloc(cache) \
+    ogs_pkbuf_cache_alloc_debug(cache, OGS_FILE_LINE)
+ogs_pkbuf_t *ogs_pkbuf_cache_alloc_debug(
+        ogs_pkbuf_cache_t *cache, const char *file_line);
+
+void ogs_pkbuf_cache_flush(void);
+void ogs_pkbuf_cache_stat(
+        ogs_pkbuf_cache_t *cache, ogs_pkbuf_cache_stat_t *stat);
+
 void *ogs_pkbuf_put_data(
         ogs_pkbuf_t *pkbuf, const void *data, unsigned int len);
 #define ogs_pkbuf_copy(pkbuf) \
@@ -34,6 +34,17 @@ extern "C" {
 
 typedef int32_t ogs_pool_id_t;
 
+/*
+ * An ID handed out by ogs_pool_id_calloc() is a generation-tagged handle.
+ *
+ *   | generation (31 - id_shift bits) | slot index + 1 (id_shift bits) |
+ *
+ * The generation of a slot is bumped on every allocation, so an ID kept
+ * after ogs_pool_id_free() no longer matches id_array[] and
+ * ogs_pool_find_by_id() returns NULL, as it did with the ID hash.
+ * The lookup is a bounds check and two array loads.
+ */
+
 #define OGS_POOL(pool, type) \
     struct { \
         const char *name; \
@@ -41,10 +52,20 @@ typedef int32_t ogs_pool_id_t;
         int size, avail; \
         type **free, *array, **index; \
         \
-        ogs_hash_t *id_hash; \
-        ogs_pool_id_t id; \
+        ogs_pool_id_t *id_array; \
+        ogs_pool_id_t id_mask; \
+        int id_shift; \
     } pool
 
+#define ogs_pool_id_shift_init(pool) do { \
+    (pool)->id_shift = 1; \
+    while ((pool)->id_shift < 30 && \
+            ((pool)->size >> (pool)->id_shift) != 0) \
+        (pool)->id_shift++; \
+    ogs_assert(((pool)->size >> (pool)->id_shift) == 0); \
+    (pool)->id_mask = (1 << (pool)->id_shift) - 1; \
+} while (0)
+
 /*
  * ogs_pool_init() shall be used in the initialization routine.
  * Otherwise, memory will be fragment since this function uses system malloc()
@@ -65,8 +86,10 @@ typedef int32_t ogs_pool_id_t;
         (pool)->index[i] = NULL; \
     } \
     \
-    (pool)->id_hash = ogs_hash_make(); \
-    ogs_assert((pool)->id_hash); \
+    (pool)->id_array = malloc(sizeof(*(pool)->id_array) * _size); \
+    ogs_assert((pool)->id_array); \
+    memset((pool)->id_array, 0, sizeof(*(pool)->id_array) * _size); \
+    ogs_pool_id_shift_init(pool); \
 } while (0)
 
 /*
@@ -80,9 +103,7 @@ typedef int32_t ogs_pool_id_t;
     free((pool)->free); \
     free((pool)->array); \
     free((pool)->index); \
-    \
-    ogs_assert((pool)->id_hash); \
-    ogs_hash_destroy((pool)->id_hash); \
+    free((pool)->id_array); \
 } while (0)
 
 /*
@@ -107,8 +128,10 @@ typedef int32_t ogs_pool_id_t;
         (pool)->index[i] = NULL; \
     } \
     \
-    (pool)->id_hash = ogs_hash_make(); \
-    ogs_assert((pool)->id_hash); \
+    (pool)->id_array = ogs_malloc(sizeof(*(pool)->id_array) * _size); \
+    ogs_assert((pool)->id_array); \
+    memset((pool)->id_array, 0, sizeof(*(pool)->id_array) * _size); \
+    ogs_pool_id_shift_init(pool); \
 } while (0)
 
 /*
@@ -124,9 +147,7 @@ typedef int32_t ogs_pool_id_t;
     ogs_free((pool)->free); \
     ogs_free((pool)->array); \
     ogs_free((pool)->index); \
-    \
-    ogs_assert((pool)->id_hash); \
-    ogs_hash_destroy((pool)->id_hash); \
+    ogs_free((pool)->id_array); \
 } while (0)
 
 #define ogs_pool_alloc(pool, node) do { \
@@ -153,26 +174,34 @@ typedef int32_t ogs_pool_id_t;
 #define ogs_pool_find(pool, _index) \
     (_index > 0 && _index <= (pool)->size) ? (pool)->index[_index-1] : NULL
 
+#define ogs_pool_id_slot(pool, id) (((id) & (pool)->id_mask) - 1)
+
 #define ogs_pool_id_calloc(pool, node) do { \
     ogs_pool_alloc(pool, node); \
     if (*node) { \
+        int __slot = ogs_pool_index(pool, *(node)) - 1; \
+        ogs_pool_id_t __gen = \
+            ((pool)->id_array[__slot] >> (pool)->id_shift) + 1; \
+        __gen &= (OGS_MAX_POOL_ID >> (pool)->id_shift); \
         memset(*(node), 0, sizeof(**(node))); \
-        (*(node))->id = OGS_NEXT_ID((pool)->id, 1, OGS_MAX_POOL_ID); \
-        ogs_hash_set((pool)->id_hash, \
-                &((*(node))->id), sizeof(ogs_pool_id_t), *(node)); \
+        (*(node))->id = (__gen << (pool)->id_shift) | (__slot + 1); \
+        (pool)->id_array[__slot] = (*(node))->id; \
     } \
 } while (0)
 
 #define ogs_pool_id_free(pool, node) do { \
     ogs_assert(((node)->id) >= OGS_MIN_POOL_ID && \
             ((node)->id) <= OGS_MAX_POOL_ID); \
-    ogs_hash_set((pool)->id_hash, \
-            &((node)->id), sizeof(ogs_pool_id_t), NULL); \
+    ogs_assert(ogs_pool_find_by_id(pool, (node)->id) == (node)); \
     ogs_pool_free(pool, node); \
 } while (0)
 
 #define ogs_pool_find_by_id(pool, id) \
-    ogs_hash_get((pool)->id_hash, &id, sizeof(ogs_pool_id_t))
+    ((void *)(((id) >= OGS_MIN_POOL_ID && \
+        (unsigned int)ogs_pool_id_slot(pool, id) < \
+            (unsigned int)(pool)->size && \
+        (pool)->id_array[ogs_pool_id_slot(pool, id)] == (id)) ? \
+            (pool)->index[ogs_pool_id_slot(pool, id)] : NULL))
 
 #define ogs_pool_size(pool) ((pool)->size)
 #define ogs_pool_avail(pool) ((pool)->avail)
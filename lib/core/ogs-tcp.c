@@ -56,6 +56,11 @@ ogs_sock_t *ogs_tcp_server(
             rv = ogs_listen_reusable(new->fd, true);
             ogs_assert(rv == OGS_OK);
 
+            if (option.so_reuseport == true) {
+                rv = ogs_reuseport(new->fd, true);
+                ogs_assert(rv == OGS_OK);
+            }
+
             if (ogs_sock_bind(new, addr) == OGS_OK) {
                 ogs_debug("tcp_server() [%s]:%d",
                         OGS_ADDR(addr, buf), OGS_PORT(addr));
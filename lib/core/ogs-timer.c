@@ -22,9 +22,46 @@
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __ogs_event_domain
 
+/*
+ * Hierarchical timing wheel
+ *
+ * Level 0 has one slot per tick. A slot of level N covers all ticks of
+ * a full round of level N-1. When level N-1 wraps around, the next slot
+ * of level N is cascaded, i.e. its timers are hashed again into lower
+ * levels. A timer which expires beyond the last level is parked in the
+ * last level and cascaded until it comes within range.
+ */
+#define OGS_TIMER_WHEEL_TICK    1000    /* 1ms */
+#define OGS_TIMER_WHEEL_BITS    6
+#define OGS_TIMER_WHEEL_SIZE    (1 << OGS_TIMER_WHEEL_BITS)
+#define OGS_TIMER_WHEEL_MASK    (OGS_TIMER_WHEEL_SIZE - 1)
+#define OGS_TIMER_WHEEL_LEVEL   6       /* 2^36 ticks, about 795 days */
+#define OGS_TIMER_WHEEL_RANGE \
+    ((uint64_t)1 << (OGS_TIMER_WHEEL_BITS * OGS_TIMER_WHEEL_LEVEL))
+
+#define OGS_TIMER_WHEEL_BIT(index) ((uint64_t)1 << (index))
+
+typedef struct ogs_timer_wheel_s {
+    ogs_time_t base;        /* Monotonic time of tick 0 */
+    uint64_t current;       /* Next tick to be processed */
+    int count;
+
+    uint64_t pending[OGS_TIMER_WHEEL_LEVEL];    /* Non-empty slots */
+    ogs_list_t slot[OGS_TIMER_WHEEL_LEVEL][OGS_TIMER_WHEEL_SIZE];
+
+    /*
+     * Earliest tick in a slot of level 1 or above, 0 if unknown.
+     * It is recalculated only when ogs_timer_mgr_next() needs it.
+     */
+    uint64_t first[OGS_TIMER_WHEEL_LEVEL][OGS_TIMER_WHEEL_SIZE];
+} ogs_timer_wheel_t;
+
 typedef struct ogs_timer_mgr_s {
     OGS_POOL(pool, ogs_timer_t);
+    ogs_timer_backend_e backend;
+
     ogs_rbtree_t tree;
+    ogs_timer_wheel_t *wheel;
 } ogs_timer_mgr_t;
 
 static void add_timer_node(
@@ -52,7 +89,241 @@ static void add_timer_node(
     ogs_rbtree_insert_color(tree, timer);
 }
 
+static uint64_t wheel_tick(ogs_timer_wheel_t *wheel, ogs_time_t time)
+{
+    if (time <= wheel->base)
+        return 0;
+    return (time - wheel->base) / OGS_TIMER_WHEEL_TICK;
+}
+
+/* Rounded up so that a timer never fires before its timeout */
+static uint64_t wheel_expires(ogs_timer_wheel_t *wheel, ogs_time_t timeout)
+{
+    if (timeout <= wheel->base)
+        return 0;
+    return (timeout - wheel->base + OGS_TIMER_WHEEL_TICK - 1) /
+        OGS_TIMER_WHEEL_TICK;
+}
+
+static int wheel_ffs(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int n = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Distance from 'index' to the next non-empty slot, 'index' included */
+static int wheel_distance(uint64_t bits, int index)
+{
+    if (index)
+        bits = (bits >> index) | (bits << (OGS_TIMER_WHEEL_SIZE - index));
+    return wheel_ffs(bits);
+}
+
+static void wheel_link(ogs_timer_wheel_t *wheel, ogs_timer_t *timer)
+{
+    uint64_t expires, delta;
+    int level, index;
+
+    expires = wheel_expires(wheel, timer->timeout);
+    if (expires < wheel->current)
+        expires = wheel->current;
+
+    delta = expires - wheel->current;
+    if (delta >= OGS_TIMER_WHEEL_RANGE) {
+        delta = OGS_TIMER_WHEEL_RANGE - 1;
+        expires = wheel->current + delta;
+    }
+
+    for (level = 0; level < OGS_TIMER_WHEEL_LEVEL - 1; level++)
+        if (delta < ((uint64_t)1 << (OGS_TIMER_WHEEL_BITS * (level + 1))))
+            break;
+
+    index = (expires >> (OGS_TIMER_WHEEL_BITS * level)) & OGS_TIMER_WHEEL_MASK;
+
+    if (!(wheel->pending[level] & OGS_TIMER_WHEEL_BIT(index))) {
+        wheel->pending[level] |= OGS_TIMER_WHEEL_BIT(index);
+        wheel->first[level][index] = expires;
+    } else if (wheel->first[level][index] &&
+            expires < wheel->first[level][index]) {
+        wheel->first[level][index] = expires;
+    }
+
+    ogs_list_add(&wheel->slot[level][index], &timer->lnode);
+    timer->slot = (level << OGS_TIMER_WHEEL_BITS) | index;
+
+    wheel->count++;
+}
+
+static void wheel_unlink(ogs_timer_wheel_t *wheel, ogs_timer_t *timer)
+{
+    int level = timer->slot >> OGS_TIMER_WHEEL_BITS;
+    int index = timer->slot & OGS_TIMER_WHEEL_MASK;
+    ogs_list_t *list = &wheel->slot[level][index];
+
+    ogs_list_remove(list, &timer->lnode);
+
+    if (ogs_list_empty(list))
+        wheel->pending[level] &= ~OGS_TIMER_WHEEL_BIT(index);
+    else if (wheel->first[level][index] ==
+            wheel_expires(wheel, timer->timeout))
+        wheel->first[level][index] = 0;
+
+    wheel->count--;
+}
+
+static void wheel_cascade(ogs_timer_wheel_t *wheel, int level)
+{
+    OGS_LIST(list);
+    ogs_lnode_t *lnode = NULL, *next_lnode = NULL;
+    int index;
+
+    index = (wheel->current >> (OGS_TIMER_WHEEL_BITS * level)) &
+        OGS_TIMER_WHEEL_MASK;
+
+    if (wheel->pending[level] & OGS_TIMER_WHEEL_BIT(index)) {
+        ogs_list_copy(&list, &wheel->slot[level][index]);
+        ogs_list_init(&wheel->slot[level][index]);
+        wheel->pending[level] &= ~OGS_TIMER_WHEEL_BIT(index);
+
+        ogs_list_for_each_safe(&list, next_lnode, lnode) {
+            ogs_timer_t *this = ogs_rb_entry(lnode, ogs_timer_t, lnode);
+            wheel->count--;
+            wheel_link(wheel, this);
+        }
+    }
+
+    if (index == 0 && level + 1 < OGS_TIMER_WHEEL_LEVEL)
+        wheel_cascade(wheel, level + 1);
+}
+
+static ogs_time_t wheel_next(ogs_timer_wheel_t *wheel)
+{
+    uint64_t first = UINT64_MAX, expires;
+    ogs_time_t timeout, current;
+    int level, index, slot;
+
+    if (!wheel->count)
+        return OGS_INFINITE_TIME;
+
+    for (level = 0; level < OGS_TIMER_WHEEL_LEVEL; level++) {
+        if (!wheel->pending[level])
+            continue;
+
+        index = (wheel->current >> (OGS_TIMER_WHEEL_BITS * level)) &
+            OGS_TIMER_WHEEL_MASK;
+
+        if (level == 0) {
+            /* Every timer of a level 0 slot expires at the same tick */
+            expires = wheel->current +
+                wheel_distance(wheel->pending[0], index);
+        } else {
+            /*
+             * Unless the current tick is where the slot at 'index' gets
+             * cascaded, that slot is done for this round and comes last.
+             */
+            if (wheel->current &
+                    (((uint64_t)1 << (OGS_TIMER_WHEEL_BITS * level)) - 1))
+                index = (index + 1) & OGS_TIMER_WHEEL_MASK;
+
+            slot = (index + wheel_distance(wheel->pending[level], index)) &
+                OGS_TIMER_WHEEL_MASK;
+
+            if (!wheel->first[level][slot]) {
+                ogs_lnode_t *lnode = NULL;
+
+                expires = UINT64_MAX;
+                ogs_list_for_each(&wheel->slot[level][slot], lnode) {
+                    ogs_timer_t *this =
+                        ogs_rb_entry(lnode, ogs_timer_t, lnode);
+                    uint64_t tick = wheel_expires(wheel, this->timeout);
+                    if (tick < expires)
+                        expires = tick;
+                }
+                wheel->first[level][slot] = expires;
+            }
+            expires = wheel->first[level][slot];
+        }
+
+        if (expires < first)
+            first = expires;
+    }
+
+    timeout = wheel->base + (ogs_time_t)first * OGS_TIMER_WHEEL_TICK;
+    current = ogs_get_monotonic_time();
+    if (timeout > current)
+        return timeout - current;
+
+    return OGS_NO_WAIT_TIME;
+}
+
+static void wheel_expire(ogs_timer_wheel_t *wheel)
+{
+    uint64_t target, tick, bits;
+    ogs_list_t *list = NULL;
+    ogs_lnode_t *lnode = NULL;
+    int index;
+
+    target = wheel_tick(wheel, ogs_get_monotonic_time());
+
+    while (wheel->current <= target) {
+        if (!wheel->count) {
+            wheel->current = target + 1;
+            break;
+        }
+
+        index = wheel->current & OGS_TIMER_WHEEL_MASK;
+        if (index == 0)
+            wheel_cascade(wheel, 1);
+
+        if (!(wheel->pending[0] & OGS_TIMER_WHEEL_BIT(index))) {
+            /* Skip to the next non-empty slot in this round */
+            bits = wheel->pending[0] >> index;
+            if (bits)
+                wheel->current += wheel_ffs(bits);
+            else
+                wheel->current = (wheel->current | OGS_TIMER_WHEEL_MASK) + 1;
+            if (wheel->current > target + 1)
+                wheel->current = target + 1;
+            continue;
+        }
+
+        /*
+         * The tick is advanced first, so a timer started again
+         * in a callback is not processed within the same tick.
+         * Such a timer can only land in this slot one round later,
+         * and it is appended after the timers expiring now.
+         */
+        tick = wheel->current++;
+        list = &wheel->slot[0][index];
+
+        while ((lnode = ogs_list_first(list))) {
+            ogs_timer_t *this = ogs_rb_entry(lnode, ogs_timer_t, lnode);
+
+            if (wheel_expires(wheel, this->timeout) > tick)
+                break;
+
+            ogs_timer_stop(this);
+            if (this->cb)
+                this->cb(this->data);
+        }
+    }
+}
+
 ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity)
+{
+    return ogs_timer_mgr_create_backend(capacity, ogs_core()->timer.backend);
+}
+
+ogs_timer_mgr_t *ogs_timer_mgr_create_backend(
+        unsigned int capacity, ogs_timer_backend_e backend)
 {
     ogs_timer_mgr_t *manager = ogs_calloc(1, sizeof *manager);
     if (!manager) {
@@ -60,6 +331,17 @@ ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity)
         return NULL;
     }
 
+    manager->backend = backend;
+    if (backend == OGS_TIMER_BACKEND_WHEEL) {
+        manager->wheel = ogs_calloc(1, sizeof *manager->wheel);
+        if (!manager->wheel) {
+            ogs_error("ogs_calloc() failed");
+            ogs_free(manager);
+            return NULL;
+        }
+        manager->wheel->base = ogs_get_monotonic_time();
+    }
+
     ogs_pool_init(&manager->pool, capacity);
 
     return manager;
@@ -70,6 +352,8 @@ void ogs_timer_mgr_destroy(ogs_timer_mgr_t *manager)
     ogs_assert(manager);
 
     ogs_pool_final(&manager->pool);
+    if (manager->wheel)
+        ogs_free(manager->wheel);
     ogs_free(manager);
 }
 
@@ -116,6 +400,16 @@ void ogs_timer_start_debug(
     manager = timer->manager;
     ogs_assert(manager);
 
+    if (manager->wheel) {
+        if (timer->running == true)
+            wheel_unlink(manager->wheel, timer);
+
+        timer->running = true;
+        timer->timeout = ogs_get_monotonic_time() + duration;
+        wheel_link(manager->wheel, timer);
+        return;
+    }
+
     if (timer->running == true)
         ogs_rbtree_delete(&manager->tree, timer);
 
@@ -134,7 +428,10 @@ void ogs_timer_stop_debug(ogs_timer_t *timer, const char *file_line)
         return;
 
     timer->running = false;
-    ogs_rbtree_delete(&manager->tree, timer);
+    if (manager->wheel)
+        wheel_unlink(manager->wheel, timer);
+    else
+        ogs_rbtree_delete(&manager->tree, timer);
 }
 
 ogs_time_t ogs_timer_mgr_next(ogs_timer_mgr_t *manager)
@@ -143,6 +440,9 @@ ogs_time_t ogs_timer_mgr_next(ogs_timer_mgr_t *manager)
     ogs_rbnode_t *rbnode = NULL;
     ogs_assert(manager);
 
+    if (manager->wheel)
+        return wheel_next(manager->wheel);
+
     current = ogs_get_monotonic_time();
     rbnode = ogs_rbtree_first(&manager->tree);
     if (rbnode) {
@@ -167,6 +467,11 @@ void ogs_timer_mgr_expire(ogs_timer_mgr_t *manager)
     ogs_timer_t *this;
     ogs_assert(manager);
 
+    if (manager->wheel) {
+        wheel_expire(manager->wheel);
+        return;
+    }
+
     current = ogs_get_monotonic_time();
 
     ogs_rbtree_for_each(&manager->tree, rbnode) {
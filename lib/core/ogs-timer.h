@@ -28,6 +28,24 @@
 extern "C" {
 #endif
 
+/*
+ * Timer manager backend
+ *
+ * OGS_TIMER_BACKEND_RBTREE keeps the timers sorted in a red-black tree,
+ * so start/stop costs O(log n) and timers fire at the exact timeout.
+ *
+ * OGS_TIMER_BACKEND_WHEEL hashes the timers into a hierarchical timing
+ * wheel with 1ms ticks, so start/stop costs O(1). A timer never fires
+ * early, but may fire up to one tick late.
+ *
+ * ogs_timer_mgr_create() uses ogs_core()->timer.backend, which defaults to
+ * the 'timer_wheel' build option and can be set by 'global.parameter'.
+ */
+typedef enum {
+    OGS_TIMER_BACKEND_RBTREE = 0,
+    OGS_TIMER_BACKEND_WHEEL,
+} ogs_timer_backend_e;
+
 typedef struct ogs_timer_mgr_s ogs_timer_mgr_t;
 typedef struct ogs_timer_s {
     ogs_rbnode_t rbnode;
@@ -39,9 +57,13 @@ typedef struct ogs_timer_s {
     ogs_timer_mgr_t *manager;
     bool running;
     ogs_time_t timeout;
+
+    int slot;   /* Timing wheel slot (level * size + index) */
 } ogs_timer_t;
 
 ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity);
+ogs_timer_mgr_t *ogs_timer_mgr_create_backend(
+        unsigned int capacity, ogs_timer_backend_e backend);
 void ogs_timer_mgr_destroy(ogs_timer_mgr_t *manager);
 
 ogs_timer_t *ogs_timer_add(
@@ -20,6 +20,9 @@
 
 #include "ogs-core.h"
 
+#undef OGS_LOG_DOMAIN
+#define OGS_LOG_DOMAIN __ogs_tlv_domain
+
 ogs_tlv_desc_t ogs_tlv_desc_more1 = {
     OGS_TLV_MORE, "More", 0, 1, 0, 0, { NULL } };
 ogs_tlv_desc_t ogs_tlv_desc_more2 = {
@@ -594,83 +597,151 @@ static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
     return OGS_OK;
 }
 
-/* rbtree structure used to keep track count of TLVs with given <type,instance>
- * while parsing. This is used to link it to the matching nth field in a
- * ogs_tlv_desc_t struct */
-typedef struct tlv_count_node_s {
-    ogs_rbnode_t node;
-    uint32_t key; /* type<<8 + instance */
-    unsigned count;
-} tlv_count_node_t;
-
-static tlv_count_node_t *tlv_count_node_find(ogs_rbtree_t *tree, tlv_count_node_t *count_node_arr, unsigned count_node_arr_len,
-        unsigned *count_alloc_next, uint16_t type, uint8_t instance)
+static int tlv_header_size(uint8_t mode)
 {
-    ogs_rbnode_t **new = NULL;
-    ogs_rbnode_t *parent = NULL;
-    tlv_count_node_t *this;
-
-    uint64_t key = (((uint32_t)type)<<8) | instance;
-
-    new = &tree->root;
-    while (*new) {
-        this = ogs_rb_entry(*new, tlv_count_node_t, node);
-        parent = *new;
-        if (key < this->key) {
-            new = &(*new)->left;
-        } else if (key > this->key) {
-            new = &(*new)->right;
-        } else { /* found entry: */
-            return this;
-        }
+    switch(mode) {
+    case OGS_TLV_MODE_T1_L1:
+        return 2;
+    case OGS_TLV_MODE_T1_L2:
+        return 3;
+    case OGS_TLV_MODE_T1_L2_I1:
+    case OGS_TLV_MODE_T2_L2:
+        return 4;
+    case OGS_TLV_MODE_T1:
+        return 1;
+    default:
+        ogs_assert_if_reached();
+        break;
     }
 
-    /* No entry, need to add one: */
-    if (*count_alloc_next == count_node_arr_len) {
-        ogs_error("This TLV has to many entries, can't parse");
+    return 0;
+}
+
+static uint8_t *tlv_get_element_desc(
+        ogs_tlv_t *tlv, uint8_t *blk, uint8_t *end,
+        uint8_t msg_mode, ogs_tlv_desc_t *desc);
+
+/*
+ * Read the element at 'pos' into 'tlv' without going past 'end'.
+ * Returns the start of the next element, or NULL if the element
+ * does not fit in the block.
+ */
+static uint8_t *tlv_get_element_checked(
+        ogs_tlv_t *tlv, uint8_t *pos, uint8_t *end,
+        uint8_t mode, ogs_tlv_desc_t *desc)
+{
+    tlv->instance = 0;
+
+    if (desc)
+        return tlv_get_element_desc(tlv, pos, end, mode, desc);
+
+    if (end - pos < tlv_header_size(mode))
+        return NULL;
+
+    pos = tlv_get_element(tlv, pos, mode);
+    if (tlv->length > end - (uint8_t *)tlv->value)
         return NULL;
+
+    return pos;
+}
+
+/*
+ * Find the descriptor of a TLV with the given <type,instance>.
+ *
+ * When a <type,instance> appears several times in the parent descriptor
+ * without OGS_TLV_MORE, the n-th TLV received goes to the n-th descriptor.
+ * 'count' keeps how many of them have been seen, by the index of the
+ * first matching descriptor, which is returned in 'first_index'.
+ */
+static ogs_tlv_desc_t *tlv_find_desc(uint8_t *count,
+        uint8_t *first_index, uint8_t *desc_index, uint32_t *tlv_offset,
+        ogs_tlv_desc_t *parent_desc, uint16_t match_type,
+        uint8_t match_instance)
+{
+    ogs_tlv_desc_t *prev_desc = NULL, *desc = NULL;
+    int i, first = -1, offset = 0;
+    unsigned match_i = 0;
+
+    for (i = 0, desc = parent_desc->child_descs[i]; desc != NULL;
+            i++, desc = parent_desc->child_descs[i]) {
+        if (desc->type == match_type && desc->instance == match_instance) {
+            if (first < 0)
+                first = i;
+            if (match_i == count[first]) {
+                *first_index = first;
+                *desc_index = i;
+                *tlv_offset = offset;
+                break;
+            }
+            match_i++;
+        }
+
+        if (desc->ctype == OGS_TLV_MORE) {
+            ogs_assert(prev_desc && prev_desc->ctype != OGS_TLV_MORE);
+            offset += prev_desc->vsize * (desc->length - 1);
+        } else {
+            offset += desc->vsize;
+        }
+
+        prev_desc = desc;
     }
-    this = &count_node_arr[(*count_alloc_next)++];
-    this->key = key;
-    this->count = 0;
-    ogs_rbtree_link_node(&this->node, parent, new);
-    ogs_rbtree_insert_color(tree, &this->node);
-    return this;
+
+    return desc;
 }
 
+/*
+ * Walk the elements of a block in place and decode each of them
+ * straight into 'msg'. Octet values point into the block.
+ *
+ * 'element_desc' is only set for the top level of
+ * ogs_tlv_parse_msg_desc(), where the format of each element
+ * depends on its descriptor.
+ */
 static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
-        ogs_tlv_t *parent_tlv, int depth, int mode)
+        uint8_t *data, uint32_t length, int depth, int mode,
+        ogs_tlv_desc_t *element_desc)
 {
     int rv;
     ogs_tlv_presence_t *presence_p = (ogs_tlv_presence_t *)msg;
     ogs_tlv_desc_t *desc = NULL, *next_desc = NULL;
-    ogs_tlv_t *tlv = NULL, *emb_tlv = NULL;
+    ogs_tlv_t tlv;
     uint8_t *p = msg;
+    uint8_t *pos = data, *next = NULL, *end = data + length;
     uint32_t offset = 0;
-    uint8_t index = 0;
+    uint8_t index = 0, first_index = 0;
+    uint8_t count[OGS_TLV_MAX_CHILD_DESC];
     int i = 0, j;
-    OGS_RBTREE(tree);
-    tlv_count_node_t count_node[OGS_TLV_MAX_CHILD_DESC];
-    unsigned count_node_alloc_next = 0;
     char indent[17] = "                "; /* 16 spaces */
 
     ogs_assert(msg);
     ogs_assert(parent_desc);
-    ogs_assert(parent_tlv);
+    ogs_assert(data);
 
     ogs_assert(depth <= 8);
     indent[depth*2] = 0;
 
-    tlv = parent_tlv;
-    while (tlv) {
-        tlv_count_node_t *curr_count = tlv_count_node_find(&tree, &count_node[0],
-                OGS_ARRAY_SIZE(count_node), &count_node_alloc_next, tlv->type, tlv->instance);
-        if (!curr_count)
+    if (length == 0) {
+        ogs_error("Empty TLV block [%s]", parent_desc->name);
+        return OGS_ERROR;
+    }
+
+    memset(count, 0, sizeof(count));
+    memset(&tlv, 0, sizeof(tlv));
+
+    while (pos < end) {
+        next = tlv_get_element_checked(&tlv, pos, end, mode, element_desc);
+        if (!next) {
+            ogs_error("Truncated TLV [%s] [OFFSET:%d,LEN:%d,MODE:%d]",
+                    parent_desc->name, (int)(pos - data), length, mode);
+            ogs_log_hexdump(OGS_LOG_ERROR, data, length);
             return OGS_ERROR;
-        desc = tlv_find_desc_by_type_inst(&index, &offset, parent_desc, tlv->type, tlv->instance, curr_count->count);
+        }
+        pos = next;
+
+        desc = tlv_find_desc(count, &first_index, &index, &offset,
+                parent_desc, tlv.type, tlv.instance);
         if (desc == NULL) {
-            ogs_warn("Unknown TLV type [%d]", tlv->type);
-            tlv = tlv->next;
+            ogs_warn("Unknown TLV type [%d]", tlv.type);
             continue;
         }
 
@@ -689,28 +760,21 @@ static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
             }
             if (j == next_desc->length) {
                 ogs_fatal("Multiple of the same type TLV need more room");
-                tlv = tlv->next;
                 continue;
             }
         } else {
-            curr_count->count++;
+            count[first_index]++;
         }
 
         if (desc->ctype == OGS_TLV_COMPOUND) {
-            emb_tlv = ogs_tlv_parse_embedded_block(tlv, mode);
-            if (emb_tlv == NULL) {
-                ogs_error("Error while parse TLV");
-                return OGS_ERROR;
-            }
-
             ogs_trace("PARSE %sC#%d [%s] T:%d I:%d (vsz=%d) off:%p ",
                     indent, i++, desc->name, desc->type, desc->instance,
                     desc->vsize, p + offset);
 
             offset += sizeof(ogs_tlv_presence_t);
 
-            rv = tlv_parse_compound(
-                    p + offset, desc, emb_tlv, depth + 1, mode);
+            rv = tlv_parse_compound(p + offset, desc,
+                    tlv.value, tlv.length, depth + 1, mode, NULL);
             if (rv != OGS_OK) {
                 ogs_error("Can't parse compound TLV");
                 return OGS_ERROR;
@@ -723,7 +787,7 @@ static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
                     indent, i++, desc->name, desc->type, desc->length,
                     desc->instance, desc->ctype, desc->vsize, p + offset);
 
-            rv = tlv_parse_leaf(p + offset, desc, tlv);
+            rv = tlv_parse_leaf(p + offset, desc, &tlv);
             if (rv != OGS_OK) {
                 ogs_error("Can't parse leaf TLV");
                 return OGS_ERROR;
@@ -731,8 +795,6 @@ static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
 
             *presence_p = 1;
         }
-
-        tlv = tlv->next;
     }
 
     return OGS_OK;
@@ -742,7 +804,6 @@ int ogs_tlv_parse_msg(void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf,
         int mode)
 {
     int rv;
-    ogs_tlv_t *root;
 
     ogs_assert(msg);
     ogs_assert(desc);
@@ -754,15 +815,9 @@ int ogs_tlv_parse_msg(void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf,
         ogs_assert_if_reached();
     }
 
-    root = ogs_tlv_parse_block(pkbuf->len, pkbuf->data, mode);
-    if (root == NULL) {
+    rv = tlv_parse_compound(msg, desc, pkbuf->data, pkbuf->len, 0, mode, NULL);
+    if (rv != OGS_OK)
         ogs_error("Can't parse TLV message");
-        return OGS_ERROR;
-    }
-
-    rv = tlv_parse_compound(msg, desc, root, 0, mode);
-
-    ogs_tlv_free_all(root);
 
     return rv;
 }
@@ -793,7 +848,9 @@ static uint16_t parse_get_element_type(uint8_t *pos, uint8_t mode)
 /* Get TLV element taking into account msg_mode (to know TLV tag length) +
  * specific TLV information from "desc" (to know whether the specific IE is TLV
  * or TV, and its expected length in the later case). */
-static uint8_t *tlv_get_element_desc(ogs_tlv_t *tlv, uint8_t *blk, uint8_t msg_mode, ogs_tlv_desc_t *desc)
+static uint8_t *tlv_get_element_desc(
+        ogs_tlv_t *tlv, uint8_t *blk, uint8_t *end,
+        uint8_t msg_mode, ogs_tlv_desc_t *desc)
 {
     uint8_t instance;
     unsigned tlv_tag_pos;
@@ -801,7 +858,10 @@ static uint8_t *tlv_get_element_desc(ogs_tlv_t *tlv, uint8_t *blk, uint8_t msg_m
     uint32_t tlv_offset = 0;
     uint16_t tlv_tag;
     uint8_t tlv_mode;
-    static ogs_tlv_desc_t* tlv_desc;
+    ogs_tlv_desc_t *tlv_desc;
+
+    if (end - blk < (msg_mode == OGS_TLV_MODE_T2_L2 ? 2 : 1))
+        return NULL;
 
     tlv_tag = parse_get_element_type(blk, msg_mode);
     instance = 0;  /* TODO: support instance != 0 if ever really needed by looking it up in pos */
@@ -813,51 +873,17 @@ static uint8_t *tlv_get_element_desc(ogs_tlv_t *tlv, uint8_t *blk, uint8_t msg_m
     }
     tlv_mode = tlv_ctype2mode(tlv_desc->ctype, msg_mode);
 
-    if (tlv_mode == OGS_TLV_MODE_T1)
-        return tlv_get_element_fixed(tlv, blk, tlv_mode, tlv_desc->length);
-    return tlv_get_element(tlv, blk, tlv_mode);
-}
-
-/* Similar to ogs_tlv_parse_block(), but taking into account each TLV format from "desc". */
-static ogs_tlv_t *ogs_tlv_parse_block_desc(uint32_t length, void *data, uint8_t msg_mode, ogs_tlv_desc_t *desc)
-{
-    uint8_t *pos = data;
-    uint8_t *blk = data;
-
-    ogs_tlv_t *root = NULL;
-    ogs_tlv_t *prev = NULL;
-    ogs_tlv_t *curr = NULL;
-
-    root = curr = ogs_tlv_get();
-
-    ogs_assert(curr);
-
-    pos = tlv_get_element_desc(curr, pos, msg_mode, desc);
-
-    ogs_assert(pos);
-
-    while(pos - blk < length) {
-        prev = curr;
-
-        curr = ogs_tlv_get();
-        ogs_assert(curr);
-        prev->next = curr;
-
-        pos = tlv_get_element_desc(curr, pos, msg_mode, desc);
-        ogs_assert(pos);
-    }
-
-    if (length != (pos - blk)) {
-        ogs_error("ogs_tlv_parse_block() failed[LEN:%d,MODE:%d]",
-                length, msg_mode);
-        ogs_error("POS[%p] BLK[%p] POS-BLK[%d]", pos, blk, (int)(pos - blk));
-        ogs_log_hexdump(OGS_LOG_FATAL, data, length);
+    if (end - blk < tlv_header_size(tlv_mode))
+        return NULL;
 
-        ogs_tlv_free_all(root);
+    if (tlv_mode == OGS_TLV_MODE_T1)
+        blk = tlv_get_element_fixed(tlv, blk, tlv_mode, tlv_desc->length);
+    else
+        blk = tlv_get_element(tlv, blk, tlv_mode);
+    if (tlv->length > end - (uint8_t *)tlv->value)
         return NULL;
-    }
 
-    return root;
+    return blk;
 }
 
 /* Similar to ogs_tlv_parse_msg(), but takes each TLV type from the desc
@@ -867,7 +893,6 @@ int ogs_tlv_parse_msg_desc(
         void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf, int msg_mode)
 {
     int rv;
-    ogs_tlv_t *root;
 
     ogs_assert(msg);
     ogs_assert(desc);
@@ -876,15 +901,10 @@ int ogs_tlv_parse_msg_desc(
     ogs_assert(desc->ctype == OGS_TLV_MESSAGE);
     ogs_assert(desc->child_descs[0]);
 
-    root = ogs_tlv_parse_block_desc(pkbuf->len, pkbuf->data, msg_mode, desc);
-    if (root == NULL) {
+    rv = tlv_parse_compound(msg, desc,
+            pkbuf->data, pkbuf->len, 0, msg_mode, desc);
+    if (rv != OGS_OK)
         ogs_error("Can't parse TLV message");
-        return OGS_ERROR;
-    }
-
-    rv = tlv_parse_compound(msg, desc, root, 0, msg_mode);
-
-    ogs_tlv_free_all(root);
 
     return rv;
 }
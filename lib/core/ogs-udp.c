@@ -17,8 +17,14 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "core-config-private.h"
+
 #include "ogs-core.h"
 
+#if HAVE_NETINET_UDP_H
+#include <netinet/udp.h>
+#endif
+
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __ogs_sock_domain
 
@@ -44,6 +50,13 @@ ogs_sock_t *ogs_udp_server(
             addr = addr->next;
             continue;
         }
+        if (option.so_reuseport) {
+            if (ogs_reuseport(new->fd, 1) != OGS_OK) {
+                ogs_sock_destroy(new);
+                addr = addr->next;
+                continue;
+            }
+        }
         if (ogs_sock_bind(new, addr) != OGS_OK) {
             ogs_sock_destroy(new);
             addr = addr->next;
@@ -143,3 +156,173 @@ int ogs_udp_connect(ogs_sock_t *sock, ogs_sockaddr_t *sa_list)
 
     return OGS_OK;
 }
+
+#if HAVE_RECVMMSG
+int ogs_recvmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num)
+{
+    struct mmsghdr msg[OGS_MAX_NUM_OF_MMSG];
+    struct iovec iov[OGS_MAX_NUM_OF_MMSG];
+    int i, n;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(from);
+    ogs_assert(num > 0 && num <= OGS_MAX_NUM_OF_MMSG);
+
+    memset(msg, 0, sizeof(msg[0]) * num);
+    for (i = 0; i < num; i++) {
+        ogs_assert(pkbuf[i]);
+
+        iov[i].iov_base = pkbuf[i]->data;
+        iov[i].iov_len = pkbuf[i]->len;
+
+        memset(&from[i], 0, sizeof from[i]);
+        msg[i].msg_hdr.msg_name = &from[i].sa;
+        msg[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    n = recvmmsg(fd, msg, num, MSG_DONTWAIT, NULL);
+    if (n <= 0)
+        return n;
+
+    for (i = 0; i < n; i++)
+        ogs_pkbuf_trim(pkbuf[i], msg[i].msg_len);
+
+    return n;
+}
+#else
+int ogs_recvmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num)
+{
+    ssize_t size;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(pkbuf[0]);
+    ogs_assert(from);
+    ogs_assert(num > 0);
+
+    size = ogs_recvfrom(fd, pkbuf[0]->data, pkbuf[0]->len, 0, &from[0]);
+    if (size <= 0)
+        return size;
+
+    ogs_pkbuf_trim(pkbuf[0], size);
+
+    return 1;
+}
+#endif
+
+#if HAVE_SENDMMSG
+int ogs_sendmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t **to, int num, bool gso)
+{
+    struct mmsghdr msg[OGS_MAX_NUM_OF_MMSG];
+    struct iovec iov[OGS_MAX_NUM_OF_MMSG];
+    int segs[OGS_MAX_NUM_OF_MMSG];
+#ifdef UDP_SEGMENT
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control[OGS_MAX_NUM_OF_MMSG];
+#endif
+    int i, j, nmsg, sent, done;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(to);
+    ogs_assert(num > 0 && num <= OGS_MAX_NUM_OF_MMSG);
+
+    memset(msg, 0, sizeof(msg[0]) * num);
+
+    nmsg = 0;
+    for (i = 0; i < num; i = j) {
+        size_t total = pkbuf[i]->len;
+
+        iov[i].iov_base = pkbuf[i]->data;
+        iov[i].iov_len = pkbuf[i]->len;
+
+        j = i + 1;
+#ifdef UDP_SEGMENT
+        /*
+         * UDP GSO : the kernel splits one large send into 'gso_size'
+         * datagrams, so only equal-length datagrams to the same peer
+         * can be coalesced. The payload is gathered from the pkbufs
+         * with an iovec, so no copy is made.
+         */
+        while (gso && j < num && pkbuf[j]->len == pkbuf[i]->len &&
+                total + pkbuf[j]->len <= 0xffff - 64 &&
+                ogs_sockaddr_is_equal(to[i], to[j])) {
+            iov[j].iov_base = pkbuf[j]->data;
+            iov[j].iov_len = pkbuf[j]->len;
+            total += pkbuf[j]->len;
+            j++;
+        }
+#endif
+
+        msg[nmsg].msg_hdr.msg_name = &to[i]->sa;
+        msg[nmsg].msg_hdr.msg_namelen = ogs_sockaddr_len(to[i]);
+        msg[nmsg].msg_hdr.msg_iov = &iov[i];
+        msg[nmsg].msg_hdr.msg_iovlen = j - i;
+        segs[nmsg] = j - i;
+
+#ifdef UDP_SEGMENT
+        if (j - i > 1) {
+            struct cmsghdr *cm = NULL;
+            uint16_t gso_size = pkbuf[i]->len;
+
+            memset(&control[nmsg], 0, sizeof(control[nmsg]));
+            msg[nmsg].msg_hdr.msg_control = control[nmsg].buf;
+            msg[nmsg].msg_hdr.msg_controllen = sizeof(control[nmsg].buf);
+
+            cm = CMSG_FIRSTHDR(&msg[nmsg].msg_hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+        }
+#endif
+        nmsg++;
+    }
+
+    done = 0;
+    sent = 0;
+    while (done < nmsg) {
+        int n = sendmmsg(fd, &msg[done], nmsg - done, 0);
+        if (n <= 0) {
+            if (sent)
+                break;
+            return -1;
+        }
+
+        for (i = done; i < done + n; i++)
+            sent += segs[i];
+        done += n;
+    }
+
+    return sent;
+}
+#else
+int ogs_sendmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t **to, int num, bool gso)
+{
+    int i, sent = 0;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(to);
+
+    for (i = 0; i < num; i++) {
+        if (ogs_sendto(fd, pkbuf[i]->data, pkbuf[i]->len, 0, to[i]) < 0) {
+            if (sent)
+                break;
+            return -1;
+        }
+        sent++;
+    }
+
+    return sent;
+}
+#endif
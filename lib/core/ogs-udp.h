@@ -34,6 +34,29 @@ ogs_sock_t *ogs_udp_client(
         ogs_sockaddr_t *sa_list, ogs_sockopt_t *socket_option);
 int ogs_udp_connect(ogs_sock_t *sock, ogs_sockaddr_t *sa_list);
 
+/*
+ * Batched datagram I/O
+ *
+ * ogs_recvmmsg() drains up to 'num' datagrams in a single system call.
+ * Each pkbuf must be prepared with ogs_pkbuf_put() to its full capacity,
+ * and is trimmed to the received length. Returns the number of datagrams
+ * received, or -1 on error (errno is preserved).
+ *
+ * ogs_sendmmsg() transmits 'num' datagrams, pkbuf[i] to to[i].
+ * If 'gso' is true, consecutive datagrams to the same destination with
+ * the same length are coalesced into one UDP_SEGMENT(GSO) message.
+ * Returns the number of datagrams sent, or -1 on error.
+ *
+ * Where recvmmsg()/sendmmsg() are not available, both fall back to
+ * one recvfrom()/sendto() per datagram.
+ */
+#define OGS_MAX_NUM_OF_MMSG 64
+
+int ogs_recvmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num);
+int ogs_sendmmsg(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t **to, int num, bool gso);
+
 #ifdef __cplusplus
 }
 #endif
@@ -57,8 +57,7 @@
     +                                                                   +
     +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 
-static int _generate_subkey(uint8_t *k1, uint8_t *k2,
-        const uint8_t *key)
+int ogs_aes_cmac_setup(ogs_aes_cmac_ctx_t *ctx, const uint8_t *key)
 {
     uint8_t zero[16] = {
         0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
@@ -69,13 +68,18 @@ static int _generate_subkey(uint8_t *k1, uint8_t *k2,
         0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x87
     };
     uint8_t L[16];
+    uint8_t *k1, *k2;
+    int i;
 
-    uint32_t rk[OGS_AES_RKLENGTH(OGS_AES_MAX_KEY_BITS)];
-    int i, nrounds;
+    ogs_assert(ctx);
+    ogs_assert(key);
+
+    k1 = ctx->k1;
+    k2 = ctx->k2;
 
     /* Step 1.  L := AES-128(K, const_Zero) */
-    nrounds = ogs_aes_setup_enc(rk, key, 128);
-    ogs_aes_encrypt(rk, nrounds, zero, L);
+    ctx->nrounds = ogs_aes_setup_enc(ctx->rk, key, 128);
+    ogs_aes_encrypt(ctx->rk, ctx->nrounds, zero, L);
 
     /* Step 2.  if MSB(L) is equal to 0 */
     if ((L[0] & 0x80) == 0)
@@ -163,23 +167,37 @@ static int _generate_subkey(uint8_t *k1, uint8_t *k2,
 
 int ogs_aes_cmac_calculate(uint8_t *cmac, const uint8_t *key,
         const uint8_t *msg, const uint32_t len)
+{
+    ogs_aes_cmac_ctx_t ctx;
+
+    ogs_assert(cmac);
+    ogs_assert(key);
+    ogs_assert(msg);
+
+    /* Step 1.  (K1,K2) := Generate_Subkey(K); */
+    ogs_aes_cmac_setup(&ctx, key);
+
+    return ogs_aes_cmac_calculate_ctx(&ctx, cmac, msg, len);
+}
+
+int ogs_aes_cmac_calculate_ctx(ogs_aes_cmac_ctx_t *ctx,
+        uint8_t *cmac, const uint8_t *msg, const uint32_t len)
 {
     uint8_t x[16] = {
         0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
         0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
     };
     uint8_t y[16], m_last[16];
-    uint8_t k1[16], k2[16];
+    const uint8_t *k1, *k2;
     int i, j, n, bs, flag;
-    uint32_t rk[OGS_AES_RKLENGTH(OGS_AES_MAX_KEY_BITS)];
-    int nrounds;
 
+    ogs_assert(ctx);
     ogs_assert(cmac);
-    ogs_assert(key);
     ogs_assert(msg);
 
-    /* Step 1.  (K1,K2) := Generate_Subkey(K); */
-    _generate_subkey(k1, k2, key);
+    /* Step 1.  (K1,K2) are cached in the context */
+    k1 = ctx->k1;
+    k2 = ctx->k2;
 
     /* Step 2.  n := ceil(len/const_Bsize); */
     n = (len + 15) / OGS_AES_BLOCK_SIZE;
@@ -239,20 +257,17 @@ int ogs_aes_cmac_calculate(uint8_t *cmac, const uint8_t *key,
                 T := AES-128(K,Y);
      */
 
-    nrounds = ogs_aes_setup_enc(rk, key, 128);
-
     for (i = 0; i <= n - 2; i++)
     {
         bs = i * OGS_AES_BLOCK_SIZE;
         for (j = 0; j < 16; j++)
             y[j] = x[j] ^ msg[bs + j];
-        ogs_aes_encrypt(rk, nrounds, y, x);
+        ogs_aes_encrypt(ctx->rk, ctx->nrounds, y, x);
     }
 
-    bs = (n - 1) * OGS_AES_BLOCK_SIZE;
     for (j = 0; j < 16; j++)
         y[j] = m_last[j] ^ x[j];
-    ogs_aes_encrypt(rk, nrounds, y, cmac);
+    ogs_aes_encrypt(ctx->rk, ctx->nrounds, y, cmac);
 
     return OGS_OK;
 }
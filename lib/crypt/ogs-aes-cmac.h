@@ -36,6 +36,21 @@
 extern "C" {
 #endif
 
+/*
+ * The AES key schedule and the subkeys K1/K2 of RFC 4493,
+ * which only depend on the key and can be kept across messages.
+ */
+typedef struct ogs_aes_cmac_ctx_s {
+    uint32_t rk[OGS_AES_RKLENGTH(128)];
+    int nrounds;
+    uint8_t k1[OGS_AES_BLOCK_SIZE];
+    uint8_t k2[OGS_AES_BLOCK_SIZE];
+} ogs_aes_cmac_ctx_t;
+
+int ogs_aes_cmac_setup(ogs_aes_cmac_ctx_t *ctx, const uint8_t *key);
+int ogs_aes_cmac_calculate_ctx(ogs_aes_cmac_ctx_t *ctx,
+        uint8_t *cmac, const uint8_t *msg, const uint32_t len);
+
 /**
  * Caculate CMAC value
  *
@@ -63,6 +63,10 @@ int ogs_aes_cbc_decrypt(const uint8_t *key,
 int ogs_aes_ctr128_encrypt(const uint8_t *key,
         uint8_t *ivec, const uint8_t *in, const uint32_t inlen,
         uint8_t *out);
+/* Same as above with a key schedule from ogs_aes_setup_enc() */
+int ogs_aes_ctr128_encrypt_rk(const uint32_t *rk, int nrounds,
+        uint8_t *ivec, const uint8_t *in, const uint32_t inlen,
+        uint8_t *out);
 
 #ifdef __cplusplus
 }
@@ -15,16 +15,28 @@ typedef uint8_t u8;
 typedef uint32_t u32;
 typedef uint64_t u64;
 
+/* State of the cipher: the LFSR S0..S15 and the FSM registers R1..R3.
+* Every function takes its state from the caller, so that the cipher can be
+* used from several threads at once.
+*/
+
+typedef struct snow_3g_ctx_s {
+	u32 s[16];
+	u32 r1, r2, r3;
+} snow_3g_ctx_t;
+
 /* Initialization.
+* Input ctx: the state of the cipher.
 * Input k[4]: Four 32-bit words making up 128-bit key.
 * Input IV[4]: Four 32-bit words making 128-bit initialization variable.
 * Output: All the LFSRs and FSM are initialized for key generation.
 * See Section 4.1.
 */
 
-void snow_3g_initialize(u32 k[4], u32 IV[4]);
+void snow_3g_initialize(snow_3g_ctx_t *ctx, u32 k[4], u32 IV[4]);
 
 /* Generation of Keystream.
+* Input ctx: the state of the cipher, initialized by snow_3g_initialize().
 * input n: number of 32-bit words of keystream.
 * input z: space for the generated keystream, assumes
 * memory is allocated already.
@@ -32,7 +44,7 @@ void snow_3g_initialize(u32 k[4], u32 IV[4]);
 * See section 4.2.
 */
 
-void snow_3g_generate_key_stream(u32 n, u32 *z);
+void snow_3g_generate_key_stream(snow_3g_ctx_t *ctx, u32 n, u32 *z);
 
 /* f8.
 * Input key: 128 bit Confidentiality Key.
@@ -3,51 +3,15 @@
  *--------------------------------------------*/
 #include "zuc.h"
 
-u32 AddM(u32 a, u32 b);
-void LFSRWithInitialisationMode(u32 u);
-void LFSRWithWorkMode(void);
-void BitReorganization(void);
-u32 L1(u32 X);
-u32 L2(u32 X);
-u32 F(void);
-void ZUC(u8* k, u8* iv, u32* ks, u32 len);
-u32 GET_WORD(u32 * DATA, u32 i);
-u8 GET_BIT(u8 * DATA, u32 i);
-
 /*--------------------------------------------
  * ZUC keystream generator algorithm
  *------------------------------------------*/
 
-/* the state registers of LFSR */ 
-static u32 LFSR_S0;
-static u32 LFSR_S1;
-static u32 LFSR_S2;
-static u32 LFSR_S3;
-static u32 LFSR_S4;
-static u32 LFSR_S5;
-static u32 LFSR_S6;
-static u32 LFSR_S7;
-static u32 LFSR_S8;
-static u32 LFSR_S9;
-static u32 LFSR_S10;
-static u32 LFSR_S11;
-static u32 LFSR_S12;
-static u32 LFSR_S13;
-static u32 LFSR_S14;
-static u32 LFSR_S15;
-
-/* the registers of F */
-static u32 F_R1;
-static u32 F_R2;
-
-/* the outputs of BitReorganization */
-static u32 BRC_X0;
-static u32 BRC_X1;
-static u32 BRC_X2;
-static u32 BRC_X3;
+/* The state registers of the LFSR and F live in zuc_ctx_t,
+ * so that the functions below are reentrant. */
 
 /* the s-boxes */ 
-static u8 S0[256] = {
+static const u8 S0[256] = {
 0x3e,0x72,0x5b,0x47,0xca,0xe0,0x00,0x33,0x04,0xd1,0x54,0x98,0x09,0xb9,0x6d,0xcb,
 0x7b,0x1b,0xf9,0x32,0xaf,0x9d,0x6a,0xa5,0xb8,0x2d,0xfc,0x1d,0x08,0x53,0x03,0x90,
 0x4d,0x4e,0x84,0x99,0xe4,0xce,0xd9,0x91,0xdd,0xb6,0x85,0x48,0x8b,0x29,0x6e,0xac,
@@ -66,7 +30,7 @@ static u8 S0[256] = {
 0x8d,0x27,0x1a,0xdb,0x81,0xb3,0xa0,0xf4,0x45,0x7a,0x19,0xdf,0xee,0x78,0x34,0x60
 }; 
 
-static u8 S1[256] =  {
+static const u8 S1[256] =  {
 0x55,0xc2,0x63,0x71,0x3b,0xc8,0x47,0x86,0x9f,0x3c,0xda,0x5b,0x29,0xaa,0xfd,0x77,
 0x8c,0xc5,0x94,0x0c,0xa6,0x1a,0x13,0x00,0xe3,0xa8,0x16,0x72,0x40,0xf9,0xf8,0x42,
 0x44,0x26,0x68,0x96,0x81,0xd9,0x45,0x3e,0x10,0x76,0xc6,0xa7,0x8b,0x39,0x43,0xe1,
@@ -86,196 +50,148 @@ static u8 S1[256] =  {
 };
  
 /* the constants D */
-static u32 EK_d[16] = {
+static const u32 EK_d[16] = {
 0x44D7, 0x26BC, 0x626B, 0x135E, 0x5789, 0x35E2, 0x7135, 0x09AF,
 0x4D78, 0x2F13, 0x6BC4, 0x1AF1, 0x5E26, 0x3C4D, 0x789A, 0x47AC
 };
 
 /* c = a + b mod (2^31 - 1) */
-u32 AddM(u32 a, u32 b)
+static u32 AddM(u32 a, u32 b)
 {
 	u32 c = a + b;
 	return (c & 0x7FFFFFFF) + (c >> 31);
 }
 
-/* LFSR with initialization mode */
 #define MulByPow2(x, k) ((((x) << k) | ((x) >> (31 - k))) & 0x7FFFFFFF)
-void LFSRWithInitialisationMode(u32 u)
-{
-	u32 f, v;
-	f = LFSR_S0;
-	
-	v = MulByPow2(LFSR_S0, 8);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S4, 20);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S10, 21);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S13, 17);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S15, 15);
-	f = AddM(f, v);
-	
-	f = AddM(f, u);
-	
-	/* update the state */
-	LFSR_S0 = LFSR_S1;
-	LFSR_S1 = LFSR_S2;
-	LFSR_S2 = LFSR_S3;
-	LFSR_S3 = LFSR_S4;
-	LFSR_S4 = LFSR_S5;
-	LFSR_S5 = LFSR_S6;
-	LFSR_S6 = LFSR_S7;
-	LFSR_S7 = LFSR_S8;
-	LFSR_S8 = LFSR_S9;
-	LFSR_S9 = LFSR_S10;
-	LFSR_S10 = LFSR_S11;
-	LFSR_S11 = LFSR_S12;
-	LFSR_S12 = LFSR_S13;
-	LFSR_S13 = LFSR_S14;
-	LFSR_S14 = LFSR_S15;
-	LFSR_S15 = f;
-}
-
-/* LFSR with work mode */
-void LFSRWithWorkMode(void)
-{
-	u32 f, v;
-	f = LFSR_S0;
-	
-	v = MulByPow2(LFSR_S0, 8);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S4, 20);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S10, 21);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S13, 17);
-	f = AddM(f, v);
-	v = MulByPow2(LFSR_S15, 15);
-	f = AddM(f, v);
-	
-	/* update the state */
-	LFSR_S0 = LFSR_S1;
-	LFSR_S1 = LFSR_S2;
-	LFSR_S2 = LFSR_S3;
-	LFSR_S3 = LFSR_S4;
-	LFSR_S4 = LFSR_S5;
-	LFSR_S5 = LFSR_S6;
-	LFSR_S6 = LFSR_S7;
-	LFSR_S7 = LFSR_S8;
-	LFSR_S8 = LFSR_S9;
-	LFSR_S9 = LFSR_S10;
-	LFSR_S10 = LFSR_S11;
-	LFSR_S11 = LFSR_S12;
-	LFSR_S12 = LFSR_S13;
-	LFSR_S13 = LFSR_S14;
-	LFSR_S14 = LFSR_S15;
-	LFSR_S15 = f;
-}
-
-/* BitReorganization */
-void BitReorganization(void)
-{
-	BRC_X0 = ((LFSR_S15 & 0x7FFF8000) << 1) | (LFSR_S14 & 0xFFFF);
-	BRC_X1 = ((LFSR_S11 & 0xFFFF) << 16) | (LFSR_S9 >> 15);
-	BRC_X2 = ((LFSR_S7 & 0xFFFF) << 16) | (LFSR_S5 >> 15);
-	BRC_X3 = ((LFSR_S2 & 0xFFFF) << 16) | (LFSR_S0 >> 15);
-}
 
 #define ROT(a, k) (((a) << k) | ((a) >> (32 - k)))
 
 /* L1 */
-u32 L1(u32 X)
-{
-	return (X ^ ROT(X, 2) ^ ROT(X, 10) ^ ROT(X, 18) ^ ROT(X, 24));
-}
+#define L1(X) ((X) ^ ROT((X), 2) ^ ROT((X), 10) ^ ROT((X), 18) ^ ROT((X), 24))
 
 /* L2 */
-u32 L2(u32 X)
-{
-	return (X ^ ROT(X, 8) ^ ROT(X, 14) ^ ROT(X, 22) ^ ROT(X, 30));
-}
+#define L2(X) ((X) ^ ROT((X), 8) ^ ROT((X), 14) ^ ROT((X), 22) ^ ROT((X), 30))
 
 #define MAKEU32(a, b, c, d) (((u32)(a) << 24) | ((u32)(b) << 16) | ((u32)(c) << 8) | ((u32)(d)))
+
 /* F */
-u32 F(void)
+static u32 F(zuc_ctx_t *ctx, u32 X0, u32 X1, u32 X2)
 {
 	u32 W, W1, W2, u, v;
 	
-	W  = (BRC_X0 ^ F_R1) + F_R2;
-	W1 = F_R1 + BRC_X1;
-	W2 = F_R2 ^ BRC_X2;
+	W  = (X0 ^ ctx->r1) + ctx->r2;
+	W1 = ctx->r1 + X1;
+	W2 = ctx->r2 ^ X2;
 	
 	u = L1((W1 << 16) | (W2 >> 16));
 	v = L2((W2 << 16) | (W1 >> 16));
 	
-	F_R1 = MAKEU32(S0[u >> 24], S1[(u >> 16) & 0xFF],
+	ctx->r1 = MAKEU32(S0[u >> 24], S1[(u >> 16) & 0xFF],
 	S0[(u >> 8) & 0xFF], S1[u & 0xFF]);
-	F_R2 = MAKEU32(S0[v >> 24], S1[(v >> 16) & 0xFF],
+	ctx->r2 = MAKEU32(S0[v >> 24], S1[(v >> 16) & 0xFF],
 	S0[(v >> 8) & 0xFF], S1[v & 0xFF]);
 	
 	return W;
 }
 
+/* The LFSR is used as a ring buffer. At the t-th clock of a round of 16,
+ * S_i is s[(t+i) % 16] and the new S15 replaces S0 in s[t]. After 16 clocks
+ * the register is in order again, so fully unrolled rounds move no data. */
+#define S(t, i) ctx->s[((t) + (i)) & 15]
+
+/* BitReorganization */
+#define BRC_X0(t) (((S(t, 15) & 0x7FFF8000) << 1) | (S(t, 14) & 0xFFFF))
+#define BRC_X1(t) (((S(t, 11) & 0xFFFF) << 16) | (S(t, 9) >> 15))
+#define BRC_X2(t) (((S(t, 7) & 0xFFFF) << 16) | (S(t, 5) >> 15))
+#define BRC_X3(t) (((S(t, 2) & 0xFFFF) << 16) | (S(t, 0) >> 15))
+
+/* LFSR with work mode */
+static u32 LFSRFeedback(u32 s0, u32 s4, u32 s10, u32 s13, u32 s15)
+{
+	u32 f = s0;
+	
+	f = AddM(f, MulByPow2(s0, 8));
+	f = AddM(f, MulByPow2(s4, 20));
+	f = AddM(f, MulByPow2(s10, 21));
+	f = AddM(f, MulByPow2(s13, 17));
+	f = AddM(f, MulByPow2(s15, 15));
+
+	return f;
+}
+#define LFSR_FEEDBACK(t) \
+	LFSRFeedback(S(t, 0), S(t, 4), S(t, 10), S(t, 13), S(t, 15))
+
+/* LFSR with initialization mode */
+#define CLOCK_INIT(t) do { \
+	u32 __w = F(ctx, BRC_X0(t), BRC_X1(t), BRC_X2(t)); \
+	S(t, 0) = AddM(LFSR_FEEDBACK(t), __w >> 1); \
+} while (0)
+
+#define CLOCK_WORK(t, z) do { \
+	(z) = F(ctx, BRC_X0(t), BRC_X1(t), BRC_X2(t)) ^ BRC_X3(t); \
+	S(t, 0) = LFSR_FEEDBACK(t); \
+} while (0)
+
+/* A single clock in work mode for the words which do not fill a whole
+ * round. The LFSR is shifted to keep S0 in s[0]. */
+static u32 clock_work_single(zuc_ctx_t *ctx)
+{
+	u32 z, f;
+
+	CLOCK_WORK(0, z);
+	f = ctx->s[0];
+	memmove(&ctx->s[0], &ctx->s[1], 15 * sizeof(u32));
+	ctx->s[15] = f;
+
+	return z;
+}
+
 #define MAKEU31(a, b, c) (((u32)(a) << 23) | ((u32)(b) << 8) | (u32)(c))
 /* initialize */
-void zuc_initialize(u8* k, u8* iv)
+void zuc_initialize(zuc_ctx_t *ctx, u8* k, u8* iv)
 {
-	u32 w, nCount;
+	int i;
 
 	/* expand key */
-	LFSR_S0 = MAKEU31(k[0], EK_d[0], iv[0]);
-	LFSR_S1 = MAKEU31(k[1], EK_d[1], iv[1]);
-	LFSR_S2 = MAKEU31(k[2], EK_d[2], iv[2]);
-	LFSR_S3 = MAKEU31(k[3], EK_d[3], iv[3]);
-	LFSR_S4 = MAKEU31(k[4], EK_d[4], iv[4]);
-	LFSR_S5 = MAKEU31(k[5], EK_d[5], iv[5]);
-	LFSR_S6 = MAKEU31(k[6], EK_d[6], iv[6]);
-	LFSR_S7 = MAKEU31(k[7], EK_d[7], iv[7]);
-	LFSR_S8 = MAKEU31(k[8], EK_d[8], iv[8]);
-	LFSR_S9 = MAKEU31(k[9], EK_d[9], iv[9]);
-	LFSR_S10 = MAKEU31(k[10], EK_d[10], iv[10]);
-	LFSR_S11 = MAKEU31(k[11], EK_d[11], iv[11]);
-	LFSR_S12 = MAKEU31(k[12], EK_d[12], iv[12]);
-	LFSR_S13 = MAKEU31(k[13], EK_d[13], iv[13]);
-	LFSR_S14 = MAKEU31(k[14], EK_d[14], iv[14]);
-	LFSR_S15 = MAKEU31(k[15], EK_d[15], iv[15]);
+	for (i = 0; i < 16; i++)
+		ctx->s[i] = MAKEU31(k[i], EK_d[i], iv[i]);
 
 	/* set F_R1 and F_R2 to zero */
-	F_R1 = 0;
-	F_R2 = 0;
-	nCount = 32;
-	while (nCount > 0)
+	ctx->r1 = 0;
+	ctx->r2 = 0;
+
+	/* 32 clocks, i.e. two rounds of 16 */
+	for (i = 0; i < 2; i++)
 	{
-		BitReorganization();
-		w = F();
-		LFSRWithInitialisationMode(w >> 1);
-		nCount --;
+		CLOCK_INIT(0); CLOCK_INIT(1); CLOCK_INIT(2); CLOCK_INIT(3);
+		CLOCK_INIT(4); CLOCK_INIT(5); CLOCK_INIT(6); CLOCK_INIT(7);
+		CLOCK_INIT(8); CLOCK_INIT(9); CLOCK_INIT(10); CLOCK_INIT(11);
+		CLOCK_INIT(12); CLOCK_INIT(13); CLOCK_INIT(14); CLOCK_INIT(15);
 	}
+
+	/* discard the output of F */
+	clock_work_single(ctx);
 }
 
-void zuc_generate_key_stream(u32* pKeystream, u32 KeystreamLen)
+void zuc_generate_key_stream(zuc_ctx_t *ctx, u32* pKeystream, u32 KeystreamLen)
 {
-	int i;
-	BitReorganization();
-	F(); 			/* discard the output of F */
-	LFSRWithWorkMode();
-	
-	for (i = 0; i < KeystreamLen; i ++)
+	u32 *ks = pKeystream;
+	u32 n = KeystreamLen;
+
+	for ( ; n >= 16; n -= 16, ks += 16)
 	{
-		BitReorganization();
-		pKeystream[i] = F() ^ BRC_X3;
-		LFSRWithWorkMode();
+		CLOCK_WORK(0, ks[0]); CLOCK_WORK(1, ks[1]);
+		CLOCK_WORK(2, ks[2]); CLOCK_WORK(3, ks[3]);
+		CLOCK_WORK(4, ks[4]); CLOCK_WORK(5, ks[5]);
+		CLOCK_WORK(6, ks[6]); CLOCK_WORK(7, ks[7]);
+		CLOCK_WORK(8, ks[8]); CLOCK_WORK(9, ks[9]);
+		CLOCK_WORK(10, ks[10]); CLOCK_WORK(11, ks[11]);
+		CLOCK_WORK(12, ks[12]); CLOCK_WORK(13, ks[13]);
+		CLOCK_WORK(14, ks[14]); CLOCK_WORK(15, ks[15]);
 	}
-}
 
-/* The ZUC algorithm, see ref. [3]*/
-void ZUC(u8* k, u8* iv, u32* ks, u32 len)
-{
-	/* The initialization of ZUC, see page 17 of ref. [3]*/
-	zuc_initialize(k, iv);
-	/*  The procedure of generating keystream of ZUC, see page 18 of ref. [3]*/
-	zuc_generate_key_stream(ks, len);
+	for ( ; n > 0; n--)
+		*ks++ = clock_work_single(ctx);
 }
 /* end of ZUC.c */
 
@@ -286,19 +202,21 @@ void ZUC(u8* k, u8* iv, u32* ks, u32 len)
 /*
  * EEA3: LTE Encryption Algorithm 3
  * EEA3.c
+ *
+ * The keystream is produced 16 words at a time on the stack
+ * and only the bytes covered by LENGTH are read and written.
 */
 void zuc_eea3(u8* CK, u32 COUNT, u32 BEARER, u32 DIRECTION, 
 				   u32 LENGTH, u8* M, u8* C)
 {
-	u32 *z, L, L8, i;
+	zuc_ctx_t ctx;
+	u32 z[16], L8, i, n;
 	u8 	IV[16];
 	u32 lastbits = (8-(LENGTH%8))%8;
-    
-	L 	= (LENGTH+31)/32;
-	z 	= (u32 *) ogs_malloc(L*sizeof(u32));
-    ogs_assert(z);
+	u8 *last;
     
 	L8 	= (LENGTH+7)/8;
+	last = C + L8 - 1;
 	
 	IV[0]	= (COUNT>>24) & 0xFF;
 	IV[1]	= (COUNT>>16) & 0xFF;
@@ -320,26 +238,35 @@ void zuc_eea3(u8* CK, u32 COUNT, u32 BEARER, u32 DIRECTION,
 	IV[14]	= IV[6];
 	IV[15]	= IV[7];
 	
-	ZUC(CK, IV, z, L);
-	
-	for (i=0; i<L8; i++)
-    {
-		C[i] = M[i] ^ ((z[i/4] >> (3-i%4)*8) & 0xff);
-    }
+	zuc_initialize(&ctx, CK, IV);
+
+	while (L8 >= 64)
+	{
+		zuc_generate_key_stream(&ctx, z, 16);
+		for (i=0; i<16; i++, M += 4, C += 4)
+		{
+			C[0] = M[0] ^ (u8)(z[i] >> 24);
+			C[1] = M[1] ^ (u8)(z[i] >> 16);
+			C[2] = M[2] ^ (u8)(z[i] >> 8);
+			C[3] = M[3] ^ (u8)(z[i]);
+		}
+		L8 -= 64;
+	}
 
-    /*
-     * Issues #3349
-     * Valgrind memcheck: Invalid read & write: Add {}.
-     */
+	if (L8)
+	{
+		n = (L8+3)/4;
+		zuc_generate_key_stream(&ctx, z, n);
+		for (i=0; i<L8; i++)
+		{
+			C[i] = M[i] ^ ((z[i/4] >> (3-i%4)*8) & 0xff);
+		}
+	}
 
 	/* zero last bits of data in case its length is not  word-aligned (32 bits)
 	   this is an addition to the C reference code, which did not handle it */
-	if (lastbits) {
-        i--;
-		C[i] &= 0x100 - (1<<lastbits);
-    }
-
-	ogs_free(z);
+	if (lastbits)
+		*last &= 0x100 - (1<<lastbits);
 }
 /* end of EEA3.c */
 
@@ -350,27 +277,32 @@ void zuc_eea3(u8* CK, u32 COUNT, u32 BEARER, u32 DIRECTION,
 /*
  * EIA3: LTE Integrity computation algorithm
  * EIA3.c
+ *
+ * The keystream is consumed as a sliding 64-bit window z_i || z_i+1,
+ * so that GET_WORD(z, 32*i + j) is the window shifted right by 32-j.
+ * Only the bits of the message which are set are visited.
 */
-u32 GET_WORD(u32 * DATA, u32 i)
-{
-	u32 WORD, ti;
-	ti	= i % 32;
-	if (ti == 0)
-		WORD = DATA[i/32];
-	else
-		WORD = (DATA[i/32]<<ti) | (DATA[i/32+1]>>(32-ti));
-	return WORD;
-}
 
-u8 GET_BIT(u8 * DATA, u32 i)
+/* Next keystream word, refilling the buffer 16 words at a time */
+#define NEXT_WORD(ctx, z, pos) ( \
+	((pos) == 16 ? (zuc_generate_key_stream((ctx), (z), 16), (pos) = 0) : 0), \
+	(z)[(pos)++] )
+
+static u32 fold_word(u32 T, u32 m, u64 window)
 {
-	return (DATA[i/8] & (1<<(7-(i%8)))) ? 1 : 0;
+	/* the lowest set bit of m is the bit j = 31 - ctz(m) of the message */
+	for ( ; m; m &= m-1)
+		T ^= (u32)(window >> (__builtin_ctz(m) + 1));
+
+	return T;
 }
 
 void zuc_eia3(u8* IK, u32 COUNT, u32 BEARER, u32 DIRECTION,
 				   u32 LENGTH, u8* M, u32* MAC)
 {
-	u32	*z, N, L, T, i;
+	zuc_ctx_t ctx;
+	u32 z[16], pos = 16;
+	u32 T, i, t, m, z0, z1;
 	u8 IV[16];
 
 	IV[0]	= (COUNT>>24) & 0xFF;
@@ -391,21 +323,35 @@ void zuc_eia3(u8* IK, u32 COUNT, u32 BEARER, u32 DIRECTION,
 	IV[14]	= IV[6] ^ ((DIRECTION&1)<<7);
 	IV[15]	= IV[7];
 	
-	N	= LENGTH + 64;
-	L	= (N + 31) / 32;
-	z	= (u32 *) ogs_malloc(L*sizeof(u32));
-    ogs_assert(z);
-	ZUC(IK, IV, z, L);
-	
+	zuc_initialize(&ctx, IK, IV);
+
+	z0 = NEXT_WORD(&ctx, z, pos);
+	z1 = NEXT_WORD(&ctx, z, pos);
+
 	T = 0;
-	for (i=0; i<LENGTH; i++) {
-		if (GET_BIT(M,i)) {
-			T ^= GET_WORD(z,i);
-		}
+	for (i=0; i<LENGTH/32; i++, M += 4) {
+		m = MAKEU32(M[0], M[1], M[2], M[3]);
+		T = fold_word(T, m, ((u64)z0 << 32) | z1);
+		z0 = z1;
+		z1 = NEXT_WORD(&ctx, z, pos);
+	}
+
+	/* the remaining bits of a partial word, z0 is now z_(LENGTH/32) */
+	t = LENGTH % 32;
+	if (t) {
+		m = 0;
+		for (i=0; i<(t+7)/8; i++)
+			m |= (u32)M[i] << (24-8*i);
+		m &= 0xFFFFFFFF << (32-t);
+		T = fold_word(T, m, ((u64)z0 << 32) | z1);
+
+		T ^= (z0 << t) | (z1 >> (32-t));
+		/* z_(L-1) is the word after z1 */
+		*MAC = T ^ NEXT_WORD(&ctx, z, pos);
+	} else {
+		T ^= z0;
+		/* z_(L-1) is z1 */
+		*MAC = T ^ z1;
 	}
-	T ^= GET_WORD(z,LENGTH);
-	
-	*MAC = T ^ z[L-1];
-	ogs_free(z);
 }
 /* end of EIA3.c */
@@ -20,16 +20,28 @@ extern "C" {
 /* type definition from */
 typedef uint8_t u8;
 typedef uint32_t u32;
+typedef uint64_t u64;
+
+/*
+ * State of the keystream generator: the LFSR S0..S15 and the registers
+ * R1, R2 of F. It is owned by the caller, so that ZUC is reentrant.
+*/
+typedef struct zuc_ctx_s {
+	u32 s[16];
+	u32 r1, r2;
+} zuc_ctx_t;
 
 /*
  * ZUC keystream generator
+ * ctx: state of the generator (output of zuc_initialize)
  * k: secret key (input, 16 bytes)
  * iv: initialization vector (input, 16 bytes)
  * Keystream: produced keystream (output, variable length)
- * KeystreamLen: length in bits requested for the keystream (input)
+ * KeystreamLen: number of 32-bit words requested for the keystream (input)
 */
-void zuc_initialize(u8* k, u8* iv);
-void zuc_generate_key_stream(u32* pKeystream, u32 KeystreamLen);
+void zuc_initialize(zuc_ctx_t *ctx, u8* k, u8* iv);
+void zuc_generate_key_stream(zuc_ctx_t *ctx,
+        u32* pKeystream, u32 KeystreamLen);
 
 /*
  * CK: ciphering key
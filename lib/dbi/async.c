@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-dbi.h"
+
+#define OGS_DBI_MAX_NUM_OF_THREAD 64
+#define OGS_DBI_MAX_NUM_OF_JOB 8192
+
+static struct {
+    int num_of_thread;
+    ogs_thread_t *thread[OGS_DBI_MAX_NUM_OF_THREAD];
+
+    ogs_queue_t *job_queue;
+
+    /* Where the completed jobs are posted */
+    ogs_queue_t *queue;
+    ogs_pollset_t *pollset;
+} self;
+
+static void job_post(ogs_dbi_job_t *job)
+{
+    ogs_event_t *e = NULL;
+    int rv;
+
+    e = ogs_event_new(OGS_EVENT_DBI);
+    ogs_assert(e);
+    e->dbi.job = job;
+
+    rv = ogs_queue_push(self.queue, e);
+    if (rv != OGS_OK) {
+        ogs_warn("ogs_queue_push() failed [%d]", (int)rv);
+        ogs_event_free(e);
+        ogs_dbi_job_free(job);
+        return;
+    }
+
+    if (self.pollset)
+        ogs_pollset_notify(self.pollset);
+}
+
+static void dbi_main(void *data)
+{
+    ogs_dbi_job_t *job = NULL;
+    int rv;
+
+    ogs_dbi_client_acquire();
+
+    for ( ;; ) {
+        rv = ogs_queue_pop(self.job_queue, (void **)&job);
+        if (rv == OGS_DONE)
+            break;
+        if (rv != OGS_OK)
+            continue;
+
+        /* NULL job : ogs_dbi_async_final() */
+        if (!job)
+            break;
+
+        job->handler(job);
+        job_post(job);
+    }
+
+    ogs_dbi_client_release();
+}
+
+int ogs_dbi_async_init(int num_of_thread,
+        ogs_queue_t *queue, ogs_pollset_t *pollset)
+{
+    int i;
+
+    ogs_assert(num_of_thread >= 0 &&
+            num_of_thread <= OGS_DBI_MAX_NUM_OF_THREAD);
+
+    memset(&self, 0, sizeof(self));
+
+    if (!num_of_thread)
+        return OGS_OK;
+
+    ogs_assert(queue);
+
+    self.queue = queue;
+    self.pollset = pollset;
+
+    self.job_queue = ogs_queue_create(OGS_DBI_MAX_NUM_OF_JOB);
+    ogs_assert(self.job_queue);
+
+    for (i = 0; i < num_of_thread; i++) {
+        self.thread[i] = ogs_thread_create(dbi_main, NULL);
+        if (!self.thread[i]) {
+            ogs_error("ogs_thread_create() failed");
+            ogs_dbi_async_final();
+            return OGS_ERROR;
+        }
+        self.num_of_thread++;
+    }
+
+    return OGS_OK;
+}
+
+void ogs_dbi_async_final(void)
+{
+    int i;
+
+    if (!self.job_queue)
+        return;
+
+    /*
+     * One NULL job per thread, behind the pending ones,
+     * so that every submitted job still gets posted back.
+     */
+    for (i = 0; i < self.num_of_thread; i++)
+        ogs_assert(OGS_OK == ogs_queue_push(self.job_queue, NULL));
+
+    for (i = 0; i < self.num_of_thread; i++)
+        ogs_thread_destroy(self.thread[i]);
+
+    ogs_queue_destroy(self.job_queue);
+
+    memset(&self, 0, sizeof(self));
+}
+
+void *ogs_dbi_job_size(size_t size,
+        ogs_dbi_job_f handler, ogs_dbi_job_f complete)
+{
+    ogs_dbi_job_t *job = NULL;
+
+    ogs_assert(size >= sizeof(ogs_dbi_job_t));
+    ogs_assert(handler);
+    ogs_assert(complete);
+
+    job = ogs_calloc(1, size);
+    if (!job) {
+        ogs_error("ogs_calloc() failed");
+        return NULL;
+    }
+
+    job->handler = handler;
+    job->complete = complete;
+
+    return job;
+}
+
+void ogs_dbi_job_free(ogs_dbi_job_t *job)
+{
+    ogs_assert(job);
+    ogs_free(job);
+}
+
+int ogs_dbi_job_submit(ogs_dbi_job_t *job)
+{
+    int rv;
+
+    ogs_assert(job);
+
+    if (!self.job_queue) {
+        job->handler(job);
+        ogs_dbi_job_complete(job);
+        return OGS_OK;
+    }
+
+    /* Never block the NF thread */
+    rv = ogs_queue_trypush(self.job_queue, job);
+    if (rv != OGS_OK) {
+        ogs_error("ogs_queue_push() failed [%d]", (int)rv);
+        return OGS_ERROR;
+    }
+
+    return OGS_OK;
+}
+
+void ogs_dbi_job_complete(ogs_dbi_job_t *job)
+{
+    ogs_assert(job);
+
+    job->complete(job);
+    ogs_dbi_job_free(job);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_DBI_INSIDE) && !defined(OGS_DBI_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_DBI_ASYNC_H
+#define OGS_DBI_ASYNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OGS_DBI_DEFAULT_NUM_OF_THREAD 4
+
+/*
+ * Asynchronous DBI
+ *
+ * The NF embeds ogs_dbi_job_t at the head of its own job structure,
+ * like the events. job->handler runs on a DBI thread with a pooled client
+ * and calls the blocking ogs_dbi_xxx() functions. The job then comes back
+ * to the NF thread as an OGS_EVENT_DBI event on the given queue, where
+ * the NF calls ogs_dbi_job_complete() to run job->complete and free it.
+ *
+ * A job that cannot be posted back (queue terminated) is freed without
+ * calling job->complete, so it must not own any other memory.
+ *
+ * Without DBI threads (num_of_thread == 0), ogs_dbi_job_submit()
+ * runs both callbacks in place.
+ */
+typedef struct ogs_dbi_job_s ogs_dbi_job_t;
+typedef void (*ogs_dbi_job_f)(ogs_dbi_job_t *job);
+
+struct ogs_dbi_job_s {
+    ogs_dbi_job_f handler;      /* on a DBI thread */
+    ogs_dbi_job_f complete;     /* on the NF thread */
+};
+
+int ogs_dbi_async_init(int num_of_thread,
+        ogs_queue_t *queue, ogs_pollset_t *pollset);
+void ogs_dbi_async_final(void);
+
+void *ogs_dbi_job_size(size_t size,
+        ogs_dbi_job_f handler, ogs_dbi_job_f complete);
+void ogs_dbi_job_free(ogs_dbi_job_t *job);
+
+int ogs_dbi_job_submit(ogs_dbi_job_t *job);
+void ogs_dbi_job_complete(ogs_dbi_job_t *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_DBI_ASYNC_H */
@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-dbi.h"
+
+typedef struct cache_entry_s {
+    ogs_lnode_t lnode;          /* LRU list, most recently used first */
+
+    char *supi;
+    ogs_time_t expires;
+
+    ogs_subscription_data_t subscription_data;
+} cache_entry_t;
+
+static struct {
+    bool enabled;
+
+    int size;
+    ogs_time_t ttl;
+
+    ogs_thread_mutex_t mutex;
+    ogs_hash_t *hash;
+    ogs_list_t lru_list;
+
+    ogs_dbi_cache_stat_t stat;
+} self;
+
+static void entry_remove(cache_entry_t *entry)
+{
+    ogs_assert(entry);
+
+    ogs_hash_set(self.hash, entry->supi, OGS_HASH_KEY_STRING, NULL);
+    ogs_list_remove(&self.lru_list, entry);
+
+    ogs_subscription_data_free(&entry->subscription_data);
+    ogs_free(entry->supi);
+    ogs_free(entry);
+
+    self.stat.count--;
+}
+
+static void entry_remove_all(void)
+{
+    cache_entry_t *entry = NULL, *next_entry = NULL;
+
+    ogs_list_for_each_safe(&self.lru_list, next_entry, entry)
+        entry_remove(entry);
+}
+
+int ogs_dbi_cache_init(int size, ogs_time_t ttl)
+{
+    ogs_assert(size > 0);
+    ogs_assert(ttl >= 0);
+
+    memset(&self, 0, sizeof(self));
+
+    self.size = size;
+    self.ttl = ttl;
+
+    ogs_thread_mutex_init(&self.mutex);
+    self.hash = ogs_hash_make();
+    ogs_assert(self.hash);
+    ogs_list_init(&self.lru_list);
+
+    self.enabled = true;
+
+    ogs_info("Subscriber cache [size:%d, ttl:%lld sec]",
+            size, (long long)ogs_time_sec(ttl));
+
+    return OGS_OK;
+}
+
+void ogs_dbi_cache_final(void)
+{
+    if (!self.enabled)
+        return;
+
+    self.enabled = false;
+
+    entry_remove_all();
+
+    ogs_hash_destroy(self.hash);
+    ogs_thread_mutex_destroy(&self.mutex);
+}
+
+bool ogs_dbi_cache_enabled(void)
+{
+    return self.enabled;
+}
+
+bool ogs_dbi_cache_get(const char *supi,
+        ogs_subscription_data_t *subscription_data)
+{
+    cache_entry_t *entry = NULL;
+
+    ogs_assert(supi);
+    ogs_assert(subscription_data);
+
+    if (!self.enabled)
+        return false;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    entry = ogs_hash_get(self.hash, supi, OGS_HASH_KEY_STRING);
+    if (entry && self.ttl && entry->expires < ogs_get_monotonic_time()) {
+        entry_remove(entry);
+        entry = NULL;
+    }
+
+    if (!entry) {
+        self.stat.miss++;
+        ogs_thread_mutex_unlock(&self.mutex);
+        return false;
+    }
+
+    ogs_list_remove(&self.lru_list, entry);
+    ogs_list_prepend(&self.lru_list, entry);
+
+    ogs_subscription_data_copy(subscription_data, &entry->subscription_data);
+    self.stat.hit++;
+
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return true;
+}
+
+void ogs_dbi_cache_put(const char *supi,
+        const ogs_subscription_data_t *subscription_data)
+{
+    cache_entry_t *entry = NULL;
+
+    ogs_assert(supi);
+    ogs_assert(subscription_data);
+
+    if (!self.enabled)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    entry = ogs_hash_get(self.hash, supi, OGS_HASH_KEY_STRING);
+    if (entry) {
+        /* Another thread has loaded the same SUPI. Keep the newer one */
+        ogs_list_remove(&self.lru_list, entry);
+        ogs_subscription_data_free(&entry->subscription_data);
+    } else {
+        if (self.stat.count >= self.size) {
+            entry_remove(ogs_list_last(&self.lru_list));
+            self.stat.eviction++;
+        }
+
+        entry = ogs_calloc(1, sizeof(*entry));
+        ogs_assert(entry);
+        entry->supi = ogs_strdup(supi);
+        ogs_assert(entry->supi);
+
+        ogs_hash_set(self.hash, entry->supi, OGS_HASH_KEY_STRING, entry);
+        self.stat.count++;
+    }
+
+    ogs_subscription_data_copy(&entry->subscription_data, subscription_data);
+    entry->expires = ogs_get_monotonic_time() + self.ttl;
+
+    ogs_list_prepend(&self.lru_list, entry);
+
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+void ogs_dbi_cache_update_mme(const char *supi,
+        const char *mme_host, const char *mme_realm, bool purge_flag)
+{
+    cache_entry_t *entry = NULL;
+    ogs_subscription_data_t *subscription_data = NULL;
+
+    ogs_assert(supi);
+
+    if (!self.enabled)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    entry = ogs_hash_get(self.hash, supi, OGS_HASH_KEY_STRING);
+    if (entry) {
+        subscription_data = &entry->subscription_data;
+
+        if (subscription_data->mme_host)
+            ogs_free(subscription_data->mme_host);
+        subscription_data->mme_host = NULL;
+        if (mme_host) {
+            subscription_data->mme_host = ogs_strdup(mme_host);
+            ogs_assert(subscription_data->mme_host);
+        }
+
+        if (subscription_data->mme_realm)
+            ogs_free(subscription_data->mme_realm);
+        subscription_data->mme_realm = NULL;
+        if (mme_realm) {
+            subscription_data->mme_realm = ogs_strdup(mme_realm);
+            ogs_assert(subscription_data->mme_realm);
+        }
+
+        subscription_data->purge_flag = purge_flag;
+    }
+
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+void ogs_dbi_cache_remove(const char *supi)
+{
+    cache_entry_t *entry = NULL;
+
+    ogs_assert(supi);
+
+    if (!self.enabled)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    entry = ogs_hash_get(self.hash, supi, OGS_HASH_KEY_STRING);
+    if (entry) {
+        entry_remove(entry);
+        self.stat.invalidation++;
+    }
+
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+void ogs_dbi_cache_remove_all(void)
+{
+    if (!self.enabled)
+        return;
+
+    ogs_thread_mutex_lock(&self.mutex);
+
+    self.stat.invalidation += self.stat.count;
+    entry_remove_all();
+
+    ogs_thread_mutex_unlock(&self.mutex);
+}
+
+/*
+ * The SQN, IMEISV and MME identity are updated on every attach.
+ * They are not cached or are written through, so such updates
+ * must not flush the profile.
+ */
+static bool field_is_cached(const char *key)
+{
+    ogs_assert(key);
+
+    if (!strcmp(key, OGS_SECURITY_STRING) ||
+        !strncmp(key, OGS_SECURITY_STRING ".",
+            strlen(OGS_SECURITY_STRING ".")))
+        return false;
+    if (!strcmp(key, OGS_IMEISV_STRING) ||
+        !strcmp(key, OGS_MME_HOST_STRING) ||
+        !strcmp(key, OGS_MME_REALM_STRING) ||
+        !strcmp(key, OGS_MME_TIMESTAMP_STRING) ||
+        !strcmp(key, OGS_PURGE_FLAG_STRING))
+        return false;
+
+    return true;
+}
+
+static bool update_is_cached(const bson_t *document)
+{
+    bson_iter_t iter, child1_iter, child2_iter;
+
+    if (!bson_iter_init_find(&iter, document, "updateDescription") ||
+        !BSON_ITER_HOLDS_DOCUMENT(&iter))
+        return true;
+
+    bson_iter_recurse(&iter, &child1_iter);
+    while (bson_iter_next(&child1_iter)) {
+        const char *key = bson_iter_key(&child1_iter);
+
+        if (!strcmp(key, "updatedFields") &&
+            BSON_ITER_HOLDS_DOCUMENT(&child1_iter)) {
+            bson_iter_recurse(&child1_iter, &child2_iter);
+            while (bson_iter_next(&child2_iter)) {
+                if (field_is_cached(bson_iter_key(&child2_iter)))
+                    return true;
+            }
+        } else if (!strcmp(key, "removedFields") &&
+            BSON_ITER_HOLDS_ARRAY(&child1_iter)) {
+            bson_iter_recurse(&child1_iter, &child2_iter);
+            while (bson_iter_next(&child2_iter)) {
+                if (!BSON_ITER_HOLDS_UTF8(&child2_iter) ||
+                    field_is_cached(bson_iter_utf8(&child2_iter, NULL)))
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ogs_dbi_cache_handle_change_stream(const bson_t *document)
+{
+    bson_iter_t iter, child1_iter;
+    const char *operation_type = NULL;
+    char *supi = NULL;
+
+    ogs_assert(document);
+
+    if (!self.enabled)
+        return;
+
+    if (bson_iter_init_find(&iter, document, "operationType") &&
+        BSON_ITER_HOLDS_UTF8(&iter))
+        operation_type = bson_iter_utf8(&iter, NULL);
+
+    if (operation_type && !strcmp(operation_type, "update") &&
+        !update_is_cached(document))
+        return;
+
+    if (operation_type &&
+        (!strcmp(operation_type, "insert") ||
+         !strcmp(operation_type, "update") ||
+         !strcmp(operation_type, "replace")) &&
+        bson_iter_init_find(&iter, document, "fullDocument") &&
+        BSON_ITER_HOLDS_DOCUMENT(&iter) &&
+        bson_iter_recurse(&iter, &child1_iter) &&
+        bson_iter_find(&child1_iter, OGS_IMSI_STRING) &&
+        BSON_ITER_HOLDS_UTF8(&child1_iter)) {
+        supi = ogs_msprintf("%s-%s",
+                OGS_ID_SUPI_TYPE_IMSI, bson_iter_utf8(&child1_iter, NULL));
+        ogs_assert(supi);
+
+        ogs_dbi_cache_remove(supi);
+
+        ogs_free(supi);
+        return;
+    }
+
+    /*
+     * A delete only carries the document '_id',
+     * and drop/invalidate affect the whole collection.
+     */
+    ogs_dbi_cache_remove_all();
+}
+
+void ogs_dbi_cache_stat(ogs_dbi_cache_stat_t *stat)
+{
+    ogs_assert(stat);
+
+    if (!self.enabled) {
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+
+    ogs_thread_mutex_lock(&self.mutex);
+    memcpy(stat, &self.stat, sizeof(*stat));
+    ogs_thread_mutex_unlock(&self.mutex);
+}
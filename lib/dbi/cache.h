@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_DBI_INSIDE) && !defined(OGS_DBI_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_DBI_CACHE_H
+#define OGS_DBI_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Subscriber profile cache
+ *
+ * Keeps up to 'size' decoded ogs_subscription_data_t keyed by SUPI
+ * in front of ogs_dbi_subscription_data(), and evicts the least recently
+ * used one when full. It is enabled by 'db_cache.size' in the configuration.
+ *
+ * ogs_dbi_update_mme() writes the MME identity through to the cached entry.
+ * The SQN and IMEISV are not part of the profile and always go to the DB.
+ *
+ * Changes made by other processes are picked up by the change stream
+ * where it is enabled (HSS). Otherwise an entry lives at most 'ttl'.
+ *
+ * All functions can be called from any thread.
+ */
+typedef struct ogs_dbi_cache_stat_s {
+    uint64_t hit;
+    uint64_t miss;
+    uint64_t eviction;
+    uint64_t invalidation;
+    unsigned int count;
+} ogs_dbi_cache_stat_t;
+
+int ogs_dbi_cache_init(int size, ogs_time_t ttl);
+void ogs_dbi_cache_final(void);
+bool ogs_dbi_cache_enabled(void);
+
+bool ogs_dbi_cache_get(const char *supi,
+        ogs_subscription_data_t *subscription_data);
+void ogs_dbi_cache_put(const char *supi,
+        const ogs_subscription_data_t *subscription_data);
+void ogs_dbi_cache_update_mme(const char *supi,
+        const char *mme_host, const char *mme_realm, bool purge_flag);
+
+void ogs_dbi_cache_remove(const char *supi);
+void ogs_dbi_cache_remove_all(void);
+void ogs_dbi_cache_handle_change_stream(const bson_t *document);
+
+void ogs_dbi_cache_stat(ogs_dbi_cache_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_DBI_CACHE_H */
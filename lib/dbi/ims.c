@@ -37,6 +37,11 @@ int ogs_dbi_msisdn_data(
 
     memset(msisdn_data, 0, sizeof(*msisdn_data));
 
+    if (ogs_dbi_mock_enabled()) {
+        ogs_error("[%s] No MSISDN data in mock DB", imsi_or_msisdn_bcd);
+        return OGS_ERROR;
+    }
+
     query = BCON_NEW("$or",
             "[",
                 "{", "imsi", BCON_UTF8(imsi_or_msisdn_bcd), "}",
@@ -44,9 +49,9 @@ int ogs_dbi_msisdn_data(
             "]");
 #if MONGOC_CHECK_VERSION(1, 5, 0)
     cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
+            ogs_mongoc_collection_subscriber(), query, NULL, NULL);
 #else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
+    cursor = mongoc_collection_find(ogs_mongoc_collection_subscriber(),
             MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
 #endif
 
@@ -133,6 +138,11 @@ int ogs_dbi_ims_data(char *supi, ogs_ims_data_t *ims_data)
 
     memset(ims_data, 0, sizeof(*ims_data));
 
+    if (ogs_dbi_mock_enabled()) {
+        ogs_error("[%s] No IMS data in mock DB", supi);
+        return OGS_ERROR;
+    }
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
@@ -141,9 +151,9 @@ int ogs_dbi_ims_data(char *supi, ogs_ims_data_t *ims_data)
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
 #if MONGOC_CHECK_VERSION(1, 5, 0)
     cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
+            ogs_mongoc_collection_subscriber(), query, NULL, NULL);
 #else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
+    cursor = mongoc_collection_find(ogs_mongoc_collection_subscriber(),
             MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
 #endif
 
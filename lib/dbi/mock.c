@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-dbi.h"
+
+#define MOCK_URI_PREFIX "mock://"
+
+#define MOCK_DEFAULT_K      "465b5ce8b199b49faa5f0a2ee238a6bc"
+#define MOCK_DEFAULT_OPC    "e8ed289deba952e4283b54e88e6183ca"
+#define MOCK_DEFAULT_AMF    "8000"
+
+typedef struct mock_subscriber_s {
+    char supi[OGS_MAX_IMSI_BCD_LEN+sizeof(OGS_ID_SUPI_TYPE_IMSI)+1];
+    uint64_t sqn;
+} mock_subscriber_t;
+
+static struct {
+    bool enabled;
+
+    ogs_thread_mutex_t mutex;
+    ogs_hash_t *subscriber_hash;
+
+    ogs_time_t latency;
+
+    uint8_t k[OGS_KEY_LEN];
+    uint8_t opc[OGS_KEY_LEN];
+    uint8_t amf[OGS_AMF_LEN];
+} self;
+
+bool ogs_dbi_mock_uri(const char *db_uri)
+{
+    return db_uri &&
+        !strncmp(db_uri, MOCK_URI_PREFIX, strlen(MOCK_URI_PREFIX));
+}
+
+int ogs_dbi_mock_init(const char *db_uri)
+{
+    char *query, *param, *saveptr = NULL;
+
+    ogs_assert(ogs_dbi_mock_uri(db_uri));
+
+    memset(&self, 0, sizeof(self));
+
+    ogs_ascii_to_hex((char *)MOCK_DEFAULT_K, strlen(MOCK_DEFAULT_K),
+            self.k, sizeof(self.k));
+    ogs_ascii_to_hex((char *)MOCK_DEFAULT_OPC, strlen(MOCK_DEFAULT_OPC),
+            self.opc, sizeof(self.opc));
+    ogs_ascii_to_hex((char *)MOCK_DEFAULT_AMF, strlen(MOCK_DEFAULT_AMF),
+            self.amf, sizeof(self.amf));
+
+    query = strchr(db_uri, '?');
+    if (query) {
+        query = ogs_strdup(query + 1);
+        ogs_assert(query);
+
+        for (param = ogs_strtok_r(query, "&", &saveptr); param;
+                param = ogs_strtok_r(NULL, "&", &saveptr)) {
+            if (!strncmp(param, "latency=", 8)) {
+                self.latency = atoll(param + 8);
+            } else if (!strncmp(param, "k=", 2)) {
+                ogs_ascii_to_hex(param + 2, strlen(param + 2),
+                        self.k, sizeof(self.k));
+            } else if (!strncmp(param, "opc=", 4)) {
+                ogs_ascii_to_hex(param + 4, strlen(param + 4),
+                        self.opc, sizeof(self.opc));
+            } else if (!strncmp(param, "amf=", 4)) {
+                ogs_ascii_to_hex(param + 4, strlen(param + 4),
+                        self.amf, sizeof(self.amf));
+            } else {
+                ogs_warn("Unknown mock parameter [%s]", param);
+            }
+        }
+
+        ogs_free(query);
+    }
+
+    ogs_thread_mutex_init(&self.mutex);
+    self.subscriber_hash = ogs_hash_make();
+    ogs_assert(self.subscriber_hash);
+
+    self.enabled = true;
+
+    ogs_info("MongoDB URI: '%s' (mock, latency:%lld usec)",
+            db_uri, (long long)self.latency);
+
+    return OGS_OK;
+}
+
+void ogs_dbi_mock_final(void)
+{
+    ogs_hash_index_t *hi;
+
+    if (!self.enabled)
+        return;
+
+    for (hi = ogs_hash_first(self.subscriber_hash);
+            hi; hi = ogs_hash_next(hi)) {
+        mock_subscriber_t *subscriber = ogs_hash_this_val(hi);
+
+        /* The key belongs to the subscriber */
+        ogs_hash_set(self.subscriber_hash,
+                subscriber->supi, OGS_HASH_KEY_STRING, NULL);
+        ogs_free(subscriber);
+    }
+    ogs_hash_destroy(self.subscriber_hash);
+
+    ogs_thread_mutex_destroy(&self.mutex);
+
+    self.enabled = false;
+}
+
+bool ogs_dbi_mock_enabled(void)
+{
+    return self.enabled;
+}
+
+/* Called with the mutex held */
+static mock_subscriber_t *subscriber_find(char *supi)
+{
+    mock_subscriber_t *subscriber = NULL;
+
+    if (strncmp(supi, OGS_ID_SUPI_TYPE_IMSI "-",
+                strlen(OGS_ID_SUPI_TYPE_IMSI "-")) ||
+        strlen(supi) >= sizeof(subscriber->supi)) {
+        ogs_info("[%s] Cannot find IMSI in DB", supi);
+        return NULL;
+    }
+
+    subscriber = ogs_hash_get(
+            self.subscriber_hash, supi, OGS_HASH_KEY_STRING);
+    if (!subscriber) {
+        subscriber = ogs_calloc(1, sizeof(*subscriber));
+        ogs_assert(subscriber);
+        strcpy(subscriber->supi, supi);
+
+        ogs_hash_set(self.subscriber_hash,
+                subscriber->supi, OGS_HASH_KEY_STRING, subscriber);
+    }
+
+    return subscriber;
+}
+
+int ogs_dbi_mock_auth_info(char *supi, ogs_dbi_auth_info_t *auth_info)
+{
+    mock_subscriber_t *subscriber = NULL;
+
+    ogs_assert(supi);
+    ogs_assert(auth_info);
+
+    if (self.latency)
+        ogs_usleep(self.latency);
+
+    ogs_thread_mutex_lock(&self.mutex);
+    subscriber = subscriber_find(supi);
+    if (subscriber) {
+        memset(auth_info, 0, sizeof(*auth_info));
+        memcpy(auth_info->k, self.k, OGS_KEY_LEN);
+        auth_info->use_opc = 1;
+        memcpy(auth_info->opc, self.opc, OGS_KEY_LEN);
+        memcpy(auth_info->amf, self.amf, OGS_AMF_LEN);
+        auth_info->sqn = subscriber->sqn;
+    }
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return subscriber ? OGS_OK : OGS_ERROR;
+}
+
+int ogs_dbi_mock_update_sqn(char *supi, uint64_t sqn)
+{
+    mock_subscriber_t *subscriber = NULL;
+
+    ogs_assert(supi);
+
+    if (self.latency)
+        ogs_usleep(self.latency);
+
+    ogs_thread_mutex_lock(&self.mutex);
+    subscriber = subscriber_find(supi);
+    if (subscriber)
+        subscriber->sqn = sqn;
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return subscriber ? OGS_OK : OGS_ERROR;
+}
+
+int ogs_dbi_mock_increment_sqn(char *supi)
+{
+    mock_subscriber_t *subscriber = NULL;
+
+    ogs_assert(supi);
+
+    if (self.latency)
+        ogs_usleep(self.latency);
+
+    ogs_thread_mutex_lock(&self.mutex);
+    subscriber = subscriber_find(supi);
+    if (subscriber)
+        subscriber->sqn = (subscriber->sqn + 32) & OGS_MAX_SQN;
+    ogs_thread_mutex_unlock(&self.mutex);
+
+    return subscriber ? OGS_OK : OGS_ERROR;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_DBI_INSIDE) && !defined(OGS_DBI_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_DBI_MOCK_H
+#define OGS_DBI_MOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * In-process backend selected by a 'mock://' DB URI,
+ * for load testing without a MongoDB server.
+ *
+ *   mock://[?latency=USEC][&k=HEX][&opc=HEX][&amf=HEX]
+ *
+ * Every IMSI exists with the same K/OPc/AMF. Only the SQN is kept
+ * per subscriber. 'latency' is slept on each query to emulate
+ * the round trip to the database.
+ *
+ * Only the authentication data is provided. The other queries fail.
+ */
+bool ogs_dbi_mock_uri(const char *db_uri);
+
+int ogs_dbi_mock_init(const char *db_uri);
+void ogs_dbi_mock_final(void);
+bool ogs_dbi_mock_enabled(void);
+
+int ogs_dbi_mock_auth_info(char *supi, ogs_dbi_auth_info_t *auth_info);
+int ogs_dbi_mock_update_sqn(char *supi, uint64_t sqn);
+int ogs_dbi_mock_increment_sqn(char *supi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_DBI_MOCK_H */
@@ -29,6 +29,9 @@
 #include "dbi/subscription.h"
 #include "dbi/session.h"
 #include "dbi/ims.h"
+#include "dbi/mock.h"
+#include "dbi/async.h"
+#include "dbi/cache.h"
 
 #undef OGS_DBI_INSIDE
 
@@ -25,6 +25,12 @@ int __ogs_dbi_domain;
 
 static ogs_mongoc_t self;
 
+static OGS_THREAD_LOCAL struct {
+    int ref;
+    mongoc_client_t *client;
+    mongoc_collection_t *subscriber;
+} local;
+
 /*
  * We've added it 
  * Because the following function is deprecated in the mongo-c-driver
@@ -134,6 +140,10 @@ int ogs_mongoc_init(const char *db_uri)
 
 void ogs_mongoc_final(void)
 {
+    if (self.pool) {
+        mongoc_client_pool_destroy(self.pool);
+        self.pool = NULL;
+    }
     if (self.database) {
         mongoc_database_destroy(self.database);
         self.database = NULL;
@@ -164,6 +174,9 @@ int ogs_dbi_init(const char *db_uri)
 
     ogs_assert(db_uri);
 
+    if (ogs_dbi_mock_uri(db_uri))
+        return ogs_dbi_mock_init(db_uri);
+
     rv = ogs_mongoc_init(db_uri);
     if (rv != OGS_OK) return rv;
 
@@ -171,6 +184,19 @@ int ogs_dbi_init(const char *db_uri)
         self.collection.subscriber = mongoc_client_get_collection(
             ogs_mongoc()->client, ogs_mongoc()->name, "subscribers");
         ogs_assert(self.collection.subscriber);
+
+        self.pool = mongoc_client_pool_new(
+                mongoc_client_get_uri(ogs_mongoc()->client));
+        ogs_assert(self.pool);
+#if MONGOC_CHECK_VERSION(1, 4, 0)
+        mongoc_client_pool_set_error_api(self.pool, 2);
+#endif
+    }
+
+    if (ogs_app()->db_cache.size > 0) {
+        rv = ogs_dbi_cache_init(
+                ogs_app()->db_cache.size, ogs_app()->db_cache.ttl);
+        if (rv != OGS_OK) return rv;
     }
 
     return OGS_OK;
@@ -178,8 +204,16 @@ int ogs_dbi_init(const char *db_uri)
 
 void ogs_dbi_final(void)
 {
+    if (ogs_dbi_mock_enabled()) {
+        ogs_dbi_mock_final();
+        return;
+    }
+
+    ogs_dbi_cache_final();
+
     if (self.collection.subscriber) {
         mongoc_collection_destroy(self.collection.subscriber);
+        self.collection.subscriber = NULL;
     }
 
 #if MONGOC_CHECK_VERSION(1, 9, 0)
@@ -191,13 +225,60 @@ void ogs_dbi_final(void)
     ogs_mongoc_final();
 }
 
+void ogs_dbi_client_acquire(void)
+{
+    if (local.ref++)
+        return;
+
+    if (!self.pool || !self.name)
+        return;
+
+    local.client = mongoc_client_pool_pop(self.pool);
+    ogs_assert(local.client);
+    local.subscriber = mongoc_client_get_collection(
+            local.client, self.name, "subscribers");
+    ogs_assert(local.subscriber);
+}
+
+void ogs_dbi_client_release(void)
+{
+    ogs_assert(local.ref > 0);
+
+    if (--local.ref)
+        return;
+
+    if (local.subscriber) {
+        mongoc_collection_destroy(local.subscriber);
+        local.subscriber = NULL;
+    }
+    if (local.client) {
+        mongoc_client_pool_push(self.pool, local.client);
+        local.client = NULL;
+    }
+}
+
+void *ogs_mongoc_collection_subscriber(void)
+{
+    if (local.subscriber)
+        return local.subscriber;
+
+    return self.collection.subscriber;
+}
+
 int ogs_dbi_collection_watch_init(void)
 {
 #if MONGOC_CHECK_VERSION(1, 9, 0)
     bson_t empty = BSON_INITIALIZER;    
     const bson_t *err_doc;
     bson_error_t error;
-    bson_t *options = BCON_NEW("fullDocument", "updateLookup");
+    bson_t *options = NULL;
+
+    if (!self.collection.subscriber) {
+        ogs_error("No subscriber collection");
+        return OGS_ERROR;
+    }
+
+    options = BCON_NEW("fullDocument", "updateLookup");
    
     ogs_mongoc()->stream = mongoc_collection_watch(self.collection.subscriber,
         &empty, options);
@@ -37,6 +37,8 @@ typedef struct ogs_mongoc_s {
     void *client;
     void *database;
 
+    void *pool;     /* mongoc_client_pool_t for the other threads */
+
 #if MONGOC_CHECK_VERSION(1, 9, 0)
     mongoc_change_stream_t *stream;
 #endif
@@ -55,6 +57,19 @@ ogs_mongoc_t *ogs_mongoc(void);
 int ogs_dbi_init(const char *db_uri);
 void ogs_dbi_final(void);
 
+/*
+ * A mongoc_client_t must not be shared between threads.
+ *
+ * A thread other than the NF main thread (DBI worker, freeDiameter)
+ * acquires a client of the pool before calling ogs_dbi_xxx(), so that
+ * the queries of the different threads run in parallel.
+ * Calls may be nested. Without a client acquired, the main client is used.
+ */
+void ogs_dbi_client_acquire(void);
+void ogs_dbi_client_release(void);
+
+void *ogs_mongoc_collection_subscriber(void);
+
 int ogs_dbi_collection_watch_init(void);
 int ogs_dbi_poll_change_stream(void);
 
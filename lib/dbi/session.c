@@ -43,6 +43,11 @@ int ogs_dbi_session_data(
 
     ogs_assert(supi);
     ogs_assert(dnn);
+
+    if (ogs_dbi_mock_enabled()) {
+        ogs_error("[%s] No session data in mock DB", supi);
+        return OGS_ERROR;
+    }
     ogs_assert(session_data);
 
     supi_type = ogs_id_get_type(supi);
@@ -53,9 +58,9 @@ int ogs_dbi_session_data(
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
 #if MONGOC_CHECK_VERSION(1, 5, 0)
     cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
+            ogs_mongoc_collection_subscriber(), query, NULL, NULL);
 #else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
+    cursor = mongoc_collection_find(ogs_mongoc_collection_subscriber(),
             MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
 #endif
 
@@ -38,6 +38,9 @@ int ogs_dbi_auth_info(char *supi, ogs_dbi_auth_info_t *auth_info)
     ogs_assert(supi);
     ogs_assert(auth_info);
 
+    if (ogs_dbi_mock_enabled())
+        return ogs_dbi_mock_auth_info(supi, auth_info);
+
     supi_type = ogs_id_get_type(supi);
     if (!supi_type) {
         ogs_error("Invalid supi=%s", supi);
@@ -53,9 +56,9 @@ int ogs_dbi_auth_info(char *supi, ogs_dbi_auth_info_t *auth_info)
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
 #if MONGOC_CHECK_VERSION(1, 5, 0)
     cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
+            ogs_mongoc_collection_subscriber(), query, NULL, NULL);
 #else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
+    cursor = mongoc_collection_find(ogs_mongoc_collection_subscriber(),
             MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
 #endif
 
@@ -138,6 +141,9 @@ int ogs_dbi_update_sqn(char *supi, uint64_t sqn)
 
     ogs_assert(supi);
 
+    if (ogs_dbi_mock_enabled())
+        return ogs_dbi_mock_update_sqn(supi, sqn);
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
@@ -149,7 +155,7 @@ int ogs_dbi_update_sqn(char *supi, uint64_t sqn)
                 OGS_SECURITY_STRING "." OGS_SQN_STRING, BCON_INT64(sqn),
             "}");
 
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(ogs_mongoc_collection_subscriber(),
             MONGOC_UPDATE_NONE, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -177,6 +183,9 @@ int ogs_dbi_update_imeisv(char *supi, char *imeisv)
 
     ogs_assert(supi);
 
+    if (ogs_dbi_mock_enabled())
+        return OGS_OK;
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
@@ -190,7 +199,7 @@ int ogs_dbi_update_imeisv(char *supi, char *imeisv)
             "{",
                 OGS_IMEISV_STRING, BCON_UTF8(imeisv),
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(ogs_mongoc_collection_subscriber(),
             MONGOC_UPDATE_UPSERT, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -219,6 +228,9 @@ int ogs_dbi_update_mme(char *supi, char *mme_host, char *mme_realm,
 
     ogs_assert(supi);
 
+    if (ogs_dbi_mock_enabled())
+        return OGS_OK;
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
@@ -235,11 +247,13 @@ int ogs_dbi_update_mme(char *supi, char *mme_host, char *mme_realm,
                 OGS_MME_TIMESTAMP_STRING, BCON_INT64(ogs_time_now()),
                 OGS_PURGE_FLAG_STRING, BCON_BOOL(purge_flag),
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(ogs_mongoc_collection_subscriber(),
             MONGOC_UPDATE_UPSERT, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
         rv = OGS_ERROR;
+    } else {
+        ogs_dbi_cache_update_mme(supi, mme_host, mme_realm, purge_flag);
     }
 
     if (query) bson_destroy(query);
@@ -264,6 +278,9 @@ int ogs_dbi_increment_sqn(char *supi)
 
     ogs_assert(supi);
 
+    if (ogs_dbi_mock_enabled())
+        return ogs_dbi_mock_increment_sqn(supi);
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
@@ -274,7 +291,7 @@ int ogs_dbi_increment_sqn(char *supi)
             "{",
                 OGS_SECURITY_STRING "." OGS_SQN_STRING, BCON_INT64(32),
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(ogs_mongoc_collection_subscriber(),
             MONGOC_UPDATE_NONE, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -288,7 +305,7 @@ int ogs_dbi_increment_sqn(char *supi)
                 OGS_SECURITY_STRING "." OGS_SQN_STRING,
                 "{", "and", BCON_INT64(max_sqn), "}",
             "}");
-    if (!mongoc_collection_update(ogs_mongoc()->collection.subscriber,
+    if (!mongoc_collection_update(ogs_mongoc_collection_subscriber(),
             MONGOC_UPDATE_NONE, query, update, NULL, &error)) {
         ogs_error("mongoc_collection_update() failure: %s", error.message);
 
@@ -327,6 +344,14 @@ int ogs_dbi_subscription_data(char *supi,
 
     memset(subscription_data, 0, sizeof(*subscription_data));
 
+    if (ogs_dbi_mock_enabled()) {
+        ogs_error("[%s] No subscription data in mock DB", supi);
+        return OGS_ERROR;
+    }
+
+    if (ogs_dbi_cache_get(supi, subscription_data))
+        return OGS_OK;
+
     supi_type = ogs_id_get_type(supi);
     ogs_assert(supi_type);
     supi_id = ogs_id_get_value(supi);
@@ -335,9 +360,9 @@ int ogs_dbi_subscription_data(char *supi,
     query = BCON_NEW(supi_type, BCON_UTF8(supi_id));
 #if MONGOC_CHECK_VERSION(1, 5, 0)
     cursor = mongoc_collection_find_with_opts(
-            ogs_mongoc()->collection.subscriber, query, NULL, NULL);
+            ogs_mongoc_collection_subscriber(), query, NULL, NULL);
 #else
-    cursor = mongoc_collection_find(ogs_mongoc()->collection.subscriber,
+    cursor = mongoc_collection_find(ogs_mongoc_collection_subscriber(),
             MONGOC_QUERY_NONE, 0, 0, 0, query, NULL, NULL);
 #endif
 
@@ -827,6 +852,8 @@ int ogs_dbi_subscription_data(char *supi,
         }
     }
 
+    ogs_dbi_cache_put(supi, subscription_data);
+
 out:
     if (query) bson_destroy(query);
     if (cursor) mongoc_cursor_destroy(cursor);
@@ -76,6 +76,8 @@ typedef struct ogs_gtp_node_s {
 
     ogs_list_t      local_list;
     ogs_list_t      remote_list;
+    ogs_hash_t      *local_xact_hash;   /* Transactions indexed by XID */
+    ogs_hash_t      *remote_xact_hash;
 } ogs_gtp_node_t;
 
 typedef struct ogs_gtpu_resource_s {
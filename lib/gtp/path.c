@@ -158,6 +158,155 @@ int ogs_gtp_send_with_teid(
     return OGS_OK;
 }
 
+static OGS_THREAD_LOCAL struct {
+    int size;
+    bool gso;
+    bool open;
+
+    int num;
+    ogs_socket_t *fd;
+    ogs_pkbuf_t **pkbuf;
+    ogs_sockaddr_t *to;
+} tx_batch;
+
+void ogs_gtp_tx_batch_init(int size, bool gso)
+{
+    memset(&tx_batch, 0, sizeof(tx_batch));
+
+    if (size <= 1)
+        return;
+
+    if (size > OGS_MAX_NUM_OF_MMSG) {
+        ogs_warn("GTP-U batch size [%d] is limited to [%d]",
+                size, OGS_MAX_NUM_OF_MMSG);
+        size = OGS_MAX_NUM_OF_MMSG;
+    }
+
+    tx_batch.size = size;
+    tx_batch.gso = gso;
+
+    tx_batch.fd = ogs_calloc(size, sizeof(*tx_batch.fd));
+    ogs_assert(tx_batch.fd);
+    tx_batch.pkbuf = ogs_calloc(size, sizeof(*tx_batch.pkbuf));
+    ogs_assert(tx_batch.pkbuf);
+    tx_batch.to = ogs_calloc(size, sizeof(*tx_batch.to));
+    ogs_assert(tx_batch.to);
+}
+
+void ogs_gtp_tx_batch_final(void)
+{
+    if (!tx_batch.size)
+        return;
+
+    ogs_gtp_tx_batch_end();
+
+    ogs_free(tx_batch.fd);
+    ogs_free(tx_batch.pkbuf);
+    ogs_free(tx_batch.to);
+
+    memset(&tx_batch, 0, sizeof(tx_batch));
+}
+
+void ogs_gtp_tx_batch_begin(void)
+{
+    if (tx_batch.size)
+        tx_batch.open = true;
+}
+
+static int tx_batch_flush(void)
+{
+    ogs_pkbuf_t *pkbuf[OGS_MAX_NUM_OF_MMSG];
+    ogs_sockaddr_t *to[OGS_MAX_NUM_OF_MMSG];
+    bool done[OGS_MAX_NUM_OF_MMSG];
+    int i, j, num, sent, total = 0;
+
+    memset(done, 0, sizeof(done[0]) * tx_batch.num);
+
+    /* One sendmmsg() per destination socket, preserving the order */
+    for (i = 0; i < tx_batch.num; i++) {
+        if (done[i])
+            continue;
+
+        num = 0;
+        for (j = i; j < tx_batch.num; j++) {
+            if (done[j] || tx_batch.fd[j] != tx_batch.fd[i])
+                continue;
+
+            pkbuf[num] = tx_batch.pkbuf[j];
+            to[num] = &tx_batch.to[j];
+            num++;
+            done[j] = true;
+        }
+
+        sent = ogs_sendmmsg(tx_batch.fd[i], pkbuf, to, num, tx_batch.gso);
+        if (sent < 0 && tx_batch.gso && ogs_socket_errno == EIO) {
+            /* The egress device cannot do UDP GSO; stop using it */
+            ogs_warn("UDP GSO is not supported, disabled");
+            tx_batch.gso = false;
+            sent = ogs_sendmmsg(tx_batch.fd[i], pkbuf, to, num, false);
+        }
+        if (sent < num) {
+            if (ogs_socket_errno != OGS_EAGAIN) {
+                ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                        "ogs_sendmmsg(%u, %d) failed [%d sent]",
+                        tx_batch.fd[i], num, sent);
+            }
+        }
+        if (sent > 0)
+            total += sent;
+    }
+
+    for (i = 0; i < tx_batch.num; i++)
+        ogs_pkbuf_free(tx_batch.pkbuf[i]);
+    tx_batch.num = 0;
+
+    return total;
+}
+
+int ogs_gtp_tx_batch_end(void)
+{
+    int sent = 0;
+
+    if (tx_batch.num)
+        sent = tx_batch_flush();
+    tx_batch.open = false;
+
+    return sent;
+}
+
+int ogs_gtp_tx_batch_send(
+        ogs_sock_t *sock,
+        ogs_pkbuf_t *pkbuf, uint32_t teid,
+        ogs_sockaddr_t *to)
+{
+    int rv;
+    ogs_gtp2_header_t *gtp_h = NULL;
+
+    ogs_assert(sock);
+    ogs_assert(pkbuf);
+    ogs_assert(to);
+
+    if (!tx_batch.open) {
+        rv = ogs_gtp_send_with_teid(sock, pkbuf, teid, to);
+        ogs_pkbuf_free(pkbuf);
+        return rv;
+    }
+
+    if (tx_batch.num == tx_batch.size)
+        tx_batch_flush();
+
+    gtp_h = (ogs_gtp2_header_t *)pkbuf->data;
+    ogs_assert(gtp_h);
+    gtp_h->teid = htobe32(teid);
+
+    tx_batch.fd[tx_batch.num] = sock->fd;
+    tx_batch.pkbuf[tx_batch.num] = pkbuf;
+    memcpy(&tx_batch.to[tx_batch.num], to, sizeof(*to));
+    tx_batch.num++;
+
+    return OGS_OK;
+}
+
 void ogs_gtp_send_error_message(
         ogs_gtp_xact_t *xact, uint32_t teid, uint8_t type, uint8_t cause_value)
 {
@@ -74,6 +74,28 @@ int ogs_gtp_send_with_teid(
         ogs_pkbuf_t *pkbuf, uint32_t teid,
         ogs_sockaddr_t *to);
 
+/*
+ * GTP-U TX batch
+ *
+ * Between ogs_gtp_tx_batch_begin() and ogs_gtp_tx_batch_end(),
+ * G-PDUs given to ogs_gtp_tx_batch_send() are queued and flushed
+ * with one sendmmsg() per destination socket. Outside of a batch,
+ * or if batching is disabled(size <= 1), they are sent immediately.
+ *
+ * The batch is per thread. Each thread sending G-PDUs
+ * calls ogs_gtp_tx_batch_init() and ogs_gtp_tx_batch_final() itself.
+ */
+void ogs_gtp_tx_batch_init(int size, bool gso);
+void ogs_gtp_tx_batch_final(void);
+
+void ogs_gtp_tx_batch_begin(void);
+int ogs_gtp_tx_batch_end(void);
+
+int ogs_gtp_tx_batch_send(
+        ogs_sock_t *sock,
+        ogs_pkbuf_t *pkbuf, uint32_t teid,
+        ogs_sockaddr_t *to);
+
 void ogs_gtp_send_error_message(
         ogs_gtp_xact_t *xact, uint32_t teid, uint8_t type, uint8_t cause_value);
 
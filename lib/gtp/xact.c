@@ -43,6 +43,11 @@ static void response_timeout(void *data);
 static void holding_timeout(void *data);
 static void peer_timeout(void *data);
 
+static void xact_hash_add(ogs_gtp_xact_t *xact);
+static void xact_hash_remove(ogs_gtp_xact_t *xact);
+static ogs_gtp_xact_t *xact_hash_find(
+        ogs_hash_t *hash, uint8_t gtp_version, uint32_t xid);
+
 int ogs_gtp_xact_init(void)
 {
     ogs_assert(ogs_gtp_xact_initialized == 0);
@@ -106,6 +111,7 @@ ogs_gtp_xact_t *ogs_gtp1_xact_local_create(ogs_gtp_node_t *gnode,
     xact->holding_rcount = ogs_local_conf()->time.message.gtp.n3_holding_rcount;
 
     ogs_list_add(&xact->gnode->local_list, xact);
+    xact_hash_add(xact);
 
     rv = ogs_gtp1_xact_update_tx(xact, hdesc, pkbuf);
     if (rv != OGS_OK) {
@@ -168,6 +174,7 @@ ogs_gtp_xact_t *ogs_gtp_xact_local_create(ogs_gtp_node_t *gnode,
     ogs_assert(xact->tm_peer);
 
     ogs_list_add(&xact->gnode->local_list, xact);
+    xact_hash_add(xact);
 
     rv = ogs_gtp_xact_update_tx(xact, hdesc, pkbuf);
     if (rv != OGS_OK) {
@@ -219,6 +226,7 @@ static ogs_gtp_xact_t *ogs_gtp_xact_remote_create(ogs_gtp_node_t *gnode, uint8_t
     ogs_assert(xact->tm_peer);
 
     ogs_list_add(&xact->gnode->remote_list, xact);
+    xact_hash_add(xact);
 
     ogs_debug("[%d] REMOTE Create  peer [%s]:%d",
             xact->xid,
@@ -241,6 +249,15 @@ void ogs_gtp_xact_delete_all(ogs_gtp_node_t *gnode)
         ogs_gtp_xact_delete(xact);
     ogs_list_for_each_safe(&gnode->remote_list, next_xact, xact)
         ogs_gtp_xact_delete(xact);
+
+    if (gnode->local_xact_hash) {
+        ogs_hash_destroy(gnode->local_xact_hash);
+        gnode->local_xact_hash = NULL;
+    }
+    if (gnode->remote_xact_hash) {
+        ogs_hash_destroy(gnode->remote_xact_hash);
+        gnode->remote_xact_hash = NULL;
+    }
 }
 
 int ogs_gtp1_xact_update_tx(ogs_gtp_xact_t *xact,
@@ -875,7 +892,7 @@ int ogs_gtp1_xact_receive(
     uint8_t type;
     uint32_t sqn, xid;
     ogs_gtp_xact_stage_t stage;
-    ogs_list_t *list = NULL;
+    ogs_hash_t *hash = NULL;
     ogs_gtp_xact_t *new = NULL;
 
     ogs_assert(gnode);
@@ -894,19 +911,19 @@ int ogs_gtp1_xact_receive(
 
     switch (stage) {
     case GTP_XACT_INITIAL_STAGE:
-        list = &gnode->remote_list;
+        hash = gnode->remote_xact_hash;
         break;
     case GTP_XACT_INTERMEDIATE_STAGE:
-        list = &gnode->local_list;
+        hash = gnode->local_xact_hash;
         break;
     case GTP_XACT_FINAL_STAGE:
         /* For types which are replies to replies, the xact is never locally
          * created during transmit, but actually during rx of the initial req, hence
          * it is never placed in the local_list, but in the remote_list. */
         if (type == OGS_GTP1_SGSN_CONTEXT_ACKNOWLEDGE_TYPE)
-            list = &gnode->remote_list;
+            hash = gnode->remote_xact_hash;
         else
-            list = &gnode->local_list;
+            hash = gnode->local_xact_hash;
         break;
     default:
         ogs_error("[%d] Unexpected type %u from GTPv1 peer [%s]:%d",
@@ -914,17 +931,14 @@ int ogs_gtp1_xact_receive(
         return OGS_ERROR;
     }
 
-    ogs_assert(list);
-    ogs_list_for_each(list, new) {
-        if (new->gtp_version == 1 && new->xid == xid) {
-            ogs_debug("[%d] %s Find GTPv%u peer [%s]:%d",
-                    new->xid,
-                    new->org == OGS_GTP_LOCAL_ORIGINATOR ? "LOCAL " : "REMOTE",
-                    new->gtp_version,
-                    OGS_ADDR(&gnode->addr, buf),
-                    OGS_PORT(&gnode->addr));
-            break;
-        }
+    new = xact_hash_find(hash, 1, xid);
+    if (new) {
+        ogs_debug("[%d] %s Find GTPv%u peer [%s]:%d",
+                new->xid,
+                new->org == OGS_GTP_LOCAL_ORIGINATOR ? "LOCAL " : "REMOTE",
+                new->gtp_version,
+                OGS_ADDR(&gnode->addr, buf),
+                OGS_PORT(&gnode->addr));
     }
 
     if (!new) {
@@ -962,7 +976,7 @@ int ogs_gtp_xact_receive(
     uint8_t type;
     uint32_t sqn, xid;
     ogs_gtp_xact_stage_t stage;
-    ogs_list_t *list = NULL;
+    ogs_hash_t *hash = NULL;
     ogs_gtp_xact_t *new = NULL;
 
     ogs_assert(gnode);
@@ -978,22 +992,22 @@ int ogs_gtp_xact_receive(
 
     switch (stage) {
     case GTP_XACT_INITIAL_STAGE:
-        list = &gnode->remote_list;
+        hash = gnode->remote_xact_hash;
         break;
     case GTP_XACT_INTERMEDIATE_STAGE:
-        list = &gnode->local_list;
+        hash = gnode->local_xact_hash;
         break;
     case GTP_XACT_FINAL_STAGE:
         if (xid & OGS_GTP_CMD_XACT_ID) {
             if (type == OGS_GTP2_MODIFY_BEARER_FAILURE_INDICATION_TYPE ||
                 type == OGS_GTP2_DELETE_BEARER_FAILURE_INDICATION_TYPE ||
                 type == OGS_GTP2_BEARER_RESOURCE_FAILURE_INDICATION_TYPE) {
-                list = &gnode->local_list;
+                hash = gnode->local_xact_hash;
             } else {
-                list = &gnode->remote_list;
+                hash = gnode->remote_xact_hash;
             }
         } else {
-            list = &gnode->local_list;
+            hash = gnode->local_xact_hash;
         }
         break;
     default:
@@ -1002,17 +1016,14 @@ int ogs_gtp_xact_receive(
         return OGS_ERROR;
     }
 
-    ogs_assert(list);
-    ogs_list_for_each(list, new) {
-        if (new->gtp_version == 2 && new->xid == xid) {
-            ogs_debug("[%d] %s Find GTPv%u peer [%s]:%d",
-                    new->xid,
-                    new->org == OGS_GTP_LOCAL_ORIGINATOR ? "LOCAL " : "REMOTE",
-                    new->gtp_version,
-                    OGS_ADDR(&gnode->addr, buf),
-                    OGS_PORT(&gnode->addr));
-            break;
-        }
+    new = xact_hash_find(hash, 2, xid);
+    if (new) {
+        ogs_debug("[%d] %s Find GTPv%u peer [%s]:%d",
+                new->xid,
+                new->org == OGS_GTP_LOCAL_ORIGINATOR ? "LOCAL " : "REMOTE",
+                new->gtp_version,
+                OGS_ADDR(&gnode->addr, buf),
+                OGS_PORT(&gnode->addr));
     }
 
     if (!new) {
@@ -1230,9 +1241,93 @@ static int ogs_gtp_xact_delete(ogs_gtp_xact_t *xact)
     if (assoc_xact)
         ogs_gtp_xact_deassociate(xact, assoc_xact);
 
+    xact_hash_remove(xact);
     ogs_list_remove(xact->org == OGS_GTP_LOCAL_ORIGINATOR ?
             &xact->gnode->local_list : &xact->gnode->remote_list, xact);
     ogs_pool_id_free(&pool, xact);
 
     return OGS_OK;
 }
+
+/*
+ * GTPv1 and GTPv2 transactions of a node share the same index,
+ * so the key combines the version with the XID (at most 24 bits).
+ *
+ * A transaction may reuse the XID of another one, e.g. the remote one
+ * created for an unexpected response. The index points to the oldest,
+ * the others are chained behind it in creation order, so the next one
+ * is found again once the oldest is deleted.
+ */
+#define XID_KEY(__vERSION, __xID) (((uint32_t)(__vERSION) << 24) | (__xID))
+
+static void xact_hash_add(ogs_gtp_xact_t *xact)
+{
+    ogs_hash_t **hash = NULL;
+    ogs_gtp_xact_t *first = NULL;
+
+    ogs_assert(xact);
+    ogs_assert(xact->gnode);
+
+    hash = xact->org == OGS_GTP_LOCAL_ORIGINATOR ?
+            &xact->gnode->local_xact_hash : &xact->gnode->remote_xact_hash;
+    if (!*hash) {
+        *hash = ogs_hash_make();
+        ogs_assert(*hash);
+    }
+
+    xact->xid_key = XID_KEY(xact->gtp_version, xact->xid);
+    xact->xid_next = NULL;
+
+    first = ogs_hash_get(*hash, &xact->xid_key, sizeof(xact->xid_key));
+    if (!first) {
+        ogs_hash_set(*hash, &xact->xid_key, sizeof(xact->xid_key), xact);
+        return;
+    }
+
+    while (first->xid_next)
+        first = first->xid_next;
+    first->xid_next = xact;
+}
+
+static void xact_hash_remove(ogs_gtp_xact_t *xact)
+{
+    ogs_hash_t *hash = NULL;
+    ogs_gtp_xact_t *first = NULL, *next = NULL;
+
+    ogs_assert(xact);
+    ogs_assert(xact->gnode);
+
+    hash = xact->org == OGS_GTP_LOCAL_ORIGINATOR ?
+            xact->gnode->local_xact_hash : xact->gnode->remote_xact_hash;
+    ogs_assert(hash);
+
+    first = ogs_hash_get(hash, &xact->xid_key, sizeof(xact->xid_key));
+    ogs_assert(first);
+
+    if (first == xact) {
+        /* The key points into the transaction, so it is replaced too */
+        next = xact->xid_next;
+        ogs_hash_set(hash, &xact->xid_key, sizeof(xact->xid_key), NULL);
+        if (next)
+            ogs_hash_set(hash,
+                    &next->xid_key, sizeof(next->xid_key), next);
+        return;
+    }
+
+    while (first->xid_next != xact) {
+        first = first->xid_next;
+        ogs_assert(first);
+    }
+    first->xid_next = xact->xid_next;
+}
+
+static ogs_gtp_xact_t *xact_hash_find(
+        ogs_hash_t *hash, uint8_t gtp_version, uint32_t xid)
+{
+    uint32_t key = XID_KEY(gtp_version, xid);
+
+    if (!hash)
+        return NULL;
+
+    return ogs_hash_get(hash, &key, sizeof(key));
+}
@@ -90,6 +90,8 @@ typedef struct ogs_gtp_xact_s {
                                          local or remote */
 
     uint32_t        xid;            /**< Transaction ID */
+    uint32_t        xid_key;        /**< XID index key (version and XID) */
+    struct ogs_gtp_xact_s *xid_next; /**< Next one with the same XID key */
     ogs_gtp_node_t  *gnode;         /**< Relevant GTP node context */
 
     void (*cb)(ogs_gtp_xact_t *, void *); /**< Local timer expiration handler */
@@ -29,6 +29,7 @@
 size_t (*ogs_metrics_connected_ues_dumper)(char *buf, size_t buflen) = NULL;
 size_t (*ogs_metrics_connected_gnbs_dumper)(char *buf, size_t buflen) = NULL;
 size_t (*ogs_metrics_connected_enbs_dumper)(char *buf, size_t buflen) = NULL;
+void (*ogs_metrics_collector)(void) = NULL;
 
 void ogs_metrics_register_connected_ues(size_t (*fn)(char *buf, size_t buflen))
 {
@@ -45,6 +46,11 @@ void ogs_metrics_register_connected_enbs(size_t (*fn)(char *buf, size_t buflen))
     ogs_metrics_connected_enbs_dumper = fn;
 }
 
+void ogs_metrics_register_collector(void (*fn)(void))
+{
+    ogs_metrics_collector = fn;
+}
+
 int __ogs_metrics_domain;
 static ogs_metrics_context_t self;
 static int context_initialized = 0;
@@ -88,6 +94,11 @@ ogs_metrics_context_t *ogs_metrics_self(void)
     return &self;
 }
 
+bool ogs_metrics_context_initialized(void)
+{
+    return context_initialized == 1;
+}
+
 static int ogs_metrics_context_prepare(void)
 {
     self.metrics_port = DEFAULT_PROMETHEUS_HTTP_PORT;
@@ -74,6 +74,7 @@ void ogs_metrics_context_open(ogs_metrics_context_t *ctx);
 void ogs_metrics_context_close(ogs_metrics_context_t *ctx);
 void ogs_metrics_context_final(void);
 ogs_metrics_context_t *ogs_metrics_self(void);
+bool ogs_metrics_context_initialized(void);
 int ogs_metrics_context_parse_config(const char *local);
 
 void ogs_metrics_server_init(ogs_metrics_context_t *ctx);
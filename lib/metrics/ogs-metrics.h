@@ -48,6 +48,10 @@ void ogs_metrics_register_connected_gnbs(size_t (*fn)(char *buf, size_t buflen))
 extern size_t (*ogs_metrics_connected_enbs_dumper)(char *buf, size_t buflen);
 void ogs_metrics_register_connected_enbs(size_t (*fn)(char *buf, size_t buflen));
 
+/* Collector hook, called right before /metrics is rendered */
+extern void (*ogs_metrics_collector)(void);
+void ogs_metrics_register_collector(void (*fn)(void));
+
 #ifdef __cplusplus
 }
 #endif
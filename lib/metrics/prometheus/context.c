@@ -22,7 +22,8 @@
  /*
  * Prometheus HTTP server (MicroHTTPD) with optional JSON endpoints:
  *   - /                (provide health check)
- *   - /metrics         (provide prometheus metrics metrics according to the relevant NF)
+ *   - /metrics         (provide prometheus metrics metrics according to the relevant NF,
+ *                       after running ogs_metrics_collector if registered)
  *   - /connected-ues   (provided by NF registering ogs_metrics_connected_ues_dumper)
  *   - /connected-gnbs  (provided by NF registering ogs_metrics_connected_gnbs_dumper)
  *   - /connected-enbs  (provided by NF registering ogs_metrics_connected_enbs_dumper)
@@ -32,13 +33,31 @@
 #include "metrics/ogs-metrics.h"
 
 #include <netdb.h> /* AI_PASSIVE */
-#include "prom.h"
 #include "microhttpd.h"
 #include <string.h>
 
 extern int __ogs_metrics_domain;
 #define MAX_LABELS 8
 
+/*
+ * Metric registry
+ *
+ * An instance is the pre-resolved handle of one label set, so updating it
+ * does not look up anything. Each thread adds into its own cache-line
+ * sized shard with a relaxed atomic, and the shards are only folded
+ * into the Prometheus text exposition format when /metrics is scraped.
+ *
+ * Specs and instances are created, freed and rendered by the main thread.
+ * Gauges are expected to be set by a single thread.
+ */
+#define MAX_SHARDS 8
+#define CACHE_LINE_SIZE 64
+
+typedef struct ogs_metrics_shard_s {
+    int64_t value;      /* counter/gauge value, or histogram sum */
+    uint8_t pad[CACHE_LINE_SIZE - sizeof(int64_t)];
+} ogs_metrics_shard_t;
+
 #if MHD_VERSION >= 0x00096100
 static void free_callback(void *cls) { ogs_free(cls); }
 #endif
@@ -58,7 +77,10 @@ typedef struct ogs_metrics_spec_s {
     ogs_list_t                  inst_list; /* list of ogs_metrics_instance_t */
     unsigned int                num_labels;
     char                        *labels[MAX_LABELS];
-    prom_metric_t               *prom;
+
+    /* Histogram upper bounds, +Inf excluded */
+    unsigned int                num_of_bucket;
+    double                      *upper_bounds;
 } ogs_metrics_spec_t;
 
 typedef struct ogs_metrics_inst_s {
@@ -66,14 +88,26 @@ typedef struct ogs_metrics_inst_s {
     ogs_list_t              entry; /* included in ogs_metrics_spec_t spec */
     unsigned int            num_labels;
     char                    *label_values[MAX_LABELS];
+
+    char                    *labels;    /* rendered, e.g. a="1",b="2" */
+
+    ogs_metrics_shard_t     shard[MAX_SHARDS];
+    /* Histogram : (num_of_bucket+1) counters per shard, +Inf last */
+    uint64_t                *bucket;
 } ogs_metrics_inst_t;
 
+typedef struct ogs_metrics_text_s {
+    char *buf;
+    size_t len, cap;
+} ogs_metrics_text_t;
+
 static OGS_POOL(metrics_spec_pool, ogs_metrics_spec_t);
 static OGS_POOL(metrics_server_pool, ogs_metrics_server_t);
 
 /* Forward decls */
 static int ogs_metrics_context_server_start(ogs_metrics_server_t *server);
 static int ogs_metrics_context_server_stop(ogs_metrics_server_t *server);
+static char *ogs_metrics_render(ogs_metrics_context_t *ctx, size_t *len);
 
 void ogs_metrics_server_init(ogs_metrics_context_t *ctx)
 {
@@ -283,8 +317,15 @@ mhd_server_access_handler(void *cls, struct MHD_Connection *connection,
 
     /* Prometheus metrics plain-text */
     if (strcmp(url, "/metrics") == 0) {
-        buf = prom_collector_registry_bridge(PROM_COLLECTOR_REGISTRY_DEFAULT);
-        rsp = MHD_create_response_from_buffer(strlen(buf), (void *)buf, MHD_RESPMEM_MUST_COPY);
+        char *text = NULL;
+        size_t len = 0;
+
+        if (ogs_metrics_collector)
+            ogs_metrics_collector();
+        text = ogs_metrics_render(ogs_metrics_self(), &len);
+        rsp = MHD_create_response_from_buffer(len, (void *)text, MHD_RESPMEM_MUST_COPY);
+        ogs_free(text);
+        if (!rsp) return (_MHD_Result)MHD_NO;
         MHD_add_response_header(rsp, "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
         ret = MHD_queue_response(connection, MHD_HTTP_OK, rsp);
         MHD_destroy_response(rsp);
@@ -406,13 +447,43 @@ static int ogs_metrics_context_server_stop(ogs_metrics_server_t *server)
     return OGS_OK;
 }
 
-/* ---- Metric spec/inst API (unchanged) ---------------------------------- */
+/* ---- Metric spec/inst API ---------------------------------------------- */
+
+static OGS_THREAD_LOCAL int shard_index = -1;
+static int next_shard_index = 0;
+
+static ogs_inline int shard_self(void)
+{
+    if (shard_index < 0)
+        shard_index = __atomic_fetch_add(
+                &next_shard_index, 1, __ATOMIC_RELAXED) % MAX_SHARDS;
+    return shard_index;
+}
+
+static void shard_store(ogs_metrics_inst_t *inst, int64_t val)
+{
+    int i;
+
+    for (i = 0; i < MAX_SHARDS; i++)
+        __atomic_store_n(&inst->shard[i].value,
+                i == 0 ? val : 0, __ATOMIC_RELAXED);
+}
+
+static int64_t shard_sum(ogs_metrics_inst_t *inst)
+{
+    int64_t sum = 0;
+    int i;
+
+    for (i = 0; i < MAX_SHARDS; i++)
+        sum += __atomic_load_n(&inst->shard[i].value, __ATOMIC_RELAXED);
+
+    return sum;
+}
 
 void ogs_metrics_spec_init(ogs_metrics_context_t *ctx)
 {
     ogs_list_init(&ctx->spec_list);
     ogs_pool_init(&metrics_spec_pool, ogs_app()->metrics.max_specs);
-    prom_collector_registry_default_init();
 }
 
 void ogs_metrics_spec_final(ogs_metrics_context_t *ctx)
@@ -422,7 +493,6 @@ void ogs_metrics_spec_final(ogs_metrics_context_t *ctx)
     ogs_list_for_each_entry_safe(&ctx->spec_list, next, spec, entry)
         ogs_metrics_spec_free(spec);
 
-    prom_collector_registry_destroy(PROM_COLLECTOR_REGISTRY_DEFAULT);
     ogs_pool_final(&metrics_spec_pool);
 }
 
@@ -434,8 +504,6 @@ ogs_metrics_spec_t *ogs_metrics_spec_new(
 {
     ogs_metrics_spec_t *spec;
     unsigned int i;
-    prom_histogram_buckets_t *buckets = NULL;
-    double *upper_bounds;
 
     ogs_assert(name);
     ogs_assert(description);
@@ -458,53 +526,51 @@ ogs_metrics_spec_t *ogs_metrics_spec_new(
 
     switch (type) {
     case OGS_METRICS_METRIC_TYPE_COUNTER:
-        spec->prom = prom_counter_new(spec->name, spec->description,
-                                      spec->num_labels, (const char **)spec->labels);
-        break;
     case OGS_METRICS_METRIC_TYPE_GAUGE:
-        spec->prom = prom_gauge_new(spec->name, spec->description,
-                                    spec->num_labels, (const char **)spec->labels);
         break;
     case OGS_METRICS_METRIC_TYPE_HISTOGRAM:
         ogs_assert(histogram_params);
+        ogs_assert(histogram_params->count > 0);
+
+        spec->num_of_bucket = histogram_params->count;
+        spec->upper_bounds = ogs_calloc(
+                spec->num_of_bucket, sizeof(*spec->upper_bounds));
+        ogs_assert(spec->upper_bounds);
+
         switch (histogram_params->type) {
         case OGS_METRICS_HISTOGRAM_BUCKET_TYPE_EXPONENTIAL:
-            buckets = prom_histogram_buckets_exponential(histogram_params->exp.start,
-                    histogram_params->exp.factor, histogram_params->count);
-            ogs_assert(buckets);
+            ogs_assert(histogram_params->exp.start > 0);
+            ogs_assert(histogram_params->exp.factor > 1);
+            spec->upper_bounds[0] = histogram_params->exp.start;
+            for (i = 1; i < spec->num_of_bucket; i++)
+                spec->upper_bounds[i] = spec->upper_bounds[i - 1] *
+                    histogram_params->exp.factor;
             break;
         case OGS_METRICS_HISTOGRAM_BUCKET_TYPE_LINEAR:
-            buckets = prom_histogram_buckets_linear(histogram_params->lin.start,
-                    histogram_params->lin.width, histogram_params->count);
-            ogs_assert(buckets);
+            ogs_assert(histogram_params->lin.width > 0);
+            for (i = 0; i < spec->num_of_bucket; i++)
+                spec->upper_bounds[i] = histogram_params->lin.start +
+                    histogram_params->lin.width * i;
             break;
         case OGS_METRICS_HISTOGRAM_BUCKET_TYPE_VARIABLE:
-            buckets = (prom_histogram_buckets_t *)prom_malloc(sizeof(prom_histogram_buckets_t));
-            ogs_assert(buckets);
-            ogs_assert(histogram_params->count <= OGS_METRICS_HIST_VAR_BUCKETS_MAX);
-            buckets->count = histogram_params->count;
-
-            upper_bounds = (double *)prom_malloc(sizeof(double) * histogram_params->count);
-            ogs_assert(upper_bounds);
-            for (i = 0; i < histogram_params->count; i++) {
-                upper_bounds[i] = histogram_params->var.buckets[i];
-                if (i > 0) ogs_assert(upper_bounds[i] > upper_bounds[i - 1]);
+            ogs_assert(histogram_params->count <=
+                    OGS_METRICS_HIST_VAR_BUCKETS_MAX);
+            for (i = 0; i < spec->num_of_bucket; i++) {
+                spec->upper_bounds[i] = histogram_params->var.buckets[i];
+                if (i > 0)
+                    ogs_assert(spec->upper_bounds[i] >
+                            spec->upper_bounds[i - 1]);
             }
-            buckets->upper_bounds = upper_bounds;
             break;
         default:
             ogs_assert_if_reached();
             break;
         }
-        spec->prom = prom_histogram_new(spec->name, spec->description,
-                buckets, spec->num_labels, (const char **)spec->labels);
-        ogs_assert(spec->prom);
         break;
     default:
         ogs_assert_if_reached();
         break;
     }
-    prom_collector_registry_must_register_metric(spec->prom);
 
     ogs_list_add(&ctx->spec_list, &spec->entry);
     return spec;
@@ -524,10 +590,52 @@ void ogs_metrics_spec_free(ogs_metrics_spec_t *spec)
     ogs_free(spec->description);
     for (i = 0; i < spec->num_labels; i++)
         ogs_free(spec->labels[i]);
+    if (spec->upper_bounds)
+        ogs_free(spec->upper_bounds);
 
     ogs_pool_free(&metrics_spec_pool, spec);
 }
 
+/* Label values escape backslash, double-quote and line feed */
+static char *render_labels(ogs_metrics_spec_t *spec, char **label_values)
+{
+    char *labels = NULL, *p;
+    const char *v;
+    size_t size = 1;
+    unsigned int i;
+
+    for (i = 0; i < spec->num_labels; i++)
+        size += strlen(spec->labels[i]) +
+            strlen(label_values[i]) * 2 + sizeof(",=\"\"");
+
+    labels = ogs_malloc(size);
+    ogs_assert(labels);
+
+    p = labels;
+    for (i = 0; i < spec->num_labels; i++) {
+        if (i > 0)
+            *p++ = ',';
+        p += strlen(strcpy(p, spec->labels[i]));
+        *p++ = '=';
+        *p++ = '"';
+        for (v = label_values[i]; *v; v++) {
+            if (*v == '\\' || *v == '"') {
+                *p++ = '\\';
+                *p++ = *v;
+            } else if (*v == '\n') {
+                *p++ = '\\';
+                *p++ = 'n';
+            } else {
+                *p++ = *v;
+            }
+        }
+        *p++ = '"';
+    }
+    *p = 0;
+
+    return labels;
+}
+
 ogs_metrics_inst_t *ogs_metrics_inst_new(
         ogs_metrics_spec_t *spec,
         unsigned int num_labels, const char **label_values)
@@ -546,6 +654,14 @@ ogs_metrics_inst_t *ogs_metrics_inst_new(
         ogs_assert(label_values[i]);
         inst->label_values[i] = ogs_strdup(label_values[i]);
     }
+    inst->labels = render_labels(spec, inst->label_values);
+
+    if (spec->type == OGS_METRICS_METRIC_TYPE_HISTOGRAM) {
+        inst->bucket = ogs_calloc(MAX_SHARDS * (spec->num_of_bucket + 1),
+                sizeof(*inst->bucket));
+        ogs_assert(inst->bucket);
+    }
+
     ogs_list_add(&spec->inst_list, &inst->entry);
     ogs_metrics_inst_reset(inst);
     return inst;
@@ -559,6 +675,9 @@ void ogs_metrics_inst_free(ogs_metrics_inst_t *inst)
 
     for (i = 0; i < inst->num_labels; i++)
         ogs_free(inst->label_values[i]);
+    ogs_free(inst->labels);
+    if (inst->bucket)
+        ogs_free(inst->bucket);
 
     ogs_free(inst);
 }
@@ -567,7 +686,7 @@ void ogs_metrics_inst_set(ogs_metrics_inst_t *inst, int val)
 {
     switch (inst->spec->type) {
     case OGS_METRICS_METRIC_TYPE_GAUGE:
-        prom_gauge_set(inst->spec->prom, (double)val, (const char **)inst->label_values);
+        shard_store(inst, val);
         break;
     default:
         ogs_assert_if_reached();
@@ -579,10 +698,10 @@ void ogs_metrics_inst_reset(ogs_metrics_inst_t *inst)
 {
     switch (inst->spec->type) {
     case OGS_METRICS_METRIC_TYPE_COUNTER:
-        prom_counter_add(inst->spec->prom, 0.0, (const char **)inst->label_values);
+        shard_store(inst, 0);
         break;
     case OGS_METRICS_METRIC_TYPE_GAUGE:
-        prom_gauge_set(inst->spec->prom, (double)inst->spec->initial_val, (const char **)inst->label_values);
+        shard_store(inst, inst->spec->initial_val);
         break;
     default:
         break;
@@ -591,20 +710,26 @@ void ogs_metrics_inst_reset(ogs_metrics_inst_t *inst)
 
 void ogs_metrics_inst_add(ogs_metrics_inst_t *inst, int val)
 {
-    switch (inst->spec->type) {
+    ogs_metrics_spec_t *spec = inst->spec;
+    unsigned int i;
+    int shard = shard_self();
+
+    switch (spec->type) {
     case OGS_METRICS_METRIC_TYPE_COUNTER:
         ogs_assert(val >= 0);
-        prom_counter_add(inst->spec->prom, (double)val, (const char **)inst->label_values);
-        break;
+        OGS_GNUC_FALLTHROUGH;
     case OGS_METRICS_METRIC_TYPE_GAUGE:
-        if (val >= 0)
-            prom_gauge_add(inst->spec->prom, (double)val, (const char **)inst->label_values);
-        else
-            prom_gauge_sub(inst->spec->prom, (double)-1.0*(double)val, (const char **)inst->label_values);
+        __atomic_fetch_add(&inst->shard[shard].value, val, __ATOMIC_RELAXED);
         break;
     case OGS_METRICS_METRIC_TYPE_HISTOGRAM:
         ogs_assert(val >= 0);
-        prom_histogram_observe(inst->spec->prom, (double)val, (const char **)inst->label_values);
+        for (i = 0; i < spec->num_of_bucket; i++)
+            if (val <= spec->upper_bounds[i])
+                break;
+        __atomic_fetch_add(
+                &inst->bucket[shard * (spec->num_of_bucket + 1) + i],
+                1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&inst->shard[shard].value, val, __ATOMIC_RELAXED);
         break;
     default:
         ogs_assert_if_reached();
@@ -612,3 +737,125 @@ void ogs_metrics_inst_add(ogs_metrics_inst_t *inst, int val)
     }
 }
 
+/* ---- Text exposition --------------------------------------------------- */
+
+static void text_printf(ogs_metrics_text_t *text, const char *fmt, ...)
+    OGS_GNUC_PRINTF(2, 3);
+
+static void text_printf(ogs_metrics_text_t *text, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    for ( ;; ) {
+        va_start(ap, fmt);
+        n = ogs_vsnprintf(text->buf + text->len, text->cap - text->len, fmt, ap);
+        va_end(ap);
+        ogs_assert(n >= 0);
+
+        if (text->len + n < text->cap)
+            break;
+
+        text->cap = ogs_max(text->cap * 2, text->len + n + 1);
+        text->buf = ogs_realloc(text->buf, text->cap);
+        ogs_assert(text->buf);
+    }
+
+    text->len += n;
+}
+
+static void render_help(ogs_metrics_text_t *text, const char *description)
+{
+    const char *p;
+
+    for (p = description; *p; p++) {
+        if (*p == '\\')
+            text_printf(text, "\\\\");
+        else if (*p == '\n')
+            text_printf(text, "\\n");
+        else
+            text_printf(text, "%c", *p);
+    }
+}
+
+static void render_histogram(ogs_metrics_text_t *text,
+        ogs_metrics_spec_t *spec, ogs_metrics_inst_t *inst)
+{
+    uint64_t count = 0;
+    unsigned int i;
+    int j;
+    const char *sep = inst->labels[0] ? "," : "";
+
+    for (i = 0; i <= spec->num_of_bucket; i++) {
+        for (j = 0; j < MAX_SHARDS; j++)
+            count += __atomic_load_n(
+                    &inst->bucket[j * (spec->num_of_bucket + 1) + i],
+                    __ATOMIC_RELAXED);
+
+        if (i < spec->num_of_bucket)
+            text_printf(text, "%s_bucket{%s%sle=\"%.15g\"} %llu\n",
+                    spec->name, inst->labels, sep,
+                    spec->upper_bounds[i], (unsigned long long)count);
+        else
+            text_printf(text, "%s_bucket{%s%sle=\"+Inf\"} %llu\n",
+                    spec->name, inst->labels, sep,
+                    (unsigned long long)count);
+    }
+
+    if (inst->labels[0]) {
+        text_printf(text, "%s_sum{%s} %lld\n",
+                spec->name, inst->labels, (long long)shard_sum(inst));
+        text_printf(text, "%s_count{%s} %llu\n",
+                spec->name, inst->labels, (unsigned long long)count);
+    } else {
+        text_printf(text, "%s_sum %lld\n",
+                spec->name, (long long)shard_sum(inst));
+        text_printf(text, "%s_count %llu\n",
+                spec->name, (unsigned long long)count);
+    }
+}
+
+static char *ogs_metrics_render(ogs_metrics_context_t *ctx, size_t *len)
+{
+    static const char *type_name[] = {
+        [OGS_METRICS_METRIC_TYPE_COUNTER] = "counter",
+        [OGS_METRICS_METRIC_TYPE_GAUGE] = "gauge",
+        [OGS_METRICS_METRIC_TYPE_HISTOGRAM] = "histogram",
+    };
+    ogs_metrics_text_t text;
+    ogs_metrics_spec_t *spec = NULL;
+    ogs_metrics_inst_t *inst = NULL;
+
+    ogs_assert(ctx);
+    ogs_assert(len);
+
+    text.len = 0;
+    text.cap = 16 * 1024;
+    text.buf = ogs_malloc(text.cap);
+    ogs_assert(text.buf);
+    text.buf[0] = 0;
+
+    ogs_list_for_each_entry(&ctx->spec_list, spec, entry) {
+        text_printf(&text, "# HELP %s ", spec->name);
+        render_help(&text, spec->description);
+        text_printf(&text, "\n# TYPE %s %s\n",
+                spec->name, type_name[spec->type]);
+
+        ogs_list_for_each_entry(&spec->inst_list, inst, entry) {
+            if (spec->type == OGS_METRICS_METRIC_TYPE_HISTOGRAM)
+                render_histogram(&text, spec, inst);
+            else if (inst->labels[0])
+                text_printf(&text, "%s{%s} %lld\n",
+                        spec->name, inst->labels,
+                        (long long)shard_sum(inst));
+            else
+                text_printf(&text, "%s %lld\n",
+                        spec->name, (long long)shard_sum(inst));
+        }
+
+        text_printf(&text, "\n");
+    }
+
+    *len = text.len;
+    return text.buf;
+}
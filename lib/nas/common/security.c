@@ -19,14 +19,47 @@
 
 #include "ogs-nas-common.h"
 
+/*
+ * Returns true if the key schedule of the context must be computed again.
+ * EEAx and EIAx share the same identity values,
+ * so a context must only be used for ciphering or only for integrity.
+ */
+static bool cipher_ctx_update(ogs_nas_cipher_ctx_t *ctx,
+        uint8_t algorithm_identity, uint8_t *key)
+{
+    if (ctx->ready &&
+        ctx->algorithm_identity == algorithm_identity &&
+        memcmp(ctx->key, key, OGS_KEY_LEN) == 0)
+        return false;
+
+    ctx->algorithm_identity = algorithm_identity;
+    memcpy(ctx->key, key, OGS_KEY_LEN);
+    ctx->ready = true;
+
+    return true;
+}
+
 void ogs_nas_mac_calculate(uint8_t algorithm_identity,
         uint8_t *knas_int, uint32_t count, uint8_t bearer, 
         uint8_t direction, ogs_pkbuf_t *pkbuf, uint8_t *mac)
+{
+    ogs_nas_cipher_ctx_t ctx;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ogs_nas_mac_calculate_ctx(&ctx, algorithm_identity,
+            knas_int, count, bearer, direction, pkbuf, mac);
+}
+
+void ogs_nas_mac_calculate_ctx(ogs_nas_cipher_ctx_t *ctx,
+        uint8_t algorithm_identity,
+        uint8_t *knas_int, uint32_t count, uint8_t bearer, 
+        uint8_t direction, ogs_pkbuf_t *pkbuf, uint8_t *mac)
 {
     uint8_t *ivec = NULL;;
     uint8_t cmac[16];
     uint32_t mac32;
 
+    ogs_assert(ctx);
     ogs_assert(knas_int);
     ogs_assert(bearer <= 0x1f);
     ogs_assert(direction == 0 || direction == 1);
@@ -41,6 +74,9 @@ void ogs_nas_mac_calculate(uint8_t algorithm_identity,
                 pkbuf->data, (pkbuf->len << 3), mac);
         break;
     case OGS_NAS_SECURITY_ALGORITHMS_128_EIA2:
+        if (cipher_ctx_update(ctx, algorithm_identity, knas_int))
+            ogs_aes_cmac_setup(&ctx->cmac, knas_int);
+
         count = htonl(count);
 
         ogs_pkbuf_push(pkbuf, 8);
@@ -50,7 +86,8 @@ void ogs_nas_mac_calculate(uint8_t algorithm_identity,
         memcpy(ivec + 0, &count, sizeof(count));
         ivec[4] = (bearer << 3) | (direction << 2);
 
-        ogs_aes_cmac_calculate(cmac, knas_int, pkbuf->data, pkbuf->len);
+        ogs_aes_cmac_calculate_ctx(&ctx->cmac,
+                cmac, pkbuf->data, pkbuf->len);
         memcpy(mac, cmac, 4);
 
         ogs_pkbuf_pull(pkbuf, 8);
@@ -74,10 +111,22 @@ void ogs_nas_mac_calculate(uint8_t algorithm_identity,
 void ogs_nas_encrypt(uint8_t algorithm_identity,
         uint8_t *knas_enc, uint32_t count, uint8_t bearer, 
         uint8_t direction, ogs_pkbuf_t *pkbuf)
+{
+    ogs_nas_cipher_ctx_t ctx;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ogs_nas_encrypt_ctx(&ctx, algorithm_identity,
+            knas_enc, count, bearer, direction, pkbuf);
+}
+
+void ogs_nas_encrypt_ctx(ogs_nas_cipher_ctx_t *ctx,
+        uint8_t algorithm_identity,
+        uint8_t *knas_enc, uint32_t count, uint8_t bearer, 
+        uint8_t direction, ogs_pkbuf_t *pkbuf)
 {
     uint8_t ivec[16];
-    SNOW_CTX ctx;
 
+    ogs_assert(ctx);
     ogs_assert(knas_enc);
     ogs_assert(bearer <= 0x1f);
     ogs_assert(direction == 0 || direction == 1);
@@ -87,21 +136,19 @@ void ogs_nas_encrypt(uint8_t algorithm_identity,
 
     switch (algorithm_identity) {
     case OGS_NAS_SECURITY_ALGORITHMS_128_EEA1:
-#if 0 /* Issue #2581 : snow_3g_f8 have memory problem */
         snow_3g_f8(knas_enc, count, bearer, direction, 
                 pkbuf->data, (pkbuf->len << 3));
-#else
-        SNOW_init(count, bearer, direction, (const char *)knas_enc, &ctx);
-        SNOW(pkbuf->len, pkbuf->data, pkbuf->data, &ctx);
-#endif
         break;
     case OGS_NAS_SECURITY_ALGORITHMS_128_EEA2:
+        if (cipher_ctx_update(ctx, algorithm_identity, knas_enc))
+            ctx->aes.nrounds = ogs_aes_setup_enc(ctx->aes.rk, knas_enc, 128);
+
         count = htonl(count);
 
         memset(ivec, 0, 16);
         memcpy(ivec + 0, &count, sizeof(count));
         ivec[4] = (bearer << 3) | (direction << 2);
-        ogs_aes_ctr128_encrypt(knas_enc, ivec, 
+        ogs_aes_ctr128_encrypt_rk(ctx->aes.rk, ctx->aes.nrounds, ivec, 
                 pkbuf->data, pkbuf->len, pkbuf->data);
         break;
     case OGS_NAS_SECURITY_ALGORITHMS_128_EEA3:
@@ -31,6 +31,44 @@ extern "C" {
 #define OGS_NAS_SECURITY_DOWNLINK_DIRECTION 1
 #define OGS_NAS_SECURITY_UPLINK_DIRECTION 0
 
+/*
+ * Per-UE ciphering context.
+ *
+ * It remembers the algorithm and the key of the last call and keeps
+ * whatever can be derived from the key alone, i.e. the AES key schedule
+ * for 128-EEA2 and the CMAC subkeys for 128-EIA2, so that they are not
+ * recomputed for every NAS message. SNOW 3G and ZUC are keyed together
+ * with COUNT/BEARER/DIRECTION and have nothing to cache.
+ *
+ * The context is set up again as soon as the algorithm or the key differ,
+ * so a zeroed context is valid and a key refresh needs no extra call.
+ * A context serves either ciphering or integrity, not both,
+ * and must be used by one thread at a time.
+ */
+typedef struct ogs_nas_cipher_ctx_s {
+    bool            ready;
+    uint8_t         algorithm_identity;
+    uint8_t         key[OGS_KEY_LEN];
+
+    union {
+        struct {
+            uint32_t rk[OGS_AES_RKLENGTH(128)];
+            int nrounds;
+        } aes;
+        ogs_aes_cmac_ctx_t cmac;
+    };
+} ogs_nas_cipher_ctx_t;
+
+void ogs_nas_mac_calculate_ctx(ogs_nas_cipher_ctx_t *ctx,
+    uint8_t algorithm_identity,
+    uint8_t *knas_int, uint32_t count, uint8_t bearer,
+    uint8_t direction, ogs_pkbuf_t *pkbuf, uint8_t *mac);
+
+void ogs_nas_encrypt_ctx(ogs_nas_cipher_ctx_t *ctx,
+    uint8_t algorithm_identity,
+    uint8_t *knas_enc, uint32_t count, uint8_t bearer,
+    uint8_t direction, ogs_pkbuf_t *pkbuf);
+
 void ogs_nas_mac_calculate(uint8_t algorithm_identity,
     uint8_t *knas_int, uint32_t count, uint8_t bearer, 
     uint8_t direction, ogs_pkbuf_t *pkbuf, uint8_t *mac);
@@ -2073,6 +2073,42 @@ void ogs_pfcp_qer_remove_all(ogs_pfcp_sess_t *sess)
         ogs_pfcp_qer_remove(qer);
 }
 
+/* Burst size : MBR during this time, at least one maximum packet */
+#define OGS_PFCP_METER_BURST_NSEC (50 * 1000 * 1000ULL)
+
+/*
+ * MBR token bucket as a Generic Cell Rate Algorithm.
+ *
+ * The bucket is a single word, the time it is full again, updated with
+ * compare-and-swap. So the threads forwarding the packets of one QER
+ * can share its bucket and the QER never gets more than its MBR.
+ *
+ * 'rate' is in Bytes per second. Returns false if 'size' Bytes exceed it.
+ */
+bool ogs_pfcp_meter_conform(
+        ogs_pfcp_meter_t *meter, uint64_t rate, size_t size)
+{
+    uint64_t now, burst, cost, tat, next;
+
+    ogs_assert(meter);
+    ogs_assert(rate);
+
+    now = (uint64_t)ogs_get_monotonic_time() * 1000;
+    burst = ogs_max(OGS_PFCP_METER_BURST_NSEC,
+            (OGS_MAX_PKT_LEN * 1000000000ULL + rate - 1) / rate);
+    cost = ((uint64_t)size * 1000000000ULL + rate - 1) / rate;
+
+    tat = __atomic_load_n(&meter->tat, __ATOMIC_RELAXED);
+    do {
+        next = ogs_max(tat, now) + cost;
+        if (next - now > burst)
+            return false;
+    } while (!__atomic_compare_exchange_n(&meter->tat, &tat, next,
+                true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return true;
+}
+
 ogs_pfcp_bar_t *ogs_pfcp_bar_new(ogs_pfcp_sess_t *sess)
 {
     ogs_pfcp_bar_t *bar = NULL;
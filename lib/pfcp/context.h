@@ -101,6 +101,8 @@ typedef struct ogs_pfcp_node_s {
 
     ogs_list_t      local_list;
     ogs_list_t      remote_list;
+    ogs_hash_t      *local_xact_hash;   /* Transactions indexed by XID */
+    ogs_hash_t      *remote_xact_hash;
 
     ogs_fsm_t       sm;             /* A state machine */
     ogs_timer_t     *t_association; /* timer to retry to associate peer node */
@@ -301,6 +303,10 @@ typedef struct ogs_pfcp_urr_s {
     ogs_pfcp_sess_t         *sess;
 } ogs_pfcp_urr_t;
 
+typedef struct ogs_pfcp_meter_s {
+    uint64_t                tat;        /* Bucket is full again (nsec) */
+} ogs_pfcp_meter_t;
+
 typedef struct ogs_pfcp_qer_s {
     ogs_lnode_t             lnode;
 
@@ -313,6 +319,9 @@ typedef struct ogs_pfcp_qer_s {
 
     uint8_t                 qfi;
 
+    /* UP function : MBR token bucket per direction (Uplink, Downlink) */
+    ogs_pfcp_meter_t        meter[2];
+
     ogs_pfcp_sess_t         *sess;
 } ogs_pfcp_qer_t;
 
@@ -490,6 +499,9 @@ ogs_pfcp_qer_t *ogs_pfcp_qer_find_or_add(
 void ogs_pfcp_qer_remove(ogs_pfcp_qer_t *qer);
 void ogs_pfcp_qer_remove_all(ogs_pfcp_sess_t *sess);
 
+bool ogs_pfcp_meter_conform(
+        ogs_pfcp_meter_t *meter, uint64_t rate, size_t size);
+
 ogs_pfcp_bar_t *ogs_pfcp_bar_new(ogs_pfcp_sess_t *sess);
 void ogs_pfcp_bar_delete(ogs_pfcp_bar_t *bar);
 
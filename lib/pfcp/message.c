@@ -4691,6 +4691,92 @@ ogs_tlv_desc_t ogs_pfcp_msg_desc_pfcp_session_report_response =
 }};
 
 
+static size_t pfcp_message_size(uint8_t type)
+{
+    switch(type)
+    {
+        case OGS_PFCP_HEARTBEAT_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_heartbeat_request) +
+                sizeof(ogs_pfcp_heartbeat_request_t);
+        case OGS_PFCP_HEARTBEAT_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_heartbeat_response) +
+                sizeof(ogs_pfcp_heartbeat_response_t);
+        case OGS_PFCP_PFD_MANAGEMENT_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_pfd_management_request) +
+                sizeof(ogs_pfcp_pfd_management_request_t);
+        case OGS_PFCP_PFD_MANAGEMENT_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_pfd_management_response) +
+                sizeof(ogs_pfcp_pfd_management_response_t);
+        case OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_association_setup_request) +
+                sizeof(ogs_pfcp_association_setup_request_t);
+        case OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_association_setup_response) +
+                sizeof(ogs_pfcp_association_setup_response_t);
+        case OGS_PFCP_ASSOCIATION_UPDATE_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_association_update_request) +
+                sizeof(ogs_pfcp_association_update_request_t);
+        case OGS_PFCP_ASSOCIATION_UPDATE_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_association_update_response) +
+                sizeof(ogs_pfcp_association_update_response_t);
+        case OGS_PFCP_ASSOCIATION_RELEASE_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_association_release_request) +
+                sizeof(ogs_pfcp_association_release_request_t);
+        case OGS_PFCP_ASSOCIATION_RELEASE_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_association_release_response) +
+                sizeof(ogs_pfcp_association_release_response_t);
+        case OGS_PFCP_VERSION_NOT_SUPPORTED_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_version_not_supported_response) +
+                sizeof(ogs_pfcp_version_not_supported_response_t);
+        case OGS_PFCP_NODE_REPORT_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_node_report_request) +
+                sizeof(ogs_pfcp_node_report_request_t);
+        case OGS_PFCP_NODE_REPORT_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_node_report_response) +
+                sizeof(ogs_pfcp_node_report_response_t);
+        case OGS_PFCP_SESSION_SET_DELETION_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_set_deletion_request) +
+                sizeof(ogs_pfcp_session_set_deletion_request_t);
+        case OGS_PFCP_SESSION_SET_DELETION_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_set_deletion_response) +
+                sizeof(ogs_pfcp_session_set_deletion_response_t);
+        case OGS_PFCP_SESSION_SET_MODIFICATION_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_set_modification_request) +
+                sizeof(ogs_pfcp_session_set_modification_request_t);
+        case OGS_PFCP_SESSION_SET_MODIFICATION_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_set_modification_response) +
+                sizeof(ogs_pfcp_session_set_modification_response_t);
+        case OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_establishment_request) +
+                sizeof(ogs_pfcp_session_establishment_request_t);
+        case OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_establishment_response) +
+                sizeof(ogs_pfcp_session_establishment_response_t);
+        case OGS_PFCP_SESSION_MODIFICATION_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_modification_request) +
+                sizeof(ogs_pfcp_session_modification_request_t);
+        case OGS_PFCP_SESSION_MODIFICATION_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_modification_response) +
+                sizeof(ogs_pfcp_session_modification_response_t);
+        case OGS_PFCP_SESSION_DELETION_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_deletion_request) +
+                sizeof(ogs_pfcp_session_deletion_request_t);
+        case OGS_PFCP_SESSION_DELETION_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_deletion_response) +
+                sizeof(ogs_pfcp_session_deletion_response_t);
+        case OGS_PFCP_SESSION_REPORT_REQUEST_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_report_request) +
+                sizeof(ogs_pfcp_session_report_request_t);
+        case OGS_PFCP_SESSION_REPORT_RESPONSE_TYPE:
+            return offsetof(ogs_pfcp_message_t, pfcp_session_report_response) +
+                sizeof(ogs_pfcp_session_report_response_t);
+        default:
+            break;
+    }
+
+    return sizeof(ogs_pfcp_header_t);
+}
+
 ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf)
 {
     int rv = OGS_ERROR;
@@ -4705,12 +4791,6 @@ ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf)
     h = (ogs_pfcp_header_t *)pkbuf->data;
     ogs_assert(h);
 
-    pfcp_message = ogs_calloc(1, sizeof(*pfcp_message));
-    if (!pfcp_message) {
-        ogs_error("No memory");
-        return NULL;
-    }
-
     if (h->seid_presence)
         size = OGS_PFCP_HEADER_LEN;
     else
@@ -4718,7 +4798,14 @@ ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf)
 
     if (ogs_pkbuf_pull(pkbuf, size) == NULL) {
         ogs_error("ogs_pkbuf_pull() failed [len:%d]", pkbuf->len);
-        ogs_pfcp_message_free(pfcp_message);
+        return NULL;
+    }
+
+    /* The union is as large as the largest message, so only
+     * the part used by this type of message is allocated */
+    pfcp_message = ogs_calloc(1, pfcp_message_size(h->type));
+    if (!pfcp_message) {
+        ogs_error("No memory");
         return NULL;
     }
     memcpy(&pfcp_message->h, pkbuf->data - size, size);
@@ -2185,6 +2185,10 @@ typedef struct ogs_pfcp_message_s {
    };
 } ogs_pfcp_message_t;
 
+/*
+ * ogs_pfcp_parse_msg() only allocates the header and the member of
+ * the union selected by h.type, so no other member may be accessed.
+ */
 ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf);
 void ogs_pfcp_message_free(ogs_pfcp_message_t *pfcp_message);
 ogs_pkbuf_t *ogs_pfcp_build_msg(ogs_pfcp_message_t *pfcp_message);
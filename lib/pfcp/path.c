@@ -428,12 +428,11 @@ void ogs_pfcp_send_gtpu(ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *sendbuf)
         return;
     }
 
-    ogs_gtp_send_with_teid(
+    /* ogs_gtp_tx_batch_send() frees or queues the sendbuf */
+    ogs_gtp_tx_batch_send(
             gnode->sock,
             sendbuf, far->outer_header_creation.teid,
             &gnode->addr);
-
-    ogs_pkbuf_free(sendbuf);
 }
 
 void ogs_pfcp_send_buffered_gtpu(ogs_pfcp_pdr_t *pdr)
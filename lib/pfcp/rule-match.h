@@ -28,6 +28,24 @@
 extern "C" {
 #endif
 
+/*
+ * 5-tuple of an IP packet. Addresses are in network byte order
+ * as in ogs_ipfw_rule_t, ports in host byte order(zero unless TCP/UDP).
+ */
+typedef struct ogs_pfcp_flow_s {
+    uint8_t proto;
+    int addr_len;
+    uint32_t src[4];
+    uint32_t dst[4];
+    uint16_t src_port;
+    uint16_t dst_port;
+} ogs_pfcp_flow_t;
+
+int ogs_pfcp_flow_parse(ogs_pfcp_flow_t *flow, ogs_pkbuf_t *pkbuf);
+bool ogs_pfcp_ipfw_match_flow(ogs_ipfw_rule_t *ipfw, ogs_pfcp_flow_t *flow);
+
+ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_flow(
+                    ogs_pfcp_pdr_t *pdr, ogs_pfcp_flow_t *flow);
 ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_packet(
                     ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *pkbuf);
 
@@ -714,7 +714,11 @@ for (k, v) in sorted_msg_list:
 f.write("   };\n");
 f.write("} ogs_pfcp_message_t;\n\n")
 
-f.write("""ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf);
+f.write("""/*
+ * ogs_pfcp_parse_msg() only allocates the header and the member of
+ * the union selected by h.type, so no other member may be accessed.
+ */
+ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf);
 void ogs_pfcp_message_free(ogs_pfcp_message_t *pfcp_message);
 ogs_pkbuf_t *ogs_pfcp_build_msg(ogs_pfcp_message_t *pfcp_message);
 
@@ -794,7 +798,24 @@ for (k, v) in sorted_msg_list:
         f.write("}};\n\n")
 f.write("\n")
 
-f.write("""ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf)
+f.write("""static size_t pfcp_message_size(uint8_t type)
+{
+    switch(type)
+    {
+""")
+for (k, v) in sorted_msg_list:
+    if "ies" in msg_list[k]:
+        f.write("        case OGS_%s_TYPE:\n" % v_upper(k))
+        f.write("            return offsetof(ogs_pfcp_message_t, %s) +\n" % v_lower(k))
+        f.write("                sizeof(ogs_%s_t);\n" % v_lower(k))
+f.write("""        default:
+            break;
+    }
+
+    return sizeof(ogs_pfcp_header_t);
+}
+
+ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf)
 {
     int rv = OGS_ERROR;
     ogs_pfcp_header_t *h = NULL;
@@ -808,12 +829,6 @@ f.write("""ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf)
     h = (ogs_pfcp_header_t *)pkbuf->data;
     ogs_assert(h);
 
-    pfcp_message = ogs_calloc(1, sizeof(*pfcp_message));
-    if (!pfcp_message) {
-        ogs_error("No memory");
-        return NULL;
-    }
-
     if (h->seid_presence)
         size = OGS_PFCP_HEADER_LEN;
     else
@@ -821,7 +836,14 @@ f.write("""ogs_pfcp_message_t *ogs_pfcp_parse_msg(ogs_pkbuf_t *pkbuf)
 
     if (ogs_pkbuf_pull(pkbuf, size) == NULL) {
         ogs_error("ogs_pkbuf_pull() failed [len:%d]", pkbuf->len);
-        ogs_pfcp_message_free(pfcp_message);
+        return NULL;
+    }
+
+    /* The union is as large as the largest message, so only
+     * the part used by this type of message is allocated */
+    pfcp_message = ogs_calloc(1, pfcp_message_size(h->type));
+    if (!pfcp_message) {
+        ogs_error("No memory");
         return NULL;
     }
     memcpy(&pfcp_message->h, pkbuf->data - size, size);
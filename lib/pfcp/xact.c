@@ -45,6 +45,10 @@ static void response_timeout(void *data);
 static void holding_timeout(void *data);
 static void delayed_commit_timeout(void *data);
 
+static void xact_hash_add(ogs_pfcp_xact_t *xact);
+static void xact_hash_remove(ogs_pfcp_xact_t *xact);
+static ogs_pfcp_xact_t *xact_hash_find(ogs_hash_t *hash, uint32_t xid);
+
 int ogs_pfcp_xact_init(void)
 {
     ogs_assert(ogs_pfcp_xact_initialized == 0);
@@ -105,6 +109,7 @@ ogs_pfcp_xact_t *ogs_pfcp_xact_local_create(ogs_pfcp_node_t *node,
 
     ogs_list_add(xact->org == OGS_PFCP_LOCAL_ORIGINATOR ?
             &xact->node->local_list : &xact->node->remote_list, xact);
+    xact_hash_add(xact);
 
     ogs_list_init(&xact->pdr_to_create_list);
 
@@ -152,6 +157,7 @@ static ogs_pfcp_xact_t *ogs_pfcp_xact_remote_create(
 
     ogs_list_add(xact->org == OGS_PFCP_LOCAL_ORIGINATOR ?
             &xact->node->local_list : &xact->node->remote_list, xact);
+    xact_hash_add(xact);
 
     ogs_debug("[%d] %s Create  peer %s",
             xact->xid,
@@ -169,6 +175,15 @@ void ogs_pfcp_xact_delete_all(ogs_pfcp_node_t *node)
         ogs_pfcp_xact_delete(xact);
     ogs_list_for_each_safe(&node->remote_list, next_xact, xact)
         ogs_pfcp_xact_delete(xact);
+
+    if (node->local_xact_hash) {
+        ogs_hash_destroy(node->local_xact_hash);
+        node->local_xact_hash = NULL;
+    }
+    if (node->remote_xact_hash) {
+        ogs_hash_destroy(node->remote_xact_hash);
+        node->remote_xact_hash = NULL;
+    }
 }
 
 ogs_pfcp_xact_t *ogs_pfcp_xact_find_by_id(ogs_pool_id_t id)
@@ -685,7 +700,7 @@ int ogs_pfcp_xact_receive(
     uint8_t type;
     uint32_t sqn, xid;
     ogs_pfcp_xact_stage_t stage;
-    ogs_list_t *list = NULL;
+    ogs_hash_t *hash = NULL;
     ogs_pfcp_xact_t *new = NULL;
 
     ogs_assert(node);
@@ -698,13 +713,13 @@ int ogs_pfcp_xact_receive(
 
     switch (stage) {
     case PFCP_XACT_INITIAL_STAGE:
-        list = &node->remote_list;
+        hash = node->remote_xact_hash;
         break;
     case PFCP_XACT_INTERMEDIATE_STAGE:
-        list = &node->local_list;
+        hash = node->local_xact_hash;
         break;
     case PFCP_XACT_FINAL_STAGE:
-        list = &node->local_list;
+        hash = node->local_xact_hash;
         break;
     default:
         ogs_error("[%d] Unexpected type %u from PFCP peer %s",
@@ -712,15 +727,12 @@ int ogs_pfcp_xact_receive(
         return OGS_ERROR;
     }
 
-    ogs_assert(list);
-    ogs_list_for_each(list, new) {
-        if (new->xid == xid) {
-            ogs_debug("[%d] %s Find    peer %s",
-                new->xid,
-                new->org == OGS_PFCP_LOCAL_ORIGINATOR ? "LOCAL " : "REMOTE",
-                ogs_sockaddr_to_string_static(node->addr_list));
-            break;
-        }
+    new = xact_hash_find(hash, xid);
+    if (new) {
+        ogs_debug("[%d] %s Find    peer %s",
+            new->xid,
+            new->org == OGS_PFCP_LOCAL_ORIGINATOR ? "LOCAL " : "REMOTE",
+            ogs_sockaddr_to_string_static(node->addr_list));
     }
 
     if (!new) {
@@ -807,9 +819,86 @@ int ogs_pfcp_xact_delete(ogs_pfcp_xact_t *xact)
     if (xact->tm_delayed_commit)
         ogs_timer_delete(xact->tm_delayed_commit);
 
+    xact_hash_remove(xact);
     ogs_list_remove(xact->org == OGS_PFCP_LOCAL_ORIGINATOR ?
             &xact->node->local_list : &xact->node->remote_list, xact);
     ogs_pool_id_free(&pool, xact);
 
     return OGS_OK;
 }
+
+/*
+ * The XID index of the node replaces the scan of local_list/remote_list,
+ * which grows with the number of outstanding transactions.
+ *
+ * A transaction may reuse the XID of another one, e.g. the remote one
+ * created for an unexpected response. The index points to the oldest,
+ * the others are chained behind it in creation order, so the next one
+ * is found again once the oldest is deleted.
+ */
+static void xact_hash_add(ogs_pfcp_xact_t *xact)
+{
+    ogs_hash_t **hash = NULL;
+    ogs_pfcp_xact_t *first = NULL;
+
+    ogs_assert(xact);
+    ogs_assert(xact->node);
+
+    hash = xact->org == OGS_PFCP_LOCAL_ORIGINATOR ?
+            &xact->node->local_xact_hash : &xact->node->remote_xact_hash;
+    if (!*hash) {
+        *hash = ogs_hash_make();
+        ogs_assert(*hash);
+    }
+
+    xact->xid_next = NULL;
+
+    first = ogs_hash_get(*hash, &xact->xid, sizeof(xact->xid));
+    if (!first) {
+        ogs_hash_set(*hash, &xact->xid, sizeof(xact->xid), xact);
+        return;
+    }
+
+    while (first->xid_next)
+        first = first->xid_next;
+    first->xid_next = xact;
+}
+
+static void xact_hash_remove(ogs_pfcp_xact_t *xact)
+{
+    ogs_hash_t *hash = NULL;
+    ogs_pfcp_xact_t *first = NULL, *next = NULL;
+
+    ogs_assert(xact);
+    ogs_assert(xact->node);
+
+    hash = xact->org == OGS_PFCP_LOCAL_ORIGINATOR ?
+            xact->node->local_xact_hash : xact->node->remote_xact_hash;
+    ogs_assert(hash);
+
+    first = ogs_hash_get(hash, &xact->xid, sizeof(xact->xid));
+    ogs_assert(first);
+
+    if (first == xact) {
+        /* The key points into the transaction, so it is replaced too */
+        next = xact->xid_next;
+        ogs_hash_set(hash, &xact->xid, sizeof(xact->xid), NULL);
+        if (next)
+            ogs_hash_set(hash, &next->xid, sizeof(next->xid), next);
+        return;
+    }
+
+    while (first->xid_next != xact) {
+        first = first->xid_next;
+        ogs_assert(first);
+    }
+    first->xid_next = xact->xid_next;
+}
+
+static ogs_pfcp_xact_t *xact_hash_find(ogs_hash_t *hash, uint32_t xid)
+{
+    if (!hash)
+        return NULL;
+
+    return ogs_hash_get(hash, &xid, sizeof(xid));
+}
@@ -45,6 +45,7 @@ typedef struct ogs_pfcp_xact_s {
                                          local or remote */
 
     uint32_t        xid;            /**< Transaction ID */
+    struct ogs_pfcp_xact_s *xid_next; /**< Next one with the same XID */
     ogs_pfcp_node_t *node;          /**< Relevant PFCP node context */
 
     /**< Local timer expiration handler & Data*/
@@ -31,6 +31,7 @@ extern "C" {
 extern const char *OGS_EVENT_NAME_SBI_SERVER;
 extern const char *OGS_EVENT_NAME_SBI_CLIENT;
 extern const char *OGS_EVENT_NAME_SBI_TIMER;
+extern const char *OGS_EVENT_NAME_DBI;
 
 typedef enum {
     OGS_EVENT_BASE = OGS_FSM_USER_SIG,
@@ -39,6 +40,8 @@ typedef enum {
     OGS_EVENT_SBI_CLIENT,
     OGS_EVENT_SBI_TIMER,
 
+    OGS_EVENT_DBI,
+
     OGS_MAX_NUM_OF_PROTO_EVENT,
 
 } ogs_event_e;
@@ -60,6 +63,10 @@ typedef struct ogs_event_s {
         ogs_sbi_message_t *message;
     } sbi;
 
+    struct {
+        void *job;
+    } dbi;
+
 } ogs_event_t;
 
 #define OGS_EVENT_SIZE 256
@@ -840,6 +840,85 @@ ogs_slice_data_t *ogs_slice_find_by_s_nssai(
     return NULL;
 }
 
+static char **framed_routes_copy(char **src)
+{
+    char **dst = NULL;
+    int i;
+
+    if (!src)
+        return NULL;
+
+    dst = ogs_calloc(OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI, sizeof(dst[0]));
+    ogs_assert(dst);
+
+    for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
+        if (!src[i])
+            break;
+        dst[i] = ogs_strdup(src[i]);
+        ogs_assert(dst[i]);
+    }
+
+    return dst;
+}
+
+static void framed_routes_free(char **routes)
+{
+    int i;
+
+    if (!routes)
+        return;
+
+    for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
+        if (!routes[i])
+            break;
+        ogs_free(routes[i]);
+    }
+    ogs_free(routes);
+}
+
+void ogs_subscription_data_copy(ogs_subscription_data_t *dst,
+        const ogs_subscription_data_t *src)
+{
+    int i, j;
+
+    ogs_assert(dst);
+    ogs_assert(src);
+
+    memcpy(dst, src, sizeof(*dst));
+
+    if (src->imsi) {
+        dst->imsi = ogs_strdup(src->imsi);
+        ogs_assert(dst->imsi);
+    }
+    if (src->mme_host) {
+        dst->mme_host = ogs_strdup(src->mme_host);
+        ogs_assert(dst->mme_host);
+    }
+    if (src->mme_realm) {
+        dst->mme_realm = ogs_strdup(src->mme_realm);
+        ogs_assert(dst->mme_realm);
+    }
+
+    for (i = 0; i < src->num_of_slice; i++) {
+        const ogs_slice_data_t *src_slice = &src->slice[i];
+        ogs_slice_data_t *dst_slice = &dst->slice[i];
+
+        for (j = 0; j < src_slice->num_of_session; j++) {
+            const ogs_session_t *src_session = &src_slice->session[j];
+            ogs_session_t *dst_session = &dst_slice->session[j];
+
+            if (src_session->name) {
+                dst_session->name = ogs_strdup(src_session->name);
+                ogs_assert(dst_session->name);
+            }
+            dst_session->ipv4_framed_routes =
+                framed_routes_copy(src_session->ipv4_framed_routes);
+            dst_session->ipv6_framed_routes =
+                framed_routes_copy(src_session->ipv6_framed_routes);
+        }
+    }
+}
+
 void ogs_subscription_data_free(ogs_subscription_data_t *subscription_data)
 {
     int i, j;
@@ -859,6 +938,8 @@ void ogs_subscription_data_free(ogs_subscription_data_t *subscription_data)
         for (j = 0; j < slice_data->num_of_session; j++) {
             if (slice_data->session[j].name)
                 ogs_free(slice_data->session[j].name);
+            framed_routes_free(slice_data->session[j].ipv4_framed_routes);
+            framed_routes_free(slice_data->session[j].ipv6_framed_routes);
         }
 
         slice_data->num_of_session = 0;
@@ -871,6 +871,8 @@ typedef struct ogs_subscription_data_s {
     bool purge_flag;
 } ogs_subscription_data_t;
 
+void ogs_subscription_data_copy(ogs_subscription_data_t *dst,
+        const ogs_subscription_data_t *src);
 void ogs_subscription_data_free(ogs_subscription_data_t *subscription_data);
 
 typedef struct ogs_session_data_s {
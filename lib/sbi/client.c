@@ -17,10 +17,15 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+/* Before ogs-sbi.h, which sets OGS_LOG_DOMAIN back to the SBI one */
+#include "metrics/ogs-metrics.h"
 #include "ogs-sbi.h"
 
 #include "curl/curl.h"
 
+/* Easy handles kept per client for the transfers to come */
+#define MAX_NUM_OF_IDLE_EASY 16
+
 typedef struct sockinfo_s {
     ogs_poll_t *poll;
     curl_socket_t sockfd;
@@ -38,12 +43,10 @@ typedef struct connection_s {
 
     char *method;
 
-    int num_of_header;
-    char **headers;
     struct curl_slist *header_list;
-    struct curl_slist *resolve_list;
 
     char *content;
+    ogs_sbi_request_t *content_of;  /* Owner of the borrowed content */
 
     char *memory;
     size_t size;
@@ -71,6 +74,9 @@ static int sock_cb(CURL *e, curl_socket_t s, int what, void *cbp, void *sockp);
 static int multi_timer_cb(CURLM *multi, long timeout_ms, void *cbp);
 static void multi_timer_expired(void *data);
 
+static CURL *easy_get(ogs_sbi_client_t *client);
+static void easy_put(ogs_sbi_client_t *client, CURL *easy);
+
 static connection_t *connection_add(
         ogs_sbi_client_t *client, ogs_sbi_client_cb_f client_cb,
         ogs_sbi_request_t *request, void *data);
@@ -79,6 +85,63 @@ static void connection_free(connection_t *conn);
 static void connection_remove_all(ogs_sbi_client_t *client);
 static void connection_timer_expired(void *data);
 
+typedef enum client_metric_s {
+    CLIENT_METR_CTR_REQUEST = 0,
+    CLIENT_METR_CTR_CONNECT,
+    CLIENT_METR_HIST_QUEUE_TIME,
+    _CLIENT_METR_MAX,
+} client_metric_t;
+
+static ogs_metrics_inst_t *client_metrics_inst[_CLIENT_METR_MAX];
+
+static void client_metrics_init(void)
+{
+    ogs_metrics_context_t *ctx = ogs_metrics_self();
+    ogs_metrics_histogram_params_t queue_time;
+    ogs_metrics_spec_t *spec = NULL;
+
+    memset(client_metrics_inst, 0, sizeof(client_metrics_inst));
+
+    /* Only NFs running a metrics server have a context to register to */
+    if (!ogs_metrics_context_initialized())
+        return;
+
+    spec = ogs_metrics_spec_new(ctx, OGS_METRICS_METRIC_TYPE_COUNTER,
+            "sbi_client_request",
+            "Number of SBI requests completed by the client",
+            0, 0, NULL, NULL);
+    client_metrics_inst[CLIENT_METR_CTR_REQUEST] =
+        ogs_metrics_inst_new(spec, 0, NULL);
+
+    spec = ogs_metrics_spec_new(ctx, OGS_METRICS_METRIC_TYPE_COUNTER,
+            "sbi_client_connection",
+            "Number of connections the SBI client had to open",
+            0, 0, NULL, NULL);
+    client_metrics_inst[CLIENT_METR_CTR_CONNECT] =
+        ogs_metrics_inst_new(spec, 0, NULL);
+
+    memset(&queue_time, 0, sizeof(queue_time));
+    queue_time.type = OGS_METRICS_HISTOGRAM_BUCKET_TYPE_EXPONENTIAL;
+    queue_time.count = 8;
+    queue_time.exp.start = 100;
+    queue_time.exp.factor = 4;
+
+#if CURL_AT_LEAST_VERSION(8,6,0)
+    spec = ogs_metrics_spec_new(ctx, OGS_METRICS_METRIC_TYPE_HISTOGRAM,
+            "sbi_client_queue_time",
+            "Time in usec an SBI request waited for a connection",
+            0, 0, NULL, &queue_time);
+#else
+    /* No queue time before curl 8.6.0; this one adds DNS, connect and TLS */
+    spec = ogs_metrics_spec_new(ctx, OGS_METRICS_METRIC_TYPE_HISTOGRAM,
+            "sbi_client_pretransfer_time",
+            "Time in usec until an SBI request was about to be sent",
+            0, 0, NULL, &queue_time);
+#endif
+    client_metrics_inst[CLIENT_METR_HIST_QUEUE_TIME] =
+        ogs_metrics_inst_new(spec, 0, NULL);
+}
+
 void ogs_sbi_client_init(int num_of_sockinfo_pool, int num_of_connection_pool)
 {
     curl_global_init(CURL_GLOBAL_DEFAULT);
@@ -89,9 +152,13 @@ void ogs_sbi_client_init(int num_of_sockinfo_pool, int num_of_connection_pool)
     ogs_pool_init(&sockinfo_pool, num_of_sockinfo_pool);
     ogs_pool_init(&connection_pool, num_of_connection_pool);
 
+    client_metrics_init();
 }
 void ogs_sbi_client_final(void)
 {
+    /* Specs and instances are free'd by ogs_metrics_context_final() */
+    memset(client_metrics_inst, 0, sizeof(client_metrics_inst));
+
     ogs_sbi_client_remove_all();
 
     ogs_pool_final(&client_pool);
@@ -163,10 +230,10 @@ ogs_sbi_client_t *ogs_sbi_client_add(
     curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, client);
     curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, multi_timer_cb);
     curl_multi_setopt(multi, CURLMOPT_TIMERDATA, client);
-#if CURL_AT_LEAST_VERSION(7,67,0)
-    curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
-                        ogs_app()->pool.stream);
-#endif
+    ogs_sbi_client_apply_connection_config(client);
+
+    client->idle_easy = ogs_calloc(MAX_NUM_OF_IDLE_EASY, sizeof(CURL *));
+    ogs_assert(client->idle_easy);
 
     ogs_list_init(&client->connection_list);
 
@@ -207,6 +274,12 @@ void ogs_sbi_client_remove(ogs_sbi_client_t *client)
 
     connection_remove_all(client);
 
+    while (client->num_of_idle_easy)
+        curl_easy_cleanup(client->idle_easy[--client->num_of_idle_easy]);
+    ogs_free(client->idle_easy);
+
+    curl_slist_free_all(client->resolve_list);
+
     ogs_assert(client->t_curl);
     ogs_timer_delete(client->t_curl);
     client->t_curl = NULL;
@@ -291,6 +364,28 @@ ogs_sbi_client_t *ogs_sbi_client_find(
     return client;
 }
 
+void ogs_sbi_client_apply_connection_config(ogs_sbi_client_t *client)
+{
+    ogs_sbi_client_connection_config_t *config = NULL;
+    CURLM *multi = NULL;
+
+    ogs_assert(client);
+    multi = client->multi;
+    ogs_assert(multi);
+
+    config = &ogs_sbi_self()->client_connection_config;
+
+#if CURL_AT_LEAST_VERSION(7,67,0)
+    curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
+            config->max_concurrent_streams ?
+                (long)config->max_concurrent_streams :
+                (long)ogs_app()->pool.stream);
+#endif
+    /* Transfers beyond it wait for a stream on an open connection */
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+            (long)config->max_connections);
+}
+
 void ogs_sbi_client_stop(ogs_sbi_client_t *client)
 {
     connection_t *conn = NULL;
@@ -401,13 +496,132 @@ static CURLcode sslctx_callback(CURL *curl, void *sslctx, void *userdata)
     return CURLE_OK;
 }
 
+static CURL *easy_get(ogs_sbi_client_t *client)
+{
+    CURL *easy = NULL;
+#if CURL_AT_LEAST_VERSION(7,65,0)
+    int max_idle_time;
+#endif
+
+    ogs_assert(client);
+
+    if (client->num_of_idle_easy) {
+        easy = client->idle_easy[--client->num_of_idle_easy];
+        /* The connections, DNS and TLS session caches are kept */
+        curl_easy_reset(easy);
+    } else {
+        easy = curl_easy_init();
+        if (!easy) {
+            ogs_error("curl_easy_init() failed");
+            return NULL;
+        }
+    }
+
+    curl_easy_setopt(easy, CURLOPT_BUFFERSIZE, OGS_MAX_SDU_LEN);
+
+    /* HTTPS certificate-related settings */
+    if (client->scheme == OpenAPI_uri_scheme_https) {
+        if (client->insecure_skip_verify) {
+            curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 0);
+            curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, 0);
+        } else {
+            if (client->cacert)
+                curl_easy_setopt(easy, CURLOPT_CAINFO, client->cacert);
+        }
+
+        /* Set private key & certificate */
+        if (client->private_key && client->cert) {
+            curl_easy_setopt(easy, CURLOPT_SSLKEY, client->private_key);
+            curl_easy_setopt(easy, CURLOPT_SSLCERT, client->cert);
+        }
+
+        if (client->sslkeylog) {
+            /* Set SSL_CTX callback */
+            curl_easy_setopt(easy, CURLOPT_SSL_CTX_FUNCTION,
+                    sslctx_callback);
+
+            /* Optionally set additional user data */
+            curl_easy_setopt(easy, CURLOPT_SSL_CTX_DATA, client);
+        }
+    }
+
+#if 1 /* Use HTTP2 */
+    curl_easy_setopt(easy,
+            CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+#endif
+
+    /*
+     * Wait for a connection being set up to the same authority,
+     * instead of opening one more for each request of a burst.
+     */
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+
+#if CURL_AT_LEAST_VERSION(7,65,0)
+    max_idle_time = ogs_sbi_self()->client_connection_config.max_idle_time;
+    if (max_idle_time)
+        curl_easy_setopt(easy, CURLOPT_MAXAGE_CONN, (long)max_idle_time);
+#endif
+
+    if (client->resolve) {
+        if (!client->resolve_list)
+            client->resolve_list = curl_slist_append(NULL, client->resolve);
+        if (client->resolve_list)
+            curl_easy_setopt(easy, CURLOPT_RESOLVE, client->resolve_list);
+        else
+            ogs_error("curl_slist_append() failed [%s]", client->resolve);
+    }
+
+    if (client->local_if) {
+        curl_easy_setopt(easy, CURLOPT_INTERFACE, client->local_if);
+    }
+
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, header_cb);
+
+    return easy;
+}
+
+static void easy_put(ogs_sbi_client_t *client, CURL *easy)
+{
+    ogs_assert(client);
+    ogs_assert(easy);
+
+    if (client->num_of_idle_easy < MAX_NUM_OF_IDLE_EASY)
+        client->idle_easy[client->num_of_idle_easy++] = easy;
+    else
+        curl_easy_cleanup(easy);
+}
+
+/* "key: val" is copied by curl_slist_append() */
+static struct curl_slist *header_append(
+        struct curl_slist *list, const char *key, const char *val)
+{
+    char buf[OGS_HUGE_LEN];
+    char *header = buf;
+
+    if (ogs_snprintf(buf, sizeof(buf), "%s: %s", key, val) >= sizeof(buf)) {
+        header = ogs_msprintf("%s: %s", key, val);
+        if (!header) {
+            ogs_error("ogs_msprintf() failed");
+            return NULL;
+        }
+    }
+
+    list = curl_slist_append(list, header);
+
+    if (header != buf)
+        ogs_free(header);
+
+    return list;
+}
+
 static connection_t *connection_add(
         ogs_sbi_client_t *client, ogs_sbi_client_cb_f client_cb,
         ogs_sbi_request_t *request, void *data)
 {
     ogs_hash_index_t *hi;
-    int i;
     connection_t *conn = NULL;
+    struct curl_slist *header_list = NULL;
     CURLMcode rc;
 
     ogs_assert(client);
@@ -432,28 +646,16 @@ static connection_t *connection_add(
         return NULL;
     }
 
-    conn->num_of_header = ogs_hash_count(request->http.headers);
-    if (conn->num_of_header) {
-        conn->headers = ogs_calloc(conn->num_of_header, sizeof(char *));
-        if (!conn->headers) {
-            ogs_error("conn->headers is NULL");
+    for (hi = ogs_hash_first(request->http.headers);
+            hi; hi = ogs_hash_next(hi)) {
+        header_list = header_append(conn->header_list,
+                ogs_hash_this_key(hi), ogs_hash_this_val(hi));
+        if (!header_list) {
+            ogs_error("header_append() failed");
             connection_free(conn);
             return NULL;
         }
-        for (hi = ogs_hash_first(request->http.headers), i = 0;
-                hi && i < conn->num_of_header; hi = ogs_hash_next(hi), i++) {
-            const char *key = ogs_hash_this_key(hi);
-            char *val = ogs_hash_this_val(hi);
-
-            conn->headers[i] = ogs_msprintf("%s: %s", key, val);
-            if (!conn->headers[i]) {
-                ogs_error("conn->headers[i=%d] is NULL", i);
-                connection_free(conn);
-                return NULL;
-            }
-            conn->header_list = curl_slist_append(
-                    conn->header_list, conn->headers[i]);
-        }
+        conn->header_list = header_list;
     }
 
     conn->timer = ogs_timer_add(
@@ -470,7 +672,7 @@ static connection_t *connection_add(
     ogs_timer_start(conn->timer,
             ogs_local_conf()->time.message.sbi.connection_deadline);
 
-    conn->easy = curl_easy_init();
+    conn->easy = easy_get(client);
     if (!conn->easy) {
         ogs_error("conn->easy is NULL");
         connection_free(conn);
@@ -489,34 +691,6 @@ static connection_t *connection_add(
         request->h.uri = uri;
     }
 
-    curl_easy_setopt(conn->easy, CURLOPT_BUFFERSIZE, OGS_MAX_SDU_LEN);
-
-    /* HTTPS certificate-related settings */
-    if (client->scheme == OpenAPI_uri_scheme_https) {
-        if (client->insecure_skip_verify) {
-            curl_easy_setopt(conn->easy, CURLOPT_SSL_VERIFYPEER, 0);
-            curl_easy_setopt(conn->easy, CURLOPT_SSL_VERIFYHOST, 0);
-        } else {
-            if (client->cacert)
-                curl_easy_setopt(conn->easy, CURLOPT_CAINFO, client->cacert);
-        }
-
-        /* Set private key & certificate */
-        if (client->private_key && client->cert) {
-            curl_easy_setopt(conn->easy, CURLOPT_SSLKEY, client->private_key);
-            curl_easy_setopt(conn->easy, CURLOPT_SSLCERT, client->cert);
-        }
-
-        if (client->sslkeylog) {
-            /* Set SSL_CTX callback */
-            curl_easy_setopt(conn->easy, CURLOPT_SSL_CTX_FUNCTION,
-                    sslctx_callback);
-
-            /* Optionally set additional user data */
-            curl_easy_setopt(conn->easy, CURLOPT_SSL_CTX_DATA, client);
-        }
-    }
-
     /* Configure HTTP Method */
     if (strcmp(request->h.method, OGS_SBI_HTTP_METHOD_PUT) == 0 ||
         strcmp(request->h.method, OGS_SBI_HTTP_METHOD_PATCH) == 0 ||
@@ -525,7 +699,11 @@ static connection_t *connection_add(
 
         curl_easy_setopt(conn->easy,
                 CURLOPT_CUSTOMREQUEST, request->h.method);
-        if (request->http.content) {
+        if (request->http.content && request->content_of) {
+            /* Sent as-is from the request it was received in */
+            conn->content_of = ogs_sbi_request_ref(request->content_of);
+            conn->content = request->http.content;
+        } else if (request->http.content) {
             conn->content = ogs_memdup(
                     request->http.content, request->http.content_length);
             if (!conn->content) {
@@ -533,13 +711,20 @@ static connection_t *connection_add(
                 connection_free(conn);
                 return NULL;
             }
+        }
+        if (conn->content) {
             curl_easy_setopt(conn->easy,
                     CURLOPT_POSTFIELDS, conn->content);
             curl_easy_setopt(conn->easy,
                 CURLOPT_POSTFIELDSIZE, request->http.content_length);
 #if 1 /* Disable HTTP/1.1 100 Continue : Use "Expect:" in libcurl */
-            conn->header_list = curl_slist_append(
-                    conn->header_list, "Expect:");
+            header_list = curl_slist_append(conn->header_list, "Expect:");
+            if (!header_list) {
+                ogs_error("curl_slist_append() failed");
+                connection_free(conn);
+                return NULL;
+            }
+            conn->header_list = header_list;
 #else
             curl_easy_setopt(conn->easy, CURLOPT_EXPECT_100_TIMEOUT_MS, 0L);
 #endif
@@ -551,28 +736,12 @@ static connection_t *connection_add(
 
     curl_easy_setopt(conn->easy, CURLOPT_HTTPHEADER, conn->header_list);
 
-#if 1 /* Use HTTP2 */
-    curl_easy_setopt(conn->easy,
-            CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
-#endif
-
     ogs_list_add(&client->connection_list, conn);
 
     curl_easy_setopt(conn->easy, CURLOPT_URL, request->h.uri);
 
-    if (client->resolve) {
-        conn->resolve_list = curl_slist_append(NULL, client->resolve);
-        curl_easy_setopt(conn->easy, CURLOPT_RESOLVE, conn->resolve_list);
-    }
-
-    if (client->local_if) {
-        curl_easy_setopt(conn->easy, CURLOPT_INTERFACE, client->local_if);
-    }
-
     curl_easy_setopt(conn->easy, CURLOPT_PRIVATE, conn);
-    curl_easy_setopt(conn->easy, CURLOPT_WRITEFUNCTION, write_cb);
     curl_easy_setopt(conn->easy, CURLOPT_WRITEDATA, conn);
-    curl_easy_setopt(conn->easy, CURLOPT_HEADERFUNCTION, header_cb);
     curl_easy_setopt(conn->easy, CURLOPT_HEADERDATA, conn);
     curl_easy_setopt(conn->easy, CURLOPT_ERRORBUFFER, conn->error);
 
@@ -601,11 +770,11 @@ static void connection_remove(connection_t *conn)
 
 static void connection_free(connection_t *conn)
 {
-    int i;
-
     ogs_assert(conn);
 
-    if (conn->content)
+    if (conn->content_of)
+        ogs_sbi_request_free(conn->content_of);
+    else if (conn->content)
         ogs_free(conn->content);
 
     if (conn->location)
@@ -617,21 +786,13 @@ static void connection_free(connection_t *conn)
         ogs_free(conn->memory);
 
     if (conn->easy)
-        curl_easy_cleanup(conn->easy);
+        easy_put(conn->client, conn->easy);
 
     if (conn->timer)
         ogs_timer_delete(conn->timer);
 
-    if (conn->num_of_header) {
-        for (i = 0; i < conn->num_of_header; i++)
-            if (conn->headers[i])
-                ogs_free(conn->headers[i]);
-        ogs_free(conn->headers);
-    }
     curl_slist_free_all(conn->header_list);
 
-    curl_slist_free_all(conn->resolve_list);
-
     if (conn->method)
         ogs_free(conn->method);
 
@@ -679,6 +840,37 @@ static void connection_timer_expired(void *data)
     connection_remove(conn);
 }
 
+static void connection_stats(ogs_sbi_client_t *client, CURL *easy)
+{
+    long num_connects = 0;
+#if CURL_AT_LEAST_VERSION(7,61,0)
+    curl_off_t queue_time = 0;
+#endif
+
+    ogs_assert(client);
+    ogs_assert(easy);
+
+    if (client_metrics_inst[CLIENT_METR_CTR_REQUEST])
+        ogs_metrics_inst_inc(client_metrics_inst[CLIENT_METR_CTR_REQUEST]);
+
+    /* Zero when the transfer went out on a connection already open */
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &num_connects);
+    if (num_connects && client_metrics_inst[CLIENT_METR_CTR_CONNECT])
+        ogs_metrics_inst_add(
+                client_metrics_inst[CLIENT_METR_CTR_CONNECT], num_connects);
+
+#if CURL_AT_LEAST_VERSION(8,6,0)
+    curl_easy_getinfo(easy, CURLINFO_QUEUE_TIME_T, &queue_time);
+#elif CURL_AT_LEAST_VERSION(7,61,0)
+    curl_easy_getinfo(easy, CURLINFO_PRETRANSFER_TIME_T, &queue_time);
+#endif
+#if CURL_AT_LEAST_VERSION(7,61,0)
+    if (client_metrics_inst[CLIENT_METR_HIST_QUEUE_TIME])
+        ogs_metrics_inst_add(client_metrics_inst[CLIENT_METR_HIST_QUEUE_TIME],
+                queue_time > INT_MAX ? INT_MAX : (int)queue_time);
+#endif
+}
+
 static void check_multi_info(ogs_sbi_client_t *client)
 {
     CURLM *multi = NULL;
@@ -715,6 +907,8 @@ static void check_multi_info(ogs_sbi_client_t *client)
             if (res == CURLE_OK) {
                 ogs_log_level_e level = OGS_LOG_DEBUG;
 
+                connection_stats(client, easy);
+
                 response = ogs_sbi_response_new();
                 ogs_assert(response);
 
@@ -745,11 +939,13 @@ static void check_multi_info(ogs_sbi_client_t *client)
                         response->status, response->h.method, response->h.uri);
 
                 if (conn->memory) {
-                    response->http.content =
-                        ogs_memdup(conn->memory, conn->size + 1);
-                    ogs_assert(response->http.content);
+                    /* Already NUL-terminated by write_cb() */
+                    response->http.content = conn->memory;
                     response->http.content_length = conn->size;
                     ogs_assert(response->http.content_length);
+
+                    conn->memory = NULL;
+                    conn->size = 0;
                 }
 
                 ogs_log_message(level, 0, "RECEIVED[%d]",
@@ -96,6 +96,14 @@ typedef struct ogs_sbi_client_s {
     void            *multi;             /* CURL multi handle */
     int             still_running;      /* number of running CURL handle */
 
+    /*
+     * Transfers share the HTTP/2 connections kept in the multi handle.
+     * Easy handles of finished transfers are kept for the next ones.
+     */
+    void            **idle_easy;
+    int             num_of_idle_easy;
+    void            *resolve_list;      /* CURLOPT_RESOLVE of 'resolve' */
+
     unsigned int    reference_count;    /* reference count for memory free */
 } ogs_sbi_client_t;
 
@@ -115,6 +123,8 @@ ogs_sbi_client_t *ogs_sbi_client_find(
         char *fqdn, uint16_t fqdn_port,
         ogs_sockaddr_t *addr, ogs_sockaddr_t *addr6);
 
+void ogs_sbi_client_apply_connection_config(ogs_sbi_client_t *client);
+
 void ogs_sbi_client_stop(ogs_sbi_client_t *client);
 void ogs_sbi_client_stop_all(void);
 
@@ -17,6 +17,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <unistd.h>
+
 #include "ogs-sbi.h"
 
 int __ogs_sbi_domain;
@@ -26,6 +28,7 @@ static int context_initialized = 0;
 static OGS_POOL(nf_instance_pool, ogs_sbi_nf_instance_t);
 static OGS_POOL(nf_service_pool, ogs_sbi_nf_service_t);
 static OGS_POOL(xact_pool, ogs_sbi_xact_t);
+static OGS_POOL(discover_pool, ogs_sbi_discover_t);
 static OGS_POOL(subscription_spec_pool, ogs_sbi_subscription_spec_t);
 static OGS_POOL(subscription_data_pool, ogs_sbi_subscription_data_t);
 static OGS_POOL(smf_info_pool, ogs_sbi_smf_info_t);
@@ -50,11 +53,17 @@ void ogs_sbi_context_init(OpenAPI_nf_type_e nf_type)
     ogs_sbi_client_init(ogs_app()->pool.event, ogs_app()->pool.event);
 
     ogs_list_init(&self.nf_instance_list);
+    self.nf_instance_id_hash = ogs_hash_make();
+    ogs_assert(self.nf_instance_id_hash);
     ogs_pool_init(&nf_instance_pool, ogs_app()->pool.nf);
     ogs_pool_init(&nf_service_pool, ogs_app()->pool.nf_service);
 
     ogs_pool_init(&xact_pool, ogs_app()->pool.xact);
 
+    self.discover_hash = ogs_hash_make();
+    ogs_assert(self.discover_hash);
+    ogs_pool_init(&discover_pool, ogs_app()->pool.xact);
+
     ogs_list_init(&self.subscription_spec_list);
     ogs_pool_init(&subscription_spec_pool, ogs_app()->pool.subscription);
 
@@ -104,8 +113,16 @@ void ogs_sbi_context_final(void)
 
     ogs_pool_final(&xact_pool);
 
+    ogs_sbi_discover_remove_all();
+    ogs_assert(self.discover_hash);
+    ogs_hash_destroy(self.discover_hash);
+    ogs_pool_final(&discover_pool);
+
     ogs_sbi_nf_instance_remove_all();
 
+    ogs_assert(self.nf_instance_id_hash);
+    ogs_hash_destroy(self.nf_instance_id_hash);
+
     ogs_pool_final(&nf_instance_pool);
     ogs_pool_final(&nf_service_pool);
     ogs_pool_final(&smf_info_pool);
@@ -618,6 +635,64 @@ int ogs_sbi_context_parse_config(
                                                 "key `%s`", del_key);
                                         }
                                     }
+                                } else if (!strcmp(client_key, "connection")) {
+                                    ogs_sbi_client_connection_config_t
+                                        *config = &self.client_connection_config;
+                                    ogs_sbi_client_t *client = NULL;
+                                    ogs_yaml_iter_t conn_iter;
+                                    ogs_yaml_iter_recurse(&client_iter,
+                                                          &conn_iter);
+
+                                    while (ogs_yaml_iter_next(&conn_iter)) {
+                                        const char *conn_key =
+                                            ogs_yaml_iter_key(&conn_iter);
+                                        const char *v =
+                                            ogs_yaml_iter_value(&conn_iter);
+                                        ogs_assert(conn_key);
+
+                                        if (!strcmp(conn_key,
+                                                "max_concurrent_streams")) {
+                                            if (v)
+                                                config->max_concurrent_streams =
+                                                    atoi(v);
+                                        } else if (!strcmp(conn_key,
+                                                "max_connections")) {
+                                            if (v)
+                                                config->max_connections =
+                                                    atoi(v);
+                                        } else if (!strcmp(conn_key,
+                                                "max_idle_time")) {
+                                            if (v)
+                                                config->max_idle_time =
+                                                    atoi(v);
+                                        } else {
+                                            ogs_warn("unknown connection "
+                                                "key `%s`", conn_key);
+                                        }
+                                    }
+
+                                    if (config->max_concurrent_streams < 0) {
+                                        ogs_warn("Ignore "
+                                            "max_concurrent_streams(%d)",
+                                            config->max_concurrent_streams);
+                                        config->max_concurrent_streams = 0;
+                                    }
+                                    if (config->max_connections < 0) {
+                                        ogs_warn("Ignore max_connections(%d)",
+                                            config->max_connections);
+                                        config->max_connections = 0;
+                                    }
+                                    if (config->max_idle_time < 0) {
+                                        ogs_warn("Ignore max_idle_time(%d)",
+                                            config->max_idle_time);
+                                        config->max_idle_time = 0;
+                                    }
+
+                                    /* NRF/SCP clients may already exist */
+                                    ogs_list_for_each(
+                                            &self.client_list, client)
+                                        ogs_sbi_client_apply_connection_config(
+                                                client);
                                 }
                             }
                         } else
@@ -732,6 +807,25 @@ int ogs_sbi_context_parse_hnet_config(ogs_yaml_iter_t *root_iter)
     return OGS_OK;
 }
 
+/* Keeps 7 generation bits in the stream IDs of the NF thread */
+#define MAX_NUM_OF_STREAM_POOL (1 << 24)
+
+/*
+ * More I/O threads than CPUs only add context switches.
+ * Each one also needs ogs_app()->pool.event proxy streams
+ * in the stream pool of the NF thread (see nghttp2-server.c).
+ */
+static int max_num_of_io_thread(void)
+{
+    long num_of_cpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int max = num_of_cpu > 0 ? (int)num_of_cpu : 1;
+
+    ogs_assert(ogs_app()->pool.event > 0);
+    max = ogs_min(max, MAX_NUM_OF_STREAM_POOL / ogs_app()->pool.event - 1);
+
+    return ogs_max(max, 0);
+}
+
 int ogs_sbi_context_parse_server_config(
         ogs_yaml_iter_t *parent, const char *interface)
 {
@@ -764,6 +858,8 @@ int ogs_sbi_context_parse_server_config(
         ogs_sockopt_t option;
         bool is_option = false;
 
+        int num_of_io_thread = 0;
+
         if (ogs_yaml_iter_type(&server_array) == YAML_MAPPING_NODE) {
             memcpy(&server_iter, &server_array, sizeof(ogs_yaml_iter_t));
         } else if (ogs_yaml_iter_type(&server_array) == YAML_SEQUENCE_NODE) {
@@ -864,6 +960,18 @@ int ogs_sbi_context_parse_server_config(
                     return rv;
                 }
                 is_option = true;
+            } else if (!strcmp(server_key, "io_thread")) {
+                const char *v = ogs_yaml_iter_value(&server_iter);
+                if (v) num_of_io_thread = atoi(v);
+                if (num_of_io_thread < 0) {
+                    ogs_warn("Ignore io_thread(%d)", num_of_io_thread);
+                    num_of_io_thread = 0;
+                }
+                if (num_of_io_thread > max_num_of_io_thread()) {
+                    ogs_warn("io_thread(%d) clamped to %d",
+                            num_of_io_thread, max_num_of_io_thread());
+                    num_of_io_thread = max_num_of_io_thread();
+                }
             }
         }
 
@@ -945,6 +1053,8 @@ int ogs_sbi_context_parse_server_config(
                     interface, scheme, node->addr, is_option ? &option : NULL);
             ogs_assert(server);
 
+            server->num_of_io_thread = num_of_io_thread;
+
             if (addr && ogs_global_conf()->parameter.no_ipv4 == 0)
                 ogs_sbi_server_set_advertise(server, AF_INET, addr);
 
@@ -1000,6 +1110,8 @@ int ogs_sbi_context_parse_server_config(
                     interface, scheme, node6->addr, is_option ? &option : NULL);
             ogs_assert(server);
 
+            server->num_of_io_thread = num_of_io_thread;
+
             if (addr && ogs_global_conf()->parameter.no_ipv6 == 0)
                 ogs_sbi_server_set_advertise(server, AF_INET6, addr);
 
@@ -1261,22 +1373,74 @@ ogs_sbi_nf_instance_t *ogs_sbi_nf_instance_add(void)
     return nf_instance;
 }
 
+/*
+ * Only the first NF instance with a given ID is in the hash,
+ * so that ogs_sbi_nf_instance_find() keeps returning the same one
+ * as when it walked the list.
+ */
+static void nf_instance_id_hash_remove(ogs_sbi_nf_instance_t *nf_instance)
+{
+    ogs_sbi_nf_instance_t *other = NULL;
+
+    ogs_assert(nf_instance);
+    ogs_assert(nf_instance->id);
+
+    if (ogs_hash_get(ogs_sbi_self()->nf_instance_id_hash,
+                nf_instance->id, strlen(nf_instance->id)) != nf_instance)
+        return;
+
+    ogs_hash_set(ogs_sbi_self()->nf_instance_id_hash,
+            nf_instance->id, strlen(nf_instance->id), NULL);
+
+    ogs_list_for_each(&ogs_sbi_self()->nf_instance_list, other) {
+        if (other != nf_instance &&
+            other->id && strcmp(other->id, nf_instance->id) == 0) {
+            ogs_hash_set(ogs_sbi_self()->nf_instance_id_hash,
+                    other->id, strlen(other->id), other);
+            break;
+        }
+    }
+}
+
 void ogs_sbi_nf_instance_set_id(ogs_sbi_nf_instance_t *nf_instance, char *id)
 {
     ogs_assert(nf_instance);
     ogs_assert(id);
 
+    if (nf_instance->id) {
+        nf_instance_id_hash_remove(nf_instance);
+        ogs_free(nf_instance->id);
+    }
+
     nf_instance->id = ogs_strdup(id);
     ogs_assert(nf_instance->id);
+
+    if (!ogs_hash_get(ogs_sbi_self()->nf_instance_id_hash,
+                nf_instance->id, strlen(nf_instance->id)))
+        ogs_hash_set(ogs_sbi_self()->nf_instance_id_hash,
+                nf_instance->id, strlen(nf_instance->id), nf_instance);
 }
 
 void ogs_sbi_nf_instance_set_type(
         ogs_sbi_nf_instance_t *nf_instance, OpenAPI_nf_type_e nf_type)
 {
     ogs_assert(nf_instance);
-    ogs_assert(nf_type);
+    ogs_assert(nf_type > OpenAPI_nf_type_NULL &&
+            nf_type < OGS_SBI_MAX_NUM_OF_NF_TYPE);
+
+    if (nf_instance->nf_type == nf_type)
+        return;
+
+    if (nf_instance->nf_type)
+        ogs_list_remove(
+                &ogs_sbi_self()->nf_type_list[nf_instance->nf_type],
+                &nf_instance->type_node);
 
     nf_instance->nf_type = nf_type;
+
+    nf_instance->type_node.nf_instance = nf_instance;
+    ogs_list_add(&ogs_sbi_self()->nf_type_list[nf_type],
+            &nf_instance->type_node);
 }
 
 void ogs_sbi_nf_instance_set_status(
@@ -1359,6 +1523,12 @@ void ogs_sbi_nf_instance_remove(ogs_sbi_nf_instance_t *nf_instance)
             nf_instance->id);
 
     ogs_list_remove(&ogs_sbi_self()->nf_instance_list, nf_instance);
+    if (nf_instance->id)
+        nf_instance_id_hash_remove(nf_instance);
+    if (nf_instance->nf_type)
+        ogs_list_remove(
+                &ogs_sbi_self()->nf_type_list[nf_instance->nf_type],
+                &nf_instance->type_node);
 
     ogs_sbi_nf_info_remove_all(&nf_instance->nf_info_list);
 
@@ -1391,8 +1561,6 @@ void ogs_sbi_nf_instance_remove_all(void)
 
 ogs_sbi_nf_instance_t *ogs_sbi_nf_instance_find(char *id)
 {
-    ogs_sbi_nf_instance_t *nf_instance = NULL;
-
     /*
      * This is related to Issue #3093.
      *
@@ -1407,12 +1575,7 @@ ogs_sbi_nf_instance_t *ogs_sbi_nf_instance_find(char *id)
      */
     if (!id) return NULL;
 
-    ogs_list_for_each(&ogs_sbi_self()->nf_instance_list, nf_instance) {
-        if (nf_instance->id && strcmp(nf_instance->id, id) == 0)
-            break;
-    }
-
-    return nf_instance;
+    return ogs_hash_get(ogs_sbi_self()->nf_instance_id_hash, id, strlen(id));
 }
 
 ogs_sbi_nf_instance_t *ogs_sbi_nf_instance_find_by_discovery_param(
@@ -1421,11 +1584,15 @@ ogs_sbi_nf_instance_t *ogs_sbi_nf_instance_find_by_discovery_param(
         ogs_sbi_discovery_option_t *discovery_option)
 {
     ogs_sbi_nf_instance_t *nf_instance = NULL;
+    ogs_sbi_nf_type_node_t *type_node = NULL;
 
     ogs_assert(target_nf_type);
+    ogs_assert(target_nf_type < OGS_SBI_MAX_NUM_OF_NF_TYPE);
     ogs_assert(requester_nf_type);
 
-    ogs_list_for_each(&ogs_sbi_self()->nf_instance_list, nf_instance) {
+    /* Only NF instances of the target NF-Type can match */
+    ogs_sbi_nf_instance_for_each_by_type(
+            target_nf_type, type_node, nf_instance) {
         if (ogs_sbi_discovery_param_is_matched(
                     nf_instance, target_nf_type, requester_nf_type,
                     discovery_option) == false)
@@ -2624,6 +2791,83 @@ ogs_sbi_xact_t *ogs_sbi_xact_find_by_id(ogs_pool_id_t id)
     return ogs_pool_find_by_id(&xact_pool, id);
 }
 
+ogs_sbi_discover_t *ogs_sbi_discover_add(char *query, ogs_pool_id_t xact_id)
+{
+    ogs_sbi_discover_t *discover = NULL;
+
+    ogs_assert(query);
+
+    ogs_pool_id_calloc(&discover_pool, &discover);
+    if (!discover) {
+        ogs_error("ogs_pool_id_calloc() failed");
+        return NULL;
+    }
+
+    discover->query = ogs_strdup(query);
+    ogs_assert(discover->query);
+    discover->xact_id = xact_id;
+
+    ogs_hash_set(self.discover_hash,
+            discover->query, OGS_HASH_KEY_STRING, discover);
+
+    return discover;
+}
+
+void ogs_sbi_discover_remove(ogs_sbi_discover_t *discover)
+{
+    ogs_assert(discover);
+
+    ogs_assert(discover->query);
+    ogs_hash_set(self.discover_hash,
+            discover->query, OGS_HASH_KEY_STRING, NULL);
+    ogs_free(discover->query);
+
+    if (discover->waiter)
+        ogs_free(discover->waiter);
+
+    ogs_pool_id_free(&discover_pool, discover);
+}
+
+void ogs_sbi_discover_remove_all(void)
+{
+    ogs_hash_index_t *hi = NULL;
+
+    for (hi = ogs_hash_first(self.discover_hash);
+            hi; hi = ogs_hash_next(hi))
+        ogs_sbi_discover_remove(ogs_hash_this_val(hi));
+}
+
+ogs_sbi_discover_t *ogs_sbi_discover_find(char *query)
+{
+    ogs_assert(query);
+    return ogs_hash_get(self.discover_hash, query, OGS_HASH_KEY_STRING);
+}
+
+ogs_sbi_discover_t *ogs_sbi_discover_find_by_id(ogs_pool_id_t id)
+{
+    return ogs_pool_find_by_id(&discover_pool, id);
+}
+
+bool ogs_sbi_discover_add_waiter(
+        ogs_sbi_discover_t *discover, ogs_pool_id_t xact_id)
+{
+    ogs_pool_id_t *waiter = NULL;
+
+    ogs_assert(discover);
+
+    waiter = ogs_realloc(discover->waiter,
+            (discover->num_of_waiter + 1) * sizeof(*waiter));
+    if (!waiter) {
+        ogs_error("ogs_realloc() failed");
+        return false;
+    }
+
+    waiter[discover->num_of_waiter++] = xact_id;
+    discover->waiter = waiter;
+
+    return true;
+}
+
 ogs_sbi_subscription_spec_t *ogs_sbi_subscription_spec_add(
         OpenAPI_nf_type_e nf_type, const char *service_name)
 {
@@ -35,6 +35,8 @@ typedef struct ogs_sbi_client_s ogs_sbi_client_t;
 typedef struct ogs_sbi_smf_info_s ogs_sbi_smf_info_t;
 typedef struct ogs_sbi_nf_instance_s ogs_sbi_nf_instance_t;
 
+#define OGS_SBI_MAX_NUM_OF_NF_TYPE 128
+
 typedef enum {
     OGS_SBI_CLIENT_DELEGATED_AUTO = 0,
     OGS_SBI_CLIENT_DELEGATED_YES,
@@ -52,9 +54,18 @@ typedef struct ogs_sbi_client_delegated_config_s {
     } scp;
 } ogs_sbi_client_delegated_config_t;
 
+/* To hold the HTTP/2 connection config under sbi.client.connection */
+typedef struct ogs_sbi_client_connection_config_s {
+    int max_concurrent_streams; /* Per connection, 0: pool.stream */
+    int max_connections;        /* Per authority, 0: no limit */
+    int max_idle_time;          /* Seconds, 0: libcurl default */
+} ogs_sbi_client_connection_config_t;
+
 typedef struct ogs_sbi_context_s {
     /* For sbi.client.delegated */
     ogs_sbi_client_delegated_config_t client_delegated_config;
+    /* For sbi.client.connection */
+    ogs_sbi_client_connection_config_t client_connection_config;
 
 #define OGS_HOME_NETWORK_PKI_VALUE_MIN 1
 #define OGS_HOME_NETWORK_PKI_VALUE_MAX 254
@@ -96,9 +107,18 @@ typedef struct ogs_sbi_context_s {
     ogs_uuid_t uuid;
 
     ogs_list_t nf_instance_list;
+    ogs_hash_t *nf_instance_id_hash;    /* by NF-Instance-Id */
+    ogs_list_t nf_type_list[OGS_SBI_MAX_NUM_OF_NF_TYPE]; /* by NF-Type */
     ogs_list_t subscription_spec_list;
     ogs_list_t subscription_data_list;
 
+    ogs_hash_t *discover_hash;          /* NF-Discover in flight, by query */
+    struct {
+        uint64_t hit;       /* Served by an already discovered NF instance */
+        uint64_t miss;      /* NF-Discover sent to the NRF */
+        uint64_t shared;    /* Waited for an identical NF-Discover */
+    } discover_stats;
+
     ogs_sbi_nf_instance_t *nf_instance;     /* SELF NF Instance */
     ogs_sbi_nf_instance_t *nrf_instance;    /* NRF Instance */
     ogs_sbi_nf_instance_t *scp_instance;    /* SCP Instance */
@@ -110,8 +130,24 @@ typedef struct ogs_sbi_context_s {
     const char *service_name[OGS_SBI_MAX_NUM_OF_SERVICE_TYPE];
 } ogs_sbi_context_t;
 
+/*
+ * Every NF instance with an NF-Type is also linked
+ * into ogs_sbi_self()->nf_type_list[nf_type], so that a lookup
+ * for one NF-Type does not have to walk all the NF instances.
+ */
+typedef struct ogs_sbi_nf_type_node_s {
+    ogs_lnode_t lnode;
+    ogs_sbi_nf_instance_t *nf_instance;
+} ogs_sbi_nf_type_node_t;
+
+#define ogs_sbi_nf_instance_for_each_by_type(__nFType, __nODE, __nFInstance) \
+    for (__nODE = ogs_list_first(&ogs_sbi_self()->nf_type_list[__nFType]); \
+        (__nODE) && ((__nFInstance) = (__nODE)->nf_instance); \
+        __nODE = ogs_list_next(__nODE))
+
 typedef struct ogs_sbi_nf_instance_s {
     ogs_lnode_t lnode;
+    ogs_sbi_nf_type_node_t type_node;   /* node in nf_type_list */
 
     ogs_fsm_t sm;                           /* A state machine */
     ogs_timer_t *t_registration_interval;   /* timer to retry
@@ -170,7 +206,6 @@ typedef struct ogs_sbi_nf_instance_s {
     ogs_sockaddr_t *ipv6[OGS_SBI_MAX_NUM_OF_IP_ADDRESS];
 
     int num_of_allowed_nf_type;
-#define OGS_SBI_MAX_NUM_OF_NF_TYPE 128
     OpenAPI_nf_type_e allowed_nf_type[OGS_SBI_MAX_NUM_OF_NF_TYPE];
 
 #define OGS_SBI_DEFAULT_PRIORITY 0
@@ -277,6 +312,24 @@ typedef struct ogs_sbi_xact_s {
     ogs_pool_id_t sbi_object_id;
 } ogs_sbi_xact_t;
 
+/*
+ * NF-Discover sent to the NRF and not answered yet.
+ *
+ * An xact asking for the same query while it is in flight does not
+ * send it again, but is added as a waiter. When the answer comes,
+ * each waiter gets its own copy of the response, as if it had sent
+ * the request itself.
+ */
+typedef struct ogs_sbi_discover_s {
+    ogs_pool_id_t id;
+
+    char *query;                /* Service, resource and sorted parameters */
+    ogs_pool_id_t xact_id;      /* xact that sent the request */
+
+    int num_of_waiter;
+    ogs_pool_id_t *waiter;      /* xact IDs */
+} ogs_sbi_discover_t;
+
 typedef struct ogs_sbi_nf_service_s {
     ogs_lnode_t lnode;
 
@@ -622,6 +675,14 @@ void ogs_sbi_xact_remove(ogs_sbi_xact_t *xact);
 void ogs_sbi_xact_remove_all(ogs_sbi_object_t *sbi_object);
 ogs_sbi_xact_t *ogs_sbi_xact_find_by_id(ogs_pool_id_t id);
 
+ogs_sbi_discover_t *ogs_sbi_discover_add(char *query, ogs_pool_id_t xact_id);
+void ogs_sbi_discover_remove(ogs_sbi_discover_t *discover);
+void ogs_sbi_discover_remove_all(void);
+ogs_sbi_discover_t *ogs_sbi_discover_find(char *query);
+ogs_sbi_discover_t *ogs_sbi_discover_find_by_id(ogs_pool_id_t id);
+bool ogs_sbi_discover_add_waiter(
+        ogs_sbi_discover_t *discover, ogs_pool_id_t xact_id);
+
 ogs_sbi_subscription_spec_t *ogs_sbi_subscription_spec_add(
         OpenAPI_nf_type_e nf_type, const char *service_name);
 void ogs_sbi_subscription_spec_remove(
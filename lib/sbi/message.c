@@ -25,6 +25,9 @@
 static OGS_POOL(request_pool, ogs_sbi_request_t);
 static OGS_POOL(response_pool, ogs_sbi_response_t);
 
+/* Requests and responses also come and go in the SBI server I/O threads */
+static ogs_thread_mutex_t pool_mutex;
+
 static char *build_json(ogs_sbi_message_t *message);
 static int parse_json(ogs_sbi_message_t *message,
         char *content_type, char *json);
@@ -45,12 +48,14 @@ void ogs_sbi_message_init(int num_of_request_pool, int num_of_response_pool)
 {
     ogs_pool_init(&request_pool, num_of_request_pool);
     ogs_pool_init(&response_pool, num_of_response_pool);
+    ogs_thread_mutex_init(&pool_mutex);
 }
 
 void ogs_sbi_message_final(void)
 {
     ogs_pool_final(&request_pool);
     ogs_pool_final(&response_pool);
+    ogs_thread_mutex_destroy(&pool_mutex);
 }
 
 void ogs_sbi_message_free(ogs_sbi_message_t *message)
@@ -246,7 +251,9 @@ ogs_sbi_request_t *ogs_sbi_request_new(void)
 {
     ogs_sbi_request_t *request = NULL;
 
+    ogs_thread_mutex_lock(&pool_mutex);
     ogs_pool_alloc(&request_pool, &request);
+    ogs_thread_mutex_unlock(&pool_mutex);
     if (!request) {
         ogs_error("ogs_pool_alloc() failed");
         return NULL;
@@ -273,7 +280,9 @@ ogs_sbi_response_t *ogs_sbi_response_new(void)
 {
     ogs_sbi_response_t *response = NULL;
 
+    ogs_thread_mutex_lock(&pool_mutex);
     ogs_pool_alloc(&response_pool, &response);
+    ogs_thread_mutex_unlock(&pool_mutex);
     if (!response) {
         ogs_error("ogs_pool_alloc() failed");
         return NULL;
@@ -296,17 +305,34 @@ ogs_sbi_response_t *ogs_sbi_response_new(void)
     return response;
 }
 
+ogs_sbi_request_t *ogs_sbi_request_ref(ogs_sbi_request_t *request)
+{
+    ogs_assert(request);
+
+    request->ref++;
+
+    return request;
+}
+
 void ogs_sbi_request_free(ogs_sbi_request_t *request)
 {
     ogs_assert(request);
 
+    /* Still referenced by a connection sending its content */
+    if (request->ref) {
+        request->ref--;
+        return;
+    }
+
     if (request->h.uri)
         ogs_free(request->h.uri);
 
     ogs_sbi_header_free(&request->h);
     http_message_free(&request->http);
 
+    ogs_thread_mutex_lock(&pool_mutex);
     ogs_pool_free(&request_pool, request);
+    ogs_thread_mutex_unlock(&pool_mutex);
 }
 
 void ogs_sbi_response_free(ogs_sbi_response_t *response)
@@ -319,7 +345,9 @@ void ogs_sbi_response_free(ogs_sbi_response_t *response)
     ogs_sbi_header_free(&response->h);
     http_message_free(&response->http);
 
+    ogs_thread_mutex_lock(&pool_mutex);
     ogs_pool_free(&response_pool, response);
+    ogs_thread_mutex_unlock(&pool_mutex);
 }
 
 ogs_sbi_request_t *ogs_sbi_build_request(ogs_sbi_message_t *message)
@@ -1403,10 +1431,14 @@ void ogs_sbi_http_hash_free(ogs_hash_t *hash)
 static char *build_json(ogs_sbi_message_t *message)
 {
     char *content = NULL;
+    char *json = NULL;
     cJSON *item = NULL;
 
     ogs_assert(message);
 
+    /* The cJSON tree and the print buffer only live in this function */
+    OpenAPI_arena_enter(0);
+
     if (message->ProblemDetails) {
         item = OpenAPI_problem_details_convertToJSON(message->ProblemDetails);
         ogs_assert(item);
@@ -1689,12 +1721,16 @@ static char *build_json(ogs_sbi_message_t *message)
     }
 
     if (item) {
-        content = cJSON_PrintUnformatted(item);
+        json = cJSON_PrintUnformatted(item);
+        ogs_assert(json);
+        ogs_log_print(OGS_LOG_TRACE, "%s", json);
+
+        content = ogs_strdup(json);
         ogs_assert(content);
-        ogs_log_print(OGS_LOG_TRACE, "%s", content);
-        cJSON_Delete(item);
     }
 
+    OpenAPI_arena_leave();
+
     return content;
 }
 
@@ -1715,9 +1751,17 @@ static int parse_json(ogs_sbi_message_t *message,
     }
 
     ogs_log_print(OGS_LOG_TRACE, "%s", json);
+
+    /*
+     * The tree is dropped with the arena once the model is built,
+     * and takes a few times the size of the text.
+     */
+    OpenAPI_arena_enter(strlen(json) * 4);
+
     item = cJSON_Parse(json);
     if (!item) {
         ogs_error("JSON parse error [%s]", json);
+        OpenAPI_arena_leave();
         return OGS_ERROR;
     }
 
@@ -3025,7 +3069,7 @@ static int parse_json(ogs_sbi_message_t *message,
 
 cleanup:
 
-    cJSON_Delete(item);
+    OpenAPI_arena_leave();
     return rv;
 }
 
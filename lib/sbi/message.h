@@ -638,6 +638,14 @@ typedef struct ogs_sbi_request_s {
     struct {
         ogs_poll_t *write;
     } poll;
+
+    /*
+     * A proxied request only borrows the content of the request it was
+     * received as, and the client holds a reference to that one
+     * until the content is sent (see ogs_sbi_request_ref()).
+     */
+    struct ogs_sbi_request_s *content_of;
+    unsigned int ref;
 } ogs_sbi_request_t;
 
 typedef struct ogs_sbi_response_s {
@@ -653,6 +661,7 @@ void ogs_sbi_message_final(void);
 void ogs_sbi_message_free(ogs_sbi_message_t *message);
 
 ogs_sbi_request_t *ogs_sbi_request_new(void);
+ogs_sbi_request_t *ogs_sbi_request_ref(ogs_sbi_request_t *request);
 void ogs_sbi_request_free(ogs_sbi_request_t *request);
 ogs_sbi_request_t *ogs_sbi_build_request(ogs_sbi_message_t *message);
 int ogs_sbi_parse_request(
@@ -65,6 +65,8 @@ struct h2_settings {
     bool enable_push;
 };
 
+typedef struct io_thread_s io_thread_t;
+
 typedef struct ogs_sbi_session_s {
     ogs_lnode_t             lnode;
 
@@ -79,6 +81,7 @@ typedef struct ogs_sbi_session_s {
     ogs_list_t              write_queue;
 
     ogs_sbi_server_t        *server;
+    io_thread_t             *io;            /* NULL in the NF thread */
     ogs_list_t              stream_list;
     int32_t                 last_stream_id;
 
@@ -96,14 +99,94 @@ typedef struct ogs_sbi_stream_s {
     bool                    memory_overflow;
 
     ogs_sbi_session_t       *session;
+
+    /*
+     * With I/O threads, the NF thread gets the request on a proxy stream
+     * of its own.
+     *
+     * The stream in the I/O thread is 'dispatched' once the request
+     * has been handed over, and is not reused until the NF thread
+     * releases it, even if it is closed in the meantime.
+     * 'proxy_id' is only used by the NF thread.
+     *
+     * The proxy points back to it with 'remote'.
+     */
+    io_thread_t             *io;
+    bool                    dispatched;
+    ogs_pool_id_t           proxy_id;
+
+    struct ogs_sbi_stream_s *remote;
+    ogs_sbi_server_t        *server;
+    bool                    responded;
 } ogs_sbi_stream_t;
 
+typedef OGS_POOL(session_pool_t, ogs_sbi_session_t);
+typedef OGS_POOL(stream_pool_t, ogs_sbi_stream_t);
+
+/*
+ * Messages between the NF thread and an I/O thread.
+ * Each direction is a single-producer/single-consumer ring.
+ */
+#define IO_REQUEST      1   /* I/O -> NF : 'data' is the request */
+#define IO_CLOSED       2   /* I/O -> NF : the stream was closed */
+#define IO_RESPONSE     3   /* NF -> I/O : 'data' is the response */
+#define IO_RELEASE      4   /* NF -> I/O : the stream can be reused */
+#define IO_GOAWAY       5   /* NF -> I/O : graceful shutdown */
+
+typedef struct io_message_s {
+    int                     type;
+    ogs_sbi_stream_t        *stream;
+    void                    *data;
+} io_message_t;
+
+typedef struct io_ring_s {
+    io_message_t            *msg;
+    unsigned int            mask;
+    unsigned int            head;   /* Written by the producer */
+    unsigned int            tail;   /* Written by the consumer */
+} io_ring_t;
+
+/*
+ * A stream has at most two messages in flight each way
+ * (REQUEST/CLOSED, RESPONSE/RELEASE) until it is released,
+ * so the rings cannot overflow. The slack is for GOAWAY.
+ */
+#define IO_RING_SLACK 16
+
+struct io_thread_s {
+    int                     index;
+    ogs_sbi_server_t        *server;
+
+    ogs_thread_t            *thread;
+    ogs_pollset_t           *pollset;
+    bool                    stop;
+
+    ogs_sock_t              *sock;  /* SO_REUSEPORT listener */
+    ogs_poll_t              *poll;
+    ogs_list_t              session_list;
+
+    session_pool_t          session_pool;
+    stream_pool_t           stream_pool;
+
+    io_ring_t               to_nf;
+    io_ring_t               to_io;
+
+    /* Set while a wakeup is pending, to save the system calls */
+    bool                    nf_notified;
+    bool                    io_notified;
+
+    ogs_socket_t            nf_notify[2];
+    ogs_poll_t              *nf_poll;
+};
+
 static void session_remove(ogs_sbi_session_t *sbi_sess);
 static void session_remove_all(ogs_sbi_server_t *server);
+static void session_goaway(ogs_sbi_session_t *sbi_sess);
 
 static void stream_remove(ogs_sbi_stream_t *stream);
 
 static void accept_handler(short when, ogs_socket_t fd, void *data);
+static void io_accept_handler(short when, ogs_socket_t fd, void *data);
 static void recv_handler(short when, ogs_socket_t fd, void *data);
 
 static int session_set_callbacks(ogs_sbi_session_t *sbi_sess);
@@ -112,13 +195,76 @@ static int session_send(ogs_sbi_session_t *sbi_sess);
 static void session_write_to_buffer(
         ogs_sbi_session_t *sbi_sess, ogs_pkbuf_t *pkbuf);
 
-static OGS_POOL(session_pool, ogs_sbi_session_t);
-static OGS_POOL(stream_pool, ogs_sbi_stream_t);
+static int io_start(ogs_sbi_server_t *server);
+static void io_stop(ogs_sbi_server_t *server);
+static void io_send_to_nf(io_thread_t *io,
+        int type, ogs_sbi_stream_t *stream, void *data);
+static void io_send_to_io(io_thread_t *io,
+        int type, ogs_sbi_stream_t *stream, void *data);
+static bool io_send_response(
+        ogs_sbi_stream_t *proxy, ogs_sbi_response_t *response);
+
+static session_pool_t session_pool;
+static stream_pool_t stream_pool;
+
+/* Each I/O thread has pools of the same size */
+static int max_num_of_session;
+static int max_num_of_stream;
+
+/* I/O threads of all the started servers */
+static int num_of_io_thread;
 
 static void server_init(int num_of_session_pool, int num_of_stream_pool)
 {
     ogs_pool_init(&session_pool, num_of_session_pool);
     ogs_pool_init(&stream_pool, num_of_stream_pool);
+
+    max_num_of_session = num_of_session_pool;
+    max_num_of_stream = num_of_stream_pool;
+}
+
+static session_pool_t *session_pool_of(io_thread_t *io)
+{
+    return io ? &io->session_pool : &session_pool;
+}
+
+static stream_pool_t *stream_pool_of(io_thread_t *io)
+{
+    return io ? &io->stream_pool : &stream_pool;
+}
+
+static ogs_pollset_t *pollset_of(ogs_sbi_session_t *sbi_sess)
+{
+    return sbi_sess->io ? sbi_sess->io->pollset : ogs_app()->pollset;
+}
+
+/*
+ * The NF thread takes every request of an I/O thread on a proxy stream,
+ * and the NF code finds it with stream_find_by_id() like any other.
+ * So the proxies come from 'stream_pool', which then needs room for
+ * max_num_of_stream proxies per I/O thread on top of its own streams.
+ *
+ * The servers are started before the NF loop runs, so the pool is
+ * still empty and can be rebuilt with the new size.
+ */
+static int stream_pool_reserve(int num_of_thread)
+{
+    int size = max_num_of_stream * (1 + num_of_thread);
+
+    if (ogs_pool_size(&stream_pool) >= size)
+        return OGS_OK;
+
+    if (ogs_pool_avail(&stream_pool) != ogs_pool_size(&stream_pool)) {
+        ogs_error("Cannot resize the stream pool while in use [%d/%d]",
+                ogs_pool_size(&stream_pool) - ogs_pool_avail(&stream_pool),
+                ogs_pool_size(&stream_pool));
+        return OGS_ERROR;
+    }
+
+    ogs_pool_final(&stream_pool);
+    ogs_pool_init(&stream_pool, size);
+
+    return OGS_OK;
 }
 
 static void server_final(void)
@@ -409,25 +555,36 @@ static int server_start(ogs_sbi_server_t *server,
         }
     }
 
-    sock = ogs_tcp_server(addr, server->node.option);
-    if (!sock) {
-        ogs_error("Cannot start SBI server");
+    /* Setup callback function */
+    server->cb = cb;
 
-        if (server->ssl_ctx)
-            SSL_CTX_free(server->ssl_ctx);
+    if (server->num_of_io_thread) {
+        if (io_start(server) != OGS_OK) {
+            ogs_error("Cannot start SBI I/O threads");
 
-        return OGS_ERROR;
-    }
+            if (server->ssl_ctx)
+                SSL_CTX_free(server->ssl_ctx);
 
-    server->node.sock = sock;
+            return OGS_ERROR;
+        }
+    } else {
+        sock = ogs_tcp_server(addr, server->node.option);
+        if (!sock) {
+            ogs_error("Cannot start SBI server");
 
-    /* Setup callback function */
-    server->cb = cb;
+            if (server->ssl_ctx)
+                SSL_CTX_free(server->ssl_ctx);
+
+            return OGS_ERROR;
+        }
 
-    /* Setup poll for server listening socket */
-    server->node.poll = ogs_pollset_add(ogs_app()->pollset,
-            OGS_POLLIN, sock->fd, accept_handler, server);
-    ogs_assert(server->node.poll);
+        server->node.sock = sock;
+
+        /* Setup poll for server listening socket */
+        server->node.poll = ogs_pollset_add(ogs_app()->pollset,
+                OGS_POLLIN, sock->fd, accept_handler, server);
+        ogs_assert(server->node.poll);
+    }
 
     hostname = ogs_gethostname(addr);
     if (hostname)
@@ -440,41 +597,59 @@ static int server_start(ogs_sbi_server_t *server,
                 server->interface ? server->interface : "",
                 server->ssl_ctx ? "https" : "http",
                 OGS_ADDR(addr, buf), OGS_PORT(addr));
+    if (server->num_of_io_thread)
+        ogs_info("nghttp2_server() %d I/O threads", server->num_of_io_thread);
 
     return OGS_OK;
 }
 
+static void session_goaway(ogs_sbi_session_t *sbi_sess)
+{
+    int rv;
+
+    ogs_assert(sbi_sess);
+
+    /* Submit a GOAWAY frame using the last stream ID. */
+    rv = nghttp2_submit_goaway(sbi_sess->session,
+                               NGHTTP2_FLAG_NONE,
+                               sbi_sess->last_stream_id,
+                               NGHTTP2_NO_ERROR,
+                               NULL, 0);
+    if (rv != 0) {
+        ogs_error("nghttp2_submit_goaway() failed (%d:%s)",
+                  rv, nghttp2_strerror(rv));
+    }
+
+    /* Send the GOAWAY frame to the client. */
+    if (session_send(sbi_sess) != OGS_OK) {
+        ogs_error("session_send() failed during graceful shutdown");
+    }
+}
+
 /* Gracefully shutdown the server by sending GOAWAY to each session. */
 static void server_graceful_shutdown(ogs_sbi_server_t *server)
 {
     ogs_sbi_session_t *sbi_sess = NULL;
     ogs_sbi_session_t *next_sbi_sess = NULL;
-    int rv;
+    io_thread_t *io = NULL;
+    int i;
 
-    /* Iterate over all active sessions in the server. */
-    ogs_list_for_each_safe(&server->session_list, next_sbi_sess, sbi_sess) {
-        /* Submit a GOAWAY frame using the last stream ID. */
-        rv = nghttp2_submit_goaway(sbi_sess->session,
-                                   NGHTTP2_FLAG_NONE,
-                                   sbi_sess->last_stream_id,
-                                   NGHTTP2_NO_ERROR,
-                                   NULL, 0);
-        if (rv != 0) {
-            ogs_error("nghttp2_submit_goaway() failed (%d:%s)",
-                      rv, nghttp2_strerror(rv));
-        }
+    /* The sessions of the I/O threads are shut down by the threads */
+    io = server->io;
+    for (i = 0; io && i < server->num_of_io_thread; i++)
+        io_send_to_io(&io[i], IO_GOAWAY, NULL, NULL);
 
-        /* Send the GOAWAY frame to the client. */
-        if (session_send(sbi_sess) != OGS_OK) {
-            ogs_error("session_send() failed during graceful shutdown");
-        }
-    }
+    /* Iterate over all active sessions in the server. */
+    ogs_list_for_each_safe(&server->session_list, next_sbi_sess, sbi_sess)
+        session_goaway(sbi_sess);
 }
 
 static void server_stop(ogs_sbi_server_t *server)
 {
     ogs_assert(server);
 
+    io_stop(server);
+
     /* Free SSL CTX */
     if (server->ssl_ctx)
         SSL_CTX_free(server->ssl_ctx);
@@ -610,6 +785,40 @@ static ssize_t response_read_callback(nghttp2_session *session,
     return response->http.content_length;
 }
 
+static ogs_sbi_response_t *response_copy(ogs_sbi_response_t *response)
+{
+    ogs_sbi_response_t *copy = NULL;
+    ogs_hash_index_t *hi;
+
+    ogs_assert(response);
+
+    copy = ogs_sbi_response_new();
+    if (!copy) {
+        ogs_error("ogs_sbi_response_new() failed");
+        return NULL;
+    }
+
+    copy->status = response->status;
+
+    for (hi = ogs_hash_first(response->http.headers);
+            hi; hi = ogs_hash_next(hi))
+        ogs_sbi_header_set(copy->http.headers,
+                ogs_hash_this_key(hi), ogs_hash_this_val(hi));
+
+    if (response->http.content && response->http.content_length) {
+        copy->http.content = ogs_memdup(
+                response->http.content, response->http.content_length);
+        if (!copy->http.content) {
+            ogs_error("ogs_memdup() failed");
+            ogs_sbi_response_free(copy);
+            return NULL;
+        }
+        copy->http.content_length = response->http.content_length;
+    }
+
+    return copy;
+}
+
 static bool server_send_rspmem_persistent(
         ogs_sbi_stream_t *stream, ogs_sbi_response_t *response)
 {
@@ -633,6 +842,17 @@ static bool server_send_rspmem_persistent(
     }
 
     ogs_assert(stream);
+
+    /* The response is freed by the I/O thread, so send a copy */
+    if (stream->remote) {
+        response = response_copy(response);
+        if (!response) {
+            ogs_error("response_copy() failed");
+            return false;
+        }
+        return io_send_response(stream, response);
+    }
+
     sbi_sess = stream->session;
     ogs_assert(sbi_sess);
     ogs_assert(sbi_sess->session);
@@ -727,6 +947,10 @@ static bool server_send_response(
 
     ogs_assert(response);
 
+    ogs_assert(stream);
+    if (stream->remote)
+        return io_send_response(stream, response);
+
     rc = server_send_rspmem_persistent(stream, response);
 
     ogs_sbi_response_free(response);
@@ -739,6 +963,11 @@ static ogs_sbi_server_t *server_from_stream(ogs_sbi_stream_t *stream)
     ogs_sbi_session_t *sbi_sess = NULL;
 
     ogs_assert(stream);
+    if (stream->remote) {
+        ogs_assert(stream->server);
+        return stream->server;
+    }
+
     sbi_sess = stream->session;
     ogs_assert(sbi_sess);
     ogs_assert(sbi_sess->server);
@@ -750,10 +979,12 @@ static ogs_sbi_stream_t *stream_add(
         ogs_sbi_session_t *sbi_sess, int32_t stream_id)
 {
     ogs_sbi_stream_t *stream = NULL;
+    stream_pool_t *pool = NULL;
 
     ogs_assert(sbi_sess);
+    pool = stream_pool_of(sbi_sess->io);
 
-    ogs_pool_id_calloc(&stream_pool, &stream);
+    ogs_pool_id_calloc(pool, &stream);
     if (!stream) {
         ogs_error("ogs_pool_id_calloc() failed");
         return NULL;
@@ -762,7 +993,7 @@ static ogs_sbi_stream_t *stream_add(
     stream->request = ogs_sbi_request_new();
     if (!stream->request) {
         ogs_error("ogs_sbi_request_new() failed");
-        ogs_pool_id_free(&stream_pool, stream);
+        ogs_pool_id_free(pool, stream);
         return NULL;
     }
 
@@ -770,6 +1001,7 @@ static ogs_sbi_stream_t *stream_add(
     sbi_sess->last_stream_id = stream_id;
 
     stream->session = sbi_sess;
+    stream->io = sbi_sess->io;
 
     ogs_list_add(&sbi_sess->stream_list, stream);
 
@@ -786,10 +1018,17 @@ static void stream_remove(ogs_sbi_stream_t *stream)
 
     ogs_list_remove(&sbi_sess->stream_list, stream);
 
+    if (stream->dispatched) {
+        /* Released later by the NF thread */
+        stream->session = NULL;
+        io_send_to_nf(stream->io, IO_CLOSED, stream, NULL);
+        return;
+    }
+
     ogs_assert(stream->request);
     ogs_sbi_request_free(stream->request);
 
-    ogs_pool_id_free(&stream_pool, stream);
+    ogs_pool_id_free(stream_pool_of(stream->io), stream);
 }
 
 static void stream_remove_all(ogs_sbi_session_t *sbi_sess)
@@ -814,14 +1053,16 @@ static void *stream_find_by_id(ogs_pool_id_t id)
 }
 
 static ogs_sbi_session_t *session_add(
-        ogs_sbi_server_t *server, ogs_sock_t *sock)
+        ogs_sbi_server_t *server, io_thread_t *io, ogs_sock_t *sock)
 {
     ogs_sbi_session_t *sbi_sess = NULL;
+    session_pool_t *pool = NULL;
 
     ogs_assert(server);
     ogs_assert(sock);
+    pool = session_pool_of(io);
 
-    ogs_pool_alloc(&session_pool, &sbi_sess);
+    ogs_pool_alloc(pool, &sbi_sess);
     if (!sbi_sess) {
         ogs_error("ogs_pool_alloc() failed");
         return NULL;
@@ -829,12 +1070,13 @@ static ogs_sbi_session_t *session_add(
     memset(sbi_sess, 0, sizeof(ogs_sbi_session_t));
 
     sbi_sess->server = server;
+    sbi_sess->io = io;
     sbi_sess->sock = sock;
 
     sbi_sess->addr = ogs_calloc(1, sizeof(ogs_sockaddr_t));
     if (!sbi_sess->addr) {
         ogs_error("ogs_calloc() failed");
-        ogs_pool_free(&session_pool, sbi_sess);
+        ogs_pool_free(pool, sbi_sess);
         return NULL;
     }
     memcpy(sbi_sess->addr, &sock->remote_addr, sizeof(ogs_sockaddr_t));
@@ -846,17 +1088,17 @@ static ogs_sbi_session_t *session_add(
         if (!sbi_sess->ssl) {
             ogs_error("SSL_new() failed");
             ogs_free(sbi_sess->addr);
-            ogs_pool_free(&session_pool, sbi_sess);
+            ogs_pool_free(pool, sbi_sess);
             return NULL;
         }
 
         context = ogs_msprintf("%d",
-                (int)ogs_pool_index(&session_pool, sbi_sess));
+                (int)ogs_pool_index(pool, sbi_sess));
         if (!context) {
             ogs_error("No memory for session id context");
             SSL_free(sbi_sess->ssl);
             ogs_free(sbi_sess->addr);
-            ogs_pool_free(&session_pool, sbi_sess);
+            ogs_pool_free(pool, sbi_sess);
             return NULL;
         }
 
@@ -866,14 +1108,14 @@ static ogs_sbi_session_t *session_add(
             ogs_free(context);
             ogs_free(sbi_sess->addr);
             SSL_free(sbi_sess->ssl);
-            ogs_pool_free(&session_pool, sbi_sess);
+            ogs_pool_free(pool, sbi_sess);
             return NULL;
         }
 
         ogs_free(context);
     }
 
-    ogs_list_add(&server->session_list, sbi_sess);
+    ogs_list_add(io ? &io->session_list : &server->session_list, sbi_sess);
 
     return sbi_sess;
 }
@@ -887,7 +1129,10 @@ static void session_remove(ogs_sbi_session_t *sbi_sess)
     server = sbi_sess->server;
     ogs_assert(server);
 
-    ogs_list_remove(&server->session_list, sbi_sess);
+    if (sbi_sess->io)
+        ogs_list_remove(&sbi_sess->io->session_list, sbi_sess);
+    else
+        ogs_list_remove(&server->session_list, sbi_sess);
 
     if (sbi_sess->ssl)
         SSL_free(sbi_sess->ssl);
@@ -912,7 +1157,7 @@ static void session_remove(ogs_sbi_session_t *sbi_sess)
     ogs_assert(sbi_sess->sock);
     ogs_sock_destroy(sbi_sess->sock);
 
-    ogs_pool_free(&session_pool, sbi_sess);
+    ogs_pool_free(session_pool_of(sbi_sess->io), sbi_sess);
 }
 
 static void session_remove_all(ogs_sbi_server_t *server)
@@ -925,19 +1170,16 @@ static void session_remove_all(ogs_sbi_server_t *server)
         session_remove(sbi_sess);
 }
 
-static void accept_handler(short when, ogs_socket_t fd, void *data)
+static void session_accept(
+        ogs_sbi_server_t *server, io_thread_t *io, ogs_sock_t *sock)
 {
-    ogs_sbi_server_t *server = data;
     ogs_sbi_session_t *sbi_sess = NULL;
-    ogs_sock_t *sock = NULL;
     ogs_sock_t *new = NULL;
 
     int on;
 
-    ogs_assert(data);
-    ogs_assert(fd != INVALID_SOCKET);
-
-    sock = server->node.sock;
+    ogs_assert(server);
+    ogs_assert(sock);
 
     new = ogs_sock_accept(sock);
     if (!new) {
@@ -954,7 +1196,7 @@ static void accept_handler(short when, ogs_socket_t fd, void *data)
         return;
     }
 
-    sbi_sess = session_add(server, new);
+    sbi_sess = session_add(server, io, new);
     ogs_assert(sbi_sess);
 
     if (sbi_sess->ssl) {
@@ -969,7 +1211,7 @@ static void accept_handler(short when, ogs_socket_t fd, void *data)
         }
     }
 
-    sbi_sess->poll.read = ogs_pollset_add(ogs_app()->pollset,
+    sbi_sess->poll.read = ogs_pollset_add(pollset_of(sbi_sess),
         OGS_POLLIN, new->fd, recv_handler, sbi_sess);
     ogs_assert(sbi_sess->poll.read);
 
@@ -980,6 +1222,16 @@ static void accept_handler(short when, ogs_socket_t fd, void *data)
     }
 }
 
+static void accept_handler(short when, ogs_socket_t fd, void *data)
+{
+    ogs_sbi_server_t *server = data;
+
+    ogs_assert(server);
+    ogs_assert(fd != INVALID_SOCKET);
+
+    session_accept(server, NULL, server->node.sock);
+}
+
 static void recv_handler(short when, ogs_socket_t fd, void *data)
 {
     char buf[OGS_ADDRSTRLEN];
@@ -1226,6 +1478,14 @@ static int on_frame_recv(nghttp2_session *session,
                 break;
             }
 
+            if (sbi_sess->io) {
+                /* The NF thread takes over the request */
+                stream->request = NULL;
+                stream->dispatched = true;
+                io_send_to_nf(sbi_sess->io, IO_REQUEST, stream, request);
+                break;
+            }
+
             if (server->cb(request,
                         OGS_UINT_TO_POINTER(stream->id)) != OGS_OK) {
                 ogs_warn("server callback error");
@@ -1802,8 +2062,463 @@ static void session_write_to_buffer(
     ogs_list_add(&sbi_sess->write_queue, pkbuf);
 
     if (!sbi_sess->poll.write) {
-        sbi_sess->poll.write = ogs_pollset_add(ogs_app()->pollset,
+        sbi_sess->poll.write = ogs_pollset_add(pollset_of(sbi_sess),
             OGS_POLLOUT, fd, session_write_callback, sbi_sess);
         ogs_assert(sbi_sess->poll.write);
     }
 }
+
+static void io_ring_create(io_ring_t *ring, unsigned int size)
+{
+    unsigned int capacity = 1;
+
+    ogs_assert(ring);
+
+    while (capacity < size)
+        capacity <<= 1;
+
+    ring->msg = ogs_calloc(capacity, sizeof(io_message_t));
+    ogs_assert(ring->msg);
+    ring->mask = capacity - 1;
+    ring->head = ring->tail = 0;
+}
+
+static void io_ring_destroy(io_ring_t *ring)
+{
+    ogs_assert(ring);
+    ogs_assert(ring->msg);
+
+    ogs_free(ring->msg);
+    ring->msg = NULL;
+}
+
+static void io_ring_push(io_ring_t *ring,
+        int type, ogs_sbi_stream_t *stream, void *data)
+{
+    unsigned int head, tail;
+    io_message_t *msg = NULL;
+
+    ogs_assert(ring);
+
+    head = ring->head;
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    ogs_assert(head - tail <= ring->mask);
+
+    msg = &ring->msg[head & ring->mask];
+    msg->type = type;
+    msg->stream = stream;
+    msg->data = data;
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static bool io_ring_pop(io_ring_t *ring, io_message_t *msg)
+{
+    unsigned int head, tail;
+
+    ogs_assert(ring);
+    ogs_assert(msg);
+
+    tail = ring->tail;
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head == tail)
+        return false;
+
+    *msg = ring->msg[tail & ring->mask];
+
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/*
+ * The flag is cleared by the consumer with the same sequentially
+ * consistent exchange before it drains the ring, so a message is
+ * either seen by that drain or followed by another wakeup.
+ */
+static void io_send_to_nf(io_thread_t *io,
+        int type, ogs_sbi_stream_t *stream, void *data)
+{
+    char c = 0;
+
+    ogs_assert(io);
+
+    io_ring_push(&io->to_nf, type, stream, data);
+
+    if (__atomic_exchange_n(&io->nf_notified, true, __ATOMIC_SEQ_CST) == false)
+        if (send(io->nf_notify[1], &c, 1, 0) != 1)
+            ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                    "send() failed");
+}
+
+static void io_send_to_io(io_thread_t *io,
+        int type, ogs_sbi_stream_t *stream, void *data)
+{
+    ogs_assert(io);
+
+    io_ring_push(&io->to_io, type, stream, data);
+
+    if (__atomic_exchange_n(&io->io_notified, true, __ATOMIC_SEQ_CST) == false)
+        ogs_pollset_notify(io->pollset);
+}
+
+static bool io_send_response(
+        ogs_sbi_stream_t *proxy, ogs_sbi_response_t *response)
+{
+    ogs_assert(proxy);
+    ogs_assert(proxy->remote);
+    ogs_assert(response);
+
+    if (response->status >= 600) {
+        ogs_error("Invalid response status [%d]", response->status);
+        ogs_sbi_response_free(response);
+        return false;
+    }
+
+    if (proxy->responded == true) {
+        ogs_error("Response already sent [%s]",
+                proxy->request ? proxy->request->h.uri : "Unknown");
+        ogs_sbi_response_free(response);
+        return false;
+    }
+    proxy->responded = true;
+
+    io_send_to_io(proxy->io, IO_RESPONSE, proxy->remote, response);
+
+    return true;
+}
+
+static void proxy_remove(ogs_sbi_stream_t *proxy)
+{
+    ogs_assert(proxy);
+
+    ogs_assert(proxy->request);
+    ogs_sbi_request_free(proxy->request);
+
+    ogs_pool_id_free(&stream_pool, proxy);
+}
+
+/* In the NF thread */
+static void io_request(io_thread_t *io,
+        ogs_sbi_stream_t *remote, ogs_sbi_request_t *request)
+{
+    ogs_sbi_server_t *server = NULL;
+    ogs_sbi_stream_t *proxy = NULL;
+    ogs_sbi_response_t *response = NULL;
+
+    ogs_assert(io);
+    server = io->server;
+    ogs_assert(server);
+    ogs_assert(server->cb);
+    ogs_assert(remote);
+    ogs_assert(request);
+
+    ogs_pool_id_calloc(&stream_pool, &proxy);
+    if (!proxy) {
+        ogs_error("ogs_pool_id_calloc() failed");
+        ogs_sbi_request_free(request);
+
+        response = ogs_sbi_response_new();
+        ogs_assert(response);
+        response->status = OGS_SBI_HTTP_STATUS_SERVICE_UNAVAILABLE;
+        io_send_to_io(io, IO_RESPONSE, remote, response);
+        return;
+    }
+
+    proxy->io = io;
+    proxy->remote = remote;
+    proxy->server = server;
+    proxy->request = request;
+
+    remote->proxy_id = proxy->id;
+
+    if (server->cb(request, OGS_UINT_TO_POINTER(proxy->id)) != OGS_OK) {
+        ogs_warn("server callback error");
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(proxy,
+                OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR, NULL,
+                "server callback error", NULL, NULL));
+    }
+}
+
+/* In the NF thread */
+static void io_closed(io_thread_t *io, ogs_sbi_stream_t *remote)
+{
+    ogs_sbi_stream_t *proxy = NULL;
+
+    ogs_assert(io);
+    ogs_assert(remote);
+
+    proxy = ogs_pool_find_by_id(&stream_pool, remote->proxy_id);
+    if (proxy)
+        proxy_remove(proxy);
+
+    io_send_to_io(io, IO_RELEASE, remote, NULL);
+}
+
+static void io_nf_handler(short when, ogs_socket_t fd, void *data)
+{
+    io_thread_t *io = data;
+    io_message_t msg;
+    char buf[16];
+
+    ogs_assert(io);
+
+    if (recv(fd, buf, sizeof(buf), 0) < 0)
+        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno, "recv() failed");
+
+    (void)__atomic_exchange_n(&io->nf_notified, false, __ATOMIC_SEQ_CST);
+
+    while (io_ring_pop(&io->to_nf, &msg)) {
+        switch (msg.type) {
+        case IO_REQUEST:
+            io_request(io, msg.stream, msg.data);
+            break;
+        case IO_CLOSED:
+            io_closed(io, msg.stream);
+            break;
+        default:
+            ogs_fatal("Invalid type [%d]", msg.type);
+            ogs_assert_if_reached();
+        }
+    }
+}
+
+/* In the I/O thread */
+static void io_drain(io_thread_t *io)
+{
+    ogs_sbi_session_t *sbi_sess = NULL, *next_sbi_sess = NULL;
+    ogs_sbi_stream_t *stream = NULL;
+    io_message_t msg;
+
+    ogs_assert(io);
+
+    (void)__atomic_exchange_n(&io->io_notified, false, __ATOMIC_SEQ_CST);
+
+    while (io_ring_pop(&io->to_io, &msg)) {
+        stream = msg.stream;
+
+        switch (msg.type) {
+        case IO_RESPONSE:
+            ogs_assert(stream);
+            /* Nowhere to send it if the stream was closed */
+            if (stream->session)
+                server_send_rspmem_persistent(stream, msg.data);
+            ogs_sbi_response_free(msg.data);
+            break;
+        case IO_RELEASE:
+            ogs_assert(stream);
+            ogs_assert(!stream->session);
+            ogs_pool_id_free(&io->stream_pool, stream);
+            break;
+        case IO_GOAWAY:
+            ogs_list_for_each_safe(
+                    &io->session_list, next_sbi_sess, sbi_sess)
+                session_goaway(sbi_sess);
+            break;
+        default:
+            ogs_fatal("Invalid type [%d]", msg.type);
+            ogs_assert_if_reached();
+        }
+    }
+}
+
+static void io_accept_handler(short when, ogs_socket_t fd, void *data)
+{
+    io_thread_t *io = data;
+
+    ogs_assert(io);
+    ogs_assert(fd != INVALID_SOCKET);
+
+    session_accept(io->server, io, io->sock);
+}
+
+static void io_main(void *data)
+{
+    io_thread_t *io = data;
+    ogs_sbi_session_t *sbi_sess = NULL, *next_sbi_sess = NULL;
+
+    ogs_assert(io);
+
+    while (!__atomic_load_n(&io->stop, __ATOMIC_ACQUIRE)) {
+        ogs_pollset_poll(io->pollset, OGS_INFINITE_TIME);
+        io_drain(io);
+    }
+
+    ogs_pollset_remove(io->poll);
+    io->poll = NULL;
+
+    /* The streams handed over to the NF thread are closed as well */
+    ogs_list_for_each_safe(&io->session_list, next_sbi_sess, sbi_sess)
+        session_remove(sbi_sess);
+}
+
+/*
+ * Not inlined in io_start(): the pool macros declare their own 'i',
+ * which would shadow the index of io[i].
+ */
+static int io_init(io_thread_t *io, ogs_sockopt_t *option)
+{
+    int rv;
+
+    ogs_assert(io);
+    ogs_assert(option);
+
+    io->sock = ogs_tcp_server(io->server->node.addr, option);
+    if (!io->sock) {
+        ogs_error("Cannot start SBI I/O thread [%d]", io->index);
+        return OGS_ERROR;
+    }
+
+    io->pollset = ogs_pollset_create(ogs_app()->pool.socket);
+    ogs_assert(io->pollset);
+
+    ogs_pool_create(&io->session_pool, max_num_of_session);
+    ogs_pool_create(&io->stream_pool, max_num_of_stream);
+
+    io_ring_create(&io->to_nf, 2 * max_num_of_stream + IO_RING_SLACK);
+    io_ring_create(&io->to_io, 2 * max_num_of_stream + IO_RING_SLACK);
+
+    rv = ogs_socketpair(AF_SOCKPAIR, SOCK_STREAM, 0, io->nf_notify);
+    ogs_assert(rv == OGS_OK);
+    rv = ogs_nonblocking(io->nf_notify[0]);
+    ogs_assert(rv == OGS_OK);
+
+    io->nf_poll = ogs_pollset_add(ogs_app()->pollset,
+            OGS_POLLIN, io->nf_notify[0], io_nf_handler, io);
+    ogs_assert(io->nf_poll);
+
+    io->poll = ogs_pollset_add(io->pollset,
+            OGS_POLLIN, io->sock->fd, io_accept_handler, io);
+    ogs_assert(io->poll);
+
+    io->thread = ogs_thread_create(io_main, io);
+    ogs_assert(io->thread);
+
+    return OGS_OK;
+}
+
+static int io_start(ogs_sbi_server_t *server)
+{
+    io_thread_t *io = NULL;
+    ogs_sockopt_t option;
+    int i;
+
+    ogs_assert(server);
+    ogs_assert(server->num_of_io_thread > 0);
+
+    if (stream_pool_reserve(
+                num_of_io_thread + server->num_of_io_thread) != OGS_OK)
+        return OGS_ERROR;
+
+    /* Every I/O thread listens on the same address */
+    ogs_sockopt_init(&option);
+    if (server->node.option)
+        memcpy(&option, server->node.option, sizeof option);
+    option.so_reuseport = true;
+
+    io = ogs_calloc(server->num_of_io_thread, sizeof(io_thread_t));
+    ogs_assert(io);
+    server->io = io;
+    num_of_io_thread += server->num_of_io_thread;
+
+    for (i = 0; i < server->num_of_io_thread; i++) {
+        io[i].index = i;
+        io[i].server = server;
+
+        if (io_init(&io[i], &option) != OGS_OK) {
+            io_stop(server);
+            return OGS_ERROR;
+        }
+    }
+
+    return OGS_OK;
+}
+
+/* After the I/O thread has exited */
+static void io_final(io_thread_t *io)
+{
+    ogs_sbi_stream_t *proxy = NULL;
+    io_message_t msg;
+
+    ogs_assert(io);
+
+    if (!io->thread) {
+        if (io->sock)
+            ogs_sock_destroy(io->sock);
+        return;
+    }
+
+    while (io_ring_pop(&io->to_nf, &msg)) {
+        switch (msg.type) {
+        case IO_REQUEST:
+            ogs_sbi_request_free(msg.data);
+            break;
+        case IO_CLOSED:
+            proxy = ogs_pool_find_by_id(&stream_pool, msg.stream->proxy_id);
+            if (proxy)
+                proxy_remove(proxy);
+            ogs_pool_id_free(&io->stream_pool, msg.stream);
+            break;
+        default:
+            ogs_assert_if_reached();
+        }
+    }
+
+    while (io_ring_pop(&io->to_io, &msg)) {
+        switch (msg.type) {
+        case IO_RESPONSE:
+            ogs_sbi_response_free(msg.data);
+            break;
+        case IO_RELEASE:
+            ogs_pool_id_free(&io->stream_pool, msg.stream);
+            break;
+        case IO_GOAWAY:
+            break;
+        default:
+            ogs_assert_if_reached();
+        }
+    }
+
+    ogs_pollset_remove(io->nf_poll);
+    ogs_closesocket(io->nf_notify[0]);
+    ogs_closesocket(io->nf_notify[1]);
+
+    io_ring_destroy(&io->to_io);
+    io_ring_destroy(&io->to_nf);
+
+    ogs_pool_destroy(&io->stream_pool);
+    ogs_pool_destroy(&io->session_pool);
+
+    ogs_pollset_destroy(io->pollset);
+    ogs_sock_destroy(io->sock);
+}
+
+static void io_stop(ogs_sbi_server_t *server)
+{
+    io_thread_t *io = NULL;
+    int i;
+
+    ogs_assert(server);
+
+    io = server->io;
+    if (!io)
+        return;
+
+    for (i = 0; i < server->num_of_io_thread; i++) {
+        if (!io[i].thread)
+            continue;
+
+        __atomic_store_n(&io[i].stop, true, __ATOMIC_RELEASE);
+        ogs_pollset_notify(io[i].pollset);
+
+        ogs_thread_destroy(io[i].thread);
+    }
+
+    for (i = 0; i < server->num_of_io_thread; i++)
+        io_final(&io[i]);
+
+    ogs_free(io);
+    server->io = NULL;
+    num_of_io_thread -= server->num_of_io_thread;
+}
@@ -86,7 +86,7 @@ void ogs_nnrf_nfm_handle_nf_profile(
 
     ogs_sbi_nf_instance_clear(nf_instance);
 
-    nf_instance->nf_type = NFProfile->nf_type;
+    ogs_sbi_nf_instance_set_type(nf_instance, NFProfile->nf_type);
     nf_instance->nf_status = NFProfile->nf_status;
     if (NFProfile->is_heart_beat_timer == true)
         nf_instance->time.heartbeat_interval = NFProfile->heart_beat_timer;
@@ -181,21 +181,18 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 #define internal_realloc realloc
 #else
 #include "ogs-core.h"
+#include "../include/arena.h"
 static void *internal_malloc(size_t size)
 {
-    void *ptr = ogs_malloc(size);
-    ogs_assert(ptr);
-    return ptr;
+    return OpenAPI_arena_malloc(size);
 }
 static void internal_free(void *pointer)
 {
-    ogs_free(pointer);
+    OpenAPI_arena_free(pointer);
 }
 static void *internal_realloc(void *pointer, size_t size)
 {
-    void *ptr = ogs_realloc(pointer, size);
-    ogs_assert(ptr);
-    return ptr;
+    return OpenAPI_arena_realloc(pointer, size);
 }
 #endif
 #endif
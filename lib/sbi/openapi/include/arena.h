@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OGS_SBI_ARENA_H
+#define OGS_SBI_ARENA_H
+
+#include "ogs-core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Arena for the cJSON trees that only live while a message body
+ * is converted from or to the OpenAPI model structures.
+ *
+ * Between OpenAPI_arena_enter() and OpenAPI_arena_leave(), every
+ * cJSON node, string and print buffer is carved out of a few chunks,
+ * and cJSON_Delete()/cJSON_free() on them does nothing.
+ * OpenAPI_arena_leave() gives all of it back at once, so nothing
+ * allocated by cJSON inside the arena may be used after it.
+ *
+ * The arena is kept per thread and cannot be nested.
+ */
+#define OGS_SBI_ARENA_CHUNK_SIZE 8192
+
+void OpenAPI_arena_enter(size_t size_hint);
+void OpenAPI_arena_leave(void);
+
+/*
+ * A cJSON tree that outlives the arena (e.g. OpenAPI_any_type_t)
+ * is allocated from the heap between these two.
+ */
+bool OpenAPI_arena_suspend(void);
+void OpenAPI_arena_resume(bool suspended);
+
+/* Number of chunks and heap allocations made by cJSON */
+uint64_t OpenAPI_arena_alloc_count(void);
+
+void *OpenAPI_arena_malloc(size_t size);
+void OpenAPI_arena_free(void *ptr);
+void *OpenAPI_arena_realloc(void *oldptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_SBI_ARENA_H */
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../include/arena.h"
+
+#define ARENA_ALIGN 8
+#define ARENA_ALIGN_UP(__x) \
+    (((__x) + (ARENA_ALIGN - 1)) & ~((uintptr_t)ARENA_ALIGN - 1))
+
+/* Every allocation is preceded by its size, for realloc */
+#define ARENA_HEADER_SIZE ARENA_ALIGN_UP(sizeof(size_t))
+#define ARENA_SIZE(__ptr) (((size_t *)(__ptr))[-1])
+
+/* A chunk does not grow beyond this unless one allocation needs it */
+#define ARENA_MAX_CHUNK_SIZE (1024*1024)
+
+typedef struct arena_chunk_s {
+    struct arena_chunk_s *next;
+    size_t size;
+    uint8_t *tail, *end;
+} arena_chunk_t;
+
+static OGS_THREAD_LOCAL arena_chunk_t *chunk_list;  /* Newest first */
+static OGS_THREAD_LOCAL bool active;
+static OGS_THREAD_LOCAL uint64_t alloc_count;
+
+static arena_chunk_t *chunk_add(size_t size)
+{
+    arena_chunk_t *chunk = NULL;
+
+    if (size < OGS_SBI_ARENA_CHUNK_SIZE)
+        size = OGS_SBI_ARENA_CHUNK_SIZE;
+
+    chunk = ogs_malloc(sizeof(*chunk) + size);
+    ogs_assert(chunk);
+    alloc_count++;
+
+    chunk->size = size;
+    chunk->tail = (uint8_t *)(chunk + 1);
+    chunk->end = chunk->tail + size;
+
+    chunk->next = chunk_list;
+    chunk_list = chunk;
+
+    return chunk;
+}
+
+static uint8_t *chunk_reserve(arena_chunk_t *chunk, size_t size)
+{
+    uint8_t *ptr = (uint8_t *)ARENA_ALIGN_UP(
+            (uintptr_t)chunk->tail + ARENA_HEADER_SIZE);
+
+    if (ptr + size > chunk->end)
+        return NULL;
+
+    chunk->tail = ptr + size;
+    ARENA_SIZE(ptr) = size;
+
+    return ptr;
+}
+
+static void *arena_alloc(size_t size)
+{
+    arena_chunk_t *chunk = chunk_list;
+    size_t chunk_size;
+    uint8_t *ptr = NULL;
+
+    ogs_assert(chunk);
+
+    ptr = chunk_reserve(chunk, size);
+    if (!ptr) {
+        /* Each chunk is twice as large as the one before */
+        chunk_size = chunk->size * 2;
+        if (chunk_size > ARENA_MAX_CHUNK_SIZE)
+            chunk_size = ARENA_MAX_CHUNK_SIZE;
+        if (chunk_size < size + ARENA_HEADER_SIZE + ARENA_ALIGN)
+            chunk_size = size + ARENA_HEADER_SIZE + ARENA_ALIGN;
+
+        chunk = chunk_add(chunk_size);
+        ptr = chunk_reserve(chunk, size);
+        ogs_assert(ptr);
+    }
+
+    return ptr;
+}
+
+static bool arena_has(const void *ptr)
+{
+    arena_chunk_t *chunk = NULL;
+
+    for (chunk = chunk_list; chunk; chunk = chunk->next) {
+        if ((const uint8_t *)ptr > (const uint8_t *)(chunk + 1) &&
+            (const uint8_t *)ptr < chunk->end)
+            return true;
+    }
+
+    return false;
+}
+
+void OpenAPI_arena_enter(size_t size_hint)
+{
+    ogs_assert(active == false);
+    ogs_assert(chunk_list == NULL);
+
+    chunk_add(size_hint);
+    active = true;
+}
+
+void OpenAPI_arena_leave(void)
+{
+    arena_chunk_t *chunk = NULL, *next = NULL;
+
+    ogs_assert(active == true);
+
+    for (chunk = chunk_list; chunk; chunk = next) {
+        next = chunk->next;
+        ogs_free(chunk);
+    }
+    chunk_list = NULL;
+
+    active = false;
+}
+
+bool OpenAPI_arena_suspend(void)
+{
+    if (active == false)
+        return false;
+
+    active = false;
+    return true;
+}
+
+void OpenAPI_arena_resume(bool suspended)
+{
+    if (suspended == true) {
+        ogs_assert(chunk_list);
+        active = true;
+    }
+}
+
+uint64_t OpenAPI_arena_alloc_count(void)
+{
+    return alloc_count;
+}
+
+void *OpenAPI_arena_malloc(size_t size)
+{
+    void *ptr = NULL;
+
+    if (active)
+        return arena_alloc(size);
+
+    ptr = ogs_malloc(size);
+    ogs_assert(ptr);
+    alloc_count++;
+
+    return ptr;
+}
+
+void OpenAPI_arena_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    if (chunk_list && arena_has(ptr))
+        return;
+
+    ogs_free(ptr);
+}
+
+void *OpenAPI_arena_realloc(void *oldptr, size_t size)
+{
+    void *ptr = NULL;
+    size_t oldsize;
+
+    if (!oldptr)
+        return OpenAPI_arena_malloc(size);
+
+    if (chunk_list && arena_has(oldptr)) {
+        oldsize = ARENA_SIZE(oldptr);
+        if (size <= oldsize)
+            return oldptr;
+
+        /* The last allocation in the chunk grows in place */
+        if (active &&
+            (uint8_t *)oldptr + oldsize == chunk_list->tail &&
+            (uint8_t *)oldptr + size <= chunk_list->end) {
+            chunk_list->tail = (uint8_t *)oldptr + size;
+            ARENA_SIZE(oldptr) = size;
+            return oldptr;
+        }
+
+        ptr = OpenAPI_arena_malloc(size);
+        memcpy(ptr, oldptr, oldsize);
+        return ptr;
+    }
+
+    ptr = ogs_realloc(oldptr, size);
+    ogs_assert(ptr);
+    alloc_count++;
+
+    return ptr;
+}
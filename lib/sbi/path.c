@@ -307,6 +307,8 @@ int ogs_sbi_discover_and_send(ogs_sbi_xact_t *xact)
             OGS_SBI_SETUP_NF_INSTANCE(
                     sbi_object->service_type_array[service_type], nf_instance);
     }
+    if (nf_instance)
+        ogs_sbi_self()->discover_stats.hit++;
 
     /* Target Client */
     if (request->h.uri == NULL) {
@@ -531,6 +533,143 @@ int ogs_sbi_discover_and_send(ogs_sbi_xact_t *xact)
     return OGS_OK;
 }
 
+static int discover_query_compare(const void *a, const void *b)
+{
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+/*
+ * Two NF-Discover requests get the same answer from the NRF
+ * if they have the same resource and the same query parameters,
+ * whatever the order they were added in.
+ */
+static char *discover_query(ogs_sbi_request_t *request)
+{
+    ogs_hash_index_t *hi = NULL;
+    const char **keys = NULL;
+    char *query = NULL;
+    int i, num_of_key = 0;
+
+    ogs_assert(request);
+    ogs_assert(request->h.service.name);
+    ogs_assert(request->h.resource.component[0]);
+
+    query = ogs_msprintf("%s/%s", request->h.service.name,
+            request->h.resource.component[0]);
+    ogs_assert(query);
+
+    num_of_key = ogs_hash_count(request->http.params);
+    if (!num_of_key)
+        return query;
+
+    keys = ogs_calloc(num_of_key, sizeof(*keys));
+    ogs_assert(keys);
+
+    i = 0;
+    for (hi = ogs_hash_first(request->http.params);
+            hi && i < num_of_key; hi = ogs_hash_next(hi))
+        keys[i++] = ogs_hash_this_key(hi);
+
+    qsort(keys, i, sizeof(*keys), discover_query_compare);
+
+    for (num_of_key = i, i = 0; i < num_of_key; i++)
+        query = ogs_mstrcatf(query, "%c%s=%s", i ? '&' : '?', keys[i],
+                (char *)ogs_hash_get(request->http.params,
+                    keys[i], OGS_HASH_KEY_STRING));
+
+    ogs_free(keys);
+
+    return query;
+}
+
+static ogs_sbi_response_t *discover_response_copy(
+        ogs_sbi_response_t *response)
+{
+    ogs_sbi_response_t *copy = NULL;
+    ogs_hash_index_t *hi = NULL;
+
+    ogs_assert(response);
+
+    copy = ogs_sbi_response_new();
+    if (!copy) {
+        ogs_error("ogs_sbi_response_new() failed");
+        return NULL;
+    }
+
+    copy->status = response->status;
+    if (response->h.method) {
+        copy->h.method = ogs_strdup(response->h.method);
+        ogs_assert(copy->h.method);
+    }
+    if (response->h.uri) {
+        copy->h.uri = ogs_strdup(response->h.uri);
+        ogs_assert(copy->h.uri);
+    }
+
+    for (hi = ogs_hash_first(response->http.headers);
+            hi; hi = ogs_hash_next(hi))
+        ogs_sbi_header_set(copy->http.headers,
+                ogs_hash_this_key(hi), ogs_hash_this_val(hi));
+
+    if (response->http.content) {
+        /* Keep the terminating NUL the client added */
+        copy->http.content = ogs_memdup(
+                response->http.content, response->http.content_length + 1);
+        ogs_assert(copy->http.content);
+        copy->http.content_length = response->http.content_length;
+    }
+
+    return copy;
+}
+
+static int client_discover_only_cb(
+        int status, ogs_sbi_response_t *response, void *data)
+{
+    ogs_sbi_discover_t *discover = NULL;
+    ogs_pool_id_t discover_id = 0;
+    ogs_pool_id_t xact_id = 0;
+    ogs_sbi_response_t *copy = NULL;
+    int i;
+
+    discover_id = OGS_POINTER_TO_UINT(data);
+    ogs_assert(discover_id >= OGS_MIN_POOL_ID &&
+            discover_id <= OGS_MAX_POOL_ID);
+
+    discover = ogs_sbi_discover_find_by_id(discover_id);
+    if (!discover) {
+        ogs_warn("NF-Discover has already been removed [%d]", discover_id);
+        if (response)
+            ogs_sbi_response_free(response);
+        return OGS_ERROR;
+    }
+
+    /*
+     * The waiters are left to their own response timer on failure,
+     * the same way as the xact that sent the request.
+     */
+    if (status == OGS_OK) {
+        ogs_assert(response);
+
+        for (i = 0; i < discover->num_of_waiter; i++) {
+            if (!ogs_sbi_xact_find_by_id(discover->waiter[i]))
+                continue;
+
+            copy = discover_response_copy(response);
+            if (!copy)
+                continue;
+
+            ogs_sbi_client_handler(OGS_OK, copy,
+                    OGS_UINT_TO_POINTER(discover->waiter[i]));
+        }
+    }
+
+    xact_id = discover->xact_id;
+    ogs_sbi_discover_remove(discover);
+
+    return ogs_sbi_client_handler(
+            status, response, OGS_UINT_TO_POINTER(xact_id));
+}
+
 int ogs_sbi_discover_only(ogs_sbi_xact_t *xact)
 {
     ogs_sbi_nf_instance_t *nf_instance = NULL;
@@ -559,9 +698,8 @@ int ogs_sbi_discover_only(ogs_sbi_xact_t *xact)
         bool rc;
         ogs_sbi_client_t *client = NULL;
         ogs_sbi_request_t *request = NULL;
-
-        ogs_warn("Try to discover [%s]",
-                    ogs_sbi_service_type_to_name(service_type));
+        ogs_sbi_discover_t *discover = NULL;
+        char *query = NULL;
 
         client = NF_INSTANCE_CLIENT(nf_instance);
         if (!client) {
@@ -576,14 +714,51 @@ int ogs_sbi_discover_only(ogs_sbi_xact_t *xact)
             return OGS_ERROR;
         }
 
+        query = discover_query(request);
+
+        /* The same NF-Discover is in flight, wait for its answer */
+        discover = ogs_sbi_discover_find(query);
+        if (discover) {
+            ogs_free(query);
+            ogs_sbi_request_free(request);
+
+            ogs_debug("Wait for discovering [%s]",
+                        ogs_sbi_service_type_to_name(service_type));
+
+            if (ogs_sbi_discover_add_waiter(discover, xact->id) == false)
+                return OGS_ERROR;
+
+            ogs_sbi_self()->discover_stats.shared++;
+            return OGS_OK;
+        }
+
+        discover = ogs_sbi_discover_add(query, xact->id);
+        ogs_free(query);
+        if (!discover) {
+            ogs_sbi_request_free(request);
+            return OGS_ERROR;
+        }
+
+        ogs_sbi_self()->discover_stats.miss++;
+        ogs_warn("Try to discover [%s] (hit %llu, shared %llu, miss %llu)",
+                    ogs_sbi_service_type_to_name(service_type),
+                    (unsigned long long)ogs_sbi_self()->discover_stats.hit,
+                    (unsigned long long)ogs_sbi_self()->discover_stats.shared,
+                    (unsigned long long)ogs_sbi_self()->discover_stats.miss);
+
         rc = ogs_sbi_client_send_request(
-                client, ogs_sbi_client_handler, request,
-                OGS_UINT_TO_POINTER(xact->id));
+                client, client_discover_only_cb, request,
+                OGS_UINT_TO_POINTER(discover->id));
         ogs_expect(rc == true);
 
         ogs_sbi_request_free(request);
 
-        return (rc == true) ? OGS_OK : OGS_ERROR;
+        if (rc == false) {
+            ogs_sbi_discover_remove(discover);
+            return OGS_ERROR;
+        }
+
+        return OGS_OK;
     }
 
     ogs_error("Cannot discover [%s]",
@@ -51,6 +51,14 @@ typedef struct ogs_sbi_server_s {
     ogs_list_t      session_list;
 
     void            *mhd; /* Used by MHD */
+
+    /*
+     * nghttp2 only: number of threads accepting and serving the HTTP/2
+     * sessions, each with its own SO_REUSEPORT listener.
+     * 0 keeps everything in the NF thread.
+     */
+    int             num_of_io_thread;
+    void            *io;
 } ogs_sbi_server_t;
 
 typedef struct ogs_sbi_server_actions_s {
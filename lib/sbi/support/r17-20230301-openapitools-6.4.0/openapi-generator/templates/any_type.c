@@ -1,4 +1,5 @@
 #include "any_type.h"
+#include "../include/arena.h"
 
 bool OpenAPI_IsInvalid(const OpenAPI_any_type_t * const item)
 {
@@ -58,8 +59,13 @@ static OpenAPI_any_type_t *any_create(cJSON *json) {
 }
 
 OpenAPI_any_type_t *OpenAPI_any_type_create(cJSON *json) {
-    OpenAPI_any_type_t *any_type_local_var =
-        any_create(cJSON_Duplicate(json, true));
+    OpenAPI_any_type_t *any_type_local_var = NULL;
+    bool suspended;
+
+    /* The copy is kept with the model, after the arena is gone */
+    suspended = OpenAPI_arena_suspend();
+    any_type_local_var = any_create(cJSON_Duplicate(json, true));
+    OpenAPI_arena_resume(suspended);
     ogs_assert(any_type_local_var);
 
     return any_type_local_var;
@@ -25,20 +25,38 @@
 ogs_pkbuf_t *ogs_tun_read(ogs_socket_t fd, ogs_pkbuf_pool_t *packet_pool)
 {
     ogs_pkbuf_t *recvbuf = NULL;
-    int n;
 
     ogs_assert(fd != INVALID_SOCKET);
 
     recvbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
     ogs_assert(recvbuf);
+
+    if (ogs_tun_recv(fd, recvbuf) != OGS_OK) {
+        ogs_pkbuf_free(recvbuf);
+        return NULL;
+    }
+
+    return recvbuf;
+}
+
+int ogs_tun_recv(ogs_socket_t fd, ogs_pkbuf_t *recvbuf)
+{
+    int n;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(recvbuf);
+    ogs_assert(recvbuf->len == 0);
+
     ogs_pkbuf_reserve(recvbuf, OGS_TUN_MAX_HEADROOM);
-    ogs_pkbuf_put(recvbuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
+    ogs_pkbuf_put(recvbuf, ogs_pkbuf_tailroom(recvbuf));
 
     n = ogs_read(fd, recvbuf->data, recvbuf->len);
     if (n <= 0) {
+        /* Non-blocking device has been drained */
+        if (n < 0 && ogs_socket_errno == OGS_EAGAIN)
+            return OGS_RETRY;
         ogs_log_message(OGS_LOG_WARN, ogs_socket_errno, "ogs_read() failed");
-        ogs_pkbuf_free(recvbuf);
-        return NULL;
+        return OGS_ERROR;
     }
 
     ogs_pkbuf_trim(recvbuf, n);
@@ -48,7 +66,7 @@ ogs_pkbuf_t *ogs_tun_read(ogs_socket_t fd, ogs_pkbuf_pool_t *packet_pool)
     ogs_pkbuf_pull(recvbuf, 4);
 #endif
 
-    return recvbuf;
+    return OGS_OK;
 }
 
 int ogs_tun_write(ogs_socket_t fd, ogs_pkbuf_t *pkbuf)
@@ -1263,6 +1263,8 @@ amf_gnb_t *amf_gnb_add(ogs_sock_t *sock, ogs_sockaddr_t *addr)
     gnb->ostream_id = 0;
 
     ogs_list_init(&gnb->ran_ue_list);
+    gnb->ran_ue_hash = ogs_hash_make();
+    ogs_assert(gnb->ran_ue_hash);
 
     ogs_hash_set(self.gnb_addr_hash,
             gnb->sctp.addr, sizeof(ogs_sockaddr_t), gnb);
@@ -1300,6 +1302,8 @@ void amf_gnb_remove(amf_gnb_t *gnb)
 
     ogs_sctp_flush_and_destroy(&gnb->sctp);
 
+    ogs_hash_destroy(gnb->ran_ue_hash);
+
     ogs_pool_id_free(&amf_gnb_pool, gnb);
     amf_metrics_inst_global_dec(AMF_METR_GLOB_GAUGE_GNB);
     ogs_info("[Removed] Number of gNBs is now %d",
@@ -1363,6 +1367,66 @@ amf_gnb_t *amf_gnb_find_by_id(ogs_pool_id_t id)
     return ogs_pool_find_by_id(&amf_gnb_pool, id);
 }
 
+/*
+ * RAN-UE-NGAP-ID is only unique within a gNB, so each gNB keeps
+ * its own index. If two ran_ue's end up with the same ID
+ * (e.g. after Path Switch or Handover), the one added first stays
+ * in the hash and is returned by the lookup, as the list scan did.
+ */
+static void ran_ue_hash_add(amf_gnb_t *gnb, ran_ue_t *ran_ue)
+{
+    ogs_assert(gnb);
+    ogs_assert(ran_ue);
+
+    if (ran_ue->ran_ue_ngap_id == INVALID_UE_NGAP_ID)
+        return;
+
+    if (ogs_hash_get(gnb->ran_ue_hash,
+                &ran_ue->ran_ue_ngap_id, sizeof(ran_ue->ran_ue_ngap_id))) {
+        ran_ue->dup_ran_ue_ngap_id = true;
+        gnb->num_of_dup_ran_ue++;
+        return;
+    }
+
+    ogs_hash_set(gnb->ran_ue_hash,
+            &ran_ue->ran_ue_ngap_id, sizeof(ran_ue->ran_ue_ngap_id), ran_ue);
+}
+
+static void ran_ue_hash_remove(amf_gnb_t *gnb, ran_ue_t *ran_ue)
+{
+    ran_ue_t *iter = NULL;
+
+    ogs_assert(gnb);
+    ogs_assert(ran_ue);
+
+    if (ran_ue->ran_ue_ngap_id == INVALID_UE_NGAP_ID)
+        return;
+
+    if (ran_ue->dup_ran_ue_ngap_id == true) {
+        ran_ue->dup_ran_ue_ngap_id = false;
+        gnb->num_of_dup_ran_ue--;
+        return;
+    }
+
+    ogs_hash_set(gnb->ran_ue_hash,
+            &ran_ue->ran_ue_ngap_id, sizeof(ran_ue->ran_ue_ngap_id), NULL);
+
+    if (!gnb->num_of_dup_ran_ue)
+        return;
+
+    /* Hand the key over to the next ran_ue with the same ID */
+    ogs_list_for_each(&gnb->ran_ue_list, iter) {
+        if (iter != ran_ue && iter->dup_ran_ue_ngap_id == true &&
+            iter->ran_ue_ngap_id == ran_ue->ran_ue_ngap_id) {
+            iter->dup_ran_ue_ngap_id = false;
+            gnb->num_of_dup_ran_ue--;
+            ogs_hash_set(gnb->ran_ue_hash,
+                    &iter->ran_ue_ngap_id, sizeof(iter->ran_ue_ngap_id), iter);
+            break;
+        }
+    }
+}
+
 /** ran_ue_context handling function */
 ran_ue_t *ran_ue_add(amf_gnb_t *gnb, uint64_t ran_ue_ngap_id)
 {
@@ -1404,6 +1468,7 @@ ran_ue_t *ran_ue_add(amf_gnb_t *gnb, uint64_t ran_ue_ngap_id)
     ran_ue->gnb_id = gnb->id;
 
     ogs_list_add(&gnb->ran_ue_list, ran_ue);
+    ran_ue_hash_add(gnb, ran_ue);
 
     stats_add_ran_ue();
 
@@ -1418,7 +1483,10 @@ void ran_ue_remove(ran_ue_t *ran_ue)
 
     gnb = amf_gnb_find_by_id(ran_ue->gnb_id);
 
-    if (gnb) ogs_list_remove(&gnb->ran_ue_list, ran_ue);
+    if (gnb) {
+        ran_ue_hash_remove(gnb, ran_ue);
+        ogs_list_remove(&gnb->ran_ue_list, ran_ue);
+    }
 
     ogs_assert(ran_ue->t_ng_holding);
     ogs_timer_delete(ran_ue->t_ng_holding);
@@ -1439,26 +1507,38 @@ void ran_ue_switch_to_gnb(ran_ue_t *ran_ue, amf_gnb_t *new_gnb)
     ogs_assert(gnb);
 
     /* Remove from the old gnb */
+    ran_ue_hash_remove(gnb, ran_ue);
     ogs_list_remove(&gnb->ran_ue_list, ran_ue);
 
     /* Add to the new gnb */
     ogs_list_add(&new_gnb->ran_ue_list, ran_ue);
+    ran_ue_hash_add(new_gnb, ran_ue);
 
     /* Switch to gnb */
     ran_ue->gnb_id = new_gnb->id;
 }
 
+void ran_ue_set_ran_ue_ngap_id(ran_ue_t *ran_ue, uint64_t ran_ue_ngap_id)
+{
+    amf_gnb_t *gnb = NULL;
+
+    ogs_assert(ran_ue);
+
+    gnb = amf_gnb_find_by_id(ran_ue->gnb_id);
+    ogs_assert(gnb);
+
+    ran_ue_hash_remove(gnb, ran_ue);
+    ran_ue->ran_ue_ngap_id = ran_ue_ngap_id;
+    ran_ue_hash_add(gnb, ran_ue);
+}
+
 ran_ue_t *ran_ue_find_by_ran_ue_ngap_id(
         amf_gnb_t *gnb, uint64_t ran_ue_ngap_id)
 {
-    ran_ue_t *ran_ue = NULL;
-
-    ogs_list_for_each(&gnb->ran_ue_list, ran_ue) {
-        if (ran_ue_ngap_id == ran_ue->ran_ue_ngap_id)
-            break;
-    }
+    ogs_assert(gnb);
 
-    return ran_ue;
+    return (ran_ue_t *)ogs_hash_get(gnb->ran_ue_hash,
+            &ran_ue_ngap_id, sizeof(ran_ue_ngap_id));
 }
 
 ran_ue_t *ran_ue_find(uint32_t index)
@@ -167,6 +167,8 @@ typedef struct amf_gnb_s {
     ogs_pkbuf_t     *ng_reset_ack; /* Reset message */
 
     ogs_list_t      ran_ue_list;
+    ogs_hash_t      *ran_ue_hash;   /* hash table for RAN-UE-NGAP-ID */
+    int             num_of_dup_ran_ue; /* ran_ue not in ran_ue_hash */
 
 } amf_gnb_t;
 
@@ -179,6 +181,7 @@ struct ran_ue_s {
 #define INVALID_UE_NGAP_ID 0xffffffffffffffffULL /* Initial value of ran_ue_ngap_id */
     uint64_t        ran_ue_ngap_id; /* RAN-UE-NGAP-ID received from RAN */
     uint64_t        amf_ue_ngap_id; /* AMF-UE-NGAP-ID received from AMF */
+    bool            dup_ran_ue_ngap_id; /* Another ran_ue owns the hash key */
 
     uint16_t        gnb_ostream_id; /* SCTP output stream id for eNB */
 
@@ -363,6 +366,9 @@ struct amf_ue_s {
     ogs_5gs_tai_t   nr_tai;
     ogs_nr_cgi_t    nr_cgi;
     ogs_time_t      ue_location_timestamp;
+
+    /* Start of the registration procedure, for fivegs_amffunction_rm_regtime */
+    ogs_time_t      registration_started;
     ogs_plmn_id_t   last_visited_plmn_id;
     ogs_nas_ue_usage_setting_t ue_usage_setting;
 
@@ -512,6 +518,9 @@ struct amf_ue_s {
      * #define OGS_NAS_SECURITY_ALGORITHMS_128_NIA1    2
      * #define OGS_NAS_SECURITY_ALGORITHMS_128_NIA3    3 */
     uint8_t         selected_int_algorithm;
+    /* Key schedules of the selected algorithms, kept across NAS messages */
+    ogs_nas_cipher_ctx_t nas_enc_ctx;
+    ogs_nas_cipher_ctx_t nas_int_ctx;
 
     /* SubscribedInfo */
     ogs_bitrate_t   ue_ambr;
@@ -940,6 +949,7 @@ amf_gnb_t *amf_gnb_find_by_id(ogs_pool_id_t id);
 ran_ue_t *ran_ue_add(amf_gnb_t *gnb, uint64_t ran_ue_ngap_id);
 void ran_ue_remove(ran_ue_t *ran_ue);
 void ran_ue_switch_to_gnb(ran_ue_t *ran_ue, amf_gnb_t *new_gnb);
+void ran_ue_set_ran_ue_ngap_id(ran_ue_t *ran_ue, uint64_t ran_ue_ngap_id);
 ran_ue_t *ran_ue_find_by_ran_ue_ngap_id(
         amf_gnb_t *gnb, uint64_t ran_ue_ngap_id);
 ran_ue_t *ran_ue_find(uint32_t index);
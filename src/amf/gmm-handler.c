@@ -1791,7 +1791,8 @@ static ogs_nas_5gmm_cause_t gmm_handle_nas_message_container(
         case OGS_NAS_SECURITY_ALGORITHMS_128_NEA1:
         case OGS_NAS_SECURITY_ALGORITHMS_128_NEA2:
         case OGS_NAS_SECURITY_ALGORITHMS_128_NEA3:
-            ogs_nas_encrypt(amf_ue->selected_enc_algorithm,
+            ogs_nas_encrypt_ctx(&amf_ue->nas_enc_ctx,
+                amf_ue->selected_enc_algorithm,
                 amf_ue->knas_enc, amf_ue->ul_count.i32,
                 amf_ue->nas.access_type,
                 OGS_NAS_SECURITY_UPLINK_DIRECTION, nasbuf);
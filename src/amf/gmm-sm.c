@@ -1372,6 +1372,8 @@ static void common_register_state(ogs_fsm_t *s, amf_event_t *e,
                     amf_ue, h, e->ngap.code,
                     &nas_message->gmm.registration_request);
 
+            amf_ue->registration_started = ogs_get_monotonic_time();
+
             switch (amf_ue->nas.registration.value) {
             case OGS_NAS_5GS_REGISTRATION_TYPE_INITIAL:
                 amf_metrics_inst_global_inc(AMF_METR_GLOB_CTR_RM_REG_INIT_REQ);
@@ -2823,6 +2825,14 @@ void gmm_state_initial_context_setup(ogs_fsm_t *s, amf_event_t *e)
                 ogs_error("Unknown reg_type[%d]",
                         amf_ue->nas.registration.value);
             }
+
+            if (amf_ue->registration_started) {
+                amf_metrics_inst_global_add(AMF_METR_GLOB_HIST_REG_TIME,
+                        ogs_time_to_msec(ogs_get_monotonic_time() -
+                            amf_ue->registration_started));
+                amf_ue->registration_started = 0;
+            }
+
             OGS_FSM_TRAN(s, &gmm_state_registered);
             break;
 
@@ -82,7 +82,8 @@ ogs_pkbuf_t *nas_5gs_security_encode(
 
     if (ciphered) {
         /* encrypt NAS message */
-        ogs_nas_encrypt(amf_ue->selected_enc_algorithm,
+        ogs_nas_encrypt_ctx(&amf_ue->nas_enc_ctx,
+            amf_ue->selected_enc_algorithm,
             amf_ue->knas_enc, amf_ue->dl_count,
             amf_ue->nas.access_type,
             OGS_NAS_SECURITY_DOWNLINK_DIRECTION, new);
@@ -96,7 +97,8 @@ ogs_pkbuf_t *nas_5gs_security_encode(
         uint8_t mac[NAS_SECURITY_MAC_SIZE];
 
         /* calculate NAS MAC(message authentication code) */
-        ogs_nas_mac_calculate(amf_ue->selected_int_algorithm,
+        ogs_nas_mac_calculate_ctx(&amf_ue->nas_int_ctx,
+            amf_ue->selected_int_algorithm,
             amf_ue->knas_int, amf_ue->dl_count,
             amf_ue->nas.access_type,
             OGS_NAS_SECURITY_DOWNLINK_DIRECTION, new, mac);
@@ -159,7 +161,8 @@ int nas_5gs_security_decode(amf_ue_t *amf_ue,
             uint32_t original_mac = h->message_authentication_code;
 
             /* calculate NAS MAC(message authentication code) */
-            ogs_nas_mac_calculate(amf_ue->selected_int_algorithm,
+            ogs_nas_mac_calculate_ctx(&amf_ue->nas_int_ctx,
+                amf_ue->selected_int_algorithm,
                 amf_ue->knas_int, amf_ue->ul_count.i32,
                 amf_ue->nas.access_type,
                 OGS_NAS_SECURITY_UPLINK_DIRECTION, pkbuf, mac);
@@ -182,7 +185,8 @@ int nas_5gs_security_decode(amf_ue_t *amf_ue,
                 ogs_error("Cannot decrypt Malformed NAS Message");
                 return OGS_ERROR;
             }
-            ogs_nas_encrypt(amf_ue->selected_enc_algorithm,
+            ogs_nas_encrypt_ctx(&amf_ue->nas_enc_ctx,
+                amf_ue->selected_enc_algorithm,
                 amf_ue->knas_enc, amf_ue->ul_count.i32,
                 amf_ue->nas.access_type,
                 OGS_NAS_SECURITY_UPLINK_DIRECTION, pkbuf);
@@ -2825,7 +2825,7 @@ void ngap_handle_path_switch_request(
         amf_ue->nr_tai.tac.v, (long long)amf_ue->nr_cgi.cell_id);
 
     /* Update RAN-UE-NGAP-ID */
-    ran_ue->ran_ue_ngap_id = *RAN_UE_NGAP_ID;
+    ran_ue_set_ran_ue_ngap_id(ran_ue, *RAN_UE_NGAP_ID);
 
     /* Change ran_ue to the NEW gNB */
     ran_ue_switch_to_gnb(ran_ue, gnb);
@@ -3523,7 +3523,7 @@ void ngap_handle_handover_request_ack(
         return;
     }
 
-    target_ue->ran_ue_ngap_id = *RAN_UE_NGAP_ID;
+    ran_ue_set_ran_ue_ngap_id(target_ue, *RAN_UE_NGAP_ID);
 
     source_ue = ran_ue_find_by_id(target_ue->source_ue_id);
     if (!source_ue) {
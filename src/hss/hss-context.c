@@ -111,7 +111,6 @@ void hss_context_init(void)
     self.impu_hash = ogs_hash_make();
     ogs_assert(self.impu_hash);
 
-    ogs_thread_mutex_init(&self.db_lock);
     ogs_thread_mutex_init(&self.cx_lock);
 
     context_initialized = 1;
@@ -135,7 +134,6 @@ void hss_context_final(void)
     ogs_pool_final(&impi_pool);
     ogs_pool_final(&impu_pool);
 
-    ogs_thread_mutex_destroy(&self.db_lock);
     ogs_thread_mutex_destroy(&self.cx_lock);
 
     context_initialized = 0;
@@ -375,14 +373,14 @@ int hss_db_auth_info(char *imsi_bcd, ogs_dbi_auth_info_t *auth_info)
     ogs_assert(imsi_bcd);
     ogs_assert(auth_info);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_auth_info(supi, auth_info);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -394,14 +392,14 @@ int hss_db_update_sqn(char *imsi_bcd, uint8_t *rand, uint64_t sqn)
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_update_sqn(supi, sqn);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -413,14 +411,14 @@ int hss_db_update_imeisv(char *imsi_bcd, char *imeisv)
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_update_imeisv(supi, imeisv);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -433,14 +431,14 @@ int hss_db_update_mme(char *imsi_bcd, char *mme_host, char *mme_realm,
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_update_mme(supi, mme_host, mme_realm, purge_flag);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -452,14 +450,14 @@ int hss_db_increment_sqn(char *imsi_bcd)
 
     ogs_assert(imsi_bcd);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_increment_sqn(supi);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -473,14 +471,14 @@ int hss_db_subscription_data(
     ogs_assert(imsi_bcd);
     ogs_assert(subscription_data);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_subscription_data(supi, subscription_data);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -492,11 +490,11 @@ int hss_db_msisdn_data(char *imsi_or_msisdn_bcd, ogs_msisdn_data_t *msisdn_data)
     ogs_assert(imsi_or_msisdn_bcd);
     ogs_assert(msisdn_data);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
 
     rv = ogs_dbi_msisdn_data(imsi_or_msisdn_bcd, msisdn_data);
 
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -509,14 +507,14 @@ int hss_db_ims_data(char *imsi_bcd, ogs_ims_data_t *ims_data)
     ogs_assert(imsi_bcd);
     ogs_assert(ims_data);
 
-    ogs_thread_mutex_lock(&self.db_lock);
+    ogs_dbi_client_acquire();
     supi = ogs_msprintf("%s-%s", OGS_ID_SUPI_TYPE_IMSI, imsi_bcd);
     ogs_assert(supi);
 
     rv = ogs_dbi_ims_data(supi, ims_data);
 
     ogs_free(supi);
-    ogs_thread_mutex_unlock(&self.db_lock);
+    ogs_dbi_client_release();
 
     return rv;
 }
@@ -1366,15 +1364,11 @@ static int process_change_stream(const bson_t *document);
 
 int hss_db_poll_change_stream(void)
 {
-    int rv;
-
-    ogs_thread_mutex_lock(&self.db_lock);
-
-    rv = poll_change_stream();
-
-    ogs_thread_mutex_unlock(&self.db_lock);
-
-    return rv;
+    /*
+     * The change stream belongs to the main client,
+     * which is only used from the HSS main thread.
+     */
+    return poll_change_stream();
 }
 
 static int poll_change_stream(void)
@@ -1449,6 +1443,8 @@ int hss_handle_change_event(const bson_t *document)
 # else
     ogs_debug("Received change stream document.");
 #endif
+    ogs_dbi_cache_handle_change_stream(document);
+
     if (!bson_iter_init_find(&iter, document, "fullDocument")) {
         ogs_error("No 'imsi' field in this document.");
         return OGS_ERROR;
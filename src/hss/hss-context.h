@@ -42,7 +42,6 @@ typedef struct _hss_context_t {
     const char          *sms_over_ims;  /* SMS over IMS */
     int                 use_mongodb_change_stream;
 
-    ogs_thread_mutex_t  db_lock;
     ogs_thread_mutex_t  cx_lock;
 
     /* S6A Interface */
@@ -233,6 +233,27 @@ hss_metrics_spec_def_t hss_metrics_spec_def_global[_HSS_METR_GLOB_MAX] = {
     .name = "swx_tx_saa",
     .description = "Transmitted SWx SAA messages",
 },
+/* Global Counters: Subscriber cache */
+[HSS_METR_GLOB_CTR_DB_CACHE_HIT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_hit",
+    .description = "Subscription data found in the subscriber cache",
+},
+[HSS_METR_GLOB_CTR_DB_CACHE_MISS] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_miss",
+    .description = "Subscription data read from the DB",
+},
+[HSS_METR_GLOB_CTR_DB_CACHE_EVICTION] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_eviction",
+    .description = "Subscriber cache entries evicted when full",
+},
+[HSS_METR_GLOB_CTR_DB_CACHE_INVALIDATION] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_invalidation",
+    .description = "Subscriber cache entries invalidated by DB changes",
+},
 /* Global Gauges: */
 [HSS_METR_GLOB_GAUGE_IMSI] = {
     .type = OGS_METRICS_METRIC_TYPE_GAUGE,
@@ -249,6 +270,11 @@ hss_metrics_spec_def_t hss_metrics_spec_def_global[_HSS_METR_GLOB_MAX] = {
     .name = "hss_impu",
     .description = "Number of IMPUs attached to HSS",
 },
+[HSS_METR_GLOB_GAUGE_DB_CACHE_ENTRY] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "db_cache_entry",
+    .description = "Number of entries in the subscriber cache",
+},
 };
 int hss_metrics_init_inst_global(void)
 {
@@ -260,6 +286,35 @@ int hss_metrics_free_inst_global(void)
     return hss_metrics_free_inst(hss_metrics_inst_global, _HSS_METR_GLOB_MAX);
 }
 
+/* Counters already published from ogs_dbi_cache_stat() */
+static ogs_dbi_cache_stat_t db_cache_published;
+
+static void db_cache_publish(hss_metric_type_global_t t,
+        uint64_t *published, uint64_t total)
+{
+    hss_metrics_inst_global_add(t, (int)(total - *published));
+    *published = total;
+}
+
+static void hss_metrics_db_cache_collect(void)
+{
+    ogs_dbi_cache_stat_t stat;
+
+    ogs_dbi_cache_stat(&stat);
+
+    db_cache_publish(HSS_METR_GLOB_CTR_DB_CACHE_HIT,
+            &db_cache_published.hit, stat.hit);
+    db_cache_publish(HSS_METR_GLOB_CTR_DB_CACHE_MISS,
+            &db_cache_published.miss, stat.miss);
+    db_cache_publish(HSS_METR_GLOB_CTR_DB_CACHE_EVICTION,
+            &db_cache_published.eviction, stat.eviction);
+    db_cache_publish(HSS_METR_GLOB_CTR_DB_CACHE_INVALIDATION,
+            &db_cache_published.invalidation, stat.invalidation);
+
+    hss_metrics_inst_global_set(HSS_METR_GLOB_GAUGE_DB_CACHE_ENTRY,
+            stat.count);
+}
+
 void hss_metrics_init(void)
 {
     ogs_metrics_context_t *ctx = ogs_metrics_self();
@@ -269,9 +324,13 @@ void hss_metrics_init(void)
             _HSS_METR_GLOB_MAX);
 
     hss_metrics_init_inst_global();
+
+    memset(&db_cache_published, 0, sizeof(db_cache_published));
+    ogs_metrics_register_collector(hss_metrics_db_cache_collect);
 }
 
 void hss_metrics_final(void)
 {
+    ogs_metrics_register_collector(NULL);
     ogs_metrics_context_final();
 }
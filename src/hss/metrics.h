@@ -48,9 +48,15 @@ typedef enum hss_metric_type_global_s {
     HSS_METR_GLOB_CTR_SWx_TX_MAA,
     HSS_METR_GLOB_CTR_SWx_TX_SAA,
 
+    HSS_METR_GLOB_CTR_DB_CACHE_HIT,
+    HSS_METR_GLOB_CTR_DB_CACHE_MISS,
+    HSS_METR_GLOB_CTR_DB_CACHE_EVICTION,
+    HSS_METR_GLOB_CTR_DB_CACHE_INVALIDATION,
+
     HSS_METR_GLOB_GAUGE_IMSI,
     HSS_METR_GLOB_GAUGE_IMPI,
     HSS_METR_GLOB_GAUGE_IMPU,
+    HSS_METR_GLOB_GAUGE_DB_CACHE_ENTRY,
     _HSS_METR_GLOB_MAX,
 } hss_metric_type_global_t;
 extern ogs_metrics_inst_t *hss_metrics_inst_global[_HSS_METR_GLOB_MAX];
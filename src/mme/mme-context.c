@@ -3021,6 +3021,8 @@ mme_enb_t *mme_enb_add(ogs_sock_t *sock, ogs_sockaddr_t *addr)
     enb->ostream_id = 0;
 
     ogs_list_init(&enb->enb_ue_list);
+    enb->enb_ue_hash = ogs_hash_make();
+    ogs_assert(enb->enb_ue_hash);
 
     ogs_hash_set(self.enb_addr_hash,
             enb->sctp.addr, sizeof(ogs_sockaddr_t), enb);
@@ -3065,6 +3067,8 @@ int mme_enb_remove(mme_enb_t *enb)
 
     ogs_sctp_flush_and_destroy(&enb->sctp);
 
+    ogs_hash_destroy(enb->enb_ue_hash);
+
     ogs_pool_id_free(&mme_enb_pool, enb);
     mme_metrics_inst_global_dec(MME_METR_GLOB_GAUGE_ENB);
     ogs_info("[Removed] Number of eNBs is now %d",
@@ -3132,6 +3136,66 @@ mme_enb_t *mme_enb_find_by_id(ogs_pool_id_t id)
     return ogs_pool_find_by_id(&mme_enb_pool, id);
 }
 
+/*
+ * eNB-UE-S1AP-ID is only unique within an eNB, so each eNB keeps
+ * its own index. If two enb_ue's end up with the same ID
+ * (e.g. after Path Switch or Handover), the one added first stays
+ * in the hash and is returned by the lookup, as the list scan did.
+ */
+static void enb_ue_hash_add(mme_enb_t *enb, enb_ue_t *enb_ue)
+{
+    ogs_assert(enb);
+    ogs_assert(enb_ue);
+
+    if (enb_ue->enb_ue_s1ap_id == INVALID_UE_S1AP_ID)
+        return;
+
+    if (ogs_hash_get(enb->enb_ue_hash,
+                &enb_ue->enb_ue_s1ap_id, sizeof(enb_ue->enb_ue_s1ap_id))) {
+        enb_ue->dup_enb_ue_s1ap_id = true;
+        enb->num_of_dup_enb_ue++;
+        return;
+    }
+
+    ogs_hash_set(enb->enb_ue_hash,
+            &enb_ue->enb_ue_s1ap_id, sizeof(enb_ue->enb_ue_s1ap_id), enb_ue);
+}
+
+static void enb_ue_hash_remove(mme_enb_t *enb, enb_ue_t *enb_ue)
+{
+    enb_ue_t *iter = NULL;
+
+    ogs_assert(enb);
+    ogs_assert(enb_ue);
+
+    if (enb_ue->enb_ue_s1ap_id == INVALID_UE_S1AP_ID)
+        return;
+
+    if (enb_ue->dup_enb_ue_s1ap_id == true) {
+        enb_ue->dup_enb_ue_s1ap_id = false;
+        enb->num_of_dup_enb_ue--;
+        return;
+    }
+
+    ogs_hash_set(enb->enb_ue_hash,
+            &enb_ue->enb_ue_s1ap_id, sizeof(enb_ue->enb_ue_s1ap_id), NULL);
+
+    if (!enb->num_of_dup_enb_ue)
+        return;
+
+    /* Hand the key over to the next enb_ue with the same ID */
+    ogs_list_for_each(&enb->enb_ue_list, iter) {
+        if (iter != enb_ue && iter->dup_enb_ue_s1ap_id == true &&
+            iter->enb_ue_s1ap_id == enb_ue->enb_ue_s1ap_id) {
+            iter->dup_enb_ue_s1ap_id = false;
+            enb->num_of_dup_enb_ue--;
+            ogs_hash_set(enb->enb_ue_hash,
+                    &iter->enb_ue_s1ap_id, sizeof(iter->enb_ue_s1ap_id), iter);
+            break;
+        }
+    }
+}
+
 /** enb_ue_context handling function */
 enb_ue_t *enb_ue_add(mme_enb_t *enb, uint32_t enb_ue_s1ap_id)
 {
@@ -3173,6 +3237,7 @@ enb_ue_t *enb_ue_add(mme_enb_t *enb, uint32_t enb_ue_s1ap_id)
     enb_ue->enb_id = enb->id;
 
     ogs_list_add(&enb->enb_ue_list, enb_ue);
+    enb_ue_hash_add(enb, enb_ue);
 
     stats_add_enb_ue();
 
@@ -3187,7 +3252,10 @@ void enb_ue_remove(enb_ue_t *enb_ue)
 
     enb = mme_enb_find_by_id(enb_ue->enb_id);
 
-    if (enb) ogs_list_remove(&enb->enb_ue_list, enb_ue);
+    if (enb) {
+        enb_ue_hash_remove(enb, enb_ue);
+        ogs_list_remove(&enb->enb_ue_list, enb_ue);
+    }
 
     ogs_assert(enb_ue->t_s1_holding);
     ogs_timer_delete(enb_ue->t_s1_holding);
@@ -3206,26 +3274,38 @@ void enb_ue_switch_to_enb(enb_ue_t *enb_ue, mme_enb_t *new_enb)
     enb = mme_enb_find_by_id(enb_ue->enb_id);
 
     /* Remove from the old enb */
+    enb_ue_hash_remove(enb, enb_ue);
     ogs_list_remove(&enb->enb_ue_list, enb_ue);
 
     /* Add to the new enb */
     ogs_list_add(&new_enb->enb_ue_list, enb_ue);
+    enb_ue_hash_add(new_enb, enb_ue);
 
     /* Switch to enb */
     enb_ue->enb_id = new_enb->id;
 }
 
+void enb_ue_set_enb_ue_s1ap_id(enb_ue_t *enb_ue, uint32_t enb_ue_s1ap_id)
+{
+    mme_enb_t *enb = NULL;
+
+    ogs_assert(enb_ue);
+
+    enb = mme_enb_find_by_id(enb_ue->enb_id);
+    ogs_assert(enb);
+
+    enb_ue_hash_remove(enb, enb_ue);
+    enb_ue->enb_ue_s1ap_id = enb_ue_s1ap_id;
+    enb_ue_hash_add(enb, enb_ue);
+}
+
 enb_ue_t *enb_ue_find_by_enb_ue_s1ap_id(
         const mme_enb_t *enb, uint32_t enb_ue_s1ap_id)
 {
-    enb_ue_t *enb_ue = NULL;
-
-    ogs_list_for_each(&enb->enb_ue_list, enb_ue) {
-        if (enb_ue_s1ap_id == enb_ue->enb_ue_s1ap_id)
-            break;
-    }
+    ogs_assert(enb);
 
-    return enb_ue;
+    return (enb_ue_t *)ogs_hash_get(enb->enb_ue_hash,
+            &enb_ue_s1ap_id, sizeof(enb_ue_s1ap_id));
 }
 
 enb_ue_t *enb_ue_find(uint32_t index)
@@ -264,6 +264,8 @@ typedef struct mme_enb_s {
     ogs_pkbuf_t     *s1_reset_ack; /* Reset message */
 
     ogs_list_t      enb_ue_list;
+    ogs_hash_t      *enb_ue_hash;   /* hash table for eNB-UE-S1AP-ID */
+    int             num_of_dup_enb_ue; /* enb_ue not in enb_ue_hash */
 
 } mme_enb_t;
 
@@ -276,6 +278,7 @@ struct enb_ue_s {
 #define INVALID_UE_S1AP_ID      0xffffffff /* Initial value of enb_ue_s1ap_id */
     uint32_t        enb_ue_s1ap_id; /* eNB-UE-S1AP-ID received from eNB */
     uint32_t        mme_ue_s1ap_id; /* MME-UE-S1AP-ID received from MME */
+    bool            dup_enb_ue_s1ap_id; /* Another enb_ue owns the hash key */
 
     uint16_t        enb_ostream_id; /* SCTP output stream id for eNB */
 
@@ -588,6 +591,9 @@ struct mme_ue_s {
      * #define NAS_SECURITY_ALGORITHMS_128_EIA1    2
      * #define NAS_SECURITY_ALGORITHMS_128_EIA3    3 */
     uint8_t         selected_int_algorithm;
+    /* Key schedules of the selected algorithms, kept across NAS messages */
+    ogs_nas_cipher_ctx_t nas_enc_ctx;
+    ogs_nas_cipher_ctx_t nas_int_ctx;
 
     /* HSS Info */
     ogs_bitrate_t   ambr; /* UE-AMBR */
@@ -1069,6 +1075,7 @@ mme_enb_t *mme_enb_find_by_id(ogs_pool_id_t id);
 enb_ue_t *enb_ue_add(mme_enb_t *enb, uint32_t enb_ue_s1ap_id);
 void enb_ue_remove(enb_ue_t *enb_ue);
 void enb_ue_switch_to_enb(enb_ue_t *enb_ue, mme_enb_t *new_enb);
+void enb_ue_set_enb_ue_s1ap_id(enb_ue_t *enb_ue, uint32_t enb_ue_s1ap_id);
 enb_ue_t *enb_ue_find_by_enb_ue_s1ap_id(
         const mme_enb_t *enb, uint32_t enb_ue_s1ap_id);
 enb_ue_t *enb_ue_find(uint32_t index);
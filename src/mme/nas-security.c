@@ -82,7 +82,8 @@ ogs_pkbuf_t *nas_eps_security_encode(
 
     if (ciphered) {
         /* encrypt NAS message */
-        ogs_nas_encrypt(mme_ue->selected_enc_algorithm,
+        ogs_nas_encrypt_ctx(&mme_ue->nas_enc_ctx,
+            mme_ue->selected_enc_algorithm,
             mme_ue->knas_enc, mme_ue->dl_count, NAS_SECURITY_BEARER,
             OGS_NAS_SECURITY_DOWNLINK_DIRECTION, new);
     }
@@ -95,7 +96,8 @@ ogs_pkbuf_t *nas_eps_security_encode(
         uint8_t mac[NAS_SECURITY_MAC_SIZE];
 
         /* calculate NAS MAC(message authentication code) */
-        ogs_nas_mac_calculate(mme_ue->selected_int_algorithm,
+        ogs_nas_mac_calculate_ctx(&mme_ue->nas_int_ctx,
+            mme_ue->selected_int_algorithm,
             mme_ue->knas_int, mme_ue->dl_count, NAS_SECURITY_BEARER, 
             OGS_NAS_SECURITY_DOWNLINK_DIRECTION, new, mac);
         memcpy(&h.message_authentication_code, mac, sizeof(mac));
@@ -151,7 +153,8 @@ int nas_eps_security_decode(mme_ue_t *mme_ue,
         memcpy(original_mac, pkbuf->data + 2, SHORT_MAC_SIZE);
 
         ogs_pkbuf_trim(pkbuf, 2);
-        ogs_nas_mac_calculate(mme_ue->selected_int_algorithm,
+        ogs_nas_mac_calculate_ctx(&mme_ue->nas_int_ctx,
+            mme_ue->selected_int_algorithm,
             mme_ue->knas_int, mme_ue->ul_count.i32, NAS_SECURITY_BEARER,
             OGS_NAS_SECURITY_UPLINK_DIRECTION, pkbuf, mac);
 
@@ -205,7 +208,8 @@ int nas_eps_security_decode(mme_ue_t *mme_ue,
             uint32_t original_mac = h->message_authentication_code;
 
             /* calculate NAS MAC(message authentication code) */
-            ogs_nas_mac_calculate(mme_ue->selected_int_algorithm,
+            ogs_nas_mac_calculate_ctx(&mme_ue->nas_int_ctx,
+                mme_ue->selected_int_algorithm,
                 mme_ue->knas_int, mme_ue->ul_count.i32, NAS_SECURITY_BEARER, 
                 OGS_NAS_SECURITY_UPLINK_DIRECTION, pkbuf, mac);
             h->message_authentication_code = original_mac;
@@ -227,7 +231,8 @@ int nas_eps_security_decode(mme_ue_t *mme_ue,
                 ogs_error("Cannot decrypt Malformed NAS Message");
                 return OGS_ERROR;
             }
-            ogs_nas_encrypt(mme_ue->selected_enc_algorithm,
+            ogs_nas_encrypt_ctx(&mme_ue->nas_enc_ctx,
+                mme_ue->selected_enc_algorithm,
                 mme_ue->knas_enc, mme_ue->ul_count.i32, NAS_SECURITY_BEARER,
                 OGS_NAS_SECURITY_UPLINK_DIRECTION, pkbuf);
         }
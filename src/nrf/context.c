@@ -42,6 +42,9 @@ void nrf_context_init(void)
     max_num_of_nrf_assoc = ogs_global_conf()->max.ue * MAX_NUM_OF_NRF_ASSOC;
     ogs_pool_init(&nrf_assoc_pool, max_num_of_nrf_assoc);
 
+    self.discovery_cache = ogs_hash_make();
+    ogs_assert(self.discovery_cache);
+
     context_initialized = 1;
 }
 
@@ -63,6 +66,9 @@ void nrf_context_final(void)
 
     ogs_pool_final(&nrf_assoc_pool);
 
+    nrf_discovery_cache_remove_all();
+    ogs_hash_destroy(self.discovery_cache);
+
     context_initialized = 0;
 }
 
@@ -171,3 +177,135 @@ void nrf_assoc_remove_all(void)
     ogs_list_for_each_safe(&self.assoc_list, next_assoc, assoc)
         nrf_assoc_remove(assoc);
 }
+
+/*
+ * The NF-Discover response only depends on the query and on the NF
+ * instances of the target NF-Type. So a serialized SearchResult is
+ * kept per query and stamped with the generation of the target NF-Type,
+ * which is bumped whenever such an NF instance is registered, updated
+ * or de-registered.
+ */
+static int discovery_cache_key_compare(const void *a, const void *b)
+{
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+char *nrf_discovery_cache_key(ogs_sbi_request_t *request)
+{
+    ogs_hash_index_t *hi = NULL;
+    const char **keys = NULL;
+    char *key = NULL;
+    int i, num_of_key = 0;
+
+    ogs_assert(request);
+    ogs_assert(request->h.uri);
+
+    key = ogs_strdup(request->h.uri);
+    ogs_assert(key);
+
+    num_of_key = ogs_hash_count(request->http.params);
+    if (!num_of_key)
+        return key;
+
+    keys = ogs_calloc(num_of_key, sizeof(*keys));
+    ogs_assert(keys);
+
+    i = 0;
+    for (hi = ogs_hash_first(request->http.params);
+            hi && i < num_of_key; hi = ogs_hash_next(hi))
+        keys[i++] = ogs_hash_this_key(hi);
+
+    /* The same query can come with its parameters in any order */
+    qsort(keys, i, sizeof(*keys), discovery_cache_key_compare);
+
+    for (num_of_key = i, i = 0; i < num_of_key; i++)
+        key = ogs_mstrcatf(key, "%c%s=%s", i ? '&' : '?', keys[i],
+                (char *)ogs_hash_get(request->http.params,
+                    keys[i], OGS_HASH_KEY_STRING));
+
+    ogs_free(keys);
+
+    return key;
+}
+
+static void discovery_cache_remove(nrf_discovery_cache_t *cache)
+{
+    ogs_assert(cache);
+
+    ogs_hash_set(self.discovery_cache, cache->key, OGS_HASH_KEY_STRING, NULL);
+
+    ogs_free(cache->key);
+    ogs_free(cache->content);
+    ogs_free(cache);
+}
+
+nrf_discovery_cache_t *nrf_discovery_cache_find(
+        char *key, OpenAPI_nf_type_e target_nf_type)
+{
+    nrf_discovery_cache_t *cache = NULL;
+
+    ogs_assert(key);
+    ogs_assert(target_nf_type > OpenAPI_nf_type_NULL &&
+            target_nf_type < OGS_SBI_MAX_NUM_OF_NF_TYPE);
+
+    cache = ogs_hash_get(self.discovery_cache, key, OGS_HASH_KEY_STRING);
+    if (!cache)
+        return NULL;
+
+    if (cache->target_nf_type != target_nf_type ||
+        cache->generation != self.nf_type_generation[target_nf_type]) {
+        discovery_cache_remove(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+void nrf_discovery_cache_add(char *key, OpenAPI_nf_type_e target_nf_type,
+        char *content, int validity_period)
+{
+    nrf_discovery_cache_t *cache = NULL;
+
+    ogs_assert(key);
+    ogs_assert(content);
+    ogs_assert(target_nf_type > OpenAPI_nf_type_NULL &&
+            target_nf_type < OGS_SBI_MAX_NUM_OF_NF_TYPE);
+
+    cache = ogs_hash_get(self.discovery_cache, key, OGS_HASH_KEY_STRING);
+    if (cache)
+        discovery_cache_remove(cache);
+
+    /* Stale entries are only dropped when looked up, so keep it bounded */
+    if (ogs_hash_count(self.discovery_cache) >= ogs_app()->pool.nf)
+        nrf_discovery_cache_remove_all();
+
+    cache = ogs_calloc(1, sizeof(*cache));
+    ogs_assert(cache);
+
+    cache->key = ogs_strdup(key);
+    ogs_assert(cache->key);
+    cache->content = ogs_strdup(content);
+    ogs_assert(cache->content);
+
+    cache->target_nf_type = target_nf_type;
+    cache->generation = self.nf_type_generation[target_nf_type];
+    cache->validity_period = validity_period;
+
+    ogs_hash_set(self.discovery_cache, cache->key, OGS_HASH_KEY_STRING, cache);
+}
+
+void nrf_discovery_cache_invalidate(OpenAPI_nf_type_e nf_type)
+{
+    if (nf_type > OpenAPI_nf_type_NULL &&
+        nf_type < OGS_SBI_MAX_NUM_OF_NF_TYPE)
+        self.nf_type_generation[nf_type]++;
+}
+
+void nrf_discovery_cache_remove_all(void)
+{
+    ogs_hash_index_t *hi = NULL;
+
+    for (hi = ogs_hash_first(self.discovery_cache);
+            hi; hi = ogs_hash_next(hi))
+        discovery_cache_remove(ogs_hash_this_val(hi));
+}
@@ -37,6 +37,10 @@ extern int __nrf_log_domain;
 
 typedef struct nrf_context_s {
     ogs_list_t assoc_list;
+
+    /* NF-Discover responses by query, see nrf_discovery_cache_find() */
+    ogs_hash_t *discovery_cache;
+    uint64_t nf_type_generation[OGS_SBI_MAX_NUM_OF_NF_TYPE];
 } nrf_context_t;
 
 typedef struct nrf_assoc_s nrf_assoc_t;
@@ -57,6 +61,24 @@ nrf_assoc_t *nrf_assoc_add(ogs_sbi_stream_t *stream);
 void nrf_assoc_remove(nrf_assoc_t *assoc);
 void nrf_assoc_remove_all(void);
 
+typedef struct nrf_discovery_cache_s {
+    char *key;                  /* URI and sorted query parameters */
+
+    OpenAPI_nf_type_e target_nf_type;
+    uint64_t generation;        /* nf_type_generation[target_nf_type] */
+
+    char *content;              /* Serialized SearchResult */
+    int validity_period;
+} nrf_discovery_cache_t;
+
+char *nrf_discovery_cache_key(ogs_sbi_request_t *request);
+nrf_discovery_cache_t *nrf_discovery_cache_find(
+        char *key, OpenAPI_nf_type_e target_nf_type);
+void nrf_discovery_cache_add(char *key, OpenAPI_nf_type_e target_nf_type,
+        char *content, int validity_period);
+void nrf_discovery_cache_invalidate(OpenAPI_nf_type_e nf_type);
+void nrf_discovery_cache_remove_all(void);
+
 #ifdef __cplusplus
 }
 #endif
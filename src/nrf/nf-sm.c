@@ -222,6 +222,8 @@ void nrf_nf_state_registered(ogs_fsm_t *s, nrf_event_t *e)
             ogs_timer_stop(nf_instance->t_no_heartbeat);
         }
 
+        nrf_discovery_cache_invalidate(nf_instance->nf_type);
+
         ogs_assert(true ==
             nrf_nnrf_nfm_send_nf_status_notify_all(
                 OpenAPI_notification_event_type_NF_DEREGISTERED, nf_instance));
@@ -41,6 +41,7 @@ bool nrf_nnrf_handle_nf_register(ogs_sbi_nf_instance_t *nf_instance,
     ogs_sbi_response_t *response = NULL;
 
     OpenAPI_nf_profile_t *NFProfile = NULL;
+    OpenAPI_nf_type_e old_nf_type = OpenAPI_nf_type_NULL;
 
     OpenAPI_lnode_t *node = NULL;
     bool plmn_valid = false;
@@ -121,8 +122,13 @@ bool nrf_nnrf_handle_nf_register(ogs_sbi_nf_instance_t *nf_instance,
         }
     }
 
+    old_nf_type = nf_instance->nf_type;
+
     ogs_nnrf_nfm_handle_nf_profile(nf_instance, NFProfile);
 
+    nrf_discovery_cache_invalidate(old_nf_type);
+    nrf_discovery_cache_invalidate(nf_instance->nf_type);
+
     ogs_sbi_client_associate(nf_instance);
 
     switch (nf_instance->nf_type) {
@@ -317,6 +323,8 @@ bool nrf_nnrf_handle_nf_update(ogs_sbi_nf_instance_t *nf_instance,
                             sizeof(nf_instance->plmn_id));
                     nf_instance->num_of_plmn_id = 0;
 
+                    nrf_discovery_cache_invalidate(nf_instance->nf_type);
+
                     /* Iterate through the JSON array of PLMN IDs */
                     cJSON_ArrayForEach(plmn_item, plmn_array) {
                         OpenAPI_plmn_id_t plmn_id;
@@ -938,20 +946,25 @@ bool nrf_nnrf_handle_nf_profile_retrieval(
     return true;
 }
 
-bool nrf_nnrf_handle_nf_discover(
-        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+bool nrf_nnrf_handle_nf_discover(ogs_sbi_stream_t *stream,
+        ogs_sbi_request_t *request, ogs_sbi_message_t *recvmsg)
 {
     ogs_sbi_message_t sendmsg;
     ogs_sbi_response_t *response = NULL;
     ogs_sbi_nf_instance_t *nf_instance = NULL;
+    ogs_sbi_nf_type_node_t *type_node = NULL;
     ogs_sbi_discovery_option_t *discovery_option = NULL;
 
+    nrf_discovery_cache_t *cache = NULL;
+    char *cache_key = NULL;
+
     OpenAPI_search_result_t *SearchResult = NULL;
     OpenAPI_nf_profile_t *NFProfile = NULL;
     OpenAPI_lnode_t *node = NULL;
     int i;
 
     ogs_assert(stream);
+    ogs_assert(request);
     ogs_assert(recvmsg);
 
     if (!recvmsg->param.target_nf_type) {
@@ -1037,6 +1050,38 @@ bool nrf_nnrf_handle_nf_discover(
         }
     }
 
+    cache_key = nrf_discovery_cache_key(request);
+    ogs_assert(cache_key);
+
+    cache = nrf_discovery_cache_find(
+            cache_key, recvmsg->param.target_nf_type);
+    if (cache) {
+        ogs_debug("NF-Discover : SearchResult from cache [%s]", cache_key);
+
+        response = ogs_sbi_response_new();
+        ogs_assert(response);
+
+        response->status = OGS_SBI_HTTP_STATUS_OK;
+        response->http.content = ogs_strdup(cache->content);
+        ogs_assert(response->http.content);
+        response->http.content_length = strlen(response->http.content);
+        ogs_sbi_header_set(response->http.headers,
+                OGS_SBI_CONTENT_TYPE, OGS_SBI_CONTENT_JSON_TYPE);
+
+        memset(&sendmsg, 0, sizeof(sendmsg));
+        sendmsg.http.cache_control =
+            ogs_msprintf("max-age=%d", cache->validity_period);
+        ogs_assert(sendmsg.http.cache_control);
+        ogs_sbi_header_set(response->http.headers,
+                "Cache-Control", sendmsg.http.cache_control);
+        ogs_free(sendmsg.http.cache_control);
+
+        ogs_assert(true == ogs_sbi_server_send_response(stream, response));
+
+        ogs_free(cache_key);
+        return true;
+    }
+
     SearchResult = ogs_calloc(1, sizeof(*SearchResult));
     ogs_assert(SearchResult);
 
@@ -1044,13 +1089,11 @@ bool nrf_nnrf_handle_nf_discover(
     ogs_assert(SearchResult->nf_instances);
 
     i = 0;
-    ogs_list_for_each(&ogs_sbi_self()->nf_instance_list, nf_instance) {
+    ogs_sbi_nf_instance_for_each_by_type(
+            recvmsg->param.target_nf_type, type_node, nf_instance) {
         if (NF_INSTANCE_EXCLUDED_FROM_DISCOVERY(nf_instance))
             continue;
 
-        if (nf_instance->nf_type != recvmsg->param.target_nf_type)
-            continue;
-
         if (ogs_sbi_nf_instance_is_allowed_nf_type(
                 nf_instance, recvmsg->param.requester_nf_type) == false)
             continue;
@@ -1109,6 +1152,12 @@ bool nrf_nnrf_handle_nf_discover(
 
         response = ogs_sbi_build_response(&sendmsg, OGS_SBI_HTTP_STATUS_OK);
         ogs_assert(response);
+
+        if (response->http.content)
+            nrf_discovery_cache_add(
+                    cache_key, recvmsg->param.target_nf_type,
+                    response->http.content, SearchResult->validity_period);
+
         ogs_assert(true == ogs_sbi_server_send_response(stream, response));
 
         goto cleanup;
@@ -1126,13 +1175,11 @@ bool nrf_nnrf_handle_nf_discover(
 
         nrf_assoc_t *assoc = NULL;
 
-        ogs_list_for_each(&ogs_sbi_self()->nf_instance_list, nf_instance) {
+        ogs_sbi_nf_instance_for_each_by_type(
+                OpenAPI_nf_type_NRF, type_node, nf_instance) {
             if (NF_INSTANCE_ID_IS_SELF(nf_instance->id))
                 continue;
 
-            if (nf_instance->nf_type != OpenAPI_nf_type_NRF)
-                continue;
-
             if (ogs_sbi_discovery_option_target_plmn_list_is_matched(
                         nf_instance, discovery_option) == false)
                 continue;
@@ -1304,6 +1351,7 @@ cleanup:
         ogs_free(sendmsg.http.cache_control);
 
     ogs_free(SearchResult);
+    ogs_free(cache_key);
 
     return true;
 }
@@ -1425,8 +1473,12 @@ static void handle_nf_discover_search_result(
         }
 
         if (NF_INSTANCE_ID_IS_OTHERS(nf_instance->id)) {
+            nrf_discovery_cache_invalidate(nf_instance->nf_type);
+
             ogs_nnrf_nfm_handle_nf_profile(nf_instance, NFProfile);
 
+            nrf_discovery_cache_invalidate(nf_instance->nf_type);
+
             ogs_sbi_client_associate(nf_instance);
 
             switch (nf_instance->nf_type) {
@@ -44,8 +44,8 @@ bool nrf_nnrf_handle_nf_list_retrieval(
 bool nrf_nnrf_handle_nf_profile_retrieval(
         ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg);
 
-bool nrf_nnrf_handle_nf_discover(
-        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg);
+bool nrf_nnrf_handle_nf_discover(ogs_sbi_stream_t *stream,
+        ogs_sbi_request_t *request, ogs_sbi_message_t *recvmsg);
 
 #ifdef __cplusplus
 }
@@ -240,7 +240,8 @@ void nrf_state_operational(ogs_fsm_t *s, nrf_event_t *e)
 
                 SWITCH(message.h.method)
                 CASE(OGS_SBI_HTTP_METHOD_GET)
-                    nrf_nnrf_handle_nf_discover(stream, &message);
+                    nrf_nnrf_handle_nf_discover(
+                            stream, request, &message);
                     break;
 
                 DEFAULT
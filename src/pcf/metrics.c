@@ -51,7 +51,33 @@ ogs_metrics_spec_t *pcf_metrics_spec_global[_PCF_METR_GLOB_MAX];
 ogs_metrics_inst_t *pcf_metrics_inst_global[_PCF_METR_GLOB_MAX];
 pcf_metrics_spec_def_t pcf_metrics_spec_def_global[_PCF_METR_GLOB_MAX] = {
 /* Global Counters: */
+/* Global Counters: Subscriber cache */
+[PCF_METR_GLOB_CTR_DB_CACHE_HIT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_hit",
+    .description = "Subscription data found in the subscriber cache",
+},
+[PCF_METR_GLOB_CTR_DB_CACHE_MISS] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_miss",
+    .description = "Subscription data read from the DB",
+},
+[PCF_METR_GLOB_CTR_DB_CACHE_EVICTION] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_eviction",
+    .description = "Subscriber cache entries evicted when full",
+},
+[PCF_METR_GLOB_CTR_DB_CACHE_INVALIDATION] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_invalidation",
+    .description = "Subscriber cache entries invalidated by DB changes",
+},
 /* Global Gauges: */
+[PCF_METR_GLOB_GAUGE_DB_CACHE_ENTRY] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "db_cache_entry",
+    .description = "Number of entries in the subscriber cache",
+},
 };
 int pcf_metrics_init_inst_global(void)
 {
@@ -63,6 +89,35 @@ int pcf_metrics_free_inst_global(void)
     return pcf_metrics_free_inst(pcf_metrics_inst_global, _PCF_METR_GLOB_MAX);
 }
 
+/* Counters already published from ogs_dbi_cache_stat() */
+static ogs_dbi_cache_stat_t db_cache_published;
+
+static void db_cache_publish(pcf_metric_type_global_t t,
+        uint64_t *published, uint64_t total)
+{
+    pcf_metrics_inst_global_add(t, (int)(total - *published));
+    *published = total;
+}
+
+static void pcf_metrics_db_cache_collect(void)
+{
+    ogs_dbi_cache_stat_t stat;
+
+    ogs_dbi_cache_stat(&stat);
+
+    db_cache_publish(PCF_METR_GLOB_CTR_DB_CACHE_HIT,
+            &db_cache_published.hit, stat.hit);
+    db_cache_publish(PCF_METR_GLOB_CTR_DB_CACHE_MISS,
+            &db_cache_published.miss, stat.miss);
+    db_cache_publish(PCF_METR_GLOB_CTR_DB_CACHE_EVICTION,
+            &db_cache_published.eviction, stat.eviction);
+    db_cache_publish(PCF_METR_GLOB_CTR_DB_CACHE_INVALIDATION,
+            &db_cache_published.invalidation, stat.invalidation);
+
+    pcf_metrics_inst_global_set(PCF_METR_GLOB_GAUGE_DB_CACHE_ENTRY,
+            stat.count);
+}
+
 /* BY_SLICE */
 const char *labels_slice[] = {
     "plmnid",
@@ -198,6 +253,9 @@ void pcf_metrics_init(void)
 
     pcf_metrics_init_inst_global();
     pcf_metrics_init_by_slice();
+
+    memset(&db_cache_published, 0, sizeof(db_cache_published));
+    ogs_metrics_register_collector(pcf_metrics_db_cache_collect);
 }
 
 void pcf_metrics_final(void)
@@ -220,5 +278,6 @@ void pcf_metrics_final(void)
         ogs_hash_destroy(metrics_hash_by_slice);
     }
 
+    ogs_metrics_register_collector(NULL);
     ogs_metrics_context_final();
 }
@@ -8,6 +8,12 @@ extern "C" {
 #endif
 
 typedef enum pcf_metric_type_global_s {
+    PCF_METR_GLOB_CTR_DB_CACHE_HIT = 0,
+    PCF_METR_GLOB_CTR_DB_CACHE_MISS,
+    PCF_METR_GLOB_CTR_DB_CACHE_EVICTION,
+    PCF_METR_GLOB_CTR_DB_CACHE_INVALIDATION,
+
+    PCF_METR_GLOB_GAUGE_DB_CACHE_ENTRY,
     _PCF_METR_GLOB_MAX,
 } pcf_metric_type_global_t;
 extern ogs_metrics_inst_t *pcf_metrics_inst_global[_PCF_METR_GLOB_MAX];
@@ -485,6 +485,41 @@ static int request_handler(ogs_sbi_request_t *request, void *data)
      *******************************/
     if (discovery_presence == true) {
 
+        /*
+         * NF instances found by an earlier NF-Discover are kept until
+         * their validity expires, so the NRF is only asked once
+         * for requests with the same discovery parameters.
+         */
+        nf_instance = ogs_sbi_nf_instance_find_by_discovery_param(
+                target_nf_type, requester_nf_type, discovery_option);
+        if (nf_instance) {
+            client = ogs_sbi_client_find_by_service_type(
+                    nf_instance, service_type);
+
+            /* A producer in the visited network goes through discovery */
+            if (client && client->fqdn &&
+                ogs_sbi_fqdn_in_vplmn(client->fqdn) == true)
+                client = NULL;
+        }
+
+        if (client) {
+            ogs_sbi_self()->discover_stats.hit++;
+
+            /* Store NF Service Producer */
+            assoc->nf_service_producer = nf_instance;
+            ogs_assert(assoc->nf_service_producer);
+
+            if (false == send_request(
+                        client, response_handler, request, false, assoc)) {
+                ogs_error("send_request() failed");
+
+                scp_assoc_remove(assoc);
+                return OGS_ERROR;
+            }
+
+            return OGS_OK;
+        }
+
         if (headers.nrf_uri) {
             char *key = NULL;
             char *nnrf_disc = NULL;
@@ -626,6 +661,8 @@ static int request_handler(ogs_sbi_request_t *request, void *data)
         assoc->requester_nf_type = requester_nf_type;
         ogs_assert(assoc->requester_nf_type);
 
+        ogs_sbi_self()->discover_stats.miss++;
+
         if (false == send_discover(nrf_client, nf_discover_handler, assoc)) {
             ogs_error("send_discover() failed");
             scp_assoc_remove(assoc);
@@ -1066,6 +1103,9 @@ static void copy_request(
     target->http.content = source->http.content;
     target->http.content_length = source->http.content_length;
 
+    /* The content is relayed without being copied */
+    target->content_of = source;
+
     /* HTTP Headers
      *
      * To remove the followings,
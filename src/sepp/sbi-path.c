@@ -477,6 +477,9 @@ static void copy_request(
     target->http.content = source->http.content;
     target->http.content_length = source->http.content_length;
 
+    /* The content is relayed without being copied */
+    target->content_of = source;
+
     /* HTTP Headers
      *
      * To remove the followings,
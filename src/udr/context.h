@@ -25,6 +25,7 @@
 #include "ogs-sbi.h"
 
 #include "udr-sm.h"
+#include "metrics.h"
 
 #ifdef __cplusplus
 extern "C" {
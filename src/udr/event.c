@@ -49,6 +49,8 @@ const char *udr_event_get_name(udr_event_t *e)
         return OGS_EVENT_NAME_SBI_CLIENT;
     case OGS_EVENT_SBI_TIMER:
         return OGS_EVENT_NAME_SBI_TIMER;
+    case OGS_EVENT_DBI:
+        return OGS_EVENT_NAME_DBI;
 
     default:
         break;
@@ -31,6 +31,8 @@ int udr_initialize(void)
     rv = ogs_app_parse_local_conf(APP_NAME);
     if (rv != OGS_OK) return rv;
 
+    udr_metrics_init();
+
     ogs_sbi_context_init(OpenAPI_nf_type_UDR);
     udr_context_init();
 
@@ -41,12 +43,21 @@ int udr_initialize(void)
     rv = ogs_sbi_context_parse_config(APP_NAME, "nrf", "scp");
     if (rv != OGS_OK) return rv;
 
+    rv = ogs_metrics_context_parse_config(APP_NAME);
+    if (rv != OGS_OK) return rv;
+
     rv = udr_context_parse_config();
     if (rv != OGS_OK) return rv;
 
+    ogs_metrics_context_open(ogs_metrics_self());
+
     rv = ogs_dbi_init(ogs_app()->db_uri);
     if (rv != OGS_OK) return rv;
 
+    rv = ogs_dbi_async_init(OGS_DBI_DEFAULT_NUM_OF_THREAD,
+            ogs_app()->queue, ogs_app()->pollset);
+    if (rv != OGS_OK) return rv;
+
     rv = udr_sbi_open();
     if (rv != OGS_OK) return rv;
 
@@ -93,10 +104,15 @@ void udr_terminate(void)
 
     udr_sbi_close();
 
+    ogs_metrics_context_close(ogs_metrics_self());
+
+    ogs_dbi_async_final();
     ogs_dbi_final();
 
     udr_context_final();
     ogs_sbi_context_final();
+
+    udr_metrics_final();
 }
 
 static void udr_main(void *data)
@@ -0,0 +1,139 @@
+#include "ogs-app.h"
+#include "context.h"
+
+#include "metrics.h"
+
+typedef struct udr_metrics_spec_def_s {
+    unsigned int type;
+    const char *name;
+    const char *description;
+    int initial_val;
+    unsigned int num_labels;
+    const char **labels;
+} udr_metrics_spec_def_t;
+
+/* Helper generic functions: */
+static int udr_metrics_init_inst(ogs_metrics_inst_t **inst,
+        ogs_metrics_spec_t **specs, unsigned int len,
+        unsigned int num_labels, const char **labels)
+{
+    unsigned int i;
+    for (i = 0; i < len; i++)
+        inst[i] = ogs_metrics_inst_new(specs[i], num_labels, labels);
+    return OGS_OK;
+}
+
+static int udr_metrics_free_inst(ogs_metrics_inst_t **inst,
+        unsigned int len)
+{
+    unsigned int i;
+    for (i = 0; i < len; i++)
+        ogs_metrics_inst_free(inst[i]);
+    memset(inst, 0, sizeof(inst[0]) * len);
+    return OGS_OK;
+}
+
+static int udr_metrics_init_spec(ogs_metrics_context_t *ctx,
+        ogs_metrics_spec_t **dst, udr_metrics_spec_def_t *src, unsigned int len)
+{
+    unsigned int i;
+    for (i = 0; i < len; i++) {
+        dst[i] = ogs_metrics_spec_new(ctx, src[i].type,
+                src[i].name, src[i].description,
+                src[i].initial_val, src[i].num_labels, src[i].labels,
+                NULL);
+    }
+    return OGS_OK;
+}
+
+/* GLOBAL */
+ogs_metrics_spec_t *udr_metrics_spec_global[_UDR_METR_GLOB_MAX];
+ogs_metrics_inst_t *udr_metrics_inst_global[_UDR_METR_GLOB_MAX];
+udr_metrics_spec_def_t udr_metrics_spec_def_global[_UDR_METR_GLOB_MAX] = {
+/* Global Counters: */
+/* Global Counters: Subscriber cache */
+[UDR_METR_GLOB_CTR_DB_CACHE_HIT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_hit",
+    .description = "Subscription data found in the subscriber cache",
+},
+[UDR_METR_GLOB_CTR_DB_CACHE_MISS] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_miss",
+    .description = "Subscription data read from the DB",
+},
+[UDR_METR_GLOB_CTR_DB_CACHE_EVICTION] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_eviction",
+    .description = "Subscriber cache entries evicted when full",
+},
+[UDR_METR_GLOB_CTR_DB_CACHE_INVALIDATION] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "db_cache_invalidation",
+    .description = "Subscriber cache entries invalidated by DB changes",
+},
+/* Global Gauges: */
+[UDR_METR_GLOB_GAUGE_DB_CACHE_ENTRY] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "db_cache_entry",
+    .description = "Number of entries in the subscriber cache",
+},
+};
+int udr_metrics_init_inst_global(void)
+{
+    return udr_metrics_init_inst(udr_metrics_inst_global,
+            udr_metrics_spec_global, _UDR_METR_GLOB_MAX, 0, NULL);
+}
+int udr_metrics_free_inst_global(void)
+{
+    return udr_metrics_free_inst(udr_metrics_inst_global, _UDR_METR_GLOB_MAX);
+}
+
+/* Counters already published from ogs_dbi_cache_stat() */
+static ogs_dbi_cache_stat_t db_cache_published;
+
+static void db_cache_publish(udr_metric_type_global_t t,
+        uint64_t *published, uint64_t total)
+{
+    udr_metrics_inst_global_add(t, (int)(total - *published));
+    *published = total;
+}
+
+static void udr_metrics_db_cache_collect(void)
+{
+    ogs_dbi_cache_stat_t stat;
+
+    ogs_dbi_cache_stat(&stat);
+
+    db_cache_publish(UDR_METR_GLOB_CTR_DB_CACHE_HIT,
+            &db_cache_published.hit, stat.hit);
+    db_cache_publish(UDR_METR_GLOB_CTR_DB_CACHE_MISS,
+            &db_cache_published.miss, stat.miss);
+    db_cache_publish(UDR_METR_GLOB_CTR_DB_CACHE_EVICTION,
+            &db_cache_published.eviction, stat.eviction);
+    db_cache_publish(UDR_METR_GLOB_CTR_DB_CACHE_INVALIDATION,
+            &db_cache_published.invalidation, stat.invalidation);
+
+    udr_metrics_inst_global_set(UDR_METR_GLOB_GAUGE_DB_CACHE_ENTRY,
+            stat.count);
+}
+
+void udr_metrics_init(void)
+{
+    ogs_metrics_context_t *ctx = ogs_metrics_self();
+    ogs_metrics_context_init();
+
+    udr_metrics_init_spec(ctx, udr_metrics_spec_global,
+            udr_metrics_spec_def_global, _UDR_METR_GLOB_MAX);
+
+    udr_metrics_init_inst_global();
+
+    memset(&db_cache_published, 0, sizeof(db_cache_published));
+    ogs_metrics_register_collector(udr_metrics_db_cache_collect);
+}
+
+void udr_metrics_final(void)
+{
+    ogs_metrics_register_collector(NULL);
+    ogs_metrics_context_final();
+}
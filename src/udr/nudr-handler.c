@@ -20,14 +20,76 @@
 #include "sbi-path.h"
 #include "nudr-handler.h"
 
-bool udr_nudr_dr_handle_subscription_authentication(
-        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+/*
+ * Authentication data is read and written by a DBI thread,
+ * so that a slow query does not hold the other requests.
+ */
+typedef enum {
+    UDR_AUTH_SUBSCRIPTION_GET,
+    UDR_AUTH_SUBSCRIPTION_PATCH,
+    UDR_AUTH_STATUS_UPDATE,
+} udr_auth_job_type_e;
+
+typedef struct udr_auth_job_s {
+    ogs_dbi_job_t h;
+
+    udr_auth_job_type_e type;
+    ogs_pool_id_t stream_id;
+    char supi[OGS_MAX_IMSI_BCD_LEN+sizeof(OGS_ID_SUPI_TYPE_IMSI)+1];
+    uint64_t sqn;
+
+    int status;
+    const char *title;
+    ogs_dbi_auth_info_t auth_info;
+} udr_auth_job_t;
+
+static void auth_job_handler(ogs_dbi_job_t *job)
+{
+    udr_auth_job_t *auth_job = (udr_auth_job_t *)job;
+
+    ogs_assert(auth_job);
+
+    auth_job->status = OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR;
+
+    if (ogs_dbi_auth_info(auth_job->supi, &auth_job->auth_info) != OGS_OK) {
+        auth_job->status = OGS_SBI_HTTP_STATUS_NOT_FOUND;
+        auth_job->title = "Cannot find SUPI Type";
+        return;
+    }
+
+    switch (auth_job->type) {
+    case UDR_AUTH_SUBSCRIPTION_GET:
+        auth_job->status = OGS_SBI_HTTP_STATUS_OK;
+        return;
+
+    case UDR_AUTH_SUBSCRIPTION_PATCH:
+        if (ogs_dbi_update_sqn(auth_job->supi, auth_job->sqn) != OGS_OK) {
+            auth_job->title = "Cannot update SQN";
+            return;
+        }
+        OGS_GNUC_FALLTHROUGH;
+
+    case UDR_AUTH_STATUS_UPDATE:
+        if (ogs_dbi_increment_sqn(auth_job->supi) != OGS_OK) {
+            auth_job->title = "Cannot increment SQN";
+            return;
+        }
+        auth_job->status = OGS_SBI_HTTP_STATUS_NO_CONTENT;
+        return;
+
+    default:
+        ogs_assert_if_reached();
+    }
+}
+
+static void auth_job_complete(ogs_dbi_job_t *job)
 {
-    int rv;
+    udr_auth_job_t *auth_job = (udr_auth_job_t *)job;
+    ogs_dbi_auth_info_t *auth_info = NULL;
 
+    ogs_sbi_stream_t *stream = NULL;
     ogs_sbi_message_t sendmsg;
     ogs_sbi_response_t *response = NULL;
-    ogs_dbi_auth_info_t auth_info;
 
     char k_string[OGS_KEYSTRLEN(OGS_KEY_LEN)];
     char opc_string[OGS_KEYSTRLEN(OGS_KEY_LEN)];
@@ -35,10 +97,108 @@ bool udr_nudr_dr_handle_subscription_authentication(
     char sqn_string[OGS_KEYSTRLEN(OGS_SQN_LEN)];
 
     char sqn[OGS_SQN_LEN];
-    char *supi = NULL;
 
     OpenAPI_authentication_subscription_t AuthenticationSubscription;
     OpenAPI_sequence_number_t SequenceNumber;
+
+    ogs_assert(auth_job);
+
+    stream = ogs_sbi_stream_find_by_id(auth_job->stream_id);
+    if (!stream) {
+        ogs_error("[%s] STREAM has already been removed [%d]",
+                auth_job->supi, auth_job->stream_id);
+        return;
+    }
+
+    if (auth_job->status == OGS_SBI_HTTP_STATUS_NOT_FOUND) {
+        ogs_warn("[%s] Cannot find SUPI in DB", auth_job->supi);
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(stream, auth_job->status,
+                NULL, auth_job->title, auth_job->supi, NULL));
+        return;
+    } else if (auth_job->status == OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR) {
+        ogs_fatal("[%s] %s", auth_job->supi, auth_job->title);
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(stream, auth_job->status,
+                NULL, auth_job->title, auth_job->supi, NULL));
+        return;
+    }
+
+    memset(&sendmsg, 0, sizeof(sendmsg));
+
+    if (auth_job->status == OGS_SBI_HTTP_STATUS_OK) {
+        auth_info = &auth_job->auth_info;
+
+        memset(&AuthenticationSubscription, 0,
+                sizeof(AuthenticationSubscription));
+
+        AuthenticationSubscription.authentication_method =
+            OpenAPI_auth_method_5G_AKA;
+
+        ogs_hex_to_ascii(auth_info->k, sizeof(auth_info->k),
+                k_string, sizeof(k_string));
+        AuthenticationSubscription.enc_permanent_key = k_string;
+
+        ogs_hex_to_ascii(auth_info->amf, sizeof(auth_info->amf),
+                amf_string, sizeof(amf_string));
+        AuthenticationSubscription.authentication_management_field =
+                amf_string;
+
+        if (!auth_info->use_opc)
+            milenage_opc(auth_info->k, auth_info->op, auth_info->opc);
+
+        ogs_hex_to_ascii(auth_info->opc, sizeof(auth_info->opc),
+                opc_string, sizeof(opc_string));
+        AuthenticationSubscription.enc_opc_key = opc_string;
+
+        ogs_uint64_to_buffer(auth_info->sqn, OGS_SQN_LEN, sqn);
+        ogs_hex_to_ascii(sqn, sizeof(sqn), sqn_string, sizeof(sqn_string));
+
+        memset(&SequenceNumber, 0, sizeof(SequenceNumber));
+        SequenceNumber.sqn = sqn_string;
+        AuthenticationSubscription.sequence_number = &SequenceNumber;
+
+        ogs_assert(AuthenticationSubscription.authentication_method);
+        sendmsg.AuthenticationSubscription = &AuthenticationSubscription;
+    }
+
+    response = ogs_sbi_build_response(&sendmsg, auth_job->status);
+    ogs_assert(response);
+    ogs_assert(true == ogs_sbi_server_send_response(stream, response));
+}
+
+static bool auth_job_submit(ogs_sbi_stream_t *stream,
+        ogs_sbi_message_t *recvmsg,
+        udr_auth_job_type_e type, char *supi, uint64_t sqn)
+{
+    udr_auth_job_t *auth_job = NULL;
+
+    auth_job = ogs_dbi_job_size(sizeof(*auth_job),
+            auth_job_handler, auth_job_complete);
+    ogs_assert(auth_job);
+
+    auth_job->type = type;
+    auth_job->stream_id = ogs_sbi_id_from_stream(stream);
+    ogs_cpystrn(auth_job->supi, supi, sizeof(auth_job->supi));
+    auth_job->sqn = sqn;
+
+    if (ogs_dbi_job_submit(&auth_job->h) != OGS_OK) {
+        ogs_dbi_job_free(&auth_job->h);
+        ogs_assert(true ==
+            ogs_sbi_server_send_error(stream,
+                OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
+                recvmsg, "Cannot submit DB job", supi, NULL));
+        return false;
+    }
+
+    return true;
+}
+
+bool udr_nudr_dr_handle_subscription_authentication(
+        ogs_sbi_stream_t *stream, ogs_sbi_message_t *recvmsg)
+{
+    char *supi = NULL;
+
     OpenAPI_list_t *PatchItemList = NULL;
     OpenAPI_lnode_t *node = NULL;
 
@@ -63,8 +223,8 @@ bool udr_nudr_dr_handle_subscription_authentication(
         return false;
     }
 
-    rv = ogs_dbi_auth_info(supi, &auth_info);
-    if (rv != OGS_OK) {
+    if (strlen(supi) >=
+            OGS_MAX_IMSI_BCD_LEN+sizeof(OGS_ID_SUPI_TYPE_IMSI)+1) {
         ogs_warn("[%s] Cannot find SUPI in DB", supi);
         ogs_assert(true ==
             ogs_sbi_server_send_error(stream, OGS_SBI_HTTP_STATUS_NOT_FOUND,
@@ -76,47 +236,8 @@ bool udr_nudr_dr_handle_subscription_authentication(
     CASE(OGS_SBI_RESOURCE_NAME_AUTHENTICATION_SUBSCRIPTION)
         SWITCH(recvmsg->h.method)
         CASE(OGS_SBI_HTTP_METHOD_GET)
-            memset(&AuthenticationSubscription, 0,
-                    sizeof(AuthenticationSubscription));
-
-            AuthenticationSubscription.authentication_method =
-                OpenAPI_auth_method_5G_AKA;
-
-            ogs_hex_to_ascii(auth_info.k, sizeof(auth_info.k),
-                    k_string, sizeof(k_string));
-            AuthenticationSubscription.enc_permanent_key = k_string;
-
-            ogs_hex_to_ascii(auth_info.amf, sizeof(auth_info.amf),
-                    amf_string, sizeof(amf_string));
-            AuthenticationSubscription.authentication_management_field =
-                    amf_string;
-
-            if (!auth_info.use_opc)
-                milenage_opc(auth_info.k, auth_info.op, auth_info.opc);
-
-            ogs_hex_to_ascii(auth_info.opc, sizeof(auth_info.opc),
-                    opc_string, sizeof(opc_string));
-            AuthenticationSubscription.enc_opc_key = opc_string;
-
-            ogs_uint64_to_buffer(auth_info.sqn, OGS_SQN_LEN, sqn);
-            ogs_hex_to_ascii(sqn, sizeof(sqn), sqn_string, sizeof(sqn_string));
-
-            memset(&SequenceNumber, 0, sizeof(SequenceNumber));
-            SequenceNumber.sqn = sqn_string;
-            AuthenticationSubscription.sequence_number = &SequenceNumber;
-
-            memset(&sendmsg, 0, sizeof(sendmsg));
-
-            ogs_assert(AuthenticationSubscription.authentication_method);
-            sendmsg.AuthenticationSubscription =
-                &AuthenticationSubscription;
-
-            response = ogs_sbi_build_response(
-                    &sendmsg, OGS_SBI_HTTP_STATUS_OK);
-            ogs_assert(response);
-            ogs_assert(true == ogs_sbi_server_send_response(stream, response));
-
-            return true;
+            return auth_job_submit(stream, recvmsg,
+                    UDR_AUTH_SUBSCRIPTION_GET, supi, 0);
 
         CASE(OGS_SBI_HTTP_METHOD_PATCH)
             char *sqn_string = NULL;
@@ -154,34 +275,8 @@ bool udr_nudr_dr_handle_subscription_authentication(
                     sqn_ms, sizeof(sqn_ms));
             sqn = ogs_buffer_to_uint64(sqn_ms, OGS_SQN_LEN);
 
-            rv = ogs_dbi_update_sqn(supi, sqn);
-            if (rv != OGS_OK) {
-                ogs_fatal("[%s] Cannot update SQN", supi);
-                ogs_assert(true ==
-                    ogs_sbi_server_send_error(stream,
-                        OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
-                        recvmsg, "Cannot update SQN", supi, NULL));
-                return false;
-            }
-
-            rv = ogs_dbi_increment_sqn(supi);
-            if (rv != OGS_OK) {
-                ogs_fatal("[%s] Cannot increment SQN", supi);
-                ogs_assert(true ==
-                    ogs_sbi_server_send_error(stream,
-                        OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
-                        recvmsg, "Cannot increment SQN", supi, NULL));
-                return false;
-            }
-
-            memset(&sendmsg, 0, sizeof(sendmsg));
-
-            response = ogs_sbi_build_response(
-                    &sendmsg, OGS_SBI_HTTP_STATUS_NO_CONTENT);
-            ogs_assert(response);
-            ogs_assert(true == ogs_sbi_server_send_response(stream, response));
-
-            return true;
+            return auth_job_submit(stream, recvmsg,
+                    UDR_AUTH_SUBSCRIPTION_PATCH, supi, sqn);
 
         DEFAULT
             ogs_error("Invalid HTTP method [%s]", recvmsg->h.method);
@@ -210,23 +305,8 @@ bool udr_nudr_dr_handle_subscription_authentication(
                 return false;
             }
 
-            memset(&sendmsg, 0, sizeof(sendmsg));
-            rv = ogs_dbi_increment_sqn(supi);
-            if (rv != OGS_OK) {
-                ogs_fatal("[%s] Cannot increment SQN", supi);
-                ogs_assert(true ==
-                    ogs_sbi_server_send_error(stream,
-                        OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR,
-                        recvmsg, "Cannot increment SQN", supi, NULL));
-                return false;
-            }
-
-            response = ogs_sbi_build_response(
-                    &sendmsg, OGS_SBI_HTTP_STATUS_NO_CONTENT);
-            ogs_assert(response);
-            ogs_assert(true == ogs_sbi_server_send_response(stream, response));
-
-            return true;
+            return auth_job_submit(stream, recvmsg,
+                    UDR_AUTH_STATUS_UPDATE, supi, 0);
 
         DEFAULT
             ogs_error("Invalid HTTP method [%s]", recvmsg->h.method);
@@ -369,6 +369,11 @@ void udr_state_operational(ogs_fsm_t *s, udr_event_t *e)
         }
         break;
 
+    case OGS_EVENT_DBI:
+        ogs_assert(e->h.dbi.job);
+        ogs_dbi_job_complete(e->h.dbi.job);
+        break;
+
     default:
         ogs_error("No handler for event %s", udr_event_get_name(e));
         break;
@@ -19,6 +19,8 @@
 
 #include "context.h"
 #include "pfcp-path.h"
+#include "rule-match.h"
+#include "snapshot.h"
 
 static upf_context_t self;
 
@@ -63,19 +65,14 @@ void upf_context_init(void)
     ogs_assert(self.ipv4_hash);
     self.ipv6_hash = ogs_hash_make();
     ogs_assert(self.ipv6_hash);
+    self.ipv4_framed_routes = ogs_lpm_create(OGS_IPV4_LEN << 3);
+    ogs_assert(self.ipv4_framed_routes);
+    self.ipv6_framed_routes = ogs_lpm_create(OGS_IPV6_LEN << 3);
+    ogs_assert(self.ipv6_framed_routes);
 
     context_initialized = 1;
 }
 
-static void free_upf_route_trie_node(struct upf_route_trie_node *node)
-{
-    if (!node)
-        return;
-    free_upf_route_trie_node(node->left);
-    free_upf_route_trie_node(node->right);
-    ogs_free(node);
-}
-
 void upf_context_final(void)
 {
     ogs_assert(context_initialized == 1);
@@ -93,8 +90,10 @@ void upf_context_final(void)
     ogs_assert(self.ipv6_hash);
     ogs_hash_destroy(self.ipv6_hash);
 
-    free_upf_route_trie_node(self.ipv4_framed_routes);
-    free_upf_route_trie_node(self.ipv6_framed_routes);
+    ogs_assert(self.ipv4_framed_routes);
+    ogs_lpm_destroy(self.ipv4_framed_routes);
+    ogs_assert(self.ipv6_framed_routes);
+    ogs_lpm_destroy(self.ipv6_framed_routes);
 
     ogs_pool_final(&upf_sess_pool);
     ogs_pool_final(&upf_n4_seid_pool);
@@ -109,6 +108,13 @@ upf_context_t *upf_self(void)
 
 static int upf_context_prepare(void)
 {
+    self.batch.size = 1;
+    self.batch.gso = false;
+
+    self.worker.num = 0;
+
+    self.profile.sample = 0;
+
     return OGS_OK;
 }
 
@@ -122,6 +128,21 @@ static int upf_context_validation(void)
         ogs_error("No upf.session.subnet: in '%s'", ogs_app()->file);
         return OGS_ERROR;
     }
+    if (self.batch.size < 1 || self.batch.size > OGS_MAX_NUM_OF_MMSG) {
+        ogs_error("upf.batch.size must be 1..%d in '%s'",
+                OGS_MAX_NUM_OF_MMSG, ogs_app()->file);
+        return OGS_ERROR;
+    }
+    if (self.worker.num < 0 || self.worker.num > UPF_MAX_NUM_OF_WORKER) {
+        ogs_error("upf.worker.num must be 0..%d in '%s'",
+                UPF_MAX_NUM_OF_WORKER, ogs_app()->file);
+        return OGS_ERROR;
+    }
+    if (self.profile.sample < 0) {
+        ogs_error("upf.profile.sample must be >= 0 in '%s'",
+                ogs_app()->file);
+        return OGS_ERROR;
+    }
     return OGS_OK;
 }
 
@@ -159,6 +180,48 @@ int upf_context_parse_config(void)
                     /* handle config in pfcp library */
                 } else if (!strcmp(upf_key, "metrics")) {
                     /* handle config in metrics library */
+                } else if (!strcmp(upf_key, "batch")) {
+                    ogs_yaml_iter_t batch_iter;
+                    ogs_yaml_iter_recurse(&upf_iter, &batch_iter);
+                    while (ogs_yaml_iter_next(&batch_iter)) {
+                        const char *batch_key =
+                            ogs_yaml_iter_key(&batch_iter);
+                        ogs_assert(batch_key);
+                        if (!strcmp(batch_key, "size")) {
+                            const char *v = ogs_yaml_iter_value(&batch_iter);
+                            if (v) self.batch.size = atoi(v);
+                        } else if (!strcmp(batch_key, "gso")) {
+                            self.batch.gso = ogs_yaml_iter_bool(&batch_iter);
+                        } else
+                            ogs_warn("unknown key `%s`", batch_key);
+                    }
+                } else if (!strcmp(upf_key, "worker")) {
+                    ogs_yaml_iter_t worker_iter;
+                    ogs_yaml_iter_recurse(&upf_iter, &worker_iter);
+                    while (ogs_yaml_iter_next(&worker_iter)) {
+                        const char *worker_key =
+                            ogs_yaml_iter_key(&worker_iter);
+                        ogs_assert(worker_key);
+                        if (!strcmp(worker_key, "num")) {
+                            const char *v = ogs_yaml_iter_value(&worker_iter);
+                            if (v) self.worker.num = atoi(v);
+                        } else
+                            ogs_warn("unknown key `%s`", worker_key);
+                    }
+                } else if (!strcmp(upf_key, "profile")) {
+                    ogs_yaml_iter_t profile_iter;
+                    ogs_yaml_iter_recurse(&upf_iter, &profile_iter);
+                    while (ogs_yaml_iter_next(&profile_iter)) {
+                        const char *profile_key =
+                            ogs_yaml_iter_key(&profile_iter);
+                        ogs_assert(profile_key);
+                        if (!strcmp(profile_key, "sample")) {
+                            const char *v =
+                                ogs_yaml_iter_value(&profile_iter);
+                            if (v) self.profile.sample = atoi(v);
+                        } else
+                            ogs_warn("unknown key `%s`", profile_key);
+                    }
                 } else
                     ogs_warn("unknown key `%s`", upf_key);
             }
@@ -220,6 +283,8 @@ int upf_sess_remove(upf_sess_t *sess)
     ogs_assert(sess);
 
     upf_sess_urr_acc_remove_all(sess);
+    upf_sess_classifier_clear(sess);
+    upf_snapshot_withdraw(sess);
 
     ogs_list_remove(&self.sess_list, sess);
     ogs_pfcp_sess_clear(&sess->pfcp);
@@ -295,9 +360,6 @@ upf_sess_t *upf_sess_find_by_upf_n4_seid(uint64_t seid)
 upf_sess_t *upf_sess_find_by_ipv4(uint32_t addr)
 {
     upf_sess_t *ret;
-    struct upf_route_trie_node *trie = self.ipv4_framed_routes;
-    const int nbits = sizeof(addr) << 3;
-    int i;
 
     ogs_assert(self.ipv4_hash);
 
@@ -305,30 +367,12 @@ upf_sess_t *upf_sess_find_by_ipv4(uint32_t addr)
     if (ret)
         return ret;
 
-    for (i =  0; i <= nbits; i++) {
-        int bit = nbits - i - 1;
-
-        if (!trie)
-            break;
-        if (trie->sess)
-            ret = trie->sess;
-        if (i == nbits)
-            break;
-
-        if ((1 << bit) & be32toh(addr))
-            trie = trie->right;
-        else
-            trie = trie->left;
-    }
-    return ret;
+    return ogs_lpm_find(self.ipv4_framed_routes, &addr);
 }
 
 upf_sess_t *upf_sess_find_by_ipv6(uint32_t *addr6)
 {
     upf_sess_t *ret = NULL;
-    struct upf_route_trie_node *trie = self.ipv6_framed_routes;
-    int i;
-    const int chunk_size = sizeof(*addr6) << 3;
 
     ogs_assert(self.ipv6_hash);
     ogs_assert(addr6);
@@ -337,23 +381,7 @@ upf_sess_t *upf_sess_find_by_ipv6(uint32_t *addr6)
     if (ret)
         return ret;
 
-    for (i = 0; i <= OGS_IPV6_128_PREFIX_LEN; i++) {
-        int part = i / chunk_size;
-        int bit = (OGS_IPV6_128_PREFIX_LEN - i - 1) % chunk_size;
-
-        if (!trie)
-            break;
-        if (trie->sess)
-            ret = trie->sess;
-        if (i == OGS_IPV6_128_PREFIX_LEN)
-            break;
-
-        if ((1 << bit) & be32toh(addr6[part]))
-            trie = trie->right;
-        else
-            trie = trie->left;
-    }
-    return ret;
+    return ogs_lpm_find(self.ipv6_framed_routes, addr6);
 }
 
 upf_sess_t *upf_sess_find_by_id(ogs_pool_id_t id)
@@ -505,83 +533,47 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
     return cause_value;
 }
 
-/* Remove amd free framed ROUTE from TRIE. It isn't an error if the framed
-   route doesn't exist in TRIE. */
-static void free_framed_route_from_trie(ogs_ipsubnet_t *route)
+/* Prefix length of a framed ROUTE : leading one bits of the mask */
+int upf_framed_route_prefixlen(ogs_ipsubnet_t *route)
 {
-    const int chunk_size = sizeof(route->sub[0]) << 3;
-    const int is_ipv4 = route->family == AF_INET;
-    const int nbits = is_ipv4 ? chunk_size : OGS_IPV6_128_PREFIX_LEN;
-    struct upf_route_trie_node **trie =
-        is_ipv4 ? &self.ipv4_framed_routes : &self.ipv6_framed_routes;
-
-    struct upf_route_trie_node **to_free_tries[OGS_IPV6_128_PREFIX_LEN + 1];
-    int free_from = 0;
-    int i = 0;
-
-    for (i = 0; i <= nbits; i++) {
-        int part = i / chunk_size;
-        int bit = (nbits - i - 1) % chunk_size;
+    const int nwords = route->family == AF_INET ? 1 : 4;
+    int i, len = 0;
+    uint32_t mask;
 
-        if (!*trie)
-            break;
-        to_free_tries[i] = trie;
-
-        if (i == nbits ||
-            ((1 << bit) & be32toh(route->mask[part])) == 0) {
-            (*trie)->sess = NULL;
-            if ((*trie)->left || (*trie)->right)
-                free_from = i + 1;
-            i++;
-            break;
-        }
-
-        if ((1 << bit) & be32toh(route->sub[part])) {
-            if ((*trie)->left || (*trie)->sess)
-                free_from = i + 1;
-            trie = &(*trie)->right;
-        } else {
-            if ((*trie)->right || (*trie)->sess)
-                free_from = i + 1;
-            trie = &(*trie)->left;
+    for (i = 0; i < nwords; i++) {
+        mask = be32toh(route->mask[i]);
+        while (mask & 0x80000000) {
+            len++;
+            mask <<= 1;
         }
+        if (len < (i + 1) * 32)
+            break;
     }
 
-    for (i = i - 1; i >= free_from; i--) {
-        trie = to_free_tries[i];
-        ogs_free(*trie);
-        *trie = NULL;
-    }
+    return len;
 }
 
-static void add_framed_route_to_trie(ogs_ipsubnet_t *route, upf_sess_t *sess)
+/* Remove framed ROUTE of SESS from the LPM table. It isn't an error
+   if the framed route doesn't exist or belongs to another session. */
+static void free_framed_route_from_lpm(
+        ogs_ipsubnet_t *route, upf_sess_t *sess)
 {
-    const int chunk_size = sizeof(route->sub[0]) << 3;
-    const int is_ipv4 = route->family == AF_INET;
-    const int nbits = is_ipv4 ? chunk_size : OGS_IPV6_128_PREFIX_LEN;
-    struct upf_route_trie_node **trie =
-        is_ipv4 ? &self.ipv4_framed_routes : &self.ipv6_framed_routes;
-    int i = 0;
+    ogs_lpm_t *lpm = route->family == AF_INET ?
+        self.ipv4_framed_routes : self.ipv6_framed_routes;
+    int prefixlen = upf_framed_route_prefixlen(route);
 
-    for (i = 0; i <= nbits; i++) {
-        int part = i / chunk_size;
-        int bit = (nbits - i - 1) % chunk_size;
-
-        if (!*trie)
-            *trie = ogs_calloc(1, sizeof(**trie));
+    if (ogs_lpm_find_exact(lpm, route->sub, prefixlen) == sess)
+        ogs_lpm_delete(lpm, route->sub, prefixlen);
+}
 
-        if (i == nbits ||
-            ((1 << bit) & be32toh(route->mask[part])) == 0) {
-            (*trie)->sess = sess;
-            break;
-        }
+static void add_framed_route_to_lpm(ogs_ipsubnet_t *route, upf_sess_t *sess)
+{
+    ogs_lpm_t *lpm = route->family == AF_INET ?
+        self.ipv4_framed_routes : self.ipv6_framed_routes;
 
-        if ((1 << bit) & be32toh(route->sub[part])) {
-            trie = &(*trie)->right;
-        } else {
-            trie = &(*trie)->left;
-        }
-    }
+    ogs_assert(OGS_OK ==
+            ogs_lpm_add(lpm, route->sub,
+                upf_framed_route_prefixlen(route), sess));
 }
 
 static int parse_framed_route(ogs_ipsubnet_t *subnet, const char *framed_route)
@@ -606,7 +598,7 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
     for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
         if (!sess->ipv4_framed_routes || !sess->ipv4_framed_routes[i].family)
             break;
-        free_framed_route_from_trie(&sess->ipv4_framed_routes[i]);
+        free_framed_route_from_lpm(&sess->ipv4_framed_routes[i], sess);
         memset(&sess->ipv4_framed_routes[i], 0,
                sizeof(sess->ipv4_framed_routes[i]));
     }
@@ -629,7 +621,7 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
                    sizeof(sess->ipv4_framed_routes[j]));
             continue;
         }
-        add_framed_route_to_trie(&sess->ipv4_framed_routes[j], sess);
+        add_framed_route_to_lpm(&sess->ipv4_framed_routes[j], sess);
         j++;
     }
     if (j == 0 && sess->ipv4_framed_routes) {
@@ -651,7 +643,7 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
     for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
         if (!sess->ipv6_framed_routes || !sess->ipv6_framed_routes[i].family)
             break;
-        free_framed_route_from_trie(&sess->ipv6_framed_routes[i]);
+        free_framed_route_from_lpm(&sess->ipv6_framed_routes[i], sess);
     }
 
     for (i = 0, j = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
@@ -672,7 +664,7 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
                    sizeof(sess->ipv6_framed_routes[j]));
             continue;
         }
-        add_framed_route_to_trie(&sess->ipv6_framed_routes[j], sess);
+        add_framed_route_to_lpm(&sess->ipv6_framed_routes[j], sess);
         j++;
     }
     if (j == 0 && sess->ipv6_framed_routes) {
@@ -686,7 +678,6 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
 void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bool is_uplink)
 {
     upf_sess_urr_acc_t *urr_acc = NULL;
-    uint64_t vol;
 
     ogs_assert(urr->id > 0 && urr->id <= OGS_MAX_NUM_OF_URR);
     urr_acc = &sess->urr_acc[urr->id-1];
@@ -706,6 +697,20 @@ void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bo
     if (urr_acc->time_of_first_packet == 0)
         urr_acc->time_of_first_packet = urr_acc->time_of_last_packet;
 
+    upf_sess_urr_acc_check(sess, urr);
+}
+
+void upf_sess_urr_acc_check(upf_sess_t *sess, ogs_pfcp_urr_t *urr)
+{
+    upf_sess_urr_acc_t *urr_acc = NULL;
+    uint64_t vol;
+
+    ogs_assert(urr->id > 0 && urr->id <= OGS_MAX_NUM_OF_URR);
+    urr_acc = &sess->urr_acc[urr->id-1];
+
+    /* Counted by the data plane workers */
+    upf_snapshot_collect(sess);
+
     /* generate report if volume threshold/quota is reached */
     vol = urr_acc->total_octets - urr_acc->last_report.total_octets;
     if ((urr->rep_triggers.volume_quota && urr->vol_quota.tovol && vol >= urr->vol_quota.total_volume) ||
@@ -735,6 +740,8 @@ void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *
     ogs_assert(urr->id > 0 && urr->id <= OGS_MAX_NUM_OF_URR);
     urr_acc = &sess->urr_acc[urr->id-1];
 
+    upf_snapshot_collect(sess);
+
     now = ogs_time_now(); /* we need UTC for start_time and end_time */
 
     if (urr_acc->last_report.timestamp)
@@ -801,6 +808,8 @@ void upf_sess_urr_acc_snapshot(upf_sess_t *sess, ogs_pfcp_urr_t *urr)
     urr_acc->last_report.dl_pkts = urr_acc->dl_pkts;
     urr_acc->last_report.ul_pkts = urr_acc->ul_pkts;
     urr_acc->last_report.timestamp = ogs_time_now();
+
+    upf_snapshot_arm(sess);
 }
 
 static void upf_sess_urr_acc_timers_cb(void *data)
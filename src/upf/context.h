@@ -45,7 +45,10 @@ extern int __upf_log_domain;
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __upf_log_domain
 
-struct upf_route_trie_node;
+#define UPF_MAX_NUM_OF_WORKER 64
+
+struct upf_classifier_s;
+struct upf_snapshot_s;
 
 typedef struct upf_context_s {
     ogs_hash_t *upf_n4_seid_hash;   /* hash table (UPF-N4-SEID) */
@@ -54,20 +57,24 @@ typedef struct upf_context_s {
     ogs_hash_t *ipv4_hash;  /* hash table (IPv4 Address) */
     ogs_hash_t *ipv6_hash;  /* hash table (IPv6 Address) */
 
-    /* IPv4 framed routes trie */
-    struct upf_route_trie_node *ipv4_framed_routes;
-    /* IPv6 framed routes trie */
-    struct upf_route_trie_node *ipv6_framed_routes;
+    ogs_lpm_t *ipv4_framed_routes;  /* LPM table (IPv4 Framed Route) */
+    ogs_lpm_t *ipv6_framed_routes;  /* LPM table (IPv6 Framed Route) */
 
     ogs_list_t sess_list;
-} upf_context_t;
 
-/* trie mapping from IP framed routes to session. */
-struct upf_route_trie_node {
-    struct upf_route_trie_node *left;
-    struct upf_route_trie_node *right;
-    upf_sess_t *sess;
-};
+    struct {
+        int size;   /* Max datagrams per wakeup (<= 1 : disabled) */
+        bool gso;   /* Use UDP_SEGMENT(GSO) on egress */
+    } batch;
+
+    struct {
+        int num;    /* Data plane threads (0 : run in the main thread) */
+    } worker;
+
+    struct {
+        int sample; /* Profile 1 packet in N (0 : disabled) */
+    } profile;
+} upf_context_t;
 
 /* Accounting: */
 typedef struct upf_sess_urr_acc_s {
@@ -124,6 +131,12 @@ typedef struct upf_sess_s {
     /* Accounting: */
     upf_sess_urr_acc_t urr_acc[OGS_MAX_NUM_OF_URR]; /* FIXME: This probably needs to be mved to a hashtable or alike */
     char            *apn_dnn;            /* APN/DNN Item */
+
+    /* Compiled PDRs, NULL until built(see rule-match.h) */
+    struct upf_classifier_s *classifier;
+
+    /* Published to the data plane workers(see snapshot.h) */
+    struct upf_snapshot_s *snapshot;
 } upf_sess_t;
 
 void upf_context_init(void);
@@ -150,8 +163,10 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
         char *framed_routes[]);
 uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
         char *framed_routes[]);
+int upf_framed_route_prefixlen(ogs_ipsubnet_t *route);
 
 void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bool is_uplink);
+void upf_sess_urr_acc_check(upf_sess_t *sess, ogs_pfcp_urr_t *urr);
 void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *urr,
                                         ogs_pfcp_user_plane_report_t *report, unsigned int idx);
 void upf_sess_urr_acc_snapshot(upf_sess_t *sess, ogs_pfcp_urr_t *urr);
@@ -51,21 +51,63 @@
 #include "event.h"
 #include "gtp-path.h"
 #include "pfcp-path.h"
+#include "meter.h"
 #include "rule-match.h"
+#include "worker.h"
+#include "snapshot.h"
 
 #define UPF_GTP_HANDLED     1
 
+#define UPF_DATA_PLANE_STAT_INTERVAL ogs_time_from_sec(1)
+
 const uint8_t proxy_mac_addr[] = { 0x0e, 0x00, 0x00, 0x00, 0x00, 0x01 };
 
-static ogs_pkbuf_pool_t *packet_pool = NULL;
+static ogs_pkbuf_cache_t *packet_cache = NULL;
+static ogs_timer_t *t_data_plane_stat = NULL;
+static OGS_THREAD_LOCAL ogs_pkbuf_t *rx_pkbuf[OGS_MAX_NUM_OF_MMSG];
+
+/*
+ * In a worker, packets to the TUN device are written
+ * at the end of the batch like the G-PDUs of the TX batch.
+ */
+static OGS_THREAD_LOCAL struct {
+    int num;
+    ogs_socket_t fd[OGS_MAX_NUM_OF_MMSG];
+    ogs_pkbuf_t *pkbuf[OGS_MAX_NUM_OF_MMSG];
+} tun_tx;
 
 static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf);
 
-static int check_framed_routes(upf_sess_t *sess, int family, uint32_t *addr)
+static void tun_tx_write(ogs_socket_t fd, ogs_pkbuf_t *pkbuf)
+{
+    if (upf_worker_self() && tun_tx.num < OGS_MAX_NUM_OF_MMSG) {
+        tun_tx.fd[tun_tx.num] = fd;
+        tun_tx.pkbuf[tun_tx.num] = pkbuf;
+        tun_tx.num++;
+        return;
+    }
+
+    if (ogs_tun_write(fd, pkbuf) != OGS_OK)
+        ogs_warn("ogs_tun_write() failed");
+    ogs_pkbuf_free(pkbuf);
+}
+
+static void tun_tx_flush(void)
+{
+    int i;
+
+    for (i = 0; i < tun_tx.num; i++) {
+        if (ogs_tun_write(tun_tx.fd[i], tun_tx.pkbuf[i]) != OGS_OK)
+            ogs_warn("ogs_tun_write() failed");
+        ogs_pkbuf_free(tun_tx.pkbuf[i]);
+    }
+    tun_tx.num = 0;
+}
+
+static int check_framed_routes(
+        ogs_ipsubnet_t *routes, int family, uint32_t *addr)
 {
     int i = 0;
-    ogs_ipsubnet_t *routes = family == AF_INET ?
-        sess->ipv4_framed_routes : sess->ipv6_framed_routes;
 
     if (!routes)
         return false;
@@ -91,6 +133,126 @@ static int check_framed_routes(upf_sess_t *sess, int family, uint32_t *addr)
     return false;
 }
 
+/*
+ * IP source spoofing check of an uplink packet against the UE addresses
+ * (NULL if not allocated) and the framed routes of its session.
+ *
+ * Return the Ethernet type of the packet, or 0 if it is to be dropped.
+ */
+static uint16_t check_src_addr(ogs_pkbuf_t *pkbuf,
+        uint32_t *ue_ipv4, ogs_ipsubnet_t *ipv4_framed_routes,
+        uint32_t *ue_ipv6, ogs_ipsubnet_t *ipv6_framed_routes,
+        char *dnn, ogs_pfcp_interface_t src_if, ogs_pfcp_interface_t dst_if,
+        uint32_t teid)
+{
+    struct ip *ip_h = NULL;
+    uint32_t *src_addr = NULL;
+
+    ogs_assert(pkbuf);
+
+    ip_h = (struct ip *)pkbuf->data;
+    ogs_assert(ip_h);
+
+    if (ip_h->ip_v == 4 && ue_ipv4) {
+        src_addr = (void *)&ip_h->ip_src.s_addr;
+        ogs_assert(src_addr);
+
+        if (src_addr[0] == ue_ipv4[0]) {
+            /* Source IP address should be matched in uplink */
+        } else if (check_framed_routes(
+                    ipv4_framed_routes, AF_INET, src_addr)) {
+            /* Or source IP address should match a framed route */
+        } else {
+            ogs_error("[DROP] Source IP-%d Spoofing APN:%s SrcIf:%d DstIf:%d TEID:0x%x",
+                        ip_h->ip_v, dnn, src_if, dst_if, teid);
+            ogs_error("       SRC:%08X, UE:%08X",
+                be32toh(src_addr[0]), be32toh(ue_ipv4[0]));
+            ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+
+            return 0;
+        }
+
+        return ETHERTYPE_IP;
+
+    } else if (ip_h->ip_v == 6 && ue_ipv6) {
+        struct ip6_hdr *ip6_h = (struct ip6_hdr *)pkbuf->data;
+        ogs_assert(ip6_h);
+        src_addr = (void *)ip6_h->ip6_src.s6_addr;
+        ogs_assert(src_addr);
+
+    /*
+     * Discussion #1776 was raised,
+     * but we decided not to allow unspecified addresses
+     * because Open5GS has already sent interface identifiers
+     * in the registgration/attach process.
+     *
+     *
+     * RFC4861
+     * 4.  Message Formats
+     * 4.1.  Router Solicitation Message Format
+     * IP Fields:
+     *    Source Address
+     *                  An IP address assigned to the sending interface, or
+     *                  the unspecified address if no address is assigned
+     *                  to the sending interface.
+     *
+     * 6.1.  Message Validation
+     * 6.1.1.  Validation of Router Solicitation Messages
+     *  Hosts MUST silently discard any received Router Solicitation
+     *  Messages.
+     *
+     *  A router MUST silently discard any received Router Solicitation
+     *  messages that do not satisfy all of the following validity checks:
+     *
+     *  ..
+     *  ..
+     *
+     *  - If the IP source address is the unspecified address, there is no
+     *    source link-layer address option in the message.
+     */
+        if (IN6_IS_ADDR_LINKLOCAL((struct in6_addr *)src_addr) &&
+            src_addr[2] == ue_ipv6[2] &&
+            src_addr[3] == ue_ipv6[3]) {
+            /*
+             * if Link-local address,
+             * Interface Identifier should be matched
+             */
+        } else if (src_addr[0] == ue_ipv6[0] &&
+                    src_addr[1] == ue_ipv6[1]) {
+            /*
+             * If Global address
+             * 64 bit prefix should be matched
+             */
+        } else if (check_framed_routes(
+                    ipv6_framed_routes, AF_INET6, src_addr)) {
+            /* Or source IP address should match a framed route */
+        } else {
+            ogs_error("[DROP] Source IP-%d Spoofing APN:%s SrcIf:%d DstIf:%d TEID:0x%x",
+                        ip_h->ip_v, dnn, src_if, dst_if, teid);
+            ogs_error("SRC:%08x %08x %08x %08x",
+                    be32toh(src_addr[0]), be32toh(src_addr[1]),
+                    be32toh(src_addr[2]), be32toh(src_addr[3]));
+            ogs_error("UE:%08x %08x %08x %08x",
+                    be32toh(ue_ipv6[0]),
+                    be32toh(ue_ipv6[1]),
+                    be32toh(ue_ipv6[2]),
+                    be32toh(ue_ipv6[3]));
+            ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+
+            return 0;
+        }
+
+        return ETHERTYPE_IPV6;
+
+    }
+
+    ogs_error("Invalid packet [IP version:%d, Packet Length:%d]",
+            ip_h->ip_v, pkbuf->len);
+    ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+
+    return 0;
+}
+
 static uint16_t _get_eth_type(uint8_t *data, uint len) {
     if (len > ETHER_HDR_LEN) {
         struct ether_header *hdr = (struct ether_header*)data;
@@ -99,105 +261,97 @@ static uint16_t _get_eth_type(uint8_t *data, uint len) {
     return 0;
 }
 
-static void _gtpv1_tun_recv_common_cb(
-        short when, ogs_socket_t fd, bool has_eth, void *data)
+static bool is_ue_addr(uint32_t addr)
 {
-    ogs_pkbuf_t *recvbuf = NULL;
+    upf_worker_t *worker = upf_worker_self();
 
-    upf_sess_t *sess = NULL;
-    ogs_pfcp_pdr_t *pdr = NULL;
-    ogs_pfcp_pdr_t *fallback_pdr = NULL;
-    ogs_pfcp_far_t *far = NULL;
-    ogs_pfcp_user_plane_report_t report;
-    int i;
+    if (worker)
+        return upf_snapshot_find_by_ipv4(worker, addr) != NULL;
 
-    recvbuf = ogs_tun_read(fd, packet_pool);
-    if (!recvbuf) {
-        ogs_warn("ogs_tun_read() failed");
-        return;
-    }
+    return upf_sess_find_by_ipv4(addr) != NULL;
+}
 
-    if (has_eth) {
-        ogs_pkbuf_t *replybuf = NULL;
-        uint16_t eth_type = _get_eth_type(recvbuf->data, recvbuf->len);
-        uint8_t size;
-
-        if (eth_type == ETHERTYPE_ARP) {
-            if (is_arp_req(recvbuf->data, recvbuf->len) &&
-                    upf_sess_find_by_ipv4(
-                        arp_parse_target_addr(recvbuf->data, recvbuf->len))) {
-                replybuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-                ogs_assert(replybuf);
-                ogs_pkbuf_reserve(replybuf, OGS_TUN_MAX_HEADROOM);
-                ogs_pkbuf_put(replybuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
-                size = arp_reply(replybuf->data, recvbuf->data, recvbuf->len,
-                    proxy_mac_addr);
-                ogs_pkbuf_trim(replybuf, size);
-                ogs_info("[SEND] reply to ARP request: %u", size);
-            } else {
-                goto cleanup;
-            }
-        } else if (eth_type == ETHERTYPE_IPV6 &&
-                    is_nd_req(recvbuf->data, recvbuf->len)) {
-            replybuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
+/*
+ * Reply to ARP and ND on a TAP device, and strip the Ethernet header
+ * of IP packets. Return false if RECVBUF is to be freed.
+ */
+static bool tun_handle_eth(ogs_socket_t fd, ogs_pkbuf_t *recvbuf)
+{
+    ogs_pkbuf_t *replybuf = NULL;
+    uint16_t eth_type = _get_eth_type(recvbuf->data, recvbuf->len);
+    uint8_t size;
+
+    if (eth_type == ETHERTYPE_ARP) {
+        if (is_arp_req(recvbuf->data, recvbuf->len) &&
+                is_ue_addr(
+                    arp_parse_target_addr(recvbuf->data, recvbuf->len))) {
+            replybuf = ogs_pkbuf_cache_alloc(packet_cache);
             ogs_assert(replybuf);
             ogs_pkbuf_reserve(replybuf, OGS_TUN_MAX_HEADROOM);
             ogs_pkbuf_put(replybuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
-            size = nd_reply(replybuf->data, recvbuf->data, recvbuf->len,
+            size = arp_reply(replybuf->data, recvbuf->data, recvbuf->len,
                 proxy_mac_addr);
             ogs_pkbuf_trim(replybuf, size);
-            ogs_info("[SEND] reply to ND solicit: %u", size);
-        }
-        if (replybuf) {
-            if (ogs_tun_write(fd, replybuf) != OGS_OK)
-                ogs_warn("ogs_tun_write() for reply failed");
-            
-            ogs_pkbuf_free(replybuf);
-            goto cleanup;
-        }
-        if (eth_type != ETHERTYPE_IP && eth_type != ETHERTYPE_IPV6) {
-            ogs_error("[DROP] Invalid eth_type [%x]]", eth_type);
-            ogs_log_hexdump(OGS_LOG_ERROR, recvbuf->data, recvbuf->len);
-            goto cleanup;
+            ogs_info("[SEND] reply to ARP request: %u", size);
+        } else {
+            return false;
         }
-        ogs_pkbuf_pull(recvbuf, ETHER_HDR_LEN);
+    } else if (eth_type == ETHERTYPE_IPV6 &&
+                is_nd_req(recvbuf->data, recvbuf->len)) {
+        replybuf = ogs_pkbuf_cache_alloc(packet_cache);
+        ogs_assert(replybuf);
+        ogs_pkbuf_reserve(replybuf, OGS_TUN_MAX_HEADROOM);
+        ogs_pkbuf_put(replybuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
+        size = nd_reply(replybuf->data, recvbuf->data, recvbuf->len,
+            proxy_mac_addr);
+        ogs_pkbuf_trim(replybuf, size);
+        ogs_info("[SEND] reply to ND solicit: %u", size);
     }
+    if (replybuf) {
+        if (ogs_tun_write(fd, replybuf) != OGS_OK)
+            ogs_warn("ogs_tun_write() for reply failed");
 
-    sess = upf_sess_find_by_ue_ip_address(recvbuf);
-    if (!sess)
-        goto cleanup;
+        ogs_pkbuf_free(replybuf);
+        return false;
+    }
+    if (eth_type != ETHERTYPE_IP && eth_type != ETHERTYPE_IPV6) {
+        ogs_error("[DROP] Invalid eth_type [%x]]", eth_type);
+        ogs_log_hexdump(OGS_LOG_ERROR, recvbuf->data, recvbuf->len);
+        return false;
+    }
+    ogs_pkbuf_pull(recvbuf, ETHER_HDR_LEN);
 
-    ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
-        far = pdr->far;
-        ogs_assert(far);
+    return true;
+}
 
-        /* Check if PDR is Downlink */
-        if (pdr->src_if != OGS_PFCP_INTERFACE_CORE)
-            continue;
+static void _gtpv1_tun_handle(
+        ogs_socket_t fd, bool has_eth, ogs_pkbuf_t *recvbuf)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *pdr = NULL;
+    ogs_pfcp_pdr_t *fallback_pdr = NULL;
+    ogs_pfcp_user_plane_report_t report;
+    upf_metrics_dp_sample_t sample;
+    unsigned int len;
+    int i;
 
-        /* Save the Fallback PDR : Lowest precedence downlink PDR */
-        fallback_pdr = pdr;
+    ogs_assert(recvbuf);
 
-        /* Check if FAR is Downlink */
-        if (far->dst_if != OGS_PFCP_INTERFACE_ACCESS)
-            continue;
+    upf_metrics_dp_sample_begin(&sample);
 
-        /* Check if Outer header creation */
-        if (far->outer_header_creation.ip4 == 0 &&
-            far->outer_header_creation.ip6 == 0 &&
-            far->outer_header_creation.udp4 == 0 &&
-            far->outer_header_creation.udp6 == 0 &&
-            far->outer_header_creation.gtpu4 == 0 &&
-            far->outer_header_creation.gtpu6 == 0)
-            continue;
+    if (has_eth && tun_handle_eth(fd, recvbuf) == false)
+        goto cleanup;
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_PARSE);
 
-        /* Check if Rule List in PDR */
-        if (ogs_list_first(&pdr->rule_list) &&
-            ogs_pfcp_pdr_rule_find_by_packet(pdr, recvbuf) == NULL)
-            continue;
+    sess = upf_sess_find_by_ue_ip_address(recvbuf);
+    if (!sess)
+        goto cleanup;
 
-        break;
-    }
+    /*
+     * Highest precedence downlink PDR towards Access
+     * whose SDF filter matches, or the lowest precedence downlink PDR.
+     */
+    pdr = upf_sess_classify_downlink(sess, recvbuf, &fallback_pdr);
 
     if (!pdr)
         pdr = fallback_pdr;
@@ -208,26 +362,30 @@ static void _gtpv1_tun_recv_common_cb(
         }
         goto cleanup;
     }
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_LOOKUP);
+
+    if (!upf_meter_police(pdr->qer,
+                upf_snapshot_qer_meter(sess, pdr->qer), false, recvbuf->len))
+        goto cleanup;
 
     /* Increment total & dl octets + pkts */
     for (i = 0; i < pdr->num_of_urr; i++)
         upf_sess_urr_acc_add(sess, pdr->urr[i], recvbuf->len, false);
 
-    ogs_assert(true == ogs_pfcp_up_handle_pdr(
-                pdr, OGS_GTPU_MSGTYPE_GPDU, 0, NULL, recvbuf, &report));
+    /* recvbuf is consumed by ogs_pfcp_up_handle_pdr() */
+    len = recvbuf->len;
 
     /*
-     * Issue #2210, Discussion #2208, #2209
-     *
-     * Metrics reduce data plane performance.
-     * It should not be used on the UPF/SGW-U data plane
-     * until this issue is resolved.
+     * GTP-U encapsulation is done inside ogs_pfcp_up_handle_pdr(),
+     * so the downlink rewrite cost is accounted in the SEND stage.
      */
-#if 0
-    upf_metrics_inst_global_inc(UPF_METR_GLOB_CTR_GTP_OUTDATAPKTN3UPF);
-    upf_metrics_inst_by_qfi_add(pdr->qer->qfi,
-        UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF, recvbuf->len);
-#endif
+    ogs_assert(true == ogs_pfcp_up_handle_pdr(
+                pdr, OGS_GTPU_MSGTYPE_GPDU, 0, NULL, recvbuf, &report));
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_SEND);
+
+    upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_OUTDATAPKTN3UPF, 1);
+    upf_metrics_dp_by_qfi_add(pdr->qer ? pdr->qer->qfi : 0,
+        UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF, len);
 
     if (report.type.downlink_data_report) {
         ogs_assert(pdr->sess);
@@ -252,6 +410,411 @@ cleanup:
     ogs_pkbuf_free(recvbuf);
 }
 
+static void handle_echo_req(
+        ogs_sock_t *sock, ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *from)
+{
+    char buf[OGS_ADDRSTRLEN];
+    ogs_pkbuf_t *echo_rsp;
+
+    ogs_info("[RECV] Echo Request from [%s]", OGS_ADDR(from, buf));
+    echo_rsp = ogs_gtp2_handle_echo_req(pkbuf);
+    ogs_expect(echo_rsp);
+    if (echo_rsp) {
+        ssize_t sent;
+
+        /* Echo reply */
+        ogs_info("[SEND] Echo Response to [%s]", OGS_ADDR(from, buf));
+
+        sent = ogs_sendto(sock->fd,
+                echo_rsp->data, echo_rsp->len, 0, from);
+        if (sent < 0 || sent != echo_rsp->len) {
+            ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                    "ogs_sendto() failed");
+        }
+        ogs_pkbuf_free(echo_rsp);
+    }
+}
+
+/*
+ * Data plane worker
+ *
+ * A worker handles the packets of the sessions published to it
+ * (see snapshot.h) as far as they are forwarded to the TUN device
+ * or to a GTP-U peer. Anything else is passed to the main thread,
+ * which handles it as if it had received it itself.
+ */
+static void worker_punt(upf_worker_t *worker, int type, ogs_pkbuf_t *pkbuf,
+        ogs_sock_t *sock, ogs_sockaddr_t *from, ogs_socket_t fd)
+{
+    upf_worker_message_t message;
+    ogs_time_t now;
+
+    memset(&message, 0, sizeof(message));
+    message.type = type;
+    message.pkbuf = pkbuf;
+    message.sock = sock;
+    if (from)
+        memcpy(&message.from, from, sizeof(message.from));
+    message.fd = fd;
+
+    if (upf_worker_punt(worker, &message) == false) {
+        ogs_pkbuf_free(pkbuf);
+
+        upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_WORKER_PUNTDROP, 1);
+        worker->drop.num++;
+
+        /* Logged at most once a second, not per packet */
+        now = ogs_get_monotonic_time();
+        if (now - worker->drop.logged >= ogs_time_from_sec(1)) {
+            ogs_warn("[DROP] Main thread is busy : %llu packets [worker#%d]",
+                    (unsigned long long)worker->drop.num, worker->index);
+            worker->drop.num = 0;
+            worker->drop.logged = now;
+        }
+    }
+}
+
+/* Same as ogs_pfcp_up_handle_pdr() for a FAR forwarding to its peer */
+static void worker_send_gtpu(upf_snapshot_t *snap, upf_snapshot_rule_t *rule,
+        uint8_t type, int len, ogs_gtp2_header_desc_t *recvhdr,
+        ogs_pkbuf_t *sendbuf)
+{
+    ogs_gtp2_header_desc_t sendhdr;
+    ogs_pfcp_qer_t *qer = NULL;
+
+    ogs_assert(rule->far.sock);
+    ogs_assert(rule->far.addr);
+
+    if (rule->qer >= 0)
+        qer = &snap->qer[rule->qer];
+
+    if ((rule->src_if == OGS_PFCP_INTERFACE_CORE &&
+         rule->src_if_type_presence == true &&
+         rule->src_if_type ==
+             OGS_PFCP_3GPP_INTERFACE_TYPE_N9_FOR_ROAMING) ||
+        (rule->far.dst_if == OGS_PFCP_INTERFACE_CORE &&
+         rule->far.dst_if_type_presence == true &&
+         rule->far.dst_if_type ==
+             OGS_PFCP_3GPP_INTERFACE_TYPE_N9_FOR_ROAMING)) {
+        /* Home Routed Roaming : only the TEID is modified */
+        ogs_pkbuf_push(sendbuf, len);
+
+    } else {
+        memset(&sendhdr, 0, sizeof(sendhdr));
+
+        sendhdr.type = type;
+        sendhdr.teid = rule->far.teid;
+
+        if (qer && qer->qfi) {
+            sendhdr.pdu_type =
+                OGS_GTP2_EXTENSION_HEADER_PDU_TYPE_DL_PDU_SESSION_INFORMATION;
+            sendhdr.qos_flow_identifier = qer->qfi;
+        } else if (rule->src_if == OGS_PFCP_INTERFACE_ACCESS &&
+                rule->far.dst_if == OGS_PFCP_INTERFACE_ACCESS &&
+                recvhdr && recvhdr->qos_flow_identifier) {
+            /* HR Indirect Forwarding */
+            sendhdr.pdu_type =
+                OGS_GTP2_EXTENSION_HEADER_PDU_TYPE_DL_PDU_SESSION_INFORMATION;
+            sendhdr.qos_flow_identifier = recvhdr->qos_flow_identifier;
+        }
+
+        if (recvhdr) {
+            if (recvhdr->pdcp_number_presence == true) {
+                sendhdr.pdcp_number_presence = recvhdr->pdcp_number_presence;
+                sendhdr.pdcp_number = recvhdr->pdcp_number;
+            }
+
+            if (recvhdr->udp.presence == true) {
+                sendhdr.udp.presence = recvhdr->udp.presence;
+                sendhdr.udp.port = recvhdr->udp.port;
+            }
+        }
+
+        ogs_gtp2_encapsulate_header(&sendhdr, sendbuf);
+
+        ogs_trace("ENCAP GTP-U[%d], TEID[0x%x]", sendhdr.type, sendhdr.teid);
+    }
+
+    /* ogs_gtp_tx_batch_send() frees or queues the sendbuf */
+    ogs_gtp_tx_batch_send(
+            rule->far.sock, sendbuf, rule->far.teid, rule->far.addr);
+}
+
+static void _gtpv1_tun_worker_handle(upf_worker_t *worker,
+        ogs_socket_t fd, bool has_eth, ogs_pkbuf_t *recvbuf)
+{
+    upf_snapshot_t *snap = NULL;
+    upf_snapshot_rule_t *rule = NULL;
+    ogs_pfcp_qer_t *qer = NULL;
+    upf_metrics_dp_sample_t sample;
+    unsigned int len;
+    int index, fallback;
+
+    ogs_assert(worker);
+    ogs_assert(recvbuf);
+
+    upf_metrics_dp_sample_begin(&sample);
+
+    if (has_eth && tun_handle_eth(fd, recvbuf) == false)
+        goto cleanup;
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_PARSE);
+
+    snap = upf_snapshot_find_by_ue_ip_address(worker, recvbuf);
+    if (!snap)
+        goto cleanup;
+
+    index = upf_classify_downlink(snap->classifier, recvbuf, &fallback);
+    if (index < 0)
+        index = fallback;
+
+    if (index < 0) {
+        if (ogs_global_conf()->parameter.multicast)
+            goto punt;
+        goto cleanup;
+    }
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_LOOKUP);
+
+    rule = &snap->rule[index];
+    if (!rule->far.sock)
+        goto punt;
+
+    if (rule->qer >= 0)
+        qer = &snap->qer[rule->qer];
+
+    if (!upf_meter_police(qer, upf_snapshot_meter(snap, rule->qer),
+                false, recvbuf->len))
+        goto cleanup;
+
+    /* Increment total & dl octets + pkts */
+    upf_snapshot_count(snap, worker, rule, recvbuf->len, false);
+
+    /* recvbuf is consumed by worker_send_gtpu() */
+    len = recvbuf->len;
+
+    worker_send_gtpu(snap, rule, OGS_GTPU_MSGTYPE_GPDU, 0, NULL, recvbuf);
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_SEND);
+
+    upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_OUTDATAPKTN3UPF, 1);
+    upf_metrics_dp_by_qfi_add(qer ? qer->qfi : 0,
+        UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF, len);
+
+    return;
+
+punt:
+    /* The Ethernet header, if any, is already removed */
+    worker_punt(worker, UPF_WORKER_TUN, recvbuf, NULL, NULL, fd);
+    return;
+
+cleanup:
+    ogs_pkbuf_free(recvbuf);
+}
+
+static void _gtpv1_u_worker_handle(upf_worker_t *worker,
+        ogs_sock_t *sock, ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *from)
+{
+    int len;
+    char buf[OGS_ADDRSTRLEN];
+
+    ogs_gtp2_header_t *gtp_h = NULL;
+    ogs_gtp2_header_desc_t header_desc;
+    upf_metrics_dp_sample_t sample;
+
+    upf_snapshot_t *snap = NULL;
+    upf_snapshot_rule_t *rule = NULL;
+    ogs_pfcp_qer_t *qer = NULL;
+    ogs_pfcp_dev_t *dev = NULL;
+    uint16_t eth_type = 0;
+    bool n6;
+    int index;
+
+    ogs_assert(worker);
+    ogs_assert(sock);
+    ogs_assert(pkbuf);
+    ogs_assert(pkbuf->len);
+    ogs_assert(from);
+
+    upf_metrics_dp_sample_begin(&sample);
+
+    gtp_h = (ogs_gtp2_header_t *)pkbuf->data;
+    if (gtp_h->version != OGS_GTP2_VERSION_1) {
+        ogs_error("[DROP] Invalid GTPU version [%d]", gtp_h->version);
+        ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+        goto cleanup;
+    }
+
+    len = ogs_gtpu_parse_header(&header_desc, pkbuf);
+    if (len < 0) {
+        ogs_error("[DROP] Cannot decode GTPU packet");
+        ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+        goto cleanup;
+    }
+    if (header_desc.type == OGS_GTPU_MSGTYPE_ECHO_REQ) {
+        handle_echo_req(sock, pkbuf, from);
+        goto cleanup;
+    }
+    if (header_desc.type == OGS_GTPU_MSGTYPE_END_MARKER) {
+        /* Nothing */
+        goto cleanup;
+    }
+    if (header_desc.type != OGS_GTPU_MSGTYPE_GPDU) {
+        /* Error Indication */
+        goto punt;
+    }
+    if (pkbuf->len <= len) {
+        ogs_error("[DROP] Small GTPU packet(type:%d len:%d)",
+                header_desc.type, len);
+        ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+        goto cleanup;
+    }
+
+    ogs_trace("[RECV] GPU-U Type [%d] from [%s] : TEID[0x%x]",
+            header_desc.type, OGS_ADDR(from, buf), header_desc.teid);
+
+    /* No session : the main thread sends Error Indication */
+    snap = upf_snapshot_find_by_teid(worker, header_desc.teid);
+    if (!snap)
+        goto punt;
+
+    ogs_assert(ogs_pkbuf_pull(pkbuf, len));
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_PARSE);
+
+    index = upf_classify_uplink(snap->classifier, pkbuf,
+            header_desc.teid, header_desc.qos_flow_identifier);
+    if (index < 0)
+        goto push;
+
+    rule = &snap->rule[index];
+
+    n6 = rule->far.dst_if == OGS_PFCP_INTERFACE_CORE &&
+        rule->far.dst_if_type_presence == true &&
+        rule->far.dst_if_type == OGS_PFCP_3GPP_INTERFACE_TYPE_N6;
+    if (!n6 && !rule->far.sock)
+        goto push;
+
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_LOOKUP);
+
+    upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_INDATAPKTN3UPF, 1);
+    upf_metrics_dp_by_qfi_add(header_desc.qos_flow_identifier,
+            UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN3UPF, pkbuf->len);
+
+    /* IP source spoofing check, see _gtpv1_u_handle() */
+    if (rule->src_if == OGS_PFCP_INTERFACE_ACCESS &&
+        rule->src_if_type_presence == true &&
+        (rule->src_if_type == OGS_PFCP_3GPP_INTERFACE_TYPE_N3_3GPP_ACCESS ||
+         rule->src_if_type == OGS_PFCP_3GPP_INTERFACE_TYPE_N9_FOR_ROAMING) &&
+        !(rule->far.dst_if_type_presence == true &&
+          rule->far.dst_if_type ==
+            OGS_PFCP_3GPP_INTERFACE_TYPE_N9_FOR_ROAMING)) {
+
+        eth_type = check_src_addr(pkbuf,
+                snap->ipv4.presence ? snap->ipv4.addr : NULL,
+                snap->ipv4_framed_routes,
+                snap->ipv6.presence ? snap->ipv6.addr : NULL,
+                snap->ipv6_framed_routes,
+                rule->dnn, rule->src_if, rule->far.dst_if,
+                header_desc.teid);
+        if (!eth_type)
+            goto cleanup;
+
+        dev = eth_type == ETHERTYPE_IP ? snap->ipv4.dev : snap->ipv6.dev;
+    }
+
+    if (rule->qer >= 0)
+        qer = &snap->qer[rule->qer];
+
+    if (!upf_meter_police(qer, upf_snapshot_meter(snap, rule->qer),
+                rule->src_if == OGS_PFCP_INTERFACE_ACCESS, pkbuf->len))
+        goto cleanup;
+
+    if (n6) {
+        if (!dev)
+            goto cleanup;
+
+        /* Increment total & ul octets + pkts */
+        upf_snapshot_count(snap, worker, rule, pkbuf->len, true);
+
+        if (dev->is_tap) {
+            ogs_assert(eth_type);
+            eth_type = htobe16(eth_type);
+            ogs_pkbuf_push(pkbuf, sizeof(eth_type));
+            memcpy(pkbuf->data, &eth_type, sizeof(eth_type));
+            ogs_pkbuf_push(pkbuf, ETHER_ADDR_LEN);
+            memcpy(pkbuf->data, proxy_mac_addr, ETHER_ADDR_LEN);
+            ogs_pkbuf_push(pkbuf, ETHER_ADDR_LEN);
+            memcpy(pkbuf->data, dev->mac_addr, ETHER_ADDR_LEN);
+        }
+        upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_REWRITE);
+
+        tun_tx_write(dev->fd, pkbuf);
+        upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_SEND);
+        return;
+    }
+
+    worker_send_gtpu(snap, rule, header_desc.type, len, &header_desc, pkbuf);
+    upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_SEND);
+    return;
+
+push:
+    /* The main thread parses it again */
+    ogs_assert(ogs_pkbuf_push(pkbuf, len));
+punt:
+    worker_punt(worker, UPF_WORKER_GTPU, pkbuf, sock, from, INVALID_SOCKET);
+    return;
+
+cleanup:
+    ogs_pkbuf_free(pkbuf);
+}
+
+static void _gtpv1_tun_recv_common_cb(
+        short when, ogs_socket_t fd, bool has_eth, void *data)
+{
+    upf_worker_t *worker = NULL;
+    ogs_pkbuf_t *recvbuf[OGS_MAX_NUM_OF_MMSG];
+    int i, num = 0, sent;
+
+    /*
+     * With batching, the TUN device is non-blocking and is drained
+     * up to 'batch.size' packets per wakeup. The resulting G-PDUs are
+     * queued and flushed towards N3 with sendmmsg() at the end.
+     */
+    do {
+        recvbuf[num] = ogs_pkbuf_cache_alloc(packet_cache);
+        ogs_assert(recvbuf[num]);
+        if (ogs_tun_recv(fd, recvbuf[num]) != OGS_OK) {
+            ogs_pkbuf_free(recvbuf[num]);
+            if (!num)
+                ogs_warn("ogs_tun_recv() failed");
+            break;
+        }
+    } while (++num < upf_self()->batch.size);
+
+    if (!num)
+        return;
+
+    ogs_gtp_tx_batch_begin();
+
+    worker = upf_worker_self();
+    if (worker) {
+        upf_snapshot_sync(worker);
+        for (i = 0; i < num; i++)
+            _gtpv1_tun_worker_handle(worker, fd, has_eth, recvbuf[i]);
+    } else {
+        for (i = 0; i < num; i++)
+            _gtpv1_tun_handle(fd, has_eth, recvbuf[i]);
+    }
+
+    sent = ogs_gtp_tx_batch_end();
+
+    if (upf_self()->batch.size > 1) {
+        upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_TUN_RXBATCH, 1);
+        upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_TUN_RXBATCHPKT, num);
+        if (sent) {
+            upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_TXBATCH, 1);
+            upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_TXBATCHPKT, sent);
+        }
+    }
+}
+
 static void _gtpv1_tun_recv_cb(short when, ogs_socket_t fd, void *data)
 {
     _gtpv1_tun_recv_common_cb(when, fd, false, data);
@@ -262,43 +825,26 @@ static void _gtpv1_tun_recv_eth_cb(short when, ogs_socket_t fd, void *data)
     _gtpv1_tun_recv_common_cb(when, fd, true, data);
 }
 
-static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+static void _gtpv1_u_handle(
+        ogs_sock_t *sock, ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *from)
 {
     int len;
-    ssize_t size;
     char buf1[OGS_ADDRSTRLEN];
     char buf2[OGS_ADDRSTRLEN];
 
     upf_sess_t *sess = NULL;
 
-    ogs_pkbuf_t *pkbuf = NULL;
-    ogs_sock_t *sock = NULL;
-    ogs_sockaddr_t from;
-
     ogs_gtp2_header_t *gtp_h = NULL;
     ogs_gtp2_header_desc_t header_desc;
     ogs_pfcp_user_plane_report_t report;
+    upf_metrics_dp_sample_t sample;
 
-    ogs_assert(fd != INVALID_SOCKET);
-    sock = data;
     ogs_assert(sock);
-
-    pkbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-    ogs_assert(pkbuf);
-    ogs_pkbuf_reserve(pkbuf, OGS_TUN_MAX_HEADROOM);
-    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
-
-    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
-    if (size <= 0) {
-        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
-                "ogs_recv() failed");
-        goto cleanup;
-    }
-
-    ogs_pkbuf_trim(pkbuf, size);
-
     ogs_assert(pkbuf);
     ogs_assert(pkbuf->len);
+    ogs_assert(from);
+
+    upf_metrics_dp_sample_begin(&sample);
 
     gtp_h = (ogs_gtp2_header_t *)pkbuf->data;
     if (gtp_h->version != OGS_GTP2_VERSION_1) {
@@ -314,24 +860,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         goto cleanup;
     }
     if (header_desc.type == OGS_GTPU_MSGTYPE_ECHO_REQ) {
-        ogs_pkbuf_t *echo_rsp;
-
-        ogs_info("[RECV] Echo Request from [%s]", OGS_ADDR(&from, buf1));
-        echo_rsp = ogs_gtp2_handle_echo_req(pkbuf);
-        ogs_expect(echo_rsp);
-        if (echo_rsp) {
-            ssize_t sent;
-
-            /* Echo reply */
-            ogs_info("[SEND] Echo Response to [%s]", OGS_ADDR(&from, buf1));
-
-            sent = ogs_sendto(fd, echo_rsp->data, echo_rsp->len, 0, &from);
-            if (sent < 0 || sent != echo_rsp->len) {
-                ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
-                        "ogs_sendto() failed");
-            }
-            ogs_pkbuf_free(echo_rsp);
-        }
+        handle_echo_req(sock, pkbuf, from);
         goto cleanup;
     }
     if (header_desc.type != OGS_GTPU_MSGTYPE_END_MARKER &&
@@ -343,7 +872,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     }
 
     ogs_trace("[RECV] GPU-U Type [%d] from [%s] : TEID[0x%x]",
-            header_desc.type, OGS_ADDR(&from, buf1), header_desc.teid);
+            header_desc.type, OGS_ADDR(from, buf1), header_desc.teid);
 
     /* Remove GTP header and send packets to TUN interface */
     ogs_assert(ogs_pkbuf_pull(pkbuf, len));
@@ -375,7 +904,6 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     } else if (header_desc.type == OGS_GTPU_MSGTYPE_GPDU) {
         uint16_t eth_type = 0;
         struct ip *ip_h = NULL;
-        uint32_t *src_addr = NULL;
         ogs_pfcp_object_t *pfcp_object = NULL;
         ogs_pfcp_sess_t *pfcp_sess = NULL;
         ogs_pfcp_pdr_t *pdr = NULL;
@@ -388,18 +916,11 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         ip_h = (struct ip *)pkbuf->data;
         ogs_assert(ip_h);
 
-        /*
-         * Issue #2210, Discussion #2208, #2209
-         *
-         * Metrics reduce data plane performance.
-         * It should not be used on the UPF/SGW-U data plane
-         * until this issue is resolved.
-         */
-#if 0
-        upf_metrics_inst_global_inc(UPF_METR_GLOB_CTR_GTP_INDATAPKTN3UPF);
-        upf_metrics_inst_by_qfi_add(header_desc.qos_flow_identifier,
+        upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_PARSE);
+
+        upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_INDATAPKTN3UPF, 1);
+        upf_metrics_dp_by_qfi_add(header_desc.qos_flow_identifier,
                 UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN3UPF, pkbuf->len);
-#endif
 
         pfcp_object = ogs_pfcp_object_find_by_teid(header_desc.teid);
         if (!pfcp_object) {
@@ -419,10 +940,10 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_error("[%s] Send Error Indication [TEID:0x%x] to [%s]",
                         OGS_ADDR(&sock->local_addr, buf1),
                         header_desc.teid,
-                        OGS_ADDR(&from, buf2));
+                        OGS_ADDR(from, buf2));
                 ogs_gtp1_send_error_indication(
                         sock, header_desc.teid,
-                        header_desc.qos_flow_identifier, &from);
+                        header_desc.qos_flow_identifier, from);
             }
             goto cleanup;
         }
@@ -438,41 +959,20 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
             pfcp_sess = (ogs_pfcp_sess_t *)pfcp_object;
             ogs_assert(pfcp_sess);
 
-            ogs_list_for_each(&pfcp_sess->pdr_list, pdr) {
-
-                /*
-                 * Originally, we checked the Source Interface
-                 * for packets received with a TEID.
-                 *
-                 * However, in the case of Home Routed Roaming,
-                 * packets arriving at the V-UPF from the Core
-                 * do not come through a TUN interface
-                 * but as standard GTP-U packets.
-                 *
-                 * Therefore, this code has been removed to support
-                 * the roaming functionality.
-                 */
-#if 0 /* <DEPRECATED> */
-                if (pdr->src_if != OGS_PFCP_INTERFACE_ACCESS &&
-                    pdr->src_if != OGS_PFCP_INTERFACE_CP_FUNCTION)
-                    continue;
-#endif
-
-                /* Check if TEID */
-                if (header_desc.teid != pdr->f_teid.teid)
-                    continue;
-
-                /* Check if QFI */
-                if (pdr->qfi && pdr->qfi != header_desc.qos_flow_identifier)
-                    continue;
-
-                /* Check if Rule List in PDR */
-                if (ogs_list_first(&pdr->rule_list) &&
-                    ogs_pfcp_pdr_rule_find_by_packet(pdr, pkbuf) == NULL)
-                    continue;
-
-                break;
-            }
+            /*
+             * Originally, we checked the Source Interface
+             * for packets received with a TEID.
+             *
+             * However, in the case of Home Routed Roaming,
+             * packets arriving at the V-UPF from the Core
+             * do not come through a TUN interface
+             * but as standard GTP-U packets.
+             *
+             * Therefore, PDRs are matched by TEID, QFI and SDF filter only
+             * to support the roaming functionality.
+             */
+            pdr = upf_sess_classify_uplink(UPF_SESS(pfcp_sess), pkbuf,
+                    header_desc.teid, header_desc.qos_flow_identifier);
 
             if (!pdr) {
                 /*
@@ -492,10 +992,10 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                             "[%s] Send Error Indication [TEID:0x%x] to [%s]",
                             OGS_ADDR(&sock->local_addr, buf1),
                             header_desc.teid,
-                            OGS_ADDR(&from, buf2));
+                            OGS_ADDR(from, buf2));
                     ogs_gtp1_send_error_indication(
                             sock, header_desc.teid,
-                            header_desc.qos_flow_identifier, &from);
+                            header_desc.qos_flow_identifier, from);
                 }
                 goto cleanup;
             }
@@ -516,6 +1016,8 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         far = pdr->far;
         ogs_assert(far);
 
+        upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_LOOKUP);
+
         /*
          * From Issue #1354
          *
@@ -599,106 +1101,30 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                  * information to perform the verification.
                  */
 
-            } else if (ip_h->ip_v == 4 && sess->ipv4) {
-                src_addr = (void *)&ip_h->ip_src.s_addr;
-                ogs_assert(src_addr);
-
-                if (src_addr[0] == sess->ipv4->addr[0]) {
-                    /* Source IP address should be matched in uplink */
-                } else if (check_framed_routes(sess, AF_INET, src_addr)) {
-                    /* Or source IP address should match a framed route */
-                } else {
-                    ogs_error("[DROP] Source IP-%d Spoofing APN:%s SrcIf:%d DstIf:%d TEID:0x%x",
-                                ip_h->ip_v, pdr->dnn, pdr->src_if, far->dst_if, header_desc.teid);
-                    ogs_error("       SRC:%08X, UE:%08X",
-                        be32toh(src_addr[0]), be32toh(sess->ipv4->addr[0]));
-                    ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
-
-                    goto cleanup;
-                }
-
-                subnet = sess->ipv4->subnet;
-                eth_type = ETHERTYPE_IP;
-
-            } else if (ip_h->ip_v == 6 && sess->ipv6) {
-                struct ip6_hdr *ip6_h = (struct ip6_hdr *)pkbuf->data;
-                ogs_assert(ip6_h);
-                src_addr = (void *)ip6_h->ip6_src.s6_addr;
-                ogs_assert(src_addr);
-
-    /*
-     * Discussion #1776 was raised,
-     * but we decided not to allow unspecified addresses
-     * because Open5GS has already sent interface identifiers
-     * in the registgration/attach process.
-     *
-     *
-     * RFC4861
-     * 4.  Message Formats
-     * 4.1.  Router Solicitation Message Format
-     * IP Fields:
-     *    Source Address
-     *                  An IP address assigned to the sending interface, or
-     *                  the unspecified address if no address is assigned
-     *                  to the sending interface.
-     *
-     * 6.1.  Message Validation
-     * 6.1.1.  Validation of Router Solicitation Messages
-     *  Hosts MUST silently discard any received Router Solicitation
-     *  Messages.
-     *
-     *  A router MUST silently discard any received Router Solicitation
-     *  messages that do not satisfy all of the following validity checks:
-     *
-     *  ..
-     *  ..
-     *
-     *  - If the IP source address is the unspecified address, there is no
-     *    source link-layer address option in the message.
-     */
-                if (IN6_IS_ADDR_LINKLOCAL((struct in6_addr *)src_addr) &&
-                    src_addr[2] == sess->ipv6->addr[2] &&
-                    src_addr[3] == sess->ipv6->addr[3]) {
-                    /*
-                     * if Link-local address,
-                     * Interface Identifier should be matched
-                     */
-                } else if (src_addr[0] == sess->ipv6->addr[0] &&
-                            src_addr[1] == sess->ipv6->addr[1]) {
-                    /*
-                     * If Global address
-                     * 64 bit prefix should be matched
-                     */
-                } else if (check_framed_routes(sess, AF_INET6, src_addr)) {
-                    /* Or source IP address should match a framed route */
-                } else {
-                    ogs_error("[DROP] Source IP-%d Spoofing APN:%s SrcIf:%d DstIf:%d TEID:0x%x",
-                                ip_h->ip_v, pdr->dnn, pdr->src_if, far->dst_if, header_desc.teid);
-                    ogs_error("SRC:%08x %08x %08x %08x",
-                            be32toh(src_addr[0]), be32toh(src_addr[1]),
-                            be32toh(src_addr[2]), be32toh(src_addr[3]));
-                    ogs_error("UE:%08x %08x %08x %08x",
-                            be32toh(sess->ipv6->addr[0]),
-                            be32toh(sess->ipv6->addr[1]),
-                            be32toh(sess->ipv6->addr[2]),
-                            be32toh(sess->ipv6->addr[3]));
-                    ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
-
+            } else {
+                eth_type = check_src_addr(pkbuf,
+                        sess->ipv4 ? sess->ipv4->addr : NULL,
+                        sess->ipv4_framed_routes,
+                        sess->ipv6 ? sess->ipv6->addr : NULL,
+                        sess->ipv6_framed_routes,
+                        pdr->dnn, pdr->src_if, far->dst_if,
+                        header_desc.teid);
+                if (!eth_type)
                     goto cleanup;
-                }
 
-                subnet = sess->ipv6->subnet;
-                eth_type = ETHERTYPE_IPV6;
-
-            } else {
-                ogs_error("Invalid packet [IP version:%d, Packet Length:%d]",
-                        ip_h->ip_v, pkbuf->len);
-                ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
-                goto cleanup;
+                if (eth_type == ETHERTYPE_IP)
+                    subnet = sess->ipv4->subnet;
+                else
+                    subnet = sess->ipv6->subnet;
             }
 
         }
 
+        if (!upf_meter_police(pdr->qer,
+                    upf_snapshot_qer_meter(sess, pdr->qer),
+                    pdr->src_if == OGS_PFCP_INTERFACE_ACCESS, pkbuf->len))
+            goto cleanup;
+
         if (far->dst_if == OGS_PFCP_INTERFACE_CORE &&
             far->dst_if_type_presence == true &&
             far->dst_if_type == OGS_PFCP_3GPP_INTERFACE_TYPE_N6) {
@@ -729,10 +1155,12 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_pkbuf_push(pkbuf, ETHER_ADDR_LEN);
                 memcpy(pkbuf->data, dev->mac_addr, ETHER_ADDR_LEN);
             }
+            upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_REWRITE);
 
             /* TODO: if destined to another UE, hairpin back out. */
-            if (ogs_tun_write(dev->fd, pkbuf) != OGS_OK)
-                ogs_warn("ogs_tun_write() failed");
+            tun_tx_write(dev->fd, pkbuf);
+            upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_SEND);
+            return;
 
         } else {
 
@@ -758,6 +1186,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
             ogs_assert(true == ogs_pfcp_up_handle_pdr(
                         pdr, header_desc.type, len, &header_desc,
                         pkbuf, &report));
+            upf_metrics_dp_sample_stage(&sample, UPF_METR_DP_STAGE_SEND);
 
 #if 0 /* <DEPRECATED> */
             if (far->dst_if == OGS_PFCP_INTERFACE_CP_FUNCTION) {
@@ -791,28 +1220,195 @@ cleanup:
     ogs_pkbuf_free(pkbuf);
 }
 
-int upf_gtp_init(void)
+static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
 {
-    ogs_pkbuf_config_t config;
-    memset(&config, 0, sizeof config);
+    char buf[OGS_ADDRSTRLEN];
+    upf_worker_t *worker = NULL;
+    ogs_sock_t *sock = NULL;
+    ogs_sockaddr_t from[OGS_MAX_NUM_OF_MMSG];
+    int i, n, num, sent;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    sock = data;
+    ogs_assert(sock);
 
-    config.cluster_2048_pool = ogs_app()->pool.gtpu;
+    num = upf_self()->batch.size;
+    ogs_assert(num >= 1 && num <= OGS_MAX_NUM_OF_MMSG);
 
-#if OGS_USE_TALLOC == 1
-    /* allocate a talloc pool for GTP to ensure it doesn't have to go back
-     * to the libc malloc all the time */
-    packet_pool = talloc_pool(__ogs_talloc_core, 1000*1024);
-    ogs_assert(packet_pool);
-#else
-    packet_pool = ogs_pkbuf_pool_create(&config);
-#endif
+    /*
+     * Receive buffers are kept across wakeups;
+     * only the ones handed to the data path are replaced.
+     */
+    for (i = 0; i < num; i++) {
+        if (rx_pkbuf[i])
+            continue;
+
+        rx_pkbuf[i] = ogs_pkbuf_cache_alloc(packet_cache);
+        ogs_assert(rx_pkbuf[i]);
+        ogs_pkbuf_reserve(rx_pkbuf[i], OGS_TUN_MAX_HEADROOM);
+        ogs_pkbuf_put(rx_pkbuf[i], OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
+    }
+
+    n = ogs_recvmmsg(fd, rx_pkbuf, from, num);
+    if (n <= 0) {
+        if (n == 0 || ogs_socket_errno != OGS_EAGAIN)
+            ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                    "ogs_recvmmsg() failed");
+        return;
+    }
+
+    ogs_gtp_tx_batch_begin();
+
+    worker = upf_worker_self();
+    if (worker)
+        upf_snapshot_sync(worker);
+
+    for (i = 0; i < n; i++) {
+        ogs_pkbuf_t *pkbuf = rx_pkbuf[i];
+        rx_pkbuf[i] = NULL;
+
+        if (!pkbuf->len) {
+            ogs_error("[DROP] Empty GTPU packet from [%s]",
+                    OGS_ADDR(&from[i], buf));
+            ogs_pkbuf_free(pkbuf);
+            continue;
+        }
+
+        if (worker)
+            _gtpv1_u_worker_handle(worker, sock, pkbuf, &from[i]);
+        else
+            _gtpv1_u_handle(sock, pkbuf, &from[i]);
+    }
+
+    sent = ogs_gtp_tx_batch_end();
+    tun_tx_flush();
+
+    if (num > 1) {
+        upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_RXBATCH, 1);
+        upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_RXBATCHPKT, n);
+        if (sent) {
+            upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_TXBATCH, 1);
+            upf_metrics_dp_global_add(UPF_METR_GLOB_CTR_GTP_TXBATCHPKT, sent);
+        }
+    }
+}
+
+int upf_gtp_init(void)
+{
+    /*
+     * G-PDUs and TUN packets are allocated from a slab of fixed-size
+     * buffers with a per-thread magazine, so the data plane does not go
+     * through the memory allocator and its lock for every packet.
+     */
+    packet_cache = ogs_pkbuf_cache_create(
+            OGS_MAX_PKT_LEN, ogs_app()->pool.gtpu);
+    ogs_assert(packet_cache);
 
     return OGS_OK;
 }
 
 void upf_gtp_final(void)
 {
-    ogs_pkbuf_pool_destroy(packet_pool);
+    ogs_pkbuf_cache_destroy(packet_cache);
+    packet_cache = NULL;
+}
+
+static void data_plane_stat_cb(void *data)
+{
+    static uint64_t exhausted = 0;
+    ogs_pkbuf_cache_stat_t stat;
+
+    ogs_pkbuf_cache_stat(packet_cache, &stat);
+
+    upf_metrics_inst_global_set(
+            UPF_METR_GLOB_GAUGE_PKBUF_INUSE, stat.in_use);
+    upf_metrics_inst_global_set(
+            UPF_METR_GLOB_GAUGE_PKBUF_HIGHWATER, stat.high_water);
+    if (stat.exhausted != exhausted) {
+        upf_metrics_inst_global_add(UPF_METR_GLOB_CTR_PKBUF_EXHAUSTED,
+                (int)(stat.exhausted - exhausted));
+        exhausted = stat.exhausted;
+    }
+
+    ogs_timer_start(t_data_plane_stat, UPF_DATA_PLANE_STAT_INTERVAL);
+}
+
+void upf_gtp_thread_init(void)
+{
+    upf_worker_t *worker = upf_worker_self();
+
+    upf_metrics_dp_thread_init(worker ? worker->index + 1 : 0);
+
+    ogs_gtp_tx_batch_init(upf_self()->batch.size, upf_self()->batch.gso);
+}
+
+void upf_gtp_thread_final(void)
+{
+    int i;
+
+    for (i = 0; i < OGS_MAX_NUM_OF_MMSG; i++) {
+        if (rx_pkbuf[i]) {
+            ogs_pkbuf_free(rx_pkbuf[i]);
+            rx_pkbuf[i] = NULL;
+        }
+    }
+
+    tun_tx_flush();
+
+    ogs_gtp_tx_batch_final();
+
+    ogs_pkbuf_cache_flush();
+}
+
+void upf_gtp_drain(void)
+{
+    upf_worker_message_t message;
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_urr_t *urr = NULL;
+    int i, n;
+
+    for (i = 0; i < upf_self()->worker.num; i++) {
+        upf_worker_t *worker = upf_worker_at(i);
+
+        if (__atomic_exchange_n(
+                    &worker->notified, false, __ATOMIC_SEQ_CST) == false)
+            continue;
+
+        ogs_gtp_tx_batch_begin();
+
+        for (n = 0; n <= worker->ring.mask; n++) {
+            if (upf_worker_pop(worker, &message) == false)
+                break;
+
+            switch (message.type) {
+            case UPF_WORKER_GTPU:
+                _gtpv1_u_handle(message.sock, message.pkbuf, &message.from);
+                break;
+            case UPF_WORKER_TUN:
+                _gtpv1_tun_handle(message.fd, false, message.pkbuf);
+                break;
+            case UPF_WORKER_URR_REPORT:
+                sess = upf_sess_find_by_id(message.sess_id);
+                if (!sess)
+                    break;
+                urr = ogs_pfcp_urr_find(&sess->pfcp, message.urr_id);
+                if (urr)
+                    upf_sess_urr_acc_check(sess, urr);
+                break;
+            default:
+                ogs_fatal("Unknown type [%d]", message.type);
+                ogs_assert_if_reached();
+            }
+        }
+
+        ogs_gtp_tx_batch_end();
+
+        if (n > worker->ring.mask) {
+            /* The rest after the PFCP messages */
+            __atomic_store_n(&worker->notified, true, __ATOMIC_SEQ_CST);
+            ogs_pollset_notify(ogs_app()->pollset);
+        }
+    }
 }
 
 static void _get_dev_mac_addr(char *ifname, uint8_t *mac_addr)
@@ -841,15 +1437,101 @@ static void _get_dev_mac_addr(char *ifname, uint8_t *mac_addr)
 #endif
 }
 
+static ogs_poll_t *tun_poll_add(
+        ogs_pollset_t *pollset, ogs_pfcp_dev_t *dev, ogs_socket_t fd)
+{
+    if (upf_self()->batch.size > 1) {
+        /* The TUN device is drained until EAGAIN */
+        ogs_assert(ogs_nonblocking(fd) == OGS_OK);
+    }
+
+    return ogs_pollset_add(pollset, OGS_POLLIN, fd,
+            dev->is_tap ? _gtpv1_tun_recv_eth_cb : _gtpv1_tun_recv_cb, NULL);
+}
+
+static int upf_gtp_open_worker(void)
+{
+    ogs_pfcp_dev_t *dev = NULL;
+    ogs_socknode_t *node = NULL, *wnode = NULL;
+    ogs_sock_t *sock = NULL;
+    upf_worker_t *worker = NULL;
+    int i;
+
+    /*
+     * Worker#0 polls the GTP-U sockets and TUN devices
+     * opened by upf_gtp_open(). Others get their own sockets
+     * in the same SO_REUSEPORT group and their own TUN queues.
+     */
+    for (i = 1; i < upf_self()->worker.num; i++) {
+        worker = upf_worker_at(i);
+
+        ogs_list_for_each(&ogs_gtp_self()->gtpu_list, node) {
+            wnode = ogs_socknode_add(&worker->gtpu_list,
+                    AF_UNSPEC, node->addr, node->option);
+            ogs_assert(wnode);
+
+            sock = ogs_gtp_server(wnode);
+            if (!sock) return OGS_ERROR;
+
+            wnode->poll = ogs_pollset_add(worker->pollset,
+                    OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, sock);
+            ogs_assert(wnode->poll);
+        }
+
+        ogs_list_for_each(&ogs_pfcp_self()->dev_list, dev) {
+            ogs_socket_t fd = ogs_tun_open_queue(
+                    dev->ifname, OGS_MAX_IFNAME_LEN, dev->is_tap);
+            if (fd == INVALID_SOCKET) {
+                ogs_warn("No TUN queue for worker#%d (dev:%s), "
+                        "create it with 'multi_queue'", i, dev->ifname);
+                continue;
+            }
+
+            ogs_assert(worker->num_of_tun < OGS_MAX_NUM_OF_DEV);
+            worker->tun[worker->num_of_tun].fd = fd;
+            worker->tun[worker->num_of_tun].poll =
+                tun_poll_add(worker->pollset, dev, fd);
+            ogs_assert(worker->tun[worker->num_of_tun].poll);
+            worker->num_of_tun++;
+        }
+    }
+
+    ogs_list_for_each(&ogs_gtp_self()->gtpu_list, node) {
+        ogs_assert(node->sock);
+        if (upf_worker_steer_by_teid(
+                    node->sock, upf_self()->worker.num) != OGS_OK)
+            ogs_warn("GTP-U is not steered by TEID, "
+                    "the kernel distributes it by flow hash");
+    }
+
+    return OGS_OK;
+}
+
 int upf_gtp_open(void)
 {
     ogs_pfcp_dev_t *dev = NULL;
     ogs_pfcp_subnet_t *subnet = NULL;
     ogs_socknode_t *node = NULL;
     ogs_sock_t *sock = NULL;
+    ogs_pollset_t *pollset = NULL;
     int rc;
 
+    if (upf_self()->worker.num)
+        pollset = upf_worker_at(0)->pollset;
+    else
+        pollset = ogs_app()->pollset;
+
     ogs_list_for_each(&ogs_gtp_self()->gtpu_list, node) {
+        if (upf_self()->worker.num > 1) {
+            if (!node->option) {
+                ogs_sockopt_t option;
+                ogs_sockopt_init(&option);
+                node->option = ogs_memdup(&option, sizeof option);
+                ogs_assert(node->option);
+            }
+            node->option->so_reuseport = true;
+        }
+
         sock = ogs_gtp_server(node);
         if (!sock) return OGS_ERROR;
 
@@ -858,7 +1540,7 @@ int upf_gtp_open(void)
         else if (sock->family == AF_INET6)
             ogs_gtp_self()->gtpu_sock6 = sock;
 
-        node->poll = ogs_pollset_add(ogs_app()->pollset,
+        node->poll = ogs_pollset_add(pollset,
                 OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, sock);
         ogs_assert(node->poll);
     }
@@ -879,26 +1561,35 @@ int upf_gtp_open(void)
     /* Open Tun interface */
     ogs_list_for_each(&ogs_pfcp_self()->dev_list, dev) {
         dev->is_tap = strstr(dev->ifname, "tap");
-        dev->fd = ogs_tun_open(dev->ifname, OGS_MAX_IFNAME_LEN, dev->is_tap);
+        dev->fd = INVALID_SOCKET;
+        if (upf_self()->worker.num > 1)
+            dev->fd = ogs_tun_open_queue(
+                    dev->ifname, OGS_MAX_IFNAME_LEN, dev->is_tap);
+        if (dev->fd == INVALID_SOCKET)
+            dev->fd = ogs_tun_open(
+                    dev->ifname, OGS_MAX_IFNAME_LEN, dev->is_tap);
         if (dev->fd == INVALID_SOCKET) {
             ogs_error("tun_open(dev:%s) failed", dev->ifname);
             return OGS_ERROR;
         }
 
-        if (dev->is_tap) {
+        if (dev->is_tap)
             _get_dev_mac_addr(dev->ifname, dev->mac_addr);
-            dev->poll = ogs_pollset_add(ogs_app()->pollset,
-                    OGS_POLLIN, dev->fd, _gtpv1_tun_recv_eth_cb, NULL);
-            ogs_assert(dev->poll);
-        } else {
-            dev->poll = ogs_pollset_add(ogs_app()->pollset,
-                    OGS_POLLIN, dev->fd, _gtpv1_tun_recv_cb, NULL);
-            ogs_assert(dev->poll);
-        }
 
+        dev->poll = tun_poll_add(pollset, dev, dev->fd);
         ogs_assert(dev->poll);
     }
 
+    if (upf_self()->worker.num > 1) {
+        rc = upf_gtp_open_worker();
+        if (rc != OGS_OK) return rc;
+    }
+
+    t_data_plane_stat = ogs_timer_add(
+            ogs_app()->timer_mgr, data_plane_stat_cb, NULL);
+    ogs_assert(t_data_plane_stat);
+    ogs_timer_start(t_data_plane_stat, UPF_DATA_PLANE_STAT_INTERVAL);
+
     /*
      * On Linux, it is possible to create a persistent tun/tap
      * interface which will continue to exist even if open5gs quit,
@@ -925,6 +1616,25 @@ int upf_gtp_open(void)
 void upf_gtp_close(void)
 {
     ogs_pfcp_dev_t *dev = NULL;
+    int i, j;
+
+    if (t_data_plane_stat) {
+        ogs_timer_delete(t_data_plane_stat);
+        t_data_plane_stat = NULL;
+    }
+
+    for (i = 1; i < upf_self()->worker.num; i++) {
+        upf_worker_t *worker = upf_worker_at(i);
+
+        ogs_socknode_remove_all(&worker->gtpu_list);
+
+        for (j = 0; j < worker->num_of_tun; j++) {
+            if (worker->tun[j].poll)
+                ogs_pollset_remove(worker->tun[j].poll);
+            ogs_closesocket(worker->tun[j].fd);
+        }
+        worker->num_of_tun = 0;
+    }
 
     ogs_socknode_remove_all(&ogs_gtp_self()->gtpu_list);
 
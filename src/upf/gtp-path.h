@@ -33,6 +33,11 @@ void upf_gtp_final(void);
 int upf_gtp_open(void);
 void upf_gtp_close(void);
 
+void upf_gtp_thread_init(void);
+void upf_gtp_thread_final(void);
+
+void upf_gtp_drain(void);
+
 #ifdef __cplusplus
 }
 #endif
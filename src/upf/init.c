@@ -21,6 +21,8 @@
 #include "gtp-path.h"
 #include "pfcp-path.h"
 #include "metrics.h"
+#include "worker.h"
+#include "snapshot.h"
 
 static ogs_thread_t *thread;
 static void upf_main(void *data);
@@ -63,6 +65,10 @@ int upf_initialize(void)
     rv = upf_context_parse_config();
     if (rv != OGS_OK) return rv;
 
+    rv = upf_metrics_dp_init(
+            upf_self()->worker.num + 1, upf_self()->profile.sample);
+    if (rv != OGS_OK) return rv;
+
     rv = ogs_pfcp_ue_pool_generate();
     if (rv != OGS_OK) return rv;
 
@@ -71,9 +77,15 @@ int upf_initialize(void)
     rv = upf_pfcp_open();
     if (rv != OGS_OK) return rv;
 
+    rv = upf_worker_init();
+    if (rv != OGS_OK) return rv;
+
     rv = upf_gtp_open();
     if (rv != OGS_OK) return rv;
 
+    rv = upf_worker_start();
+    if (rv != OGS_OK) return rv;
+
     thread = ogs_thread_create(upf_main, NULL);
     if (!thread) return OGS_ERROR;
 
@@ -90,6 +102,8 @@ void upf_terminate(void)
 
     ogs_thread_destroy(thread);
 
+    upf_worker_stop();
+
     upf_pfcp_close();
     upf_gtp_close();
 
@@ -103,8 +117,10 @@ void upf_terminate(void)
     ogs_pfcp_xact_final();
 
     upf_gtp_final();
+    upf_worker_final();
     upf_event_final();
 
+    upf_metrics_dp_final();
     upf_metrics_final();
 }
 
@@ -113,6 +129,8 @@ static void upf_main(void *data)
     ogs_fsm_t upf_sm;
     int rv;
 
+    upf_gtp_thread_init();
+
     ogs_fsm_init(&upf_sm, upf_state_initial, upf_state_final, 0);
 
     for ( ;; ) {
@@ -132,6 +150,10 @@ static void upf_main(void *data)
          */
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
+        /* Packets and reports passed by the data plane workers */
+        upf_gtp_drain();
+        upf_snapshot_reclaim();
+
         for ( ;; ) {
             upf_event_t *e = NULL;
 
@@ -152,4 +174,6 @@ static void upf_main(void *data)
 done:
 
     ogs_fsm_fini(&upf_sm, 0);
+
+    upf_gtp_thread_final();
 }
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "meter.h"
+#include "metrics.h"
+
+#define UPF_METER_UPLINK 0
+#define UPF_METER_DOWNLINK 1
+
+bool upf_meter_police(ogs_pfcp_qer_t *qer, ogs_pfcp_meter_t *meter,
+        bool uplink, size_t size)
+{
+    int dir = uplink ? UPF_METER_UPLINK : UPF_METER_DOWNLINK;
+    uint8_t gate;
+    uint64_t rate;
+
+    if (!qer)
+        return true;
+
+    ogs_assert(meter);
+
+    gate = uplink ? qer->gate_status.uplink : qer->gate_status.downlink;
+    if (gate != OGS_PFCP_GATE_OPEN)
+        goto drop;
+
+    rate = (uplink ? qer->mbr.uplink : qer->mbr.downlink) / 8;
+    if (rate && !ogs_pfcp_meter_conform(&meter[dir], rate, size))
+        goto drop;
+
+    upf_metrics_dp_by_qfi_add(qer->qfi,
+            UPF_METR_CTR_QER_CONFORMEDVOLUME, size);
+    return true;
+
+drop:
+    upf_metrics_dp_by_qfi_add(qer->qfi,
+            UPF_METR_CTR_QER_DROPPEDVOLUME, size);
+    return false;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPF_METER_H
+#define UPF_METER_H
+
+#include "context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * QER policing
+ *
+ * A packet is dropped if the gate of its direction is closed,
+ * or if it exceeds the MBR of the QER. The MBR is enforced with
+ * a token bucket refilled from the time elapsed since the last packet,
+ * so there is no timer (see ogs_pfcp_meter_conform()).
+ *
+ * 'meter' holds the buckets (Uplink, Downlink) of the QER: qer->meter
+ * without data plane workers, the one shared by all the threads
+ * in its snapshot otherwise (see snapshot.h).
+ *
+ * The GBR is not policed. It is a guarantee, not a limit.
+ */
+bool upf_meter_police(ogs_pfcp_qer_t *qer, ogs_pfcp_meter_t *meter,
+        bool uplink, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_METER_H */
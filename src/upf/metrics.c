@@ -76,6 +76,47 @@ upf_metrics_spec_def_t upf_metrics_spec_def_global[_UPF_METR_GLOB_MAX] = {
     .name = "fivegs_upffunction_sm_n4sessionreportsucc",
     .description = "Number of successful N4 session reports",
 },
+[UPF_METR_GLOB_CTR_GTP_RXBATCH] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_gtpu_rx_batches",
+    .description = "Number of batched GTP-U receive wakeups",
+},
+[UPF_METR_GLOB_CTR_GTP_RXBATCHPKT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_gtpu_rx_batch_packets",
+    .description = "Number of GTP-U packets received in batches",
+},
+[UPF_METR_GLOB_CTR_GTP_TXBATCH] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_gtpu_tx_batches",
+    .description = "Number of batched GTP-U transmit flushes",
+},
+[UPF_METR_GLOB_CTR_GTP_TXBATCHPKT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_gtpu_tx_batch_packets",
+    .description = "Number of GTP-U packets transmitted in batches",
+},
+[UPF_METR_GLOB_CTR_TUN_RXBATCH] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_tun_rx_batches",
+    .description = "Number of batched TUN receive wakeups",
+},
+[UPF_METR_GLOB_CTR_TUN_RXBATCHPKT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_tun_rx_batch_packets",
+    .description = "Number of TUN packets received in batches",
+},
+[UPF_METR_GLOB_CTR_PKBUF_EXHAUSTED] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_pkbuf_cache_exhausted",
+    .description = "Number of packet buffers allocated outside the cache",
+},
+[UPF_METR_GLOB_CTR_WORKER_PUNTDROP] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "upf_worker_punt_dropped",
+    .description = "Number of packets dropped by the data plane workers "
+        "because the main thread was busy",
+},
 /* Global Gauges: */
 [UPF_METR_GLOB_GAUGE_UPF_SESSIONNBR] = {
     .type = OGS_METRICS_METRIC_TYPE_GAUGE,
@@ -87,6 +128,16 @@ upf_metrics_spec_def_t upf_metrics_spec_def_global[_UPF_METR_GLOB_MAX] = {
     .name = "pfcp_peers_active",
     .description = "Active PFCP peers",
 },
+[UPF_METR_GLOB_GAUGE_PKBUF_INUSE] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "upf_pkbuf_cache_inuse",
+    .description = "Packet buffers taken from the cache",
+},
+[UPF_METR_GLOB_GAUGE_PKBUF_HIGHWATER] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "upf_pkbuf_cache_highwater",
+    .description = "Highest number of packet buffers taken from the cache",
+},
 };
 int upf_metrics_init_inst_global(void)
 {
@@ -122,6 +173,14 @@ UPF_METR_BY_QFI_CTR_ENTRY(
     UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF,
     "fivegs_ep_n3_gtp_outdatavolumeqosleveln3upf",
     "Data volume of outgoing GTP data packets per QoS level on the N3 interface")
+UPF_METR_BY_QFI_CTR_ENTRY(
+    UPF_METR_CTR_QER_CONFORMEDVOLUME,
+    "upf_qer_conformed_bytes",
+    "Data volume of packets within the gate status and MBR of their QER")
+UPF_METR_BY_QFI_CTR_ENTRY(
+    UPF_METR_CTR_QER_DROPPEDVOLUME,
+    "upf_qer_dropped_bytes",
+    "Data volume of packets dropped by the gate status or MBR of their QER")
 };
 void upf_metrics_init_by_qfi(void);
 int upf_metrics_free_inst_by_qfi(ogs_metrics_inst_t **inst);
@@ -321,6 +380,258 @@ int upf_metrics_free_inst_by_dnn(ogs_metrics_inst_t **inst)
     return upf_metrics_free_inst(inst, _UPF_METR_BY_DNN_MAX);
 }
 
+/* DATA PLANE */
+OGS_THREAD_LOCAL upf_metrics_dp_t *upf_metrics_dp_local = NULL;
+
+static void *dp_mem = NULL;
+static upf_metrics_dp_t *dp_array[UPF_MAX_NUM_OF_WORKER+1];
+static int num_of_dp = 0;
+static upf_metrics_dp_t dp_published;
+
+const char *labels_stage[] = {
+    "stage"
+};
+const char *labels_stage_le[] = {
+    "stage", "le"
+};
+static const char *dp_stage_name[_UPF_METR_DP_STAGE_MAX] = {
+    [UPF_METR_DP_STAGE_PARSE] = "parse",
+    [UPF_METR_DP_STAGE_LOOKUP] = "lookup",
+    [UPF_METR_DP_STAGE_REWRITE] = "rewrite",
+    [UPF_METR_DP_STAGE_SEND] = "send",
+};
+static ogs_metrics_spec_t *dp_spec_bucket, *dp_spec_sum, *dp_spec_count;
+static ogs_metrics_inst_t *dp_inst_bucket
+    [_UPF_METR_DP_STAGE_MAX][UPF_METR_DP_HIST_BUCKETS+1];
+static ogs_metrics_inst_t *dp_inst_sum[_UPF_METR_DP_STAGE_MAX];
+static ogs_metrics_inst_t *dp_inst_count[_UPF_METR_DP_STAGE_MAX];
+
+static void upf_metrics_dp_collect(void);
+
+int upf_metrics_dp_init(int num_of_thread, int sample_rate)
+{
+    size_t stride;
+    uintptr_t base;
+    int i, j;
+
+    ogs_assert(num_of_thread > 0 &&
+            num_of_thread <= OGS_ARRAY_SIZE(dp_array));
+
+    /* One block per thread, each starting on its own cache line */
+    stride = (sizeof(upf_metrics_dp_t) + 63) & ~(size_t)63;
+    dp_mem = ogs_calloc(1, stride * num_of_thread + 64);
+    if (!dp_mem) {
+        ogs_error("ogs_calloc() failed");
+        return OGS_ERROR;
+    }
+    base = ((uintptr_t)dp_mem + 63) & ~(uintptr_t)63;
+
+    for (i = 0; i < num_of_thread; i++) {
+        dp_array[i] = (upf_metrics_dp_t *)(base + stride * i);
+        dp_array[i]->sample_rate = sample_rate;
+        dp_array[i]->sample_countdown = sample_rate;
+    }
+    num_of_dp = num_of_thread;
+    memset(&dp_published, 0, sizeof(dp_published));
+
+    if (sample_rate) {
+        ogs_metrics_context_t *ctx = ogs_metrics_self();
+
+        dp_spec_bucket = ogs_metrics_spec_new(ctx,
+                OGS_METRICS_METRIC_TYPE_COUNTER,
+                "upf_dp_stage_cycles_bucket",
+                "Sampled packets by CPU cycles spent in a data plane stage",
+                0, OGS_ARRAY_SIZE(labels_stage_le), labels_stage_le, NULL);
+        dp_spec_sum = ogs_metrics_spec_new(ctx,
+                OGS_METRICS_METRIC_TYPE_COUNTER,
+                "upf_dp_stage_cycles_sum",
+                "CPU cycles spent in a data plane stage by sampled packets",
+                0, OGS_ARRAY_SIZE(labels_stage), labels_stage, NULL);
+        dp_spec_count = ogs_metrics_spec_new(ctx,
+                OGS_METRICS_METRIC_TYPE_COUNTER,
+                "upf_dp_stage_cycles_count",
+                "Sampled packets per data plane stage",
+                0, OGS_ARRAY_SIZE(labels_stage), labels_stage, NULL);
+
+        for (i = 0; i < _UPF_METR_DP_STAGE_MAX; i++) {
+            for (j = 0; j <= UPF_METR_DP_HIST_BUCKETS; j++) {
+                char le[24];
+
+                if (j == UPF_METR_DP_HIST_BUCKETS)
+                    ogs_snprintf(le, sizeof(le), "+Inf");
+                else
+                    ogs_snprintf(le, sizeof(le), "%llu",
+                        1ULL << (UPF_METR_DP_HIST_MIN_SHIFT + j));
+
+                dp_inst_bucket[i][j] = ogs_metrics_inst_new(dp_spec_bucket,
+                        2, (const char *[]){ dp_stage_name[i], le });
+            }
+            dp_inst_sum[i] = ogs_metrics_inst_new(dp_spec_sum,
+                    1, (const char *[]){ dp_stage_name[i] });
+            dp_inst_count[i] = ogs_metrics_inst_new(dp_spec_count,
+                    1, (const char *[]){ dp_stage_name[i] });
+        }
+    }
+
+    ogs_metrics_register_collector(upf_metrics_dp_collect);
+
+    return OGS_OK;
+}
+
+void upf_metrics_dp_final(void)
+{
+    ogs_metrics_register_collector(NULL);
+
+    /* Specs and instances are free'd by ogs_metrics_context_final() */
+    dp_spec_bucket = dp_spec_sum = dp_spec_count = NULL;
+    memset(dp_inst_bucket, 0, sizeof(dp_inst_bucket));
+    memset(dp_inst_sum, 0, sizeof(dp_inst_sum));
+    memset(dp_inst_count, 0, sizeof(dp_inst_count));
+
+    if (dp_mem)
+        ogs_free(dp_mem);
+    dp_mem = NULL;
+
+    memset(dp_array, 0, sizeof(dp_array));
+    num_of_dp = 0;
+}
+
+void upf_metrics_dp_thread_init(int index)
+{
+    ogs_assert(index >= 0 && index < num_of_dp);
+    upf_metrics_dp_local = dp_array[index];
+}
+
+uint64_t upf_metrics_dp_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t cycles;
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (cycles));
+    return cycles;
+#else
+    return ogs_get_monotonic_time();
+#endif
+}
+
+void upf_metrics_dp_sample_record(
+        upf_metrics_dp_sample_t *sample, upf_metric_dp_stage_t stage)
+{
+    upf_metrics_dp_t *dp = upf_metrics_dp_local;
+    uint64_t now, cycles, v;
+    int k = 0;
+
+    ogs_assert(dp);
+    ogs_assert(stage < _UPF_METR_DP_STAGE_MAX);
+
+    now = upf_metrics_dp_cycles();
+    cycles = now - sample->cycles;
+    sample->cycles = now;
+
+    /* Bucket k : cycles <= 2^(UPF_METR_DP_HIST_MIN_SHIFT+k) */
+    if (cycles > (1ULL << UPF_METR_DP_HIST_MIN_SHIFT)) {
+        v = (cycles - 1) >> UPF_METR_DP_HIST_MIN_SHIFT;
+        while (v && k < UPF_METR_DP_HIST_BUCKETS) {
+            k++;
+            v >>= 1;
+        }
+    }
+
+    dp->stage[stage].bucket[k]++;
+    dp->stage[stage].sum += cycles;
+    dp->stage[stage].count++;
+}
+
+static void dp_publish(ogs_metrics_inst_t *inst,
+        uint64_t *published, uint64_t total)
+{
+    uint64_t delta = total - *published;
+
+    while (delta) {
+        int val = (int)ogs_min(delta, INT32_MAX);
+
+        ogs_metrics_inst_add(inst, val);
+        delta -= val;
+    }
+    *published = total;
+}
+
+static void dp_publish_by_qfi(uint8_t qfi, upf_metric_type_by_qfi_t t,
+        uint64_t *published, uint64_t total)
+{
+    uint64_t delta = total - *published;
+
+    while (delta) {
+        int val = (int)ogs_min(delta, INT32_MAX);
+
+        upf_metrics_inst_by_qfi_add(qfi, t, val);
+        delta -= val;
+    }
+    *published = total;
+}
+
+/*
+ * Called by the metrics server before rendering.
+ * The blocks are read without a lock, so a counter may miss
+ * the packets being handled right now. They show up at the next scrape.
+ */
+static void upf_metrics_dp_collect(void)
+{
+    upf_metrics_dp_t total;
+    uint64_t cumulative;
+    int n, i, j;
+
+    memset(&total, 0, sizeof(total));
+
+    for (n = 0; n < num_of_dp; n++) {
+        volatile upf_metrics_dp_t *dp = dp_array[n];
+
+        for (i = 0; i < _UPF_METR_GLOB_MAX; i++)
+            total.global[i] += dp->global[i];
+        for (i = 0; i < _UPF_METR_BY_QFI_MAX; i++)
+            for (j = 0; j <= OGS_MAX_QOS_FLOW_ID; j++)
+                total.by_qfi[i][j] += dp->by_qfi[i][j];
+        for (i = 0; i < _UPF_METR_DP_STAGE_MAX; i++) {
+            for (j = 0; j <= UPF_METR_DP_HIST_BUCKETS; j++)
+                total.stage[i].bucket[j] += dp->stage[i].bucket[j];
+            total.stage[i].sum += dp->stage[i].sum;
+            total.stage[i].count += dp->stage[i].count;
+        }
+    }
+
+    for (i = 0; i < _UPF_METR_GLOB_MAX; i++) {
+        if (total.global[i] != dp_published.global[i])
+            dp_publish(upf_metrics_inst_global[i],
+                    &dp_published.global[i], total.global[i]);
+    }
+    for (i = 0; i < _UPF_METR_BY_QFI_MAX; i++) {
+        for (j = 0; j <= OGS_MAX_QOS_FLOW_ID; j++) {
+            if (total.by_qfi[i][j] != dp_published.by_qfi[i][j])
+                dp_publish_by_qfi(j, i,
+                        &dp_published.by_qfi[i][j], total.by_qfi[i][j]);
+        }
+    }
+
+    if (!dp_spec_bucket)
+        return;
+
+    for (i = 0; i < _UPF_METR_DP_STAGE_MAX; i++) {
+        /* Prometheus buckets are cumulative */
+        cumulative = 0;
+        for (j = 0; j <= UPF_METR_DP_HIST_BUCKETS; j++) {
+            cumulative += total.stage[i].bucket[j];
+            total.stage[i].bucket[j] = cumulative;
+            dp_publish(dp_inst_bucket[i][j],
+                    &dp_published.stage[i].bucket[j], cumulative);
+        }
+        dp_publish(dp_inst_sum[i],
+                &dp_published.stage[i].sum, total.stage[i].sum);
+        dp_publish(dp_inst_count[i],
+                &dp_published.stage[i].count, total.stage[i].count);
+    }
+}
+
 void upf_metrics_init(void)
 {
     ogs_metrics_context_t *ctx = ogs_metrics_self();
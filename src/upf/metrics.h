@@ -14,8 +14,18 @@ typedef enum upf_metric_type_global_s {
     UPF_METR_GLOB_CTR_SM_N4SESSIONESTABREQ,
     UPF_METR_GLOB_CTR_SM_N4SESSIONREPORT,
     UPF_METR_GLOB_CTR_SM_N4SESSIONREPORTSUCC,
+    UPF_METR_GLOB_CTR_GTP_RXBATCH,
+    UPF_METR_GLOB_CTR_GTP_RXBATCHPKT,
+    UPF_METR_GLOB_CTR_GTP_TXBATCH,
+    UPF_METR_GLOB_CTR_GTP_TXBATCHPKT,
+    UPF_METR_GLOB_CTR_TUN_RXBATCH,
+    UPF_METR_GLOB_CTR_TUN_RXBATCHPKT,
+    UPF_METR_GLOB_CTR_PKBUF_EXHAUSTED,
+    UPF_METR_GLOB_CTR_WORKER_PUNTDROP,
     UPF_METR_GLOB_GAUGE_UPF_SESSIONNBR,
     UPF_METR_GLOB_GAUGE_PFCP_PEERS_ACTIVE,
+    UPF_METR_GLOB_GAUGE_PKBUF_INUSE,
+    UPF_METR_GLOB_GAUGE_PKBUF_HIGHWATER,
     _UPF_METR_GLOB_MAX,
 } upf_metric_type_global_t;
 extern ogs_metrics_inst_t *upf_metrics_inst_global[_UPF_METR_GLOB_MAX];
@@ -36,6 +46,8 @@ static inline void upf_metrics_inst_global_dec(upf_metric_type_global_t t)
 typedef enum upf_metric_type_by_qfi_s {
     UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN3UPF = 0,
     UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF,
+    UPF_METR_CTR_QER_CONFORMEDVOLUME,
+    UPF_METR_CTR_QER_DROPPEDVOLUME,
     _UPF_METR_BY_QFI_MAX,
 } upf_metric_type_by_qfi_t;
 
@@ -60,6 +72,90 @@ typedef enum upf_metric_type_by_dnn_s {
 void upf_metrics_inst_by_dnn_add(
     char *dnn, upf_metric_type_by_dnn_t t, int val);
 
+/*
+ * DATA PLANE
+ *
+ * Each data plane thread counts into its own cache-line aligned block
+ * with plain additions. The blocks are summed and published only when
+ * the metrics are scraped, so the forwarding path never takes a lock
+ * or touches a shared cache line.
+ *
+ * With upf.profile.sample: N (> 0), one packet in N also records
+ * the cycles spent in each stage into log2 histograms.
+ */
+typedef enum upf_metric_dp_stage_s {
+    UPF_METR_DP_STAGE_PARSE = 0,
+    UPF_METR_DP_STAGE_LOOKUP,
+    UPF_METR_DP_STAGE_REWRITE,
+    UPF_METR_DP_STAGE_SEND,
+    _UPF_METR_DP_STAGE_MAX,
+} upf_metric_dp_stage_t;
+
+#define UPF_METR_DP_HIST_MIN_SHIFT  5   /* First bucket : le 32 cycles */
+#define UPF_METR_DP_HIST_BUCKETS    16  /* Last bucket : le 2^20, then +Inf */
+
+typedef struct upf_metrics_dp_s {
+    uint64_t global[_UPF_METR_GLOB_MAX];
+    uint64_t by_qfi[_UPF_METR_BY_QFI_MAX][OGS_MAX_QOS_FLOW_ID+1];
+
+    struct {
+        uint64_t bucket[UPF_METR_DP_HIST_BUCKETS+1];
+        uint64_t sum;
+        uint64_t count;
+    } stage[_UPF_METR_DP_STAGE_MAX];
+
+    int sample_rate;        /* 0 : disabled */
+    int sample_countdown;
+} upf_metrics_dp_t;
+
+typedef struct upf_metrics_dp_sample_s {
+    bool on;
+    uint64_t cycles;
+} upf_metrics_dp_sample_t;
+
+extern OGS_THREAD_LOCAL upf_metrics_dp_t *upf_metrics_dp_local;
+
+int upf_metrics_dp_init(int num_of_thread, int sample_rate);
+void upf_metrics_dp_final(void);
+void upf_metrics_dp_thread_init(int index);
+
+uint64_t upf_metrics_dp_cycles(void);
+void upf_metrics_dp_sample_record(
+        upf_metrics_dp_sample_t *sample, upf_metric_dp_stage_t stage);
+
+static inline void upf_metrics_dp_global_add(
+        upf_metric_type_global_t t, uint64_t val)
+{
+    if (upf_metrics_dp_local)
+        upf_metrics_dp_local->global[t] += val;
+}
+static inline void upf_metrics_dp_by_qfi_add(
+        uint8_t qfi, upf_metric_type_by_qfi_t t, uint64_t val)
+{
+    if (upf_metrics_dp_local && qfi <= OGS_MAX_QOS_FLOW_ID)
+        upf_metrics_dp_local->by_qfi[t][qfi] += val;
+}
+
+static inline void upf_metrics_dp_sample_begin(
+        upf_metrics_dp_sample_t *sample)
+{
+    upf_metrics_dp_t *dp = upf_metrics_dp_local;
+
+    sample->on = false;
+    if (!dp || !dp->sample_rate || --dp->sample_countdown > 0)
+        return;
+
+    dp->sample_countdown = dp->sample_rate;
+    sample->on = true;
+    sample->cycles = upf_metrics_dp_cycles();
+}
+static inline void upf_metrics_dp_sample_stage(
+        upf_metrics_dp_sample_t *sample, upf_metric_dp_stage_t stage)
+{
+    if (sample->on)
+        upf_metrics_dp_sample_record(sample, stage);
+}
+
 void upf_metrics_init(void);
 void upf_metrics_final(void);
 
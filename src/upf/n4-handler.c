@@ -21,6 +21,8 @@
 #include "pfcp-path.h"
 #include "gtp-path.h"
 #include "n4-handler.h"
+#include "rule-match.h"
+#include "snapshot.h"
 
 static void upf_n4_handle_create_urr(upf_sess_t *sess, ogs_pfcp_tlv_create_urr_t *create_urr_arr,
                               uint8_t *cause_value, uint8_t *offending_ie_value)
@@ -77,6 +79,8 @@ void upf_n4_handle_session_establishment_request(
         return;
     }
 
+    upf_sess_classifier_clear(sess);
+
     memset(&sereq_flags, 0, sizeof(sereq_flags));
     if (req->pfcpsereq_flags.presence == 1)
         sereq_flags.value = req->pfcpsereq_flags.u8;
@@ -208,6 +212,8 @@ void upf_n4_handle_session_establishment_request(
                     OGS_PFCP_OBJ_SESS_TYPE, pdr, restoration_indication);
     }
 
+    upf_sess_classifier_build(sess);
+
     /* Send Buffered Packet to gNB/SGW */
     ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
         if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) { /* Downlink */
@@ -215,6 +221,9 @@ void upf_n4_handle_session_establishment_request(
         }
     }
 
+    /* Workers forward after the buffered packets are sent */
+    upf_snapshot_publish(sess);
+
     if (restoration_indication == true ||
         ogs_pfcp_self()->up_function_features.ftup == 0)
         ogs_assert(OGS_OK ==
@@ -231,6 +240,7 @@ cleanup:
     upf_metrics_inst_by_cause_add(cause_value,
             UPF_METR_CTR_SM_N4SESSIONESTABFAIL, 1);
     ogs_pfcp_sess_clear(&sess->pfcp);
+    upf_snapshot_publish(sess);
     ogs_pfcp_send_error_message(xact, sess ? sess->smf_n4_f_seid.seid : 0,
             OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE,
             cause_value, offending_ie_value);
@@ -263,6 +273,8 @@ void upf_n4_handle_session_modification_request(
         return;
     }
 
+    upf_sess_classifier_clear(sess);
+
     for (i = 0; i < OGS_MAX_NUM_OF_PDR; i++) {
         created_pdr[i] = ogs_pfcp_handle_create_pdr(&sess->pfcp,
                 &req->create_pdr[i], NULL, &cause_value, &offending_ie_value);
@@ -411,6 +423,8 @@ void upf_n4_handle_session_modification_request(
             ogs_pfcp_object_teid_hash_set(OGS_PFCP_OBJ_SESS_TYPE, pdr, false);
     }
 
+    upf_sess_classifier_build(sess);
+
     /* Send Buffered Packet to gNB/SGW */
     ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
         if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) { /* Downlink */
@@ -418,6 +432,9 @@ void upf_n4_handle_session_modification_request(
         }
     }
 
+    /* Workers forward after the buffered packets are sent */
+    upf_snapshot_publish(sess);
+
     if (ogs_pfcp_self()->up_function_features.ftup == 0)
         ogs_assert(OGS_OK ==
             upf_pfcp_send_session_modification_response(
@@ -430,6 +447,7 @@ void upf_n4_handle_session_modification_request(
 
 cleanup:
     ogs_pfcp_sess_clear(&sess->pfcp);
+    upf_snapshot_publish(sess);
     ogs_pfcp_send_error_message(xact, sess ? sess->smf_n4_f_seid.seid : 0,
             OGS_PFCP_SESSION_MODIFICATION_RESPONSE_TYPE,
             cause_value, offending_ie_value);
@@ -65,3 +65,267 @@ upf_sess_t *upf_sess_find_by_ue_ip_address(ogs_pkbuf_t *pkbuf)
 
     return sess;
 }
+
+static bool downlink_to_access(ogs_pfcp_pdr_t *pdr)
+{
+    ogs_pfcp_far_t *far = pdr->far;
+    ogs_assert(far);
+
+    /* Check if FAR is Downlink */
+    if (far->dst_if != OGS_PFCP_INTERFACE_ACCESS)
+        return false;
+
+    /* Check if Outer header creation */
+    if (far->outer_header_creation.ip4 == 0 &&
+        far->outer_header_creation.ip6 == 0 &&
+        far->outer_header_creation.udp4 == 0 &&
+        far->outer_header_creation.udp6 == 0 &&
+        far->outer_header_creation.gtpu4 == 0 &&
+        far->outer_header_creation.gtpu6 == 0)
+        return false;
+
+    return true;
+}
+
+static int num_of_entry(ogs_pfcp_pdr_t *pdr)
+{
+    int num = ogs_list_count(&pdr->rule_list);
+    return num ? num : 1;
+}
+
+static int add_entry(upf_classifier_entry_t *entry,
+        ogs_pfcp_pdr_t *pdr, int index, uint8_t qfi)
+{
+    ogs_pfcp_rule_t *rule = NULL;
+    int num = 0;
+
+    if (ogs_list_first(&pdr->rule_list) == NULL) {
+        entry->index = index;
+        entry->qfi = qfi;
+        entry->any = true;
+        return 1;
+    }
+
+    ogs_list_for_each(&pdr->rule_list, rule) {
+        entry[num].index = index;
+        entry[num].qfi = qfi;
+        entry[num].any = false;
+        memcpy(&entry[num].ipfw, &rule->ipfw, sizeof(rule->ipfw));
+        num++;
+    }
+
+    return num;
+}
+
+upf_classifier_t *upf_classifier_build(ogs_list_t *pdr_list)
+{
+    upf_classifier_t *classifier = NULL;
+    ogs_pfcp_pdr_t *pdr = NULL;
+    int num_of_dl = 0, num_of_ul = 0;
+    int i, j, first;
+
+    ogs_assert(pdr_list);
+
+    classifier = ogs_calloc(1, sizeof(*classifier));
+    ogs_assert(classifier);
+
+    ogs_list_for_each(pdr_list, pdr) {
+        ogs_assert(pdr->far);
+        ogs_assert(classifier->num_of_pdr < OGS_MAX_NUM_OF_PDR);
+        classifier->pdr[classifier->num_of_pdr++] = pdr;
+
+        if (pdr->src_if == OGS_PFCP_INTERFACE_CORE && downlink_to_access(pdr))
+            num_of_dl += num_of_entry(pdr);
+        num_of_ul += num_of_entry(pdr);
+    }
+
+    if (num_of_dl) {
+        classifier->dl.entry =
+            ogs_calloc(num_of_dl, sizeof(upf_classifier_entry_t));
+        ogs_assert(classifier->dl.entry);
+    }
+    if (num_of_ul) {
+        classifier->ul.entry =
+            ogs_calloc(num_of_ul, sizeof(upf_classifier_entry_t));
+        ogs_assert(classifier->ul.entry);
+        classifier->ul.teid = ogs_calloc(
+                classifier->num_of_pdr, sizeof(*classifier->ul.teid));
+        ogs_assert(classifier->ul.teid);
+    }
+
+    /* Downlink : PDRs from Core towards Access, in precedence order */
+    classifier->dl.fallback = -1;
+    for (i = 0; i < classifier->num_of_pdr; i++) {
+        pdr = classifier->pdr[i];
+        if (pdr->src_if != OGS_PFCP_INTERFACE_CORE)
+            continue;
+
+        classifier->dl.fallback = i;
+
+        if (downlink_to_access(pdr) == false)
+            continue;
+
+        classifier->dl.num += add_entry(
+                classifier->dl.entry + classifier->dl.num, pdr, i, 0);
+    }
+    ogs_assert(classifier->dl.num == num_of_dl);
+
+    /* Uplink : grouped by TEID, in precedence order within a TEID */
+    for (i = 0; i < classifier->num_of_pdr; i++) {
+        uint32_t teid = classifier->pdr[i]->f_teid.teid;
+
+        for (j = 0; j < classifier->ul.num_of_teid; j++)
+            if (classifier->ul.teid[j].teid == teid)
+                break;
+        if (j < classifier->ul.num_of_teid)
+            continue;
+
+        first = classifier->ul.num;
+        for (j = i; j < classifier->num_of_pdr; j++) {
+            pdr = classifier->pdr[j];
+            if (pdr->f_teid.teid != teid)
+                continue;
+
+            classifier->ul.num += add_entry(
+                    classifier->ul.entry + classifier->ul.num,
+                    pdr, j, pdr->qfi);
+        }
+
+        j = classifier->ul.num_of_teid++;
+        classifier->ul.teid[j].teid = teid;
+        classifier->ul.teid[j].first = first;
+        classifier->ul.teid[j].num = classifier->ul.num - first;
+    }
+    ogs_assert(classifier->ul.num == num_of_ul);
+
+    return classifier;
+}
+
+void upf_classifier_free(upf_classifier_t *classifier)
+{
+    ogs_assert(classifier);
+
+    if (classifier->dl.entry)
+        ogs_free(classifier->dl.entry);
+    if (classifier->ul.entry)
+        ogs_free(classifier->ul.entry);
+    if (classifier->ul.teid)
+        ogs_free(classifier->ul.teid);
+    ogs_free(classifier);
+}
+
+static int classify(upf_classifier_entry_t *entry, int num,
+        ogs_pkbuf_t *pkbuf, uint8_t qfi)
+{
+    ogs_pfcp_flow_t flow;
+    int rv = OGS_RETRY; /* Not parsed yet */
+    int i;
+
+    for (i = 0; i < num; i++) {
+        if (entry[i].qfi && entry[i].qfi != qfi)
+            continue;
+
+        if (entry[i].any)
+            return entry[i].index;
+
+        if (rv == OGS_RETRY)
+            rv = ogs_pfcp_flow_parse(&flow, pkbuf);
+        if (rv != OGS_OK)
+            continue;
+
+        if (ogs_pfcp_ipfw_match_flow(&entry[i].ipfw, &flow) == true)
+            return entry[i].index;
+    }
+
+    return -1;
+}
+
+int upf_classify_downlink(upf_classifier_t *classifier,
+        ogs_pkbuf_t *pkbuf, int *fallback)
+{
+    ogs_assert(classifier);
+    ogs_assert(pkbuf);
+    ogs_assert(fallback);
+
+    *fallback = classifier->dl.fallback;
+
+    return classify(classifier->dl.entry, classifier->dl.num, pkbuf, 0);
+}
+
+int upf_classify_uplink(upf_classifier_t *classifier,
+        ogs_pkbuf_t *pkbuf, uint32_t teid, uint8_t qfi)
+{
+    int i;
+
+    ogs_assert(classifier);
+    ogs_assert(pkbuf);
+
+    for (i = 0; i < classifier->ul.num_of_teid; i++) {
+        if (classifier->ul.teid[i].teid == teid)
+            return classify(
+                    classifier->ul.entry + classifier->ul.teid[i].first,
+                    classifier->ul.teid[i].num, pkbuf, qfi);
+    }
+
+    return -1;
+}
+
+void upf_sess_classifier_build(upf_sess_t *sess)
+{
+    ogs_assert(sess);
+
+    upf_sess_classifier_clear(sess);
+    sess->classifier = upf_classifier_build(&sess->pfcp.pdr_list);
+}
+
+void upf_sess_classifier_clear(upf_sess_t *sess)
+{
+    ogs_assert(sess);
+
+    if (!sess->classifier)
+        return;
+
+    upf_classifier_free(sess->classifier);
+    sess->classifier = NULL;
+}
+
+ogs_pfcp_pdr_t *upf_sess_classify_downlink(
+        upf_sess_t *sess, ogs_pkbuf_t *pkbuf, ogs_pfcp_pdr_t **fallback)
+{
+    upf_classifier_t *classifier = NULL;
+    int index, fallback_index;
+
+    ogs_assert(sess);
+    ogs_assert(pkbuf);
+    ogs_assert(fallback);
+
+    if (!sess->classifier)
+        upf_sess_classifier_build(sess);
+    classifier = sess->classifier;
+    ogs_assert(classifier);
+
+    index = upf_classify_downlink(classifier, pkbuf, &fallback_index);
+
+    *fallback = fallback_index < 0 ? NULL : classifier->pdr[fallback_index];
+
+    return index < 0 ? NULL : classifier->pdr[index];
+}
+
+ogs_pfcp_pdr_t *upf_sess_classify_uplink(upf_sess_t *sess,
+        ogs_pkbuf_t *pkbuf, uint32_t teid, uint8_t qfi)
+{
+    upf_classifier_t *classifier = NULL;
+    int index;
+
+    ogs_assert(sess);
+    ogs_assert(pkbuf);
+
+    if (!sess->classifier)
+        upf_sess_classifier_build(sess);
+    classifier = sess->classifier;
+    ogs_assert(classifier);
+
+    index = upf_classify_uplink(classifier, pkbuf, teid, qfi);
+
+    return index < 0 ? NULL : classifier->pdr[index];
+}
@@ -28,6 +28,71 @@ extern "C" {
 
 upf_sess_t *upf_sess_find_by_ue_ip_address(ogs_pkbuf_t *pkbuf);
 
+/*
+ * Per-session PDR classifier
+ *
+ * The PDR list is compiled into flat arrays in precedence order,
+ * one entry per SDF filter(or one wildcard entry if the PDR has none).
+ * Uplink entries are grouped by TEID. The packet 5-tuple is parsed
+ * at most once per lookup.
+ *
+ * It is built at the end of PFCP Session Establishment/Modification
+ * and cleared at their start, so PDR/FAR changes are never seen
+ * half-applied. A lookup rebuilds it if it is missing.
+ *
+ * Entries refer to the PDRs by their index in the PDR list. A data plane
+ * snapshot(see snapshot.h) keeps its own classifier without the PDRs.
+ */
+typedef struct upf_classifier_entry_s {
+    int             index;      /* PDR index in precedence order */
+    uint8_t         qfi;        /* Uplink only, 0 : any QFI */
+    bool            any;        /* No SDF filter */
+    ogs_ipfw_rule_t ipfw;
+} upf_classifier_entry_t;
+
+typedef struct upf_classifier_s {
+    /* PDRs in precedence order, NULL in a snapshot */
+    ogs_pfcp_pdr_t *pdr[OGS_MAX_NUM_OF_PDR];
+    int num_of_pdr;
+
+    struct {
+        upf_classifier_entry_t *entry;
+        int num;
+
+        /* Lowest precedence downlink PDR, -1 : none */
+        int fallback;
+    } dl;
+
+    struct {
+        upf_classifier_entry_t *entry;
+        int num;
+
+        struct {
+            uint32_t teid;
+            int first;
+            int num;
+        } *teid;
+        int num_of_teid;
+    } ul;
+} upf_classifier_t;
+
+upf_classifier_t *upf_classifier_build(ogs_list_t *pdr_list);
+void upf_classifier_free(upf_classifier_t *classifier);
+
+/* Return the PDR index, or -1 if no PDR matches */
+int upf_classify_downlink(upf_classifier_t *classifier,
+        ogs_pkbuf_t *pkbuf, int *fallback);
+int upf_classify_uplink(upf_classifier_t *classifier,
+        ogs_pkbuf_t *pkbuf, uint32_t teid, uint8_t qfi);
+
+void upf_sess_classifier_build(upf_sess_t *sess);
+void upf_sess_classifier_clear(upf_sess_t *sess);
+
+ogs_pfcp_pdr_t *upf_sess_classify_downlink(
+        upf_sess_t *sess, ogs_pkbuf_t *pkbuf, ogs_pfcp_pdr_t **fallback);
+ogs_pfcp_pdr_t *upf_sess_classify_uplink(upf_sess_t *sess,
+        ogs_pkbuf_t *pkbuf, uint32_t teid, uint8_t qfi);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,795 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE 1
+#define _BSD_SOURCE     1
+
+#include "snapshot.h"
+
+#if HAVE_NETINET_IP_H
+#include <netinet/ip.h>
+#endif
+
+#if HAVE_NETINET_IP6_H
+#include <netinet/ip6.h>
+#endif
+
+/*
+ * Update log
+ *
+ * Appended by the main thread only. A worker follows 'next'
+ * from its cursor and publishes the generation it reached,
+ * so an entry older than every worker can be reclaimed.
+ */
+typedef struct upf_snapshot_update_s {
+    struct upf_snapshot_update_s *next;
+    uint64_t gen;
+
+    upf_snapshot_t *old;    /* Freed once all workers went past */
+    upf_snapshot_t *new;
+} upf_snapshot_update_t;
+
+static upf_snapshot_update_t *head = NULL;
+static upf_snapshot_update_t *tail = NULL;
+static uint64_t generation = 0;
+
+static void snapshot_arm(upf_sess_t *sess, upf_snapshot_t *snap);
+
+void upf_snapshot_init(void)
+{
+    int i;
+
+    ogs_assert(head == NULL);
+
+    head = tail = ogs_calloc(1, sizeof(upf_snapshot_update_t));
+    ogs_assert(head);
+    generation = 0;
+
+    for (i = 0; i < upf_self()->worker.num; i++) {
+        upf_worker_t *worker = upf_worker_at(i);
+
+        worker->cursor = head;
+        worker->gen = head->gen;
+    }
+}
+
+static void snapshot_free(upf_snapshot_t *snap)
+{
+    int i;
+
+    ogs_assert(snap);
+
+    if (snap->rule) {
+        for (i = 0; i < snap->classifier->num_of_pdr; i++)
+            if (snap->rule[i].dnn)
+                ogs_free(snap->rule[i].dnn);
+        ogs_free(snap->rule);
+    }
+    upf_classifier_free(snap->classifier);
+
+    if (snap->teid)
+        ogs_free(snap->teid);
+    if (snap->ipv4_framed_routes)
+        ogs_free(snap->ipv4_framed_routes);
+    if (snap->ipv6_framed_routes)
+        ogs_free(snap->ipv6_framed_routes);
+
+    if (snap->qer)
+        ogs_free(snap->qer);
+    if (snap->meter) {
+        for (i = 0; i < snap->num_of_qer; i++) {
+            ogs_assert(snap->meter[i]->ref > 0);
+            if (--snap->meter[i]->ref == 0)
+                ogs_free(snap->meter[i]);
+        }
+        ogs_free(snap->meter);
+    }
+    if (snap->urr)
+        ogs_free(snap->urr);
+    if (snap->row)
+        ogs_free(snap->row);
+
+    ogs_free(snap);
+}
+
+void upf_snapshot_final(void)
+{
+    upf_snapshot_update_t *update = NULL;
+
+    /* Every session is removed, so every snapshot is an old one */
+    while (head) {
+        update = head;
+        head = head->next;
+
+        if (update->old)
+            snapshot_free(update->old);
+        ogs_free(update);
+    }
+    tail = NULL;
+}
+
+static ogs_ipsubnet_t *framed_routes_dup(ogs_ipsubnet_t *routes)
+{
+    ogs_ipsubnet_t *dup = NULL;
+
+    if (!routes)
+        return NULL;
+
+    dup = ogs_memdup(routes,
+            sizeof(ogs_ipsubnet_t) * OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI);
+    ogs_assert(dup);
+
+    return dup;
+}
+
+/*
+ * The buckets of a QER move to the next snapshot, so a PFCP Session
+ * Modification never refills them. They are kept in time, not in Bytes,
+ * so they stay valid if the MBR is modified.
+ */
+static upf_snapshot_meter_t *meter_find_or_add(
+        upf_snapshot_t *old, ogs_pfcp_qer_id_t id)
+{
+    upf_snapshot_meter_t *meter = NULL;
+    int i;
+
+    for (i = 0; old && i < old->num_of_qer; i++) {
+        if (old->qer[i].id == id)
+            return old->meter[i];
+    }
+
+    meter = ogs_calloc(1, sizeof(*meter));
+    ogs_assert(meter);
+
+    return meter;
+}
+
+static upf_snapshot_t *snapshot_build(upf_sess_t *sess)
+{
+    upf_snapshot_t *snap = NULL;
+    upf_classifier_t *classifier = NULL;
+    ogs_pfcp_qer_t *qer = NULL, *qer_list[OGS_MAX_NUM_OF_QER];
+    ogs_pfcp_urr_t *urr = NULL, *urr_list[OGS_MAX_NUM_OF_URR];
+    int num_of_worker = upf_self()->worker.num;
+    int i, j, k;
+
+    ogs_assert(sess);
+
+    snap = ogs_calloc(1, sizeof(*snap));
+    ogs_assert(snap);
+
+    snap->sess_id = sess->id;
+
+    /* QERs and their meters */
+    ogs_list_for_each(&sess->pfcp.qer_list, qer) {
+        ogs_assert(snap->num_of_qer < OGS_MAX_NUM_OF_QER);
+        qer_list[snap->num_of_qer++] = qer;
+    }
+    if (snap->num_of_qer) {
+        snap->qer = ogs_calloc(snap->num_of_qer, sizeof(ogs_pfcp_qer_t));
+        ogs_assert(snap->qer);
+        snap->meter = ogs_calloc(
+                snap->num_of_qer, sizeof(upf_snapshot_meter_t *));
+        ogs_assert(snap->meter);
+
+        for (i = 0; i < snap->num_of_qer; i++) {
+            memcpy(&snap->qer[i], qer_list[i], sizeof(ogs_pfcp_qer_t));
+            memset(&snap->qer[i].lnode, 0, sizeof(snap->qer[i].lnode));
+            memset(snap->qer[i].meter, 0, sizeof(snap->qer[i].meter));
+            snap->qer[i].id_node = NULL;
+            snap->qer[i].sess = NULL;
+
+            snap->meter[i] = meter_find_or_add(
+                    sess->snapshot, qer_list[i]->id);
+            snap->meter[i]->ref++;
+        }
+    }
+
+    /* URRs and their counters */
+    ogs_list_for_each(&sess->pfcp.urr_list, urr) {
+        ogs_assert(snap->num_of_urr < OGS_MAX_NUM_OF_URR);
+        urr_list[snap->num_of_urr++] = urr;
+    }
+    if (snap->num_of_urr) {
+        snap->urr = ogs_calloc(snap->num_of_urr, sizeof(*snap->urr));
+        ogs_assert(snap->urr);
+        snap->row = ogs_calloc(num_of_worker * snap->num_of_urr,
+                sizeof(upf_snapshot_row_t));
+        ogs_assert(snap->row);
+
+        for (i = 0; i < snap->num_of_urr; i++) {
+            urr = urr_list[i];
+            ogs_assert(urr->id > 0 && urr->id <= OGS_MAX_NUM_OF_URR);
+
+            snap->urr[i].id = urr->id;
+            snap->urr[i].volume =
+                (urr->rep_triggers.volume_quota && urr->vol_quota.tovol) ||
+                (urr->rep_triggers.volume_threshold &&
+                 urr->vol_threshold.tovol);
+            snap->urr[i].trigger = UINT64_MAX;
+        }
+        for (i = 0; i < num_of_worker * snap->num_of_urr; i++)
+            snap->row[i].asked = UINT64_MAX;
+    }
+
+    /* PDRs and their FARs */
+    classifier = upf_classifier_build(&sess->pfcp.pdr_list);
+    ogs_assert(classifier);
+    snap->classifier = classifier;
+
+    if (classifier->num_of_pdr) {
+        snap->rule = ogs_calloc(
+                classifier->num_of_pdr, sizeof(upf_snapshot_rule_t));
+        ogs_assert(snap->rule);
+        snap->teid = ogs_calloc(classifier->num_of_pdr, sizeof(uint32_t));
+        ogs_assert(snap->teid);
+    }
+
+    for (i = 0; i < classifier->num_of_pdr; i++) {
+        ogs_pfcp_pdr_t *pdr = classifier->pdr[i];
+        ogs_pfcp_far_t *far = pdr->far;
+        ogs_gtp_node_t *gnode = NULL;
+        upf_snapshot_rule_t *rule = &snap->rule[i];
+
+        ogs_assert(far);
+
+        rule->id = pdr->id;
+        rule->src_if = pdr->src_if;
+        rule->src_if_type_presence = pdr->src_if_type_presence;
+        rule->src_if_type = pdr->src_if_type;
+        if (pdr->dnn) {
+            rule->dnn = ogs_strdup(pdr->dnn);
+            ogs_assert(rule->dnn);
+        }
+
+        rule->far.apply_action = far->apply_action;
+        rule->far.dst_if = far->dst_if;
+        rule->far.dst_if_type_presence = far->dst_if_type_presence;
+        rule->far.dst_if_type = far->dst_if_type;
+        rule->far.teid = far->outer_header_creation.teid;
+
+        /* Buffering and dropping are left to the main thread */
+        gnode = far->gnode;
+        if (gnode && gnode->sock &&
+            (far->apply_action & OGS_PFCP_APPLY_ACTION_FORW) &&
+            far->dst_if != OGS_PFCP_INTERFACE_UNKNOWN) {
+            rule->far.sock = gnode->sock;
+            rule->far.addr = &gnode->addr;
+        }
+
+        rule->qer = -1;
+        for (j = 0; pdr->qer && j < snap->num_of_qer; j++) {
+            if (qer_list[j] == pdr->qer) {
+                rule->qer = j;
+                break;
+            }
+        }
+
+        for (j = 0; j < pdr->num_of_urr; j++) {
+            for (k = 0; k < snap->num_of_urr; k++) {
+                if (urr_list[k] == pdr->urr[j]) {
+                    rule->urr[rule->num_of_urr++] = k;
+                    break;
+                }
+            }
+        }
+
+        if (pdr->hash.teid.len) {
+            for (j = 0; j < snap->num_of_teid; j++)
+                if (snap->teid[j] == pdr->hash.teid.key)
+                    break;
+            if (j == snap->num_of_teid)
+                snap->teid[snap->num_of_teid++] = pdr->hash.teid.key;
+        }
+    }
+
+    /* The snapshot does not refer to the PDRs */
+    memset(classifier->pdr, 0, sizeof(classifier->pdr));
+
+    /* UE IP addresses and framed routes */
+    if (sess->ipv4) {
+        snap->ipv4.presence = true;
+        memcpy(snap->ipv4.addr, sess->ipv4->addr, sizeof(snap->ipv4.addr));
+        if (sess->ipv4->subnet)
+            snap->ipv4.dev = sess->ipv4->subnet->dev;
+    }
+    if (sess->ipv6) {
+        snap->ipv6.presence = true;
+        memcpy(snap->ipv6.addr, sess->ipv6->addr, sizeof(snap->ipv6.addr));
+        if (sess->ipv6->subnet)
+            snap->ipv6.dev = sess->ipv6->subnet->dev;
+    }
+    snap->ipv4_framed_routes = framed_routes_dup(sess->ipv4_framed_routes);
+    snap->ipv6_framed_routes = framed_routes_dup(sess->ipv6_framed_routes);
+
+    return snap;
+}
+
+static void snapshot_update(upf_snapshot_t *old, upf_snapshot_t *new)
+{
+    upf_snapshot_update_t *update = NULL;
+    int i;
+
+    ogs_assert(tail);
+
+    update = ogs_calloc(1, sizeof(*update));
+    ogs_assert(update);
+
+    update->gen = ++generation;
+    update->old = old;
+    update->new = new;
+
+    __atomic_store_n(&tail->next, update, __ATOMIC_RELEASE);
+    tail = update;
+
+    for (i = 0; i < upf_self()->worker.num; i++)
+        ogs_pollset_notify(upf_worker_at(i)->pollset);
+}
+
+void upf_snapshot_publish(upf_sess_t *sess)
+{
+    upf_snapshot_t *snap = NULL;
+
+    ogs_assert(sess);
+
+    if (!upf_self()->worker.num)
+        return;
+
+    snap = snapshot_build(sess);
+    ogs_assert(snap);
+
+    /* Armed before the workers can see it */
+    snapshot_arm(sess, snap);
+
+    snapshot_update(sess->snapshot, snap);
+    sess->snapshot = snap;
+}
+
+void upf_snapshot_withdraw(upf_sess_t *sess)
+{
+    ogs_assert(sess);
+
+    if (!sess->snapshot)
+        return;
+
+    snapshot_update(sess->snapshot, NULL);
+    sess->snapshot = NULL;
+}
+
+/* Fold the counters of SNAP not seen yet into the session */
+static void snapshot_fold(upf_sess_t *sess, upf_snapshot_t *snap)
+{
+    upf_sess_urr_acc_t *urr_acc = NULL;
+    upf_snapshot_row_t *row = NULL;
+    upf_snapshot_count_t count;
+    int num_of_worker = upf_self()->worker.num;
+    int i, j;
+
+    ogs_assert(sess);
+    ogs_assert(snap);
+
+    for (i = 0; i < num_of_worker; i++) {
+        for (j = 0; j < snap->num_of_urr; j++) {
+            row = &snap->row[i * snap->num_of_urr + j];
+
+#define READ(__f) \
+    count.__f = __atomic_load_n(&row->count.__f, __ATOMIC_RELAXED)
+            READ(total_octets);
+            READ(ul_octets);
+            READ(dl_octets);
+            READ(total_pkts);
+            READ(ul_pkts);
+            READ(dl_pkts);
+            READ(time_of_first_packet);
+            READ(time_of_last_packet);
+#undef READ
+
+            if (count.total_pkts == row->seen.total_pkts)
+                continue;
+
+            urr_acc = &sess->urr_acc[snap->urr[j].id-1];
+
+            urr_acc->total_octets +=
+                count.total_octets - row->seen.total_octets;
+            urr_acc->ul_octets += count.ul_octets - row->seen.ul_octets;
+            urr_acc->dl_octets += count.dl_octets - row->seen.dl_octets;
+            urr_acc->total_pkts += count.total_pkts - row->seen.total_pkts;
+            urr_acc->ul_pkts += count.ul_pkts - row->seen.ul_pkts;
+            urr_acc->dl_pkts += count.dl_pkts - row->seen.dl_pkts;
+
+            if (count.time_of_first_packet &&
+                (urr_acc->time_of_first_packet == 0 ||
+                 count.time_of_first_packet < urr_acc->time_of_first_packet))
+                urr_acc->time_of_first_packet = count.time_of_first_packet;
+            if (count.time_of_last_packet > urr_acc->time_of_last_packet)
+                urr_acc->time_of_last_packet = count.time_of_last_packet;
+
+            memcpy(&row->seen, &count, sizeof(count));
+        }
+    }
+}
+
+void upf_snapshot_collect(upf_sess_t *sess)
+{
+    upf_snapshot_update_t *update = NULL;
+
+    ogs_assert(sess);
+
+    if (!upf_self()->worker.num)
+        return;
+
+    /* Including the snapshots the workers may still be counting in */
+    for (update = head; update; update = update->next)
+        if (update->old && update->old->sess_id == sess->id)
+            snapshot_fold(sess, update->old);
+
+    if (sess->snapshot)
+        snapshot_fold(sess, sess->snapshot);
+
+    upf_snapshot_arm(sess);
+}
+
+void upf_snapshot_reclaim(void)
+{
+    upf_snapshot_update_t *update = NULL;
+    upf_sess_t *sess = NULL;
+    uint64_t gen, min = UINT64_MAX;
+    int i;
+
+    if (!upf_self()->worker.num)
+        return;
+
+    for (i = 0; i < upf_self()->worker.num; i++) {
+        gen = __atomic_load_n(&upf_worker_at(i)->gen, __ATOMIC_ACQUIRE);
+        min = ogs_min(min, gen);
+    }
+
+    for (update = head; update && update->gen <= min; update = update->next) {
+        if (!update->old)
+            continue;
+
+        sess = upf_sess_find_by_id(update->old->sess_id);
+        if (sess) {
+            snapshot_fold(sess, update->old);
+            upf_snapshot_arm(sess);
+        }
+
+        snapshot_free(update->old);
+        update->old = NULL;
+    }
+
+    /* Keep the entry a worker may still be at */
+    while (head != tail && head->gen < min) {
+        update = head;
+        head = head->next;
+        ogs_free(update);
+    }
+}
+
+/*
+ * A worker asks for a report once the counters of all workers reach
+ * the trigger, i.e. once the volume since the last report would reach
+ * the Volume Threshold or Quota.
+ */
+static void snapshot_arm(upf_sess_t *sess, upf_snapshot_t *snap)
+{
+    upf_sess_urr_acc_t *urr_acc = NULL;
+    ogs_pfcp_urr_t *urr = NULL;
+    uint64_t limit, vol, seen, trigger;
+    int i, j;
+
+    ogs_assert(sess);
+    ogs_assert(snap);
+
+    for (i = 0; i < snap->num_of_urr; i++) {
+        trigger = UINT64_MAX;
+
+        urr = ogs_pfcp_urr_find(&sess->pfcp, snap->urr[i].id);
+        if (urr && snap->urr[i].volume) {
+            limit = UINT64_MAX;
+            if (urr->rep_triggers.volume_quota && urr->vol_quota.tovol)
+                limit = ogs_min(limit, urr->vol_quota.total_volume);
+            if (urr->rep_triggers.volume_threshold &&
+                urr->vol_threshold.tovol)
+                limit = ogs_min(limit, urr->vol_threshold.total_volume);
+
+            urr_acc = &sess->urr_acc[snap->urr[i].id-1];
+            vol = urr_acc->total_octets - urr_acc->last_report.total_octets;
+
+            seen = 0;
+            for (j = 0; j < upf_self()->worker.num; j++)
+                seen += snap->row[j * snap->num_of_urr + i].seen.total_octets;
+
+            trigger = vol < limit ? seen + (limit - vol) : seen;
+        }
+
+        __atomic_store_n(&snap->urr[i].trigger, trigger, __ATOMIC_RELAXED);
+    }
+}
+
+void upf_snapshot_arm(upf_sess_t *sess)
+{
+    ogs_assert(sess);
+
+    if (sess->snapshot)
+        snapshot_arm(sess, sess->snapshot);
+}
+
+ogs_pfcp_meter_t *upf_snapshot_qer_meter(
+        upf_sess_t *sess, ogs_pfcp_qer_t *qer)
+{
+    upf_snapshot_t *snap = NULL;
+    int i;
+
+    ogs_assert(sess);
+
+    if (!qer)
+        return NULL;
+
+    /* Packets passed by the workers share the bucket of theirs */
+    snap = sess->snapshot;
+    for (i = 0; snap && i < snap->num_of_qer; i++) {
+        if (snap->qer[i].id == qer->id)
+            return upf_snapshot_meter(snap, i);
+    }
+
+    return qer->meter;
+}
+
+static void routes_remove(
+        ogs_lpm_t *lpm, ogs_ipsubnet_t *routes, upf_snapshot_t *snap)
+{
+    int i, prefixlen;
+
+    for (i = 0; routes && i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
+        if (!routes[i].family)
+            break;
+
+        prefixlen = upf_framed_route_prefixlen(&routes[i]);
+        if (ogs_lpm_find_exact(lpm, routes[i].sub, prefixlen) == snap)
+            ogs_lpm_delete(lpm, routes[i].sub, prefixlen);
+    }
+}
+
+static void routes_add(
+        ogs_lpm_t *lpm, ogs_ipsubnet_t *routes, upf_snapshot_t *snap)
+{
+    int i;
+
+    for (i = 0; routes && i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
+        if (!routes[i].family)
+            break;
+
+        ogs_assert(OGS_OK == ogs_lpm_add(lpm, routes[i].sub,
+                    upf_framed_route_prefixlen(&routes[i]), snap));
+    }
+}
+
+/* Remove the keys of SNAP which still map to it */
+static void table_remove(upf_worker_t *worker, upf_snapshot_t *snap)
+{
+    int i;
+
+    for (i = 0; i < snap->num_of_teid; i++) {
+        if (ogs_hash_get(worker->teid_hash,
+                    &snap->teid[i], sizeof(snap->teid[i])) == snap)
+            ogs_hash_set(worker->teid_hash,
+                    &snap->teid[i], sizeof(snap->teid[i]), NULL);
+    }
+
+    if (snap->ipv4.presence &&
+        ogs_hash_get(worker->ipv4_hash,
+            snap->ipv4.addr, OGS_IPV4_LEN) == snap)
+        ogs_hash_set(worker->ipv4_hash, snap->ipv4.addr, OGS_IPV4_LEN, NULL);
+    if (snap->ipv6.presence &&
+        ogs_hash_get(worker->ipv6_hash,
+            snap->ipv6.addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3) == snap)
+        ogs_hash_set(worker->ipv6_hash,
+                snap->ipv6.addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
+
+    routes_remove(worker->ipv4_framed_routes, snap->ipv4_framed_routes, snap);
+    routes_remove(worker->ipv6_framed_routes, snap->ipv6_framed_routes, snap);
+}
+
+/*
+ * ogs_hash_set() keeps the key of an existing entry,
+ * so the entry is removed first for the key to be the one of SNAP.
+ */
+static void table_add(upf_worker_t *worker, upf_snapshot_t *snap)
+{
+    int i;
+
+    for (i = 0; i < snap->num_of_teid; i++) {
+        ogs_hash_set(worker->teid_hash,
+                &snap->teid[i], sizeof(snap->teid[i]), NULL);
+        ogs_hash_set(worker->teid_hash,
+                &snap->teid[i], sizeof(snap->teid[i]), snap);
+    }
+
+    if (snap->ipv4.presence) {
+        ogs_hash_set(worker->ipv4_hash, snap->ipv4.addr, OGS_IPV4_LEN, NULL);
+        ogs_hash_set(worker->ipv4_hash, snap->ipv4.addr, OGS_IPV4_LEN, snap);
+    }
+    if (snap->ipv6.presence) {
+        ogs_hash_set(worker->ipv6_hash,
+                snap->ipv6.addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
+        ogs_hash_set(worker->ipv6_hash,
+                snap->ipv6.addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, snap);
+    }
+
+    routes_add(worker->ipv4_framed_routes, snap->ipv4_framed_routes, snap);
+    routes_add(worker->ipv6_framed_routes, snap->ipv6_framed_routes, snap);
+}
+
+void upf_snapshot_sync(upf_worker_t *worker)
+{
+    upf_snapshot_update_t *update = NULL;
+
+    ogs_assert(worker);
+    ogs_assert(worker->cursor);
+
+    update = __atomic_load_n(&worker->cursor->next, __ATOMIC_ACQUIRE);
+    if (!update)
+        return;
+
+    do {
+        if (update->old)
+            table_remove(worker, update->old);
+        if (update->new)
+            table_add(worker, update->new);
+
+        worker->cursor = update;
+        update = __atomic_load_n(&update->next, __ATOMIC_ACQUIRE);
+    } while (update);
+
+    /* Nothing from before is looked up any longer */
+    __atomic_store_n(&worker->gen, worker->cursor->gen, __ATOMIC_RELEASE);
+}
+
+upf_snapshot_t *upf_snapshot_find_by_teid(
+        upf_worker_t *worker, uint32_t teid)
+{
+    ogs_assert(worker);
+    return ogs_hash_get(worker->teid_hash, &teid, sizeof(teid));
+}
+
+upf_snapshot_t *upf_snapshot_find_by_ipv4(
+        upf_worker_t *worker, uint32_t addr)
+{
+    upf_snapshot_t *snap = NULL;
+
+    ogs_assert(worker);
+
+    snap = ogs_hash_get(worker->ipv4_hash, &addr, OGS_IPV4_LEN);
+    if (snap)
+        return snap;
+
+    return ogs_lpm_find(worker->ipv4_framed_routes, &addr);
+}
+
+upf_snapshot_t *upf_snapshot_find_by_ue_ip_address(
+        upf_worker_t *worker, ogs_pkbuf_t *pkbuf)
+{
+    upf_snapshot_t *snap = NULL;
+    struct ip *ip_h = NULL;
+    struct ip6_hdr *ip6_h = NULL;
+    uint32_t *addr6 = NULL;
+
+    ogs_assert(worker);
+    ogs_assert(pkbuf);
+    ogs_assert(pkbuf->len);
+
+    ip_h = (struct ip *)pkbuf->data;
+    if (ip_h->ip_v == 4) {
+        snap = upf_snapshot_find_by_ipv4(worker, ip_h->ip_dst.s_addr);
+    } else if (ip_h->ip_v == 6) {
+        ip6_h = (struct ip6_hdr *)pkbuf->data;
+        addr6 = (uint32_t *)ip6_h->ip6_dst.s6_addr;
+
+        snap = ogs_hash_get(worker->ipv6_hash,
+                addr6, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3);
+        if (!snap)
+            snap = ogs_lpm_find(worker->ipv6_framed_routes, addr6);
+    } else {
+        ogs_error("Invalid packet [IP version:%d, Packet Length:%d]",
+                ip_h->ip_v, pkbuf->len);
+        ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+    }
+
+    return snap;
+}
+
+ogs_pfcp_meter_t *upf_snapshot_meter(upf_snapshot_t *snap, int qer)
+{
+    ogs_assert(snap);
+
+    if (qer < 0)
+        return NULL;
+
+    ogs_assert(qer < snap->num_of_qer);
+    return snap->meter[qer]->meter;
+}
+
+void upf_snapshot_count(upf_snapshot_t *snap, upf_worker_t *worker,
+        upf_snapshot_rule_t *rule, size_t size, bool uplink)
+{
+    upf_snapshot_row_t *row = NULL;
+    upf_snapshot_count_t *count = NULL;
+    upf_worker_message_t message;
+    uint64_t trigger, total;
+    ogs_time_t now;
+    int i, j, slot;
+
+    ogs_assert(snap);
+    ogs_assert(worker);
+    ogs_assert(rule);
+
+    if (!rule->num_of_urr)
+        return;
+
+    now = ogs_time_now();
+
+    for (i = 0; i < rule->num_of_urr; i++) {
+        slot = rule->urr[i];
+        row = &snap->row[worker->index * snap->num_of_urr + slot];
+        count = &row->count;
+
+        /* Only this worker writes the row, the main thread reads it */
+#define ADD(__f, __v) \
+    __atomic_store_n(&count->__f, count->__f + (__v), __ATOMIC_RELAXED)
+        ADD(total_octets, size);
+        ADD(total_pkts, 1);
+        if (uplink) {
+            ADD(ul_octets, size);
+            ADD(ul_pkts, 1);
+        } else {
+            ADD(dl_octets, size);
+            ADD(dl_pkts, 1);
+        }
+#undef ADD
+        if (count->time_of_first_packet == 0)
+            __atomic_store_n(&count->time_of_first_packet,
+                    now, __ATOMIC_RELAXED);
+        __atomic_store_n(&count->time_of_last_packet, now, __ATOMIC_RELAXED);
+
+        if (!snap->urr[slot].volume)
+            continue;
+
+        trigger = __atomic_load_n(&snap->urr[slot].trigger, __ATOMIC_RELAXED);
+        if (trigger == row->asked)
+            continue;
+
+        total = 0;
+        for (j = 0; j < upf_self()->worker.num; j++)
+            total += __atomic_load_n(
+                    &snap->row[j * snap->num_of_urr + slot].count.total_octets,
+                    __ATOMIC_RELAXED);
+        if (total < trigger)
+            continue;
+
+        memset(&message, 0, sizeof(message));
+        message.type = UPF_WORKER_URR_REPORT;
+        message.sess_id = snap->sess_id;
+        message.urr_id = snap->urr[slot].id;
+
+        /* Asked again with the next packet if the ring is full */
+        if (upf_worker_punt(worker, &message) == true)
+            row->asked = trigger;
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPF_SNAPSHOT_H
+#define UPF_SNAPSHOT_H
+
+#include "rule-match.h"
+#include "worker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Data plane snapshot
+ *
+ * With data plane workers, the PDRs, FARs, QERs and URRs of a session
+ * are published to them as an immutable copy built by the main thread
+ * at the end of PFCP Session Establishment/Modification.
+ *
+ * A snapshot is never modified once published. The main thread appends
+ * the replacement {old, new} to an update log, and every worker applies
+ * the log to its own TEID/UE IP tables before it handles packets.
+ * The old snapshot is freed once all workers went past its entry.
+ *
+ * The meters of a QER are shared by all the threads, so a session whose
+ * flows are spread over the workers still gets no more than the MBR.
+ * They are handed over to the next snapshot of the session.
+ * The URR counters are per worker and live in the snapshot. They are
+ * folded into the session(urr_acc) by the main thread when a report
+ * is built and when the snapshot is freed. A worker whose counters cross the volume trigger armed
+ * by the main thread asks it for a report(see upf_snapshot_count()).
+ *
+ * Anything else (buffering, Error Indication, End Marker, multicast)
+ * is passed to the main thread as is.
+ */
+typedef struct upf_snapshot_count_s {
+    uint64_t total_octets;
+    uint64_t ul_octets;
+    uint64_t dl_octets;
+    uint64_t total_pkts;
+    uint64_t ul_pkts;
+    uint64_t dl_pkts;
+    ogs_time_t time_of_first_packet;
+    ogs_time_t time_of_last_packet;
+} upf_snapshot_count_t;
+
+typedef struct upf_snapshot_row_s {
+    upf_snapshot_count_t count; /* Written by its worker only */
+    upf_snapshot_count_t seen;  /* Already folded, main thread only */
+    uint64_t asked;             /* Trigger reported, its worker only */
+} upf_snapshot_row_t;
+
+typedef struct upf_snapshot_rule_s {
+    ogs_pfcp_pdr_id_t id;
+    ogs_pfcp_interface_t src_if;
+    bool src_if_type_presence;
+    ogs_pfcp_3gpp_interface_type_t src_if_type;
+    char *dnn;
+
+    struct {
+        ogs_pfcp_apply_action_t apply_action;
+        ogs_pfcp_interface_t dst_if;
+        bool dst_if_type_presence;
+        ogs_pfcp_3gpp_interface_type_t dst_if_type;
+        uint32_t teid;          /* Outer Header Creation */
+
+        /* NULL : passed to the main thread */
+        ogs_sock_t *sock;
+        ogs_sockaddr_t *addr;
+    } far;
+
+    int qer;                    /* Index in qer[], -1 : none */
+
+    int num_of_urr;
+    int urr[OGS_MAX_NUM_OF_URR]; /* Index in urr[] */
+} upf_snapshot_rule_t;
+
+typedef struct upf_snapshot_meter_s {
+    ogs_pfcp_meter_t meter[2];  /* Uplink, Downlink */
+    int ref;                    /* Snapshots holding it, main thread only */
+} upf_snapshot_meter_t;
+
+typedef struct upf_snapshot_s {
+    ogs_pool_id_t sess_id;
+
+    upf_classifier_t *classifier;   /* Without the PDRs */
+    upf_snapshot_rule_t *rule;      /* By PDR index */
+
+    uint32_t *teid;
+    int num_of_teid;
+
+    struct {
+        bool presence;
+        uint32_t addr[4];
+        ogs_pfcp_dev_t *dev;
+    } ipv4, ipv6;
+
+    ogs_ipsubnet_t *ipv4_framed_routes;
+    ogs_ipsubnet_t *ipv6_framed_routes;
+
+    int num_of_qer;
+    ogs_pfcp_qer_t *qer;
+    upf_snapshot_meter_t **meter;   /* [qer], shared */
+
+    int num_of_urr;
+    struct {
+        ogs_pfcp_urr_id_t id;
+        bool volume;                /* Volume Threshold/Quota armed */
+        uint64_t trigger;           /* Written by the main thread */
+    } *urr;
+    upf_snapshot_row_t *row;        /* [worker][urr] */
+} upf_snapshot_t;
+
+void upf_snapshot_init(void);
+void upf_snapshot_final(void);
+
+/* Main thread */
+void upf_snapshot_publish(upf_sess_t *sess);
+void upf_snapshot_withdraw(upf_sess_t *sess);
+void upf_snapshot_reclaim(void);
+
+void upf_snapshot_collect(upf_sess_t *sess);
+void upf_snapshot_arm(upf_sess_t *sess);
+
+ogs_pfcp_meter_t *upf_snapshot_qer_meter(
+        upf_sess_t *sess, ogs_pfcp_qer_t *qer);
+
+/* Data plane worker */
+void upf_snapshot_sync(upf_worker_t *worker);
+
+upf_snapshot_t *upf_snapshot_find_by_teid(
+        upf_worker_t *worker, uint32_t teid);
+upf_snapshot_t *upf_snapshot_find_by_ipv4(
+        upf_worker_t *worker, uint32_t addr);
+upf_snapshot_t *upf_snapshot_find_by_ue_ip_address(
+        upf_worker_t *worker, ogs_pkbuf_t *pkbuf);
+
+ogs_pfcp_meter_t *upf_snapshot_meter(upf_snapshot_t *snap, int qer);
+void upf_snapshot_count(upf_snapshot_t *snap, upf_worker_t *worker,
+        upf_snapshot_rule_t *rule, size_t size, bool uplink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_SNAPSHOT_H */
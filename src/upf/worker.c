@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "worker.h"
+#include "gtp-path.h"
+#include "snapshot.h"
+
+#if HAVE_LINUX_FILTER_H
+#include <linux/filter.h>
+#endif
+
+/* Messages in flight from a worker before its packets are dropped */
+#define UPF_WORKER_RING_SIZE 1024
+
+static upf_worker_t *worker_array = NULL;
+static int num_of_worker = 0;
+
+static OGS_THREAD_LOCAL upf_worker_t *self_worker = NULL;
+
+static void worker_main(void *data);
+
+int upf_worker_init(void)
+{
+    int i;
+
+    num_of_worker = upf_self()->worker.num;
+    if (!num_of_worker)
+        return OGS_OK;
+
+    worker_array = ogs_calloc(num_of_worker, sizeof(upf_worker_t));
+    ogs_assert(worker_array);
+
+    for (i = 0; i < num_of_worker; i++) {
+        upf_worker_t *worker = &worker_array[i];
+
+        worker->index = i;
+        worker->pollset = ogs_pollset_create(ogs_app()->pool.socket);
+        if (!worker->pollset) {
+            ogs_error("ogs_pollset_create() failed");
+            return OGS_ERROR;
+        }
+        ogs_list_init(&worker->gtpu_list);
+
+        worker->teid_hash = ogs_hash_make();
+        ogs_assert(worker->teid_hash);
+        worker->ipv4_hash = ogs_hash_make();
+        ogs_assert(worker->ipv4_hash);
+        worker->ipv6_hash = ogs_hash_make();
+        ogs_assert(worker->ipv6_hash);
+        worker->ipv4_framed_routes = ogs_lpm_create(OGS_IPV4_LEN << 3);
+        ogs_assert(worker->ipv4_framed_routes);
+        worker->ipv6_framed_routes = ogs_lpm_create(OGS_IPV6_LEN << 3);
+        ogs_assert(worker->ipv6_framed_routes);
+
+        worker->ring.msg = ogs_calloc(
+                UPF_WORKER_RING_SIZE, sizeof(upf_worker_message_t));
+        ogs_assert(worker->ring.msg);
+        worker->ring.mask = UPF_WORKER_RING_SIZE - 1;
+    }
+
+    upf_snapshot_init();
+
+    ogs_info("UPF data plane: %d workers", num_of_worker);
+
+    return OGS_OK;
+}
+
+void upf_worker_final(void)
+{
+    upf_worker_message_t message;
+    int i;
+
+    if (!num_of_worker)
+        return;
+
+    for (i = 0; i < num_of_worker; i++) {
+        upf_worker_t *worker = &worker_array[i];
+
+        ogs_assert(worker->thread == NULL);
+
+        if (worker->ring.msg) {
+            while (upf_worker_pop(worker, &message) == true)
+                if (message.pkbuf)
+                    ogs_pkbuf_free(message.pkbuf);
+            ogs_free(worker->ring.msg);
+        }
+
+        if (worker->teid_hash) {
+            ogs_hash_destroy(worker->teid_hash);
+            ogs_hash_destroy(worker->ipv4_hash);
+            ogs_hash_destroy(worker->ipv6_hash);
+            ogs_lpm_destroy(worker->ipv4_framed_routes);
+            ogs_lpm_destroy(worker->ipv6_framed_routes);
+        }
+
+        if (worker->pollset)
+            ogs_pollset_destroy(worker->pollset);
+    }
+
+    upf_snapshot_final();
+
+    ogs_free(worker_array);
+    worker_array = NULL;
+
+    num_of_worker = 0;
+}
+
+int upf_worker_start(void)
+{
+    int i;
+
+    for (i = 0; i < num_of_worker; i++) {
+        upf_worker_t *worker = &worker_array[i];
+
+        __atomic_store_n(&worker->stop, false, __ATOMIC_RELAXED);
+        worker->thread = ogs_thread_create(worker_main, worker);
+        if (!worker->thread) {
+            ogs_error("ogs_thread_create() failed");
+            return OGS_ERROR;
+        }
+    }
+
+    return OGS_OK;
+}
+
+void upf_worker_stop(void)
+{
+    int i;
+
+    for (i = 0; i < num_of_worker; i++) {
+        upf_worker_t *worker = &worker_array[i];
+
+        if (!worker->thread)
+            continue;
+
+        __atomic_store_n(&worker->stop, true, __ATOMIC_RELEASE);
+        ogs_pollset_notify(worker->pollset);
+
+        ogs_thread_destroy(worker->thread);
+        worker->thread = NULL;
+    }
+}
+
+upf_worker_t *upf_worker_at(int index)
+{
+    ogs_assert(index >= 0 && index < num_of_worker);
+    return &worker_array[index];
+}
+
+upf_worker_t *upf_worker_self(void)
+{
+    return self_worker;
+}
+
+/*
+ * The flag is cleared by the main thread with the same sequentially
+ * consistent exchange before it drains the ring, so a message is
+ * either seen by that drain or followed by another wakeup.
+ */
+bool upf_worker_punt(upf_worker_t *worker, upf_worker_message_t *message)
+{
+    unsigned int head, tail;
+
+    ogs_assert(worker);
+    ogs_assert(message);
+
+    head = worker->ring.head;
+    tail = __atomic_load_n(&worker->ring.tail, __ATOMIC_ACQUIRE);
+    if (head - tail > worker->ring.mask)
+        return false;
+
+    memcpy(&worker->ring.msg[head & worker->ring.mask],
+            message, sizeof(*message));
+
+    __atomic_store_n(&worker->ring.head, head + 1, __ATOMIC_RELEASE);
+
+    if (__atomic_exchange_n(
+                &worker->notified, true, __ATOMIC_SEQ_CST) == false)
+        ogs_pollset_notify(ogs_app()->pollset);
+
+    return true;
+}
+
+bool upf_worker_pop(upf_worker_t *worker, upf_worker_message_t *message)
+{
+    unsigned int head, tail;
+
+    ogs_assert(worker);
+    ogs_assert(message);
+
+    tail = worker->ring.tail;
+    head = __atomic_load_n(&worker->ring.head, __ATOMIC_ACQUIRE);
+    if (head == tail)
+        return false;
+
+    memcpy(message, &worker->ring.msg[tail & worker->ring.mask],
+            sizeof(*message));
+
+    __atomic_store_n(&worker->ring.tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+int upf_worker_steer_by_teid(ogs_sock_t *sock, int num)
+{
+#if HAVE_LINUX_FILTER_H && defined(SO_ATTACH_REUSEPORT_CBPF)
+    /*
+     * The program sees the UDP payload, i.e. the GTP-U header,
+     * and returns the index of the socket in the SO_REUSEPORT group.
+     *
+     * TEID is at offset 4. A short packet makes the load fail
+     * and the program return 0, so it goes to worker#0.
+     */
+    struct sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, 4 },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, 0 },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog prog;
+    int rc;
+
+    ogs_assert(sock);
+    ogs_assert(num > 0);
+
+    code[1].k = num;
+
+    memset(&prog, 0, sizeof(prog));
+    prog.len = OGS_ARRAY_SIZE(code);
+    prog.filter = code;
+
+    rc = setsockopt(sock->fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+            &prog, sizeof(prog));
+    if (rc != 0) {
+        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                "setsockopt(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF) failed");
+        return OGS_ERROR;
+    }
+
+    return OGS_OK;
+#else
+    ogs_error("SO_ATTACH_REUSEPORT_CBPF is not supported");
+    return OGS_ERROR;
+#endif
+}
+
+static void worker_main(void *data)
+{
+    upf_worker_t *worker = data;
+    ogs_assert(worker);
+
+    self_worker = worker;
+
+    upf_gtp_thread_init();
+
+    while (!__atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE)) {
+        upf_snapshot_sync(worker);
+        ogs_pollset_poll(worker->pollset, OGS_INFINITE_TIME);
+    }
+
+    upf_gtp_thread_final();
+
+    self_worker = NULL;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPF_WORKER_H
+#define UPF_WORKER_H
+
+#include "context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Data plane worker
+ *
+ * With upf.worker.num > 0, GTP-U and TUN I/O leave the main thread.
+ * Every worker polls its own SO_REUSEPORT GTP-U socket per address,
+ * steered by TEID, and its own queue of each multi-queue TUN device.
+ *
+ * Workers do not share any state with the main thread(PFCP, timers).
+ * Sessions are published to them as snapshots(see snapshot.h) looked up
+ * in tables of their own, and packets they cannot handle alone are
+ * passed to the main thread through a ring.
+ */
+#define UPF_WORKER_GTPU         1   /* GTP-U packet with its header */
+#define UPF_WORKER_TUN          2   /* IP packet from the TUN device */
+#define UPF_WORKER_URR_REPORT   3   /* Volume trigger reached */
+
+typedef struct upf_worker_message_s {
+    int             type;
+
+    ogs_pkbuf_t     *pkbuf;
+    ogs_sock_t      *sock;
+    ogs_sockaddr_t  from;
+    ogs_socket_t    fd;
+
+    ogs_pool_id_t   sess_id;
+    ogs_pfcp_urr_id_t urr_id;
+} upf_worker_message_t;
+
+struct upf_snapshot_update_s;
+
+typedef struct upf_worker_s {
+    int             index;
+
+    ogs_thread_t    *thread;
+    ogs_pollset_t   *pollset;
+    bool            stop;
+
+    ogs_list_t      gtpu_list;  /* GTP-U sockets (not used by worker#0) */
+
+    struct {
+        ogs_socket_t fd;
+        ogs_poll_t  *poll;
+    } tun[OGS_MAX_NUM_OF_DEV];  /* TUN queues (not used by worker#0) */
+    int             num_of_tun;
+
+    /* Snapshots by key, updated by the worker only */
+    ogs_hash_t      *teid_hash;
+    ogs_hash_t      *ipv4_hash;
+    ogs_hash_t      *ipv6_hash;
+    ogs_lpm_t       *ipv4_framed_routes;
+    ogs_lpm_t       *ipv6_framed_routes;
+
+    struct upf_snapshot_update_s *cursor;
+    uint64_t        gen;        /* Read by the main thread */
+
+    /* Messages to the main thread */
+    struct {
+        upf_worker_message_t *msg;
+        unsigned int mask;
+        unsigned int head;      /* Written by the worker */
+        unsigned int tail;      /* Written by the main thread */
+    } ring;
+    bool            notified;
+
+    /* Packets dropped on a full ring, not logged yet */
+    struct {
+        uint64_t    num;
+        ogs_time_t  logged;
+    } drop;
+} upf_worker_t;
+
+int upf_worker_init(void);
+void upf_worker_final(void);
+
+int upf_worker_start(void);
+void upf_worker_stop(void);
+
+upf_worker_t *upf_worker_at(int index);
+upf_worker_t *upf_worker_self(void);
+
+bool upf_worker_punt(upf_worker_t *worker, upf_worker_message_t *message);
+bool upf_worker_pop(upf_worker_t *worker, upf_worker_message_t *message);
+
+int upf_worker_steer_by_teid(ogs_sock_t *sock, int num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_WORKER_H */
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "test-common.h"
+
+/*
+ * Keep NUM_OF_UE_PER_GNB contexts alive on a single gNB
+ * and measure how long the AMF takes to answer an InitialUEMessage
+ * as the number of UEs grows. Every InitialUEMessage is looked up
+ * by RAN-UE-NGAP-ID, so the cost should not depend on the load.
+ * The results are printed on stdout.
+ *
+ * Each UE stops at the Identity request (unknown 5G-GUTI),
+ * which is answered by the AMF itself without any SBI round trip.
+ */
+#define NUM_OF_UE_PER_GNB   512
+#define NUM_OF_UE_PER_STEP  64
+
+static void test1_func(abts_case *tc, void *data)
+{
+    int rv;
+    ogs_socknode_t *ngap;
+    ogs_pkbuf_t *gmmbuf;
+    ogs_pkbuf_t *sendbuf;
+    ogs_pkbuf_t *recvbuf;
+    int i, j;
+
+    ogs_nas_5gs_mobile_identity_suci_t mobile_identity_suci;
+    test_ue_t *test_ue = NULL;
+
+    uint64_t ran_ue_ngap_id[NUM_OF_UE_PER_GNB];
+    uint64_t amf_ue_ngap_id[NUM_OF_UE_PER_GNB];
+    int unexpected = 0;
+
+    ogs_time_t start, elapsed;
+
+    /* Setup Test UE Context */
+    memset(&mobile_identity_suci, 0, sizeof(mobile_identity_suci));
+
+    mobile_identity_suci.h.supi_format = OGS_NAS_5GS_SUPI_FORMAT_IMSI;
+    mobile_identity_suci.h.type = OGS_NAS_5GS_MOBILE_IDENTITY_SUCI;
+    mobile_identity_suci.routing_indicator1 = 0;
+    mobile_identity_suci.routing_indicator2 = 0xf;
+    mobile_identity_suci.routing_indicator3 = 0xf;
+    mobile_identity_suci.routing_indicator4 = 0xf;
+    mobile_identity_suci.protection_scheme_id = OGS_PROTECTION_SCHEME_NULL;
+    mobile_identity_suci.home_network_pki_value = 0;
+
+    test_ue = test_ue_add_by_suci(&mobile_identity_suci, "0000203191");
+    ogs_assert(test_ue);
+
+    test_ue->nr_cgi.cell_id = 0x40001;
+
+    test_ue->nas.registration.tsc = 0;
+    test_ue->nas.registration.ksi = OGS_NAS_KSI_NO_KEY_IS_AVAILABLE;
+    test_ue->nas.registration.follow_on_request = 1;
+    test_ue->nas.registration.value = OGS_NAS_5GS_REGISTRATION_TYPE_INITIAL;
+
+    test_ue->k_string = "465b5ce8b199b49faa5f0a2ee238a6bc";
+    test_ue->opc_string = "e8ed289deba952e4283b54e88e6183ca";
+
+    /* gNB connects to AMF */
+    ngap = testngap_client(1, AF_INET);
+    ABTS_PTR_NOTNULL(tc, ngap);
+
+    /* Send NG-Setup Reqeust */
+    sendbuf = testngap_build_ng_setup_request(0x4000, 22);
+    ABTS_PTR_NOTNULL(tc, sendbuf);
+    rv = testgnb_ngap_send(ngap, sendbuf);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    /* Receive NG-Setup Response */
+    recvbuf = testgnb_ngap_read(ngap);
+    ABTS_PTR_NOTNULL(tc, recvbuf);
+    testngap_recv(test_ue, recvbuf);
+
+    test_ue->ran_ue_ngap_id = 0;
+    test_ue->registration_request_param.guti = 1;
+
+    for (i = 0; i < NUM_OF_UE_PER_GNB; i += NUM_OF_UE_PER_STEP) {
+        start = ogs_get_monotonic_time();
+
+        for (j = i; j < i + NUM_OF_UE_PER_STEP; j++) {
+            /* Send Registration request with a new RAN-UE-NGAP-ID */
+            gmmbuf = testgmm_build_registration_request(
+                    test_ue, NULL, false, false);
+            ABTS_PTR_NOTNULL(tc, gmmbuf);
+            sendbuf = testngap_build_initial_ue_message(test_ue, gmmbuf,
+                        NGAP_RRCEstablishmentCause_mo_Signalling, false, true);
+            ABTS_PTR_NOTNULL(tc, sendbuf);
+            rv = testgnb_ngap_send(ngap, sendbuf);
+            ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+            /* Receive Identity request */
+            recvbuf = testgnb_ngap_read(ngap);
+            ABTS_PTR_NOTNULL(tc, recvbuf);
+            testngap_recv(test_ue, recvbuf);
+            if (test_ue->gmm_message_type != OGS_NAS_5GS_IDENTITY_REQUEST)
+                unexpected++;
+
+            ran_ue_ngap_id[j] = test_ue->ran_ue_ngap_id;
+            amf_ue_ngap_id[j] = test_ue->amf_ue_ngap_id;
+        }
+
+        elapsed = ogs_get_monotonic_time() - start;
+        printf("[%d-%d UEs per gNB] InitialUEMessage : %lld usec\n",
+                i, i + NUM_OF_UE_PER_STEP,
+                (long long)(elapsed / NUM_OF_UE_PER_STEP));
+    }
+
+    ABTS_INT_EQUAL(tc, 0, unexpected);
+
+    /* INVALID SUCI */
+    ((uint8_t *)(test_ue->mobile_identity.buffer))[9] = 0x99;
+
+    for (i = 0; i < NUM_OF_UE_PER_GNB; i++) {
+        test_ue->ran_ue_ngap_id = ran_ue_ngap_id[i];
+        test_ue->amf_ue_ngap_id = amf_ue_ngap_id[i];
+
+        /* Send Identity response */
+        gmmbuf = testgmm_build_identity_response(test_ue);
+        ABTS_PTR_NOTNULL(tc, gmmbuf);
+        sendbuf = testngap_build_uplink_nas_transport(test_ue, gmmbuf);
+        ABTS_PTR_NOTNULL(tc, sendbuf);
+        rv = testgnb_ngap_send(ngap, sendbuf);
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+        /* Receive Registration reject */
+        recvbuf = testgnb_ngap_read(ngap);
+        ABTS_PTR_NOTNULL(tc, recvbuf);
+        testngap_recv(test_ue, recvbuf);
+        ABTS_INT_EQUAL(tc,
+                OGS_NAS_5GS_REGISTRATION_REJECT, test_ue->gmm_message_type);
+
+        /* Receive UEContextReleaseCommand */
+        recvbuf = testgnb_ngap_read(ngap);
+        ABTS_PTR_NOTNULL(tc, recvbuf);
+        testngap_recv(test_ue, recvbuf);
+        ABTS_INT_EQUAL(tc,
+                NGAP_ProcedureCode_id_UEContextRelease,
+                test_ue->ngap_procedure_code);
+
+        /* Send UEContextReleaseComplete */
+        sendbuf = testngap_build_ue_context_release_complete(test_ue);
+        ABTS_PTR_NOTNULL(tc, sendbuf);
+        rv = testgnb_ngap_send(ngap, sendbuf);
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    }
+
+    ogs_msleep(300);
+
+    /* gNB disonncect from AMF */
+    testgnb_ngap_close(ngap);
+
+    /* Clear Test UE Context */
+    test_ue_remove(test_ue);
+}
+
+abts_suite *test_gnb_load(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+
+    return suite;
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+#include "core/abts.h"
+
+/*
+ * Install NUM_OF_SESS UPF sessions, each owning a /30, /31 or /32
+ * as a UE address or a small framed route, and measure the lookup
+ * and the update of ogs_lpm against the trie it replaced.
+ * The results are printed on stdout.
+ */
+#define NUM_OF_SESS     (1024*1024)
+#define NUM_OF_LOOKUP   (1024*1024)
+
+#define DATA(__nUM) ((void *)(uintptr_t)(__nUM))
+#define LEN(__iNDEX) (30 + (__iNDEX) % 3)
+
+/*
+ * Reference: the bit-by-bit binary trie the UPF used for framed routes
+ */
+typedef struct trie_node_s {
+    struct trie_node_s *left;
+    struct trie_node_s *right;
+    void *data;
+} trie_node_t;
+
+typedef struct trie_s {
+    trie_node_t *root;
+    trie_node_t *node;      /* Preallocated nodes */
+    int num_of_node;
+    int max_num_of_node;
+} trie_t;
+
+static trie_node_t *trie_node_alloc(trie_t *trie)
+{
+    ogs_assert(trie->num_of_node < trie->max_num_of_node);
+    return &trie->node[trie->num_of_node++];
+}
+
+static void trie_add(trie_t *trie, uint32_t addr, int len, void *data)
+{
+    trie_node_t **node = &trie->root;
+    uint32_t host = be32toh(addr);
+    int i;
+
+    for (i = 0; i <= len; i++) {
+        if (!*node)
+            *node = trie_node_alloc(trie);
+        if (i == len) {
+            (*node)->data = data;
+            return;
+        }
+        node = ((host >> (31 - i)) & 1) ? &(*node)->right : &(*node)->left;
+    }
+}
+
+static void trie_delete(trie_t *trie, uint32_t addr, int len)
+{
+    trie_node_t *node = trie->root;
+    uint32_t host = be32toh(addr);
+    int i;
+
+    for (i = 0; i < len && node; i++)
+        node = ((host >> (31 - i)) & 1) ? node->right : node->left;
+
+    if (node)
+        node->data = NULL;
+}
+
+static void *trie_find(trie_t *trie, uint32_t addr)
+{
+    trie_node_t *node = trie->root;
+    uint32_t host = be32toh(addr);
+    void *found = NULL;
+    int i;
+
+    for (i = 0; node; i++) {
+        if (node->data)
+            found = node->data;
+        if (i == 32)
+            break;
+        node = ((host >> (31 - i)) & 1) ? node->right : node->left;
+    }
+
+    return found;
+}
+
+static uint32_t test_seed;
+
+static uint32_t test_random(void)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 17;
+    test_seed ^= test_seed << 5;
+    return test_seed;
+}
+
+static void print_result(const char *name, const char *what,
+        int num, ogs_time_t elapsed)
+{
+    printf("%d sessions, %s %s : %lld nsec per %s\n", NUM_OF_SESS,
+            name, what, (long long)(elapsed * 1000 / num), what);
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    trie_t trie;
+    uint32_t *addr = NULL, *lookup = NULL;
+    int i, rv = OGS_OK, mismatch = 0;
+    uintptr_t sum = 0;
+    ogs_time_t start;
+
+    memset(&trie, 0, sizeof(trie));
+    trie.max_num_of_node = NUM_OF_SESS * 4;
+    trie.node = calloc(trie.max_num_of_node, sizeof(trie_node_t));
+    ogs_assert(trie.node);
+
+    addr = calloc(NUM_OF_SESS, sizeof(uint32_t));
+    ogs_assert(addr);
+    lookup = calloc(NUM_OF_LOOKUP, sizeof(uint32_t));
+    ogs_assert(lookup);
+
+    test_seed = 2463534242U;
+
+    for (i = 0; i < NUM_OF_SESS; i++)
+        addr[i] = htobe32(0x0a000000 + (i << 2));
+    for (i = 0; i < NUM_OF_LOOKUP; i++)
+        lookup[i] = htobe32(0x0a000000 +
+                (test_random() % (NUM_OF_SESS << 2)));
+
+    lpm = ogs_lpm_create(32);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    /* Session Establishment */
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_SESS; i++)
+        rv |= ogs_lpm_add(lpm, &addr[i], LEN(i), DATA(i + 1));
+    print_result("lpm", "add", NUM_OF_SESS, ogs_get_monotonic_time() - start);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, NUM_OF_SESS, ogs_lpm_count(lpm));
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_SESS; i++)
+        trie_add(&trie, addr[i], LEN(i), DATA(i + 1));
+    print_result("trie", "add", NUM_OF_SESS, ogs_get_monotonic_time() - start);
+
+    /* Downlink packets */
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++)
+        sum += (uintptr_t)ogs_lpm_find(lpm, &lookup[i]);
+    print_result("lpm", "find",
+            NUM_OF_LOOKUP, ogs_get_monotonic_time() - start);
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_LOOKUP; i++)
+        sum -= (uintptr_t)trie_find(&trie, lookup[i]);
+    print_result("trie", "find",
+            NUM_OF_LOOKUP, ogs_get_monotonic_time() - start);
+
+    ABTS_TRUE(tc, sum == 0);
+
+    for (i = 0; i < NUM_OF_LOOKUP; i++)
+        if (ogs_lpm_find(lpm, &lookup[i]) != trie_find(&trie, lookup[i]))
+            mismatch++;
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    /* Session Release */
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_SESS; i++)
+        ogs_lpm_delete(lpm, &addr[i], LEN(i));
+    print_result("lpm", "delete",
+            NUM_OF_SESS, ogs_get_monotonic_time() - start);
+    ABTS_INT_EQUAL(tc, 0, ogs_lpm_count(lpm));
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_SESS; i++)
+        trie_delete(&trie, addr[i], LEN(i));
+    print_result("trie", "delete",
+            NUM_OF_SESS, ogs_get_monotonic_time() - start);
+
+    ogs_lpm_destroy(lpm);
+    free(trie.node);
+    free(lookup);
+    free(addr);
+}
+
+abts_suite *test_lpm(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+
+    return suite;
+}
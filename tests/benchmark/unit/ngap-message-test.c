@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-ngap.h"
+#include "core/abts.h"
+
+static ogs_pkbuf_t *build_uplink_nas_transport(
+        uint64_t ran_ue_ngap_id, uint64_t amf_ue_ngap_id, ogs_pkbuf_t *gmmbuf)
+{
+    const char *payload =
+        "7e005c00 0d0199f9 07f0ff00 00000020"
+        "3190";
+    char hexbuf[OGS_HUGE_LEN];
+
+    NGAP_NGAP_PDU_t pdu;
+    NGAP_InitiatingMessage_t *initiatingMessage = NULL;
+    NGAP_UplinkNASTransport_t *UplinkNASTransport = NULL;
+
+    NGAP_UplinkNASTransport_IEs_t *ie = NULL;
+    NGAP_AMF_UE_NGAP_ID_t *AMF_UE_NGAP_ID = NULL;
+    NGAP_RAN_UE_NGAP_ID_t *RAN_UE_NGAP_ID = NULL;
+    NGAP_NAS_PDU_t *NAS_PDU = NULL;
+    NGAP_UserLocationInformation_t *UserLocationInformation = NULL;
+    NGAP_UserLocationInformationNR_t *userLocationInformationNR = NULL;
+    NGAP_NR_CGI_t *nR_CGI = NULL;
+    NGAP_TAI_t *tAI = NULL;
+
+    ogs_nr_cgi_t nr_cgi;
+    ogs_5gs_tai_t nr_tai;
+
+    ogs_assert(gmmbuf);
+
+    memset(&pdu, 0, sizeof (NGAP_NGAP_PDU_t));
+    pdu.present = NGAP_NGAP_PDU_PR_initiatingMessage;
+    pdu.choice.initiatingMessage =
+        CALLOC(1, sizeof(NGAP_InitiatingMessage_t));
+
+    initiatingMessage = pdu.choice.initiatingMessage;
+    initiatingMessage->procedureCode =
+        NGAP_ProcedureCode_id_UplinkNASTransport;
+    initiatingMessage->criticality = NGAP_Criticality_ignore;
+    initiatingMessage->value.present =
+        NGAP_InitiatingMessage__value_PR_UplinkNASTransport;
+
+    UplinkNASTransport =
+        &initiatingMessage->value.choice.UplinkNASTransport;
+
+    ie = CALLOC(1, sizeof(NGAP_UplinkNASTransport_IEs_t));
+    ASN_SEQUENCE_ADD(&UplinkNASTransport->protocolIEs, ie);
+
+    ie->id = NGAP_ProtocolIE_ID_id_AMF_UE_NGAP_ID;
+    ie->criticality = NGAP_Criticality_reject;
+    ie->value.present = NGAP_UplinkNASTransport_IEs__value_PR_AMF_UE_NGAP_ID;
+
+    AMF_UE_NGAP_ID = &ie->value.choice.AMF_UE_NGAP_ID;
+
+    ie = CALLOC(1, sizeof(NGAP_UplinkNASTransport_IEs_t));
+    ASN_SEQUENCE_ADD(&UplinkNASTransport->protocolIEs, ie);
+
+    ie->id = NGAP_ProtocolIE_ID_id_RAN_UE_NGAP_ID;
+    ie->criticality = NGAP_Criticality_reject;
+    ie->value.present = NGAP_UplinkNASTransport_IEs__value_PR_RAN_UE_NGAP_ID;
+
+    RAN_UE_NGAP_ID = &ie->value.choice.RAN_UE_NGAP_ID;
+
+    ie = CALLOC(1, sizeof(NGAP_UplinkNASTransport_IEs_t));
+    ASN_SEQUENCE_ADD(&UplinkNASTransport->protocolIEs, ie);
+
+    ie->id = NGAP_ProtocolIE_ID_id_NAS_PDU;
+    ie->criticality = NGAP_Criticality_reject;
+    ie->value.present = NGAP_UplinkNASTransport_IEs__value_PR_NAS_PDU;
+
+    NAS_PDU = &ie->value.choice.NAS_PDU;
+
+    ie = CALLOC(1, sizeof(NGAP_UplinkNASTransport_IEs_t));
+    ASN_SEQUENCE_ADD(&UplinkNASTransport->protocolIEs, ie);
+
+    ie->id = NGAP_ProtocolIE_ID_id_UserLocationInformation;
+    ie->criticality = NGAP_Criticality_ignore;
+    ie->value.present =
+        NGAP_UplinkNASTransport_IEs__value_PR_UserLocationInformation;
+
+    UserLocationInformation = &ie->value.choice.UserLocationInformation;
+
+    asn_uint642INTEGER(AMF_UE_NGAP_ID, amf_ue_ngap_id);
+    *RAN_UE_NGAP_ID = ran_ue_ngap_id;
+
+    NAS_PDU->size = gmmbuf->len;
+    NAS_PDU->buf = CALLOC(NAS_PDU->size, sizeof(uint8_t));
+    memcpy(NAS_PDU->buf, gmmbuf->data, NAS_PDU->size);
+    ogs_pkbuf_free(gmmbuf);
+
+    userLocationInformationNR =
+            CALLOC(1, sizeof(NGAP_UserLocationInformationNR_t));
+
+    nR_CGI = &userLocationInformationNR->nR_CGI;
+    ogs_ngap_nr_cgi_to_ASN(&nr_cgi, nR_CGI);
+
+    tAI = &userLocationInformationNR->tAI;
+    ogs_ngap_5gs_tai_to_ASN(&nr_tai, tAI);
+
+    UserLocationInformation->present =
+        NGAP_UserLocationInformation_PR_userLocationInformationNR;
+    UserLocationInformation->choice.userLocationInformationNR =
+        userLocationInformationNR;
+
+    return ogs_ngap_encode(&pdu);
+}
+
+/*
+ * Cost of decoding and encoding captured NGAP messages, in ns and in
+ * allocations per message. ogs_ngap_decode() builds the tree in an arena,
+ * while aper_decode() alone builds it from the heap as before.
+ * The results are printed on stdout.
+ */
+#define NGAP_BENCH_LOOP 10000
+
+static void ngap_bench(abts_case *tc, const char *name, ogs_pkbuf_t *pkbuf)
+{
+    ogs_ngap_message_t message, *struct_ptr = &message;
+    ogs_pkbuf_t *encoded = NULL;
+    asn_dec_rval_t dec_ret = {0};
+    ogs_time_t start, usec[3];
+    uint64_t count[3];
+    int i, rv;
+
+    rv = ogs_ngap_decode(&message, pkbuf);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    encoded = ogs_ngap_encode(&message);
+    ABTS_PTR_NOTNULL(tc, encoded);
+    ABTS_INT_EQUAL(tc, pkbuf->len, encoded->len);
+    ABTS_TRUE(tc, memcmp(pkbuf->data, encoded->data, pkbuf->len) == 0);
+    ogs_pkbuf_free(encoded);
+
+#define BENCH(__n, __stmt) do { \
+        count[__n] = ogs_asn_alloc_count(); \
+        start = ogs_get_monotonic_time(); \
+        for (i = 0; i < NGAP_BENCH_LOOP; i++) { __stmt; } \
+        usec[__n] = ogs_get_monotonic_time() - start; \
+        count[__n] = ogs_asn_alloc_count() - count[__n]; \
+    } while (0)
+
+    BENCH(0,
+        memset(&message, 0, sizeof(message));
+        dec_ret = aper_decode(NULL, &asn_DEF_NGAP_NGAP_PDU,
+                (void **)&struct_ptr, pkbuf->data, pkbuf->len, 0, 0);
+        ogs_assert(dec_ret.code == RC_OK);
+        ogs_ngap_free(&message));
+    BENCH(1,
+        rv = ogs_ngap_decode(&message, pkbuf);
+        ogs_assert(rv == OGS_OK);
+        ogs_ngap_free(&message));
+    BENCH(2,
+        rv = ogs_ngap_decode(&message, pkbuf);
+        ogs_assert(rv == OGS_OK);
+        encoded = ogs_ngap_encode(&message);
+        ogs_assert(encoded);
+        ogs_pkbuf_free(encoded));
+
+#undef BENCH
+
+#define NSEC(__n) ((long long)usec[__n] * 1000 / NGAP_BENCH_LOOP)
+#define ALLOC(__n) ((long long)count[__n] / NGAP_BENCH_LOOP)
+    printf("[%s:%d bytes] decode %lld ns/%lld allocs "
+            "(heap %lld ns/%lld allocs), encode %lld ns/%lld allocs\n",
+            name, pkbuf->len, NSEC(1), ALLOC(1), NSEC(0), ALLOC(0),
+            NSEC(2) - NSEC(1), ALLOC(2) - ALLOC(1));
+#undef NSEC
+#undef ALLOC
+}
+
+static void ngap_message_test1(abts_case *tc, void *data)
+{
+    static const struct {
+        const char *name;
+        const char *payload;
+        int len;
+    } captured[] = {
+        { "NGSetupRequest",
+          "0015004200000500 1b00090009f10728 000800000052400b 0400354720674e42"
+          "2d43550066000d00 000000010009f107 0000000800154001 0001114009403035"
+          "484c41423032", 70 },
+        { "NGSetupRequest",
+          "0015003f00000500 1b00080045f01000 0000040052400903 0035484c41423032"
+          "0066000d00000062 280045f010000000 0800154001400111 4009203035484c41"
+          "423032", 67 },
+        { "NGReset",
+          "0014001300000200 0f400200c0005800 06400160010001", 23 },
+    };
+    const char *payload =
+        "7e005c00 0d0199f9 07f0ff00 00000020"
+        "3190";
+    ogs_pkbuf_t *pkbuf = NULL;
+    char hexbuf[OGS_HUGE_LEN];
+    int i;
+
+    for (i = 0; i < OGS_ARRAY_SIZE(captured); i++) {
+        pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+        ogs_assert(pkbuf);
+        ogs_pkbuf_put_data(pkbuf, ogs_hex_from_string(
+                captured[i].payload, hexbuf, sizeof(hexbuf)), captured[i].len);
+
+        ngap_bench(tc, captured[i].name, pkbuf);
+
+        ogs_pkbuf_free(pkbuf);
+    }
+
+    /* UplinkNASTransport(Registration Request) */
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 18);
+
+    pkbuf = build_uplink_nas_transport(1, 2, pkbuf);
+    ogs_assert(pkbuf);
+
+    ngap_bench(tc, "UplinkNASTransport", pkbuf);
+
+    ogs_pkbuf_free(pkbuf);
+}
+
+abts_suite *test_ngap_message(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    ogs_log_install_domain(&__ogs_ngap_domain, "ngap", OGS_LOG_ERROR);
+
+    abts_run_test(suite, ngap_message_test1, NULL);
+
+    return suite;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+#include "core/abts.h"
+
+#define NUM_OF_PDR 4
+#define NUM_OF_SDF_FILTER 2
+
+/* Session Establishment Request with a few PDRs and FARs */
+static ogs_pkbuf_t *pfcp_message_test_build(uint64_t seid)
+{
+    ogs_pfcp_message_t *pfcp_message = NULL;
+    ogs_pfcp_session_establishment_request_t *req = NULL;
+    ogs_pfcp_header_t *h = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+    int i, j;
+
+    static uint8_t node_id[] = { 0x00, 0x0a, 0x00, 0x00, 0x01 };
+    static uint8_t f_seid[] = {
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0x0a, 0x00, 0x00, 0x01 };
+    static uint8_t sdf_filter[] =
+        "\x01\x00\x00\x1a" "permit out ip from any to assigned";
+
+    pfcp_message = ogs_calloc(1, sizeof(*pfcp_message));
+    ogs_assert(pfcp_message);
+    req = &pfcp_message->pfcp_session_establishment_request;
+
+    pfcp_message->h.type = OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE;
+
+    req->node_id.presence = 1;
+    req->node_id.data = node_id;
+    req->node_id.len = sizeof(node_id);
+
+    req->cp_f_seid.presence = 1;
+    req->cp_f_seid.data = f_seid;
+    req->cp_f_seid.len = sizeof(f_seid);
+
+    for (i = 0; i < NUM_OF_PDR; i++) {
+        ogs_pfcp_tlv_create_pdr_t *create_pdr = &req->create_pdr[i];
+        ogs_pfcp_tlv_create_far_t *create_far = &req->create_far[i];
+
+        create_pdr->presence = 1;
+        create_pdr->pdr_id.presence = 1;
+        create_pdr->pdr_id.u16 = i + 1;
+        create_pdr->precedence.presence = 1;
+        create_pdr->precedence.u32 = 255 - i;
+        create_pdr->pdi.presence = 1;
+        create_pdr->pdi.source_interface.presence = 1;
+        create_pdr->pdi.source_interface.u8 = i & 1;
+        for (j = 0; j < NUM_OF_SDF_FILTER; j++) {
+            create_pdr->pdi.sdf_filter[j].presence = 1;
+            create_pdr->pdi.sdf_filter[j].data = sdf_filter;
+            create_pdr->pdi.sdf_filter[j].len = sizeof(sdf_filter) - 1;
+        }
+        create_pdr->far_id.presence = 1;
+        create_pdr->far_id.u32 = i + 1;
+
+        create_far->presence = 1;
+        create_far->far_id.presence = 1;
+        create_far->far_id.u32 = i + 1;
+        create_far->apply_action.presence = 1;
+        create_far->apply_action.u16 = OGS_PFCP_APPLY_ACTION_FORW;
+    }
+
+    req->pdn_type.presence = 1;
+    req->pdn_type.u8 = OGS_PDU_SESSION_TYPE_IPV4;
+
+    pkbuf = ogs_pfcp_build_msg(pfcp_message);
+    ogs_assert(pkbuf);
+    ogs_pfcp_message_free(pfcp_message);
+
+    ogs_assert(ogs_pkbuf_push(pkbuf, OGS_PFCP_HEADER_LEN));
+    h = (ogs_pfcp_header_t *)pkbuf->data;
+    memset(h, 0, OGS_PFCP_HEADER_LEN);
+    h->version = OGS_PFCP_VERSION;
+    h->seid_presence = 1;
+    h->type = OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE;
+    h->length = htobe16(pkbuf->len - 4);
+    h->seid = htobe64(seid);
+    h->sqn = OGS_PFCP_XID_TO_SQN(1);
+
+    return pkbuf;
+}
+
+/*
+ * Decode rate of a Session Establishment Request.
+ * The results are printed on stdout.
+ */
+#define BENCH_LOOP 100000
+
+static void pfcp_message_test1(abts_case *tc, void *data)
+{
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_pfcp_message_t *pfcp_message = NULL;
+    ogs_time_t start, usec;
+    int i, len;
+
+    pkbuf = pfcp_message_test_build(1);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    len = pkbuf->len;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < BENCH_LOOP; i++) {
+        pfcp_message = ogs_pfcp_parse_msg(pkbuf);
+        ogs_assert(pfcp_message);
+        ogs_pfcp_message_free(pfcp_message);
+        ogs_pkbuf_push(pkbuf, OGS_PFCP_HEADER_LEN);
+    }
+    usec = ogs_get_monotonic_time() - start;
+    if (usec == 0) usec = 1;
+
+    printf("[%d bytes] %lld ns per Session Establishment Request\n", len,
+            (long long)usec * 1000 / BENCH_LOOP);
+
+    ogs_pkbuf_free(pkbuf);
+}
+
+abts_suite *test_pfcp_message(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, pfcp_message_test1, NULL);
+
+    return suite;
+}
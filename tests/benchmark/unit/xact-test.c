@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+#include "core/abts.h"
+
+/*
+ * Keep NUM_OF_XACT PFCP transactions outstanding on a single node
+ * and measure how long the response lookup takes,
+ * as during a mass session setup over one SMF-UPF association.
+ * The results are printed on stdout.
+ */
+#define NUM_OF_XACT     100000
+
+static ogs_pfcp_xact_t *xact[NUM_OF_XACT];
+
+static ogs_pkbuf_t *test_pkbuf_alloc(void)
+{
+    ogs_pkbuf_t *pkbuf = ogs_pkbuf_alloc(NULL, OGS_TLV_MAX_HEADROOM);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_reserve(pkbuf, OGS_TLV_MAX_HEADROOM);
+
+    return pkbuf;
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    int rv, i;
+    int unexpected = 0;
+    uint32_t xid;
+    ogs_sockaddr_t *addr = NULL;
+    ogs_pfcp_node_t node;
+    ogs_pfcp_header_t h;
+    ogs_pfcp_xact_t *found = NULL;
+    ogs_timer_mgr_t *timer_mgr = ogs_app()->timer_mgr;
+    uint64_t pool_xact = ogs_app()->pool.xact;
+    ogs_time_t start, elapsed;
+
+    ogs_app()->pool.xact = NUM_OF_XACT * 2;
+
+    /* Timers are never expired in this test */
+    ogs_local_conf()->time.message.pfcp.t1_response_duration =
+        ogs_time_from_sec(3);
+    ogs_local_conf()->time.message.pfcp.t1_holding_duration =
+        ogs_time_from_sec(12);
+    ogs_app()->timer_mgr = ogs_timer_mgr_create(NUM_OF_XACT * 2 * 3);
+    ogs_assert(ogs_app()->timer_mgr);
+
+    ogs_pfcp_xact_init();
+
+    rv = ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1", OGS_PFCP_UDP_PORT, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    memset(&node, 0, sizeof(node));
+    node.addr_list = addr;
+    ogs_list_init(&node.local_list);
+    ogs_list_init(&node.remote_list);
+
+    /* Send PFCP Session Establishment Requests */
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_XACT; i++) {
+        memset(&h, 0, sizeof(h));
+        h.type = OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE;
+        h.seid = i;
+
+        xact[i] = ogs_pfcp_xact_local_create(&node, NULL, NULL);
+        ogs_assert(xact[i]);
+        rv = ogs_pfcp_xact_update_tx(xact[i], &h, test_pkbuf_alloc());
+        ogs_assert(rv == OGS_OK);
+    }
+    elapsed = ogs_get_monotonic_time() - start;
+    printf("%d PFCP requests : %lld nsec per request\n", NUM_OF_XACT,
+            (long long)(elapsed * 1000 / NUM_OF_XACT));
+
+    /* Receive the responses in the reverse order */
+    start = ogs_get_monotonic_time();
+    for (i = NUM_OF_XACT - 1; i >= 0; i--) {
+        memset(&h, 0, sizeof(h));
+        h.type = OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE;
+        h.sqn = OGS_PFCP_XID_TO_SQN(xact[i]->xid);
+
+        found = NULL;
+        rv = ogs_pfcp_xact_receive(&node, &h, &found);
+        if (rv != OGS_OK || found != xact[i])
+            unexpected++;
+    }
+    elapsed = ogs_get_monotonic_time() - start;
+    printf("%d PFCP responses : %lld nsec per response\n", NUM_OF_XACT,
+            (long long)(elapsed * 1000 / NUM_OF_XACT));
+
+    ABTS_INT_EQUAL(tc, 0, unexpected);
+
+    /* Receive the peer requests, and their retransmissions */
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < NUM_OF_XACT; i++) {
+        memset(&h, 0, sizeof(h));
+        h.type = OGS_PFCP_SESSION_REPORT_REQUEST_TYPE;
+        h.sqn = OGS_PFCP_XID_TO_SQN(i + 1);
+
+        found = NULL;
+        rv = ogs_pfcp_xact_receive(&node, &h, &found);
+        if (rv != OGS_OK || !found ||
+            found->org != OGS_PFCP_REMOTE_ORIGINATOR)
+            unexpected++;
+    }
+    elapsed = ogs_get_monotonic_time() - start;
+    printf("%d PFCP peer requests : %lld nsec per request\n", NUM_OF_XACT,
+            (long long)(elapsed * 1000 / NUM_OF_XACT));
+
+    ABTS_INT_EQUAL(tc, 0, unexpected);
+    ABTS_INT_EQUAL(tc, NUM_OF_XACT, ogs_list_count(&node.remote_list));
+
+    /* A retransmitted request is matched with its transaction */
+    memset(&h, 0, sizeof(h));
+    h.type = OGS_PFCP_SESSION_REPORT_REQUEST_TYPE;
+    h.sqn = OGS_PFCP_XID_TO_SQN(NUM_OF_XACT / 2);
+    rv = ogs_pfcp_xact_receive(&node, &h, &found);
+    ABTS_INT_EQUAL(tc, OGS_RETRY, rv);
+    ABTS_INT_EQUAL(tc, NUM_OF_XACT, ogs_list_count(&node.remote_list));
+
+    /* A response to a deleted transaction is not matched */
+    xid = xact[0]->xid;
+    ogs_pfcp_xact_delete(xact[0]);
+
+    memset(&h, 0, sizeof(h));
+    h.type = OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE;
+    h.sqn = OGS_PFCP_XID_TO_SQN(xid);
+    rv = ogs_pfcp_xact_receive(&node, &h, &found);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, rv);
+    ABTS_INT_EQUAL(tc, NUM_OF_XACT - 1, ogs_list_count(&node.local_list));
+    ABTS_INT_EQUAL(tc, NUM_OF_XACT, ogs_list_count(&node.remote_list));
+
+    ogs_pfcp_xact_delete_all(&node);
+    ABTS_INT_EQUAL(tc, 0, ogs_list_count(&node.local_list));
+    ABTS_INT_EQUAL(tc, 0, ogs_list_count(&node.remote_list));
+
+    ogs_freeaddrinfo(addr);
+
+    ogs_pfcp_xact_final();
+
+    ogs_timer_mgr_destroy(ogs_app()->timer_mgr);
+    ogs_app()->timer_mgr = timer_mgr;
+    ogs_app()->pool.xact = pool_xact;
+}
+
+abts_suite *test_xact(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+
+    return suite;
+}
@@ -20,6 +20,11 @@
 #include "ogs-core.h"
 #include "core/abts.h"
 
+#if !defined(_WIN32)
+#include <signal.h>
+#include <fcntl.h>
+#endif
+
 static void test_basic(abts_case *tc, void *data)
 {
     int domain_id = -1;
@@ -103,11 +108,167 @@ static void test_basic(abts_case *tc, void *data)
 #endif
 }
 
+#if !defined(_WIN32)
+#define ASYNC_THREADS 4
+#define ASYNC_LINES 2000
+
+static int async_domain;
+
+static void async_thread(void *data)
+{
+    int i, id = *(int *)data;
+
+    for (i = 0; i < ASYNC_LINES; i++)
+        ogs_log_printf(OGS_LOG_INFO, async_domain, 0, NULL, 0, NULL,
+                1, "ASYNC %d %d\n", id, i);
+}
+
+/* Send stderr to a file while the test logs there */
+static FILE *async_capture(int *saved)
+{
+    FILE *out = NULL;
+
+    fflush(stderr);
+    out = tmpfile();
+    ogs_assert(out);
+    *saved = dup(2);
+    ogs_assert(*saved >= 0);
+    ogs_assert(dup2(fileno(out), 2) >= 0);
+
+    return out;
+}
+
+static void async_restore(FILE *out, int saved)
+{
+    fflush(stderr);
+    ogs_assert(dup2(saved, 2) >= 0);
+    close(saved);
+    rewind(out);
+}
+
+static void test_async1(abts_case *tc, void *data)
+{
+    ogs_thread_t *thread[ASYNC_THREADS];
+    int i, id[ASYNC_THREADS], next[ASYNC_THREADS];
+    int n, t, seq, lines = 0, saved;
+    uint64_t written, dropped;
+    char buf[OGS_HUGE_LEN];
+    FILE *out = NULL;
+
+    ogs_log_install_domain(&async_domain, "ASYNC", OGS_LOG_INFO);
+
+    out = async_capture(&saved);
+
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_log_async_start(0, OGS_LOG_OVERFLOW_BLOCK));
+    for (i = 0; i < ASYNC_THREADS; i++) {
+        id[i] = i;
+        thread[i] = ogs_thread_create(async_thread, &id[i]);
+        ABTS_PTR_NOTNULL(tc, thread[i]);
+    }
+    for (i = 0; i < ASYNC_THREADS; i++)
+        ogs_thread_destroy(thread[i]);
+    ogs_log_async_stop();
+    ogs_log_async_stats(&written, &dropped);
+
+    async_restore(out, saved);
+
+    /* Nothing is lost, and each thread's lines stay in order */
+    ABTS_TRUE(tc, written >= ASYNC_THREADS * ASYNC_LINES);
+    ABTS_INT_EQUAL(tc, 0, (int)dropped);
+
+    memset(next, 0, sizeof(next));
+    while (fgets(buf, sizeof(buf), out)) {
+        n = sscanf(buf, "ASYNC %d %d", &t, &seq);
+        if (n != 2)
+            continue;
+        if (t < 0 || t >= ASYNC_THREADS || next[t] != seq)
+            break;
+        next[t] = seq + 1;
+        lines++;
+    }
+    ABTS_INT_EQUAL(tc, ASYNC_THREADS * ASYNC_LINES, lines);
+
+    fclose(out);
+}
+
+static void test_async2(abts_case *tc, void *data)
+{
+    int i, n, t, seq, lines = 0, saved;
+    uint64_t written, dropped;
+    char buf[OGS_HUGE_LEN];
+    FILE *out = NULL;
+
+    out = async_capture(&saved);
+
+    /* The smallest ring fills up faster than the writer empties it */
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_log_async_start(0, OGS_LOG_OVERFLOW_DROP));
+    for (i = 0; i < 10 * ASYNC_LINES; i++)
+        ogs_log_printf(OGS_LOG_INFO, async_domain, 0, NULL, 0, NULL,
+                1, "ASYNC 0 %d\n", i);
+    ogs_log_async_stop();
+    ogs_log_async_stats(&written, &dropped);
+
+    async_restore(out, saved);
+
+    while (fgets(buf, sizeof(buf), out)) {
+        n = sscanf(buf, "ASYNC %d %d", &t, &seq);
+        if (n == 2)
+            lines++;
+    }
+    ABTS_INT_EQUAL(tc, 10 * ASYNC_LINES, lines + (int)dropped);
+
+    fclose(out);
+}
+
+static void test_async3(abts_case *tc, void *data)
+{
+    int i, fds[2], saved, flags;
+    uint64_t written, dropped;
+    void (*sigpipe)(int);
+    char buf[OGS_HUGE_LEN];
+
+    /* Nobody reads the full pipe, so the writer gets stuck in write() */
+    fflush(stderr);
+    ABTS_INT_EQUAL(tc, 0, pipe(fds));
+    flags = fcntl(fds[1], F_GETFL);
+    fcntl(fds[1], F_SETFL, flags | O_NONBLOCK);
+    memset(buf, 0, sizeof(buf));
+    while (write(fds[1], buf, sizeof(buf)) > 0);
+    fcntl(fds[1], F_SETFL, flags);
+    saved = dup(2);
+    ogs_assert(saved >= 0);
+    ogs_assert(dup2(fds[1], 2) >= 0);
+    sigpipe = signal(SIGPIPE, SIG_IGN);
+
+    /* Callers keep dropping lines instead of waiting for the writer */
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_log_async_start(0, OGS_LOG_OVERFLOW_DROP));
+    for (i = 0; i < 10 * ASYNC_LINES; i++)
+        ogs_log_printf(OGS_LOG_INFO, async_domain, 0, NULL, 0, NULL,
+                1, "ASYNC 0 %d\n", i);
+    ogs_log_async_stats(&written, &dropped);
+    ABTS_TRUE(tc, dropped > 0);
+
+    /* The writer gets EPIPE from then on */
+    close(fds[0]);
+    ogs_log_async_stop();
+
+    ogs_assert(dup2(saved, 2) >= 0);
+    close(saved);
+    close(fds[1]);
+    signal(SIGPIPE, sigpipe);
+}
+#endif
+
 abts_suite *test_log(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test_basic, NULL);
+#if !defined(_WIN32)
+    abts_run_test(suite, test_async1, NULL);
+    abts_run_test(suite, test_async2, NULL);
+    abts_run_test(suite, test_async3, NULL);
+#endif
 
     return suite;
 }
@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+#include "core/abts.h"
+
+#define DATA(__nUM) ((void *)(uintptr_t)(__nUM))
+
+static void ipv4(uint32_t *addr, const char *str)
+{
+    ogs_assert(inet_pton(AF_INET, str, addr) == 1);
+}
+
+static void ipv6(uint8_t *addr6, const char *str)
+{
+    ogs_assert(inet_pton(AF_INET6, str, addr6) == 1);
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    uint32_t addr;
+
+    lpm = ogs_lpm_create(32);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    ipv4(&addr, "10.45.0.1");
+    ABTS_TRUE(tc, ogs_lpm_find(lpm, &addr) == NULL);
+
+    ipv4(&addr, "10.0.0.0");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, &addr, 8, DATA(1)));
+    ipv4(&addr, "10.45.0.0");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, &addr, 16, DATA(2)));
+    /* Host bits are ignored */
+    ipv4(&addr, "10.45.1.255");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, &addr, 24, DATA(3)));
+    ipv4(&addr, "10.45.1.7");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, &addr, 32, DATA(4)));
+    ABTS_INT_EQUAL(tc, 4, ogs_lpm_count(lpm));
+
+    ipv4(&addr, "10.45.1.7");
+    ABTS_PTR_EQUAL(tc, DATA(4), ogs_lpm_find(lpm, &addr));
+    ipv4(&addr, "10.45.1.8");
+    ABTS_PTR_EQUAL(tc, DATA(3), ogs_lpm_find(lpm, &addr));
+    ipv4(&addr, "10.45.2.1");
+    ABTS_PTR_EQUAL(tc, DATA(2), ogs_lpm_find(lpm, &addr));
+    ipv4(&addr, "10.46.1.7");
+    ABTS_PTR_EQUAL(tc, DATA(1), ogs_lpm_find(lpm, &addr));
+    ipv4(&addr, "11.45.1.7");
+    ABTS_TRUE(tc, ogs_lpm_find(lpm, &addr) == NULL);
+
+    ipv4(&addr, "10.45.1.0");
+    ABTS_PTR_EQUAL(tc, DATA(3), ogs_lpm_find_exact(lpm, &addr, 24));
+    ABTS_TRUE(tc, ogs_lpm_find_exact(lpm, &addr, 23) == NULL);
+
+    /* Overwrite */
+    ipv4(&addr, "10.45.0.0");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, &addr, 16, DATA(5)));
+    ABTS_INT_EQUAL(tc, 4, ogs_lpm_count(lpm));
+    ipv4(&addr, "10.45.2.1");
+    ABTS_PTR_EQUAL(tc, DATA(5), ogs_lpm_find(lpm, &addr));
+
+    /* Default route */
+    addr = 0;
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, &addr, 0, DATA(6)));
+    ipv4(&addr, "11.45.1.7");
+    ABTS_PTR_EQUAL(tc, DATA(6), ogs_lpm_find(lpm, &addr));
+
+    ipv4(&addr, "10.45.1.7");
+    ogs_lpm_delete(lpm, &addr, 24);
+    ABTS_PTR_EQUAL(tc, DATA(4), ogs_lpm_find(lpm, &addr));
+    ipv4(&addr, "10.45.1.8");
+    ABTS_PTR_EQUAL(tc, DATA(5), ogs_lpm_find(lpm, &addr));
+
+    /* Deleting an unknown prefix does nothing */
+    ogs_lpm_delete(lpm, &addr, 24);
+    ogs_lpm_delete(lpm, &addr, 31);
+    ABTS_INT_EQUAL(tc, 4, ogs_lpm_count(lpm));
+
+    addr = 0;
+    ogs_lpm_delete(lpm, &addr, 0);
+    ipv4(&addr, "11.45.1.7");
+    ABTS_TRUE(tc, ogs_lpm_find(lpm, &addr) == NULL);
+
+    ogs_lpm_destroy(lpm);
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    uint8_t addr6[16];
+
+    lpm = ogs_lpm_create(128);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    ipv6(addr6, "2001:db8::");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, addr6, 32, DATA(1)));
+    ipv6(addr6, "2001:db8:cafe::");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, addr6, 48, DATA(2)));
+    ipv6(addr6, "2001:db8:cafe:1::");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, addr6, 64, DATA(3)));
+    ipv6(addr6, "2001:db8:cafe:1::8000:0:0");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, addr6, 81, DATA(4)));
+    ipv6(addr6, "2001:db8:cafe:1::1");
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_lpm_add(lpm, addr6, 128, DATA(5)));
+
+    ipv6(addr6, "2001:db8:cafe:1::1");
+    ABTS_PTR_EQUAL(tc, DATA(5), ogs_lpm_find(lpm, addr6));
+    ipv6(addr6, "2001:db8:cafe:1::2");
+    ABTS_PTR_EQUAL(tc, DATA(3), ogs_lpm_find(lpm, addr6));
+    ipv6(addr6, "2001:db8:cafe:1:0:ffff::2");
+    ABTS_PTR_EQUAL(tc, DATA(4), ogs_lpm_find(lpm, addr6));
+    ipv6(addr6, "2001:db8:cafe:2::1");
+    ABTS_PTR_EQUAL(tc, DATA(2), ogs_lpm_find(lpm, addr6));
+    ipv6(addr6, "2001:db8:beef::1");
+    ABTS_PTR_EQUAL(tc, DATA(1), ogs_lpm_find(lpm, addr6));
+    ipv6(addr6, "2001:db9::1");
+    ABTS_TRUE(tc, ogs_lpm_find(lpm, addr6) == NULL);
+
+    ipv6(addr6, "2001:db8:cafe:1::");
+    ogs_lpm_delete(lpm, addr6, 64);
+    ipv6(addr6, "2001:db8:cafe:1::2");
+    ABTS_PTR_EQUAL(tc, DATA(2), ogs_lpm_find(lpm, addr6));
+    ABTS_INT_EQUAL(tc, 4, ogs_lpm_count(lpm));
+
+    ogs_lpm_destroy(lpm);
+}
+
+/*
+ * Reference: the bit-by-bit binary trie the UPF used for framed routes
+ */
+typedef struct trie_node_s {
+    struct trie_node_s *left;
+    struct trie_node_s *right;
+    void *data;
+} trie_node_t;
+
+typedef struct trie_s {
+    trie_node_t *root;
+    trie_node_t *node;      /* Preallocated nodes */
+    int num_of_node;
+    int max_num_of_node;
+} trie_t;
+
+static trie_node_t *trie_node_alloc(trie_t *trie)
+{
+    ogs_assert(trie->num_of_node < trie->max_num_of_node);
+    return &trie->node[trie->num_of_node++];
+}
+
+static void trie_add(trie_t *trie, uint32_t addr, int len, void *data)
+{
+    trie_node_t **node = &trie->root;
+    uint32_t host = be32toh(addr);
+    int i;
+
+    for (i = 0; i <= len; i++) {
+        if (!*node)
+            *node = trie_node_alloc(trie);
+        if (i == len) {
+            (*node)->data = data;
+            return;
+        }
+        node = ((host >> (31 - i)) & 1) ? &(*node)->right : &(*node)->left;
+    }
+}
+
+static void trie_delete(trie_t *trie, uint32_t addr, int len)
+{
+    trie_node_t *node = trie->root;
+    uint32_t host = be32toh(addr);
+    int i;
+
+    for (i = 0; i < len && node; i++)
+        node = ((host >> (31 - i)) & 1) ? node->right : node->left;
+
+    if (node)
+        node->data = NULL;
+}
+
+static void *trie_find(trie_t *trie, uint32_t addr)
+{
+    trie_node_t *node = trie->root;
+    uint32_t host = be32toh(addr);
+    void *found = NULL;
+    int i;
+
+    for (i = 0; node; i++) {
+        if (node->data)
+            found = node->data;
+        if (i == 32)
+            break;
+        node = ((host >> (31 - i)) & 1) ? node->right : node->left;
+    }
+
+    return found;
+}
+
+static uint32_t test_seed;
+
+static uint32_t test_random(void)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 17;
+    test_seed ^= test_seed << 5;
+    return test_seed;
+}
+
+/*
+ * Random prefixes in a small address space, so that they nest,
+ * checked against the reference trie
+ */
+#define TEST3_PREFIX_NUM 4096
+#define TEST3_LOOKUP_NUM 100000
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    trie_t trie;
+    uint32_t addr[TEST3_PREFIX_NUM];
+    int len[TEST3_PREFIX_NUM];
+    uint32_t lookup;
+    int i, mismatch = 0;
+
+    memset(&trie, 0, sizeof(trie));
+    trie.max_num_of_node = TEST3_PREFIX_NUM * 33 + 1;
+    trie.node = calloc(trie.max_num_of_node, sizeof(trie_node_t));
+    ogs_assert(trie.node);
+
+    lpm = ogs_lpm_create(32);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    test_seed = 2463534242U;
+
+    for (i = 0; i < TEST3_PREFIX_NUM; i++) {
+        addr[i] = htobe32(0x0a000000 | (test_random() & 0xffff));
+        len[i] = 8 + test_random() % 25;
+
+        ABTS_INT_EQUAL(tc, OGS_OK,
+                ogs_lpm_add(lpm, &addr[i], len[i], DATA(i + 1)));
+        trie_add(&trie, addr[i], len[i], DATA(i + 1));
+    }
+
+    for (i = 0; i < TEST3_LOOKUP_NUM; i++) {
+        lookup = htobe32(0x0a000000 | (test_random() & 0x1ffff));
+        if (ogs_lpm_find(lpm, &lookup) != trie_find(&trie, lookup))
+            mismatch++;
+
+        /* Delete some and look them up again */
+        if (i % 64 == 0) {
+            int n = test_random() % TEST3_PREFIX_NUM;
+            ogs_lpm_delete(lpm, &addr[n], len[n]);
+            trie_delete(&trie, addr[n], len[n]);
+        }
+    }
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    ogs_lpm_destroy(lpm);
+    free(trie.node);
+}
+
+/*
+ * Dense session prefixes checked against the reference trie.
+ *
+ * Each session owns a /30, /31 or /32, as a UE address
+ * or a small framed route. Every lookup is compared with the trie
+ * with all sessions installed and again after every other one is removed.
+ */
+#define TEST4_SESS_NUM (16*1024)
+#define TEST4_LOOKUP_NUM (64*1024)
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    trie_t trie;
+    uint32_t *addr = NULL, *lookup = NULL;
+    int i, rv = OGS_OK, mismatch = 0;
+
+#define TEST4_LEN(__iNDEX) (30 + (__iNDEX) % 3)
+
+    memset(&trie, 0, sizeof(trie));
+    trie.max_num_of_node = TEST4_SESS_NUM * 4;
+    trie.node = calloc(trie.max_num_of_node, sizeof(trie_node_t));
+    ogs_assert(trie.node);
+
+    addr = calloc(TEST4_SESS_NUM, sizeof(uint32_t));
+    ogs_assert(addr);
+    lookup = calloc(TEST4_LOOKUP_NUM, sizeof(uint32_t));
+    ogs_assert(lookup);
+
+    test_seed = 2463534242U;
+
+    for (i = 0; i < TEST4_SESS_NUM; i++)
+        addr[i] = htobe32(0x0a000000 + (i << 2));
+    for (i = 0; i < TEST4_LOOKUP_NUM; i++)
+        lookup[i] = htobe32(0x0a000000 +
+                (test_random() % (TEST4_SESS_NUM << 2)));
+
+    lpm = ogs_lpm_create(32);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    for (i = 0; i < TEST4_SESS_NUM; i++) {
+        rv |= ogs_lpm_add(lpm, &addr[i], TEST4_LEN(i), DATA(i + 1));
+        trie_add(&trie, addr[i], TEST4_LEN(i), DATA(i + 1));
+    }
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, TEST4_SESS_NUM, ogs_lpm_count(lpm));
+
+    for (i = 0; i < TEST4_LOOKUP_NUM; i++)
+        if (ogs_lpm_find(lpm, &lookup[i]) != trie_find(&trie, lookup[i]))
+            mismatch++;
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    for (i = 0; i < TEST4_SESS_NUM; i += 2) {
+        ogs_lpm_delete(lpm, &addr[i], TEST4_LEN(i));
+        trie_delete(&trie, addr[i], TEST4_LEN(i));
+    }
+    ABTS_INT_EQUAL(tc, TEST4_SESS_NUM / 2, ogs_lpm_count(lpm));
+
+    for (i = 0; i < TEST4_LOOKUP_NUM; i++)
+        if (ogs_lpm_find(lpm, &lookup[i]) != trie_find(&trie, lookup[i]))
+            mismatch++;
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    for (i = 1; i < TEST4_SESS_NUM; i += 2)
+        ogs_lpm_delete(lpm, &addr[i], TEST4_LEN(i));
+    ABTS_INT_EQUAL(tc, 0, ogs_lpm_count(lpm));
+
+    for (i = 0; i < TEST4_LOOKUP_NUM; i++)
+        if (ogs_lpm_find(lpm, &lookup[i]) != NULL)
+            mismatch++;
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+
+    ogs_lpm_destroy(lpm);
+    free(trie.node);
+    free(lookup);
+    free(addr);
+}
+
+abts_suite *test_lpm(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+
+    return suite;
+}
@@ -70,12 +70,183 @@ static void test2_func(abts_case *tc, void *data)
     ogs_pkbuf_free(p3);
 }
 
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_pkbuf_cache_t *cache = NULL;
+    ogs_pkbuf_cache_stat_t stat;
+    ogs_pkbuf_t *pkbuf[5], *p2 = NULL;
+    unsigned char *tmp = NULL;
+    int i;
+
+    cache = ogs_pkbuf_cache_create(100, 4);
+    ABTS_PTR_NOTNULL(tc, cache);
+
+    for (i = 0; i < 4; i++) {
+        pkbuf[i] = ogs_pkbuf_cache_alloc(cache);
+        ABTS_PTR_NOTNULL(tc, pkbuf[i]);
+        ABTS_PTR_EQUAL(tc, cache, pkbuf[i]->cache);
+        ABTS_INT_EQUAL(tc, 0, pkbuf[i]->len);
+        ABTS_INT_EQUAL(tc, 100, ogs_pkbuf_tailroom(pkbuf[i]));
+    }
+
+    /* The slab is empty, so the buffer comes from the default pool */
+    pkbuf[4] = ogs_pkbuf_cache_alloc(cache);
+    ABTS_PTR_NOTNULL(tc, pkbuf[4]);
+    ABTS_TRUE(tc, pkbuf[4]->cache == NULL);
+    ABTS_INT_EQUAL(tc, 100, ogs_pkbuf_tailroom(pkbuf[4]));
+
+    ogs_pkbuf_cache_stat(cache, &stat);
+    ABTS_INT_EQUAL(tc, 100, stat.size);
+    ABTS_INT_EQUAL(tc, 4, stat.num);
+    ABTS_INT_EQUAL(tc, 4, stat.in_use);
+    ABTS_INT_EQUAL(tc, 4, stat.high_water);
+    ABTS_INT_EQUAL(tc, 1, stat.exhausted);
+
+    ogs_pkbuf_reserve(pkbuf[0], 50);
+    tmp = ogs_pkbuf_push(pkbuf[0], 10);
+    ABTS_PTR_NOTNULL(tc, tmp);
+    memset(tmp, 0xa5, 10);
+
+    ogs_pkbuf_free(pkbuf[1]);
+
+    p2 = ogs_pkbuf_copy(pkbuf[0]);
+    ABTS_PTR_NOTNULL(tc, p2);
+    ABTS_PTR_EQUAL(tc, cache, p2->cache);
+    ABTS_PTR_EQUAL(tc, pkbuf[1], p2);
+    ABTS_INT_EQUAL(tc, 10, p2->len);
+    ABTS_INT_EQUAL(tc, 40, ogs_pkbuf_headroom(p2));
+    ABTS_INT_EQUAL(tc, 50, ogs_pkbuf_tailroom(p2));
+    ABTS_TRUE(tc, memcmp(p2->data, tmp, 10) == 0);
+
+    ogs_pkbuf_free(p2);
+    for (i = 0; i < 5; i++)
+        if (i != 1)
+            ogs_pkbuf_free(pkbuf[i]);
+
+    /* Freed buffers stay in this thread's magazine until flushed */
+    ogs_pkbuf_cache_stat(cache, &stat);
+    ABTS_INT_EQUAL(tc, 4, stat.in_use);
+
+    ogs_pkbuf_cache_flush();
+
+    ogs_pkbuf_cache_stat(cache, &stat);
+    ABTS_INT_EQUAL(tc, 0, stat.in_use);
+    ABTS_INT_EQUAL(tc, 4, stat.high_water);
+
+    ogs_pkbuf_cache_destroy(cache);
+}
+
+#define TEST4_THREAD_NUM 8
+#define TEST4_LOOP 10000
+#define TEST4_BURST 48
+static ogs_pkbuf_cache_t *test4_cache;
+static int test4_failed;
+
+static void test4_thread(void *data)
+{
+    ogs_pkbuf_t *pkbuf[TEST4_BURST];
+    int i, j;
+
+    for (i = 0; i < TEST4_LOOP; i++) {
+        for (j = 0; j < TEST4_BURST; j++) {
+            pkbuf[j] = ogs_pkbuf_cache_alloc(test4_cache);
+            if (!pkbuf[j] || pkbuf[j]->cache != test4_cache) {
+                test4_failed = 1;
+                return;
+            }
+            ogs_pkbuf_put_u32(pkbuf[j], (uint32_t)j);
+        }
+        for (j = 0; j < TEST4_BURST; j++)
+            ogs_pkbuf_free(pkbuf[j]);
+    }
+
+    ogs_pkbuf_cache_flush();
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_thread_t *thread[TEST4_THREAD_NUM];
+    ogs_pkbuf_cache_stat_t stat;
+    int i;
+
+    test4_cache = ogs_pkbuf_cache_create(
+            OGS_MAX_PKT_LEN, TEST4_THREAD_NUM * TEST4_BURST * 2);
+    ABTS_PTR_NOTNULL(tc, test4_cache);
+    test4_failed = 0;
+
+    for (i = 0; i < TEST4_THREAD_NUM; i++) {
+        thread[i] = ogs_thread_create(test4_thread, NULL);
+        ABTS_PTR_NOTNULL(tc, thread[i]);
+    }
+    for (i = 0; i < TEST4_THREAD_NUM; i++)
+        ogs_thread_destroy(thread[i]);
+
+    ABTS_INT_EQUAL(tc, 0, test4_failed);
+
+    ogs_pkbuf_cache_stat(test4_cache, &stat);
+    ABTS_INT_EQUAL(tc, 0, stat.in_use);
+    ABTS_INT_EQUAL(tc, 0, stat.exhausted);
+
+    ogs_pkbuf_cache_destroy(test4_cache);
+}
+
+/*
+ * Benchmark: a burst of packet-sized buffers is allocated and freed,
+ * as the UPF does per recvmmsg() batch. The results are logged at INFO.
+ */
+#define TEST5_LOOP 20000
+#define TEST5_BURST 32
+static void test5_func(abts_case *tc, void *data)
+{
+    ogs_pkbuf_cache_t *cache = NULL;
+    ogs_pkbuf_t *pkbuf[TEST5_BURST];
+    ogs_time_t start, pool_usec, cache_usec;
+    int i, j, failed = 0;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < TEST5_LOOP; i++) {
+        for (j = 0; j < TEST5_BURST; j++)
+            pkbuf[j] = ogs_pkbuf_alloc(NULL, OGS_MAX_PKT_LEN);
+        for (j = 0; j < TEST5_BURST; j++) {
+            if (!pkbuf[j]) failed++;
+            ogs_pkbuf_free(pkbuf[j]);
+        }
+    }
+    pool_usec = ogs_get_monotonic_time() - start;
+
+    cache = ogs_pkbuf_cache_create(OGS_MAX_PKT_LEN, TEST5_BURST * 2);
+    ABTS_PTR_NOTNULL(tc, cache);
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < TEST5_LOOP; i++) {
+        for (j = 0; j < TEST5_BURST; j++)
+            pkbuf[j] = ogs_pkbuf_cache_alloc(cache);
+        for (j = 0; j < TEST5_BURST; j++) {
+            if (!pkbuf[j]) failed++;
+            ogs_pkbuf_free(pkbuf[j]);
+        }
+    }
+    cache_usec = ogs_get_monotonic_time() - start;
+
+    ogs_pkbuf_cache_flush();
+    ogs_pkbuf_cache_destroy(cache);
+
+    ABTS_INT_EQUAL(tc, 0, failed);
+
+    ogs_info("pkbuf alloc/free x %d: default pool %lld usec, cache %lld usec",
+            TEST5_LOOP * TEST5_BURST,
+            (long long)pool_usec, (long long)cache_usec);
+}
+
 abts_suite *test_pkbuf(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
 
     return suite;
 }
@@ -228,6 +228,122 @@ static void test3_func(abts_case *tc, void *data)
     ogs_pool_final(&testpool);
 }
 
+typedef struct idnode_s {
+    ogs_pool_id_t id;
+    int value;
+} idnode_t;
+
+static OGS_POOL(idpool, idnode_t);
+
+static void test4_func(abts_case *tc, void *data)
+{
+    idnode_t *node[5], *reused = NULL;
+    ogs_pool_id_t id[5], stale;
+    int i;
+
+    ogs_pool_init(&idpool, 5);
+
+    for (i = 0; i < 5; i++) {
+        ogs_pool_id_calloc(&idpool, &node[i]);
+        ABTS_PTR_NOTNULL(tc, node[i]);
+        id[i] = node[i]->id;
+        ABTS_TRUE(tc, id[i] >= OGS_MIN_POOL_ID && id[i] <= OGS_MAX_POOL_ID);
+        ABTS_PTR_EQUAL(tc, node[i], ogs_pool_find_by_id(&idpool, id[i]));
+    }
+
+    /* A freed ID is not found even after its slot is reused */
+    stale = id[2];
+    ogs_pool_id_free(&idpool, node[2]);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+
+    ogs_pool_id_calloc(&idpool, &reused);
+    ABTS_PTR_EQUAL(tc, node[2], reused);
+    ABTS_TRUE(tc, reused->id != stale);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+    ABTS_PTR_EQUAL(tc, reused, ogs_pool_find_by_id(&idpool, reused->id));
+    node[2] = reused;
+    id[2] = reused->id;
+
+    /* IDs which were never handed out */
+    stale = OGS_INVALID_POOL_ID;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+    stale = -1;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+    stale = idpool.id_mask + 1;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+    stale = id[0] | idpool.id_mask;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+
+    for (i = 0; i < 5; i++)
+        ogs_pool_id_free(&idpool, node[i]);
+    for (i = 0; i < 5; i++)
+        ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, id[i]));
+
+    ogs_pool_final(&idpool);
+}
+
+/*
+ * Compare ogs_pool_find_by_id() with the ID hash it replaced.
+ * The results are logged at INFO.
+ */
+#define TEST5_SIZE 65536
+#define TEST5_LOOP 16
+static void test5_func(abts_case *tc, void *data)
+{
+    idnode_t **node = NULL;
+    ogs_hash_t *hash = NULL;
+    ogs_time_t start, hash_usec, pool_usec;
+    int i, j, missed = 0;
+
+    node = ogs_calloc(TEST5_SIZE, sizeof(*node));
+    ogs_assert(node);
+    hash = ogs_hash_make();
+    ogs_assert(hash);
+
+    ogs_pool_init(&idpool, TEST5_SIZE);
+
+    for (i = 0; i < TEST5_SIZE; i++) {
+        ogs_pool_id_calloc(&idpool, &node[i]);
+        ogs_assert(node[i]);
+        ogs_hash_set(hash, &node[i]->id, sizeof(ogs_pool_id_t), node[i]);
+    }
+
+    start = ogs_get_monotonic_time();
+    for (j = 0; j < TEST5_LOOP; j++) {
+        for (i = 0; i < TEST5_SIZE; i++) {
+            if (ogs_hash_get(hash,
+                    &node[i]->id, sizeof(ogs_pool_id_t)) != node[i])
+                missed++;
+        }
+    }
+    hash_usec = ogs_get_monotonic_time() - start;
+
+    start = ogs_get_monotonic_time();
+    for (j = 0; j < TEST5_LOOP; j++) {
+        for (i = 0; i < TEST5_SIZE; i++) {
+            if (ogs_pool_find_by_id(&idpool, node[i]->id) != node[i])
+                missed++;
+        }
+    }
+    pool_usec = ogs_get_monotonic_time() - start;
+
+    ABTS_INT_EQUAL(tc, 0, missed);
+
+    ogs_info("find by id x %d: hash %lld usec, pool %lld usec",
+            TEST5_SIZE * TEST5_LOOP,
+            (long long)hash_usec, (long long)pool_usec);
+
+    for (i = 0; i < TEST5_SIZE; i++) {
+        ogs_hash_set(hash, &node[i]->id, sizeof(ogs_pool_id_t), NULL);
+        ogs_pool_id_free(&idpool, node[i]);
+    }
+
+    ogs_pool_final(&idpool);
+
+    ogs_hash_destroy(hash);
+    ogs_free(node);
+}
+
 abts_suite *test_pool(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -235,6 +351,8 @@ abts_suite *test_pool(abts_suite *suite)
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
     abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
 
     return suite;
 }
@@ -424,6 +424,94 @@ static void test8_func(abts_case *tc, void *data)
     ABTS_INT_EQUAL(tc, OGS_OK, rv);
 }
 
+#define TEST9_NUM 8
+static void test9_func(abts_case *tc, void *data)
+{
+    int rv, i, n;
+    ogs_sock_t *server, *client;
+    ogs_sockaddr_t *addr;
+    ogs_sockaddr_t from[TEST9_NUM], *to[TEST9_NUM];
+    ogs_pkbuf_t *pkbuf[TEST9_NUM];
+    char buf[OGS_ADDRSTRLEN];
+
+    rv = ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1", PORT, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    server = ogs_udp_server(addr, NULL);
+    ABTS_PTR_NOTNULL(tc, server);
+
+    client = ogs_sock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ABTS_PTR_NOTNULL(tc, client);
+
+    for (i = 0; i < TEST9_NUM; i++) {
+        pkbuf[i] = ogs_pkbuf_alloc(NULL, STRLEN);
+        ABTS_PTR_NOTNULL(tc, pkbuf[i]);
+        ogs_pkbuf_put_data(pkbuf[i], DATASTR, strlen(DATASTR));
+        to[i] = addr;
+    }
+
+    /* The last datagram has a different length and is not coalesced */
+    ogs_pkbuf_trim(pkbuf[TEST9_NUM-1], 4);
+
+    n = ogs_sendmmsg(client->fd, pkbuf, to, TEST9_NUM, false);
+    ABTS_INT_EQUAL(tc, TEST9_NUM, n);
+
+    for (i = 0; i < TEST9_NUM; i++) {
+        ogs_pkbuf_trim(pkbuf[i], 0);
+        ogs_pkbuf_put(pkbuf[i], ogs_pkbuf_tailroom(pkbuf[i]));
+    }
+
+    n = 0;
+    while (n < TEST9_NUM) {
+        rv = ogs_recvmmsg(server->fd, &pkbuf[n], &from[n], TEST9_NUM - n);
+        ABTS_TRUE(tc, rv > 0);
+        if (rv <= 0)
+            break;
+        n += rv;
+    }
+    ABTS_INT_EQUAL(tc, TEST9_NUM, n);
+
+    for (i = 0; i < TEST9_NUM-1; i++) {
+        ABTS_INT_EQUAL(tc, strlen(DATASTR), pkbuf[i]->len);
+        ABTS_TRUE(tc, memcmp(pkbuf[i]->data, DATASTR, strlen(DATASTR)) == 0);
+        ABTS_STR_EQUAL(tc, "127.0.0.1", OGS_ADDR(&from[i], buf));
+    }
+    ABTS_INT_EQUAL(tc, 4, pkbuf[TEST9_NUM-1]->len);
+
+    for (i = 0; i < TEST9_NUM; i++)
+        ogs_pkbuf_free(pkbuf[i]);
+
+    ogs_sock_destroy(client);
+    ogs_sock_destroy(server);
+
+    rv = ogs_freeaddrinfo(addr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+}
+
+static void test10_func(abts_case *tc, void *data)
+{
+    int rv;
+    ogs_sock_t *server1, *server2;
+    ogs_sockaddr_t *addr;
+    ogs_sockopt_t option;
+
+    rv = ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1", PORT, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    ogs_sockopt_init(&option);
+    option.so_reuseport = true;
+
+    server1 = ogs_udp_server(addr, &option);
+    ABTS_PTR_NOTNULL(tc, server1);
+    server2 = ogs_udp_server(addr, &option);
+    ABTS_PTR_NOTNULL(tc, server2);
+
+    ogs_sock_destroy(server2);
+    ogs_sock_destroy(server1);
+
+    rv = ogs_freeaddrinfo(addr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+}
+
 abts_suite *test_socket(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -436,6 +524,10 @@ abts_suite *test_socket(abts_suite *suite)
     abts_run_test(suite, test6_func, NULL);
     abts_run_test(suite, test7_func, NULL);
     abts_run_test(suite, test8_func, NULL);
+    abts_run_test(suite, test9_func, NULL);
+#if defined(SO_REUSEPORT)
+    abts_run_test(suite, test10_func, NULL);
+#endif
 
     return suite;
 }
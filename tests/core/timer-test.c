@@ -51,7 +51,7 @@ static void test1_func(abts_case *tc, void *data)
 
     memset(expire_check, 0, TEST_DURATION/TEST_TIMER_PRECISION);
 
-    timer = ogs_timer_mgr_create(512);
+    timer = ogs_timer_mgr_create_backend(512, (uintptr_t)data);
     pollset = ogs_pollset_create(512);
     ogs_assert(timer);
     for(n = 0; n < sizeof(timer_duration)/sizeof(ogs_time_t); n++) {
@@ -126,7 +126,7 @@ static void test2_func(abts_case *tc, void *data)
     memset(expire_check, 0, TEST_DURATION/TEST_TIMER_PRECISION);
     memset(tm_num, 0, sizeof(int)*(TEST_DURATION/TEST_TIMER_PRECISION));
 
-    timer = ogs_timer_mgr_create(512);
+    timer = ogs_timer_mgr_create_backend(512, (uintptr_t)data);
     ogs_assert(timer);
 
     for(n = 0; n < TEST_TIMER_NUM; n++) {
@@ -168,7 +168,7 @@ static void test3_func(abts_case *tc, void *data)
     memset(expire_check, 0, TEST_DURATION/TEST_TIMER_PRECISION);
     memset(tm_num, 0, sizeof(int)*(TEST_DURATION/TEST_TIMER_PRECISION));
 
-    timer = ogs_timer_mgr_create(512);
+    timer = ogs_timer_mgr_create_backend(512, (uintptr_t)data);
     ogs_assert(timer);
 
     for(n = 0; n < TEST_TIMER_NUM; n++) {
@@ -208,13 +208,162 @@ static void test3_func(abts_case *tc, void *data)
     ogs_timer_mgr_destroy(timer);
 }
 
+/* Timers far apart fall into different levels of the timing wheel */
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_timer_mgr_t *timer = NULL;
+    ogs_timer_t *timer_array[5];
+    ogs_time_t duration[5] = {
+        ogs_time_from_msec(30), ogs_time_from_msec(300),
+        ogs_time_from_sec(20), ogs_time_from_sec(54*60),
+        ogs_time_from_sec(30*24*60*60),
+    };
+    ogs_time_t next;
+    int n;
+
+    timer = ogs_timer_mgr_create_backend(512, (uintptr_t)data);
+    ogs_assert(timer);
+
+    ABTS_INT_EQUAL(tc, OGS_INFINITE_TIME, ogs_timer_mgr_next(timer));
+
+    /* Started in reverse order, the earliest one must still be found */
+    for (n = 4; n >= 0; n--) {
+        timer_array[n] = ogs_timer_add(
+                timer, test_expire_func_1, (void*)(uintptr_t)n);
+        ogs_assert(timer_array[n]);
+        ogs_timer_start(timer_array[n], duration[n]);
+    }
+
+    for (n = 0; n < 5; n++) {
+        next = ogs_timer_mgr_next(timer);
+        ABTS_TRUE(tc, next <= duration[n] + ogs_time_from_msec(1));
+        ABTS_TRUE(tc, next >= duration[n] - ogs_time_from_msec(100));
+        ogs_timer_stop(timer_array[n]);
+    }
+    ABTS_INT_EQUAL(tc, OGS_INFINITE_TIME, ogs_timer_mgr_next(timer));
+
+    /* Restart moves a timer to another slot */
+    ogs_timer_start(timer_array[3], duration[3]);
+    ogs_timer_start(timer_array[0], duration[2]);
+    ogs_timer_start(timer_array[0], duration[0]);
+    next = ogs_timer_mgr_next(timer);
+    ABTS_TRUE(tc, next <= duration[0] + ogs_time_from_msec(1));
+
+    memset(expire_check, 0, TEST_DURATION/TEST_TIMER_PRECISION);
+    ogs_usleep(next);
+    ogs_timer_mgr_expire(timer);
+    ABTS_INT_EQUAL(tc, 1, expire_check[0]);
+    ABTS_INT_EQUAL(tc, 0, expire_check[3]);
+
+    next = ogs_timer_mgr_next(timer);
+    ABTS_TRUE(tc, next > duration[3] - ogs_time_from_sec(1));
+
+    for (n = 0; n < 5; n++)
+        ogs_timer_delete(timer_array[n]);
+
+    ogs_timer_mgr_destroy(timer);
+}
+
+/*
+ * Benchmark: NAS/PFCP-like churn with many running timers.
+ * Most timers are restarted before they expire, some are stopped,
+ * and a small share expires. The results are logged at INFO.
+ */
+#define TEST5_TIMER_NUM 100000
+#define TEST5_LOOP 1000000
+static int test5_expired;
+static uint32_t test5_seed;
+
+static void test5_expire_func(void *data)
+{
+    test5_expired++;
+}
+
+/* Cheap PRNG, so that the loop measures the timer manager */
+static uint32_t test5_random(void)
+{
+    test5_seed ^= test5_seed << 13;
+    test5_seed ^= test5_seed >> 17;
+    test5_seed ^= test5_seed << 5;
+    return test5_seed;
+}
+
+static void test5_func(abts_case *tc, void *data)
+{
+    ogs_timer_mgr_t *timer = NULL;
+    ogs_timer_t **timer_array = NULL;
+    ogs_time_t start, start_usec, churn_usec, expire_usec;
+    int n, i;
+
+    timer_array = ogs_calloc(TEST5_TIMER_NUM, sizeof(ogs_timer_t *));
+    ogs_assert(timer_array);
+
+    timer = ogs_timer_mgr_create_backend(TEST5_TIMER_NUM, (uintptr_t)data);
+    ogs_assert(timer);
+
+    test5_seed = 2463534242U;
+
+    start = ogs_get_monotonic_time();
+    for (n = 0; n < TEST5_TIMER_NUM; n++) {
+        timer_array[n] = ogs_timer_add(timer, test5_expire_func, NULL);
+        ogs_assert(timer_array[n]);
+        ogs_timer_start(timer_array[n],
+                ogs_time_from_sec(6 + test5_random() % 3600));
+    }
+    start_usec = ogs_get_monotonic_time() - start;
+
+    start = ogs_get_monotonic_time();
+    for (i = 0; i < TEST5_LOOP; i++) {
+        n = test5_random() % TEST5_TIMER_NUM;
+        if (i % 8 == 0)
+            ogs_timer_stop(timer_array[n]);
+        else if (i % 64 == 1)
+            ogs_timer_start(timer_array[n],
+                    ogs_time_from_msec(1 + test5_random() % 50));
+        else
+            ogs_timer_start(timer_array[n],
+                    ogs_time_from_sec(6 + test5_random() % 3600));
+        if (i % 1024 == 0)
+            ogs_timer_mgr_expire(timer);
+    }
+    churn_usec = ogs_get_monotonic_time() - start;
+
+    test5_expired = 0;
+    ogs_usleep(ogs_time_from_msec(60));
+    start = ogs_get_monotonic_time();
+    ogs_timer_mgr_expire(timer);
+    expire_usec = ogs_get_monotonic_time() - start;
+
+    ABTS_TRUE(tc, ogs_timer_mgr_next(timer) >= ogs_time_from_sec(1));
+
+    for (n = 0; n < TEST5_TIMER_NUM; n++)
+        ogs_timer_delete(timer_array[n]);
+
+    ogs_timer_mgr_destroy(timer);
+    ogs_free(timer_array);
+
+    ogs_info("%s: start x %d %lld usec, churn x %d %lld usec, "
+            "expire x %d %lld usec",
+            (uintptr_t)data == OGS_TIMER_BACKEND_WHEEL ? "wheel" : "rbtree",
+            TEST5_TIMER_NUM, (long long)start_usec,
+            TEST5_LOOP, (long long)churn_usec,
+            test5_expired, (long long)expire_usec);
+}
+
 abts_suite *test_timer(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
-    abts_run_test(suite, test1_func, NULL);
-    abts_run_test(suite, test2_func, NULL);
-    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test1_func, (void *)OGS_TIMER_BACKEND_RBTREE);
+    abts_run_test(suite, test2_func, (void *)OGS_TIMER_BACKEND_RBTREE);
+    abts_run_test(suite, test3_func, (void *)OGS_TIMER_BACKEND_RBTREE);
+    abts_run_test(suite, test4_func, (void *)OGS_TIMER_BACKEND_RBTREE);
+    abts_run_test(suite, test1_func, (void *)OGS_TIMER_BACKEND_WHEEL);
+    abts_run_test(suite, test2_func, (void *)OGS_TIMER_BACKEND_WHEEL);
+    abts_run_test(suite, test3_func, (void *)OGS_TIMER_BACKEND_WHEEL);
+    abts_run_test(suite, test4_func, (void *)OGS_TIMER_BACKEND_WHEEL);
+    abts_run_test(suite, test5_func, (void *)OGS_TIMER_BACKEND_RBTREE);
+    abts_run_test(suite, test5_func, (void *)OGS_TIMER_BACKEND_WHEEL);
 
     return suite;
 }
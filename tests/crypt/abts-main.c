@@ -25,6 +25,7 @@ abts_suite *test_aes(abts_suite *suite);
 abts_suite *test_sha(abts_suite *suite);
 abts_suite *test_base64(abts_suite *suite);
 abts_suite *test_ecies(abts_suite *suite);
+abts_suite *test_cipher(abts_suite *suite);
 
 const struct testlist {
     abts_suite *(*func)(abts_suite *suite);
@@ -33,6 +34,7 @@ const struct testlist {
     {test_sha},
     {test_base64},
     {test_ecies},
+    {test_cipher},
     {NULL},
 };
 
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+#include "ogs-crypt.h"
+#include "core/abts.h"
+
+#define GUARD 0x5a
+#define MAX_LEN 300
+
+/*
+ * 128-EEA1 against the OpenSSL-derived SNOW 3G core, for every length
+ * in bytes, with a partial last byte for most of them
+ */
+static void cipher_test1(abts_case *tc, void *data)
+{
+    uint8_t key[16] = {
+        0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00,
+        0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48 };
+    uint8_t plain[MAX_LEN], buf[MAX_LEN+1], ref[MAX_LEN];
+    SNOW_CTX ctx;
+    int i, len, bits;
+
+    for (i = 0; i < MAX_LEN; i++)
+        plain[i] = i * 7;
+
+    for (len = 1; len <= MAX_LEN; len++) {
+        bits = (len << 3) - (len & 7);
+
+        memcpy(buf, plain, len);
+        buf[len] = GUARD;
+        snow_3g_f8(key, 0x72a4f20f + len, 0x0c, len & 1, buf, bits);
+
+        memcpy(ref, plain, len);
+        SNOW_init(0x72a4f20f + len, 0x0c, len & 1, (const char *)key, &ctx);
+        SNOW(len, ref, ref, &ctx);
+        ref[len-1] &= 0xff << (len & 7);
+
+        ABTS_TRUE(tc, memcmp(buf, ref, len) == 0);
+        ABTS_INT_EQUAL(tc, GUARD, buf[len]);
+    }
+}
+
+/* 128-EIA3 with a single bit, and 128-EEA3 with a partial last byte */
+static void cipher_test2(abts_case *tc, void *data)
+{
+    uint8_t ik[16] = { 0 };
+    uint8_t message[4] = { 0 };
+    uint32_t mac32 = 0;
+
+    const char *_ck = "17 3d 14 ba 50 03 73 1d 7a 60 04 94 70 f0 0a 29";
+    const char *_plain =
+        "6cf65340 735552ab 0c9752fa 6f9025fe 0bd675d9 005875b2 00000000";
+    const char *_cipher =
+        "a6c85fc6 6afb8533 aafc2518 dfe78494 0ee1e4b0 30238cc8 10000000";
+    uint8_t ck[16];
+    uint8_t plain[25+1];
+    uint8_t tmp[25];
+
+    zuc_eia3(ik, 0, 0, 0, 1, message, &mac32);
+    ABTS_INT_EQUAL(tc, 0xc8a9595e, mac32);
+
+    ogs_hex_from_string(_plain, plain, sizeof(plain)-1);
+    plain[25] = GUARD;
+    zuc_eea3(ogs_hex_from_string(_ck, ck, sizeof(ck)),
+            0x66035492, 0xf, 0, 193, plain, plain);
+    ogs_hex_from_string(_cipher, tmp, sizeof(tmp));
+    tmp[24] &= 0x80;
+    ABTS_TRUE(tc, memcmp(plain, tmp, 25) == 0);
+    ABTS_INT_EQUAL(tc, GUARD, plain[25]);
+}
+
+/* A cached key schedule gives the same results as the one-shot functions */
+static void cipher_test3(abts_case *tc, void *data)
+{
+    uint8_t key[16] = {
+        0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c,
+        0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1 };
+    uint8_t msg[MAX_LEN], out1[MAX_LEN], out2[MAX_LEN];
+    uint8_t ivec1[16], ivec2[16];
+    uint8_t cmac1[16], cmac2[16];
+    uint32_t rk[OGS_AES_RKLENGTH(128)];
+    int nrounds;
+    ogs_aes_cmac_ctx_t cmac;
+    int i, len;
+
+    for (i = 0; i < MAX_LEN; i++)
+        msg[i] = i * 13;
+
+    nrounds = ogs_aes_setup_enc(rk, key, 128);
+    ogs_aes_cmac_setup(&cmac, key);
+
+    for (len = 1; len <= MAX_LEN; len++) {
+        memset(ivec1, 0, 16);
+        memset(ivec2, 0, 16);
+        ivec1[3] = ivec2[3] = len;
+
+        ogs_aes_ctr128_encrypt(key, ivec1, msg, len, out1);
+        ogs_aes_ctr128_encrypt_rk(rk, nrounds, ivec2, msg, len, out2);
+        ABTS_TRUE(tc, memcmp(out1, out2, len) == 0);
+
+        ogs_aes_cmac_calculate(cmac1, key, msg, len);
+        ogs_aes_cmac_calculate_ctx(&cmac, cmac2, msg, len);
+        ABTS_TRUE(tc, memcmp(cmac1, cmac2, 16) == 0);
+    }
+}
+
+/*
+ * Throughput of the NAS ciphering and integrity algorithms
+ * for a small NAS message and for a full MTU.
+ */
+#define BENCH_BYTES (4*1024*1024)
+
+static void cipher_test4(abts_case *tc, void *data)
+{
+    static const int size[] = { 64, 1500 };
+    uint8_t key[16] = {
+        0x17, 0x3d, 0x14, 0xba, 0x50, 0x03, 0x73, 0x1d,
+        0x7a, 0x60, 0x04, 0x94, 0x70, 0xf0, 0x0a, 0x29 };
+    uint8_t buf[1500], ivec[16], mac[16];
+    uint32_t mac32, rk[OGS_AES_RKLENGTH(128)];
+    int nrounds;
+    ogs_aes_cmac_ctx_t cmac;
+    ogs_time_t start, usec[7];
+    int i, j, len, loop;
+
+    memset(buf, 0x3c, sizeof(buf));
+    nrounds = ogs_aes_setup_enc(rk, key, 128);
+    ogs_aes_cmac_setup(&cmac, key);
+
+    for (i = 0; i < OGS_ARRAY_SIZE(size); i++) {
+        len = size[i];
+        loop = BENCH_BYTES / len;
+
+#define BENCH(__n, __stmt) do { \
+        start = ogs_get_monotonic_time(); \
+        for (j = 0; j < loop; j++) { __stmt; } \
+        usec[__n] = ogs_get_monotonic_time() - start; \
+        if (usec[__n] == 0) usec[__n] = 1; \
+    } while (0)
+
+        BENCH(0, snow_3g_f8(key, j, 1, 0, buf, len << 3));
+        BENCH(1, snow_3g_f9(key, j, 1 << 27, 0, buf, len << 3, mac));
+        BENCH(2, memset(ivec, 0, 16); ivec[3] = j;
+                ogs_aes_ctr128_encrypt_rk(rk, nrounds, ivec, buf, len, buf));
+        BENCH(3, memset(ivec, 0, 16); ivec[3] = j;
+                ogs_aes_ctr128_encrypt(key, ivec, buf, len, buf));
+        BENCH(4, ogs_aes_cmac_calculate_ctx(&cmac, mac, buf, len));
+        BENCH(5, zuc_eea3(key, j, 1, 0, len << 3, buf, buf));
+        BENCH(6, zuc_eia3(key, j, 1, 0, len << 3, buf, &mac32));
+
+#undef BENCH
+
+#define MBPS(__n) ((long long)loop * len * 8 / usec[__n])
+        ogs_info("[%4d bytes] EEA1 %lld, EIA1 %lld, "
+                "EEA2 %lld (%lld without cached key), EIA2 %lld, "
+                "EEA3 %lld, EIA3 %lld Mbit/s",
+                len, MBPS(0), MBPS(1), MBPS(2), MBPS(3), MBPS(4),
+                MBPS(5), MBPS(6));
+#undef MBPS
+    }
+}
+
+abts_suite *test_cipher(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, cipher_test1, NULL);
+    abts_run_test(suite, cipher_test2, NULL);
+    abts_run_test(suite, cipher_test3, NULL);
+    abts_run_test(suite, cipher_test4, NULL);
+
+    return suite;
+}
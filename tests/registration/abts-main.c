@@ -30,6 +30,7 @@ abts_suite *test_gmm_status(abts_suite *suite);
 abts_suite *test_ue_context(abts_suite *suite);
 abts_suite *test_reset(abts_suite *suite);
 abts_suite *test_multi_ue(abts_suite *suite);
+abts_suite *test_gnb_load(abts_suite *suite);
 abts_suite *test_crash(abts_suite *suite);
 
 const struct testlist {
@@ -46,6 +47,7 @@ const struct testlist {
     {test_ue_context},
     {test_reset},
     {test_multi_ue},
+    {test_gnb_load},
 #if 0 /* Since there is error LOG, we disabled the following test */
     {test_crash},
 #endif
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-sbi.h"
+#include "core/abts.h"
+
+#define TEST_PORT 7781
+#define TEST_URI "http://127.0.0.1:7781/nsbi-test/v1/echo"
+
+static struct {
+    int num_of_request;
+    ogs_pool_id_t stream_id[64];
+
+    int num_of_response;
+    int num_of_ok;
+} test;
+
+static int server_cb(ogs_sbi_request_t *request, void *data)
+{
+    ogs_assert(request);
+    ogs_assert(test.num_of_request < OGS_ARRAY_SIZE(test.stream_id));
+
+    /* Answered from the loop, as the NF state machines do */
+    test.stream_id[test.num_of_request++] = OGS_POINTER_TO_UINT(data);
+
+    return OGS_OK;
+}
+
+static int client_cb(int status, ogs_sbi_response_t *response, void *data)
+{
+    test.num_of_response++;
+
+    if (status == OGS_OK) {
+        ogs_assert(response);
+        if (response->status == OGS_SBI_HTTP_STATUS_OK)
+            test.num_of_ok++;
+        ogs_sbi_response_free(response);
+    }
+
+    return OGS_OK;
+}
+
+static void respond_all(void)
+{
+    ogs_sbi_stream_t *stream = NULL;
+    ogs_sbi_response_t *response = NULL;
+    int i;
+
+    for (i = 0; i < test.num_of_request; i++) {
+        if (!test.stream_id[i])
+            continue;
+
+        stream = ogs_sbi_stream_find_by_id(test.stream_id[i]);
+        test.stream_id[i] = 0;
+        if (!stream)
+            continue;
+
+        response = ogs_sbi_response_new();
+        ogs_assert(response);
+        response->status = OGS_SBI_HTTP_STATUS_OK;
+        ogs_assert(true == ogs_sbi_server_send_response(stream, response));
+    }
+}
+
+/* Runs the NF loop until every request got its response */
+static void run(int num_of_response)
+{
+    ogs_time_t deadline = ogs_get_monotonic_time() + ogs_time_from_sec(5);
+
+    while (test.num_of_response < num_of_response &&
+            ogs_get_monotonic_time() < deadline) {
+        ogs_pollset_poll(ogs_app()->pollset, ogs_time_from_msec(10));
+        ogs_timer_mgr_expire(ogs_app()->timer_mgr);
+        respond_all();
+    }
+}
+
+static void send_request(ogs_sbi_client_t *client)
+{
+    ogs_sbi_request_t *request = NULL;
+
+    request = ogs_sbi_request_new();
+    ogs_assert(request);
+    request->h.method = ogs_strdup(OGS_SBI_HTTP_METHOD_GET);
+    ogs_assert(request->h.method);
+    request->h.uri = ogs_strdup(TEST_URI);
+    ogs_assert(request->h.uri);
+
+    ogs_assert(true ==
+            ogs_sbi_client_send_request(client, client_cb, request, NULL));
+
+    /* The client keeps its own copy */
+    ogs_sbi_request_free(request);
+}
+
+static ogs_sbi_server_t *server_start(void)
+{
+    ogs_sockaddr_t *addr = NULL;
+    ogs_sbi_server_t *server = NULL;
+
+    ogs_assert(OGS_OK == ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1",
+                TEST_PORT, 0));
+    server = ogs_sbi_server_add(NULL, OpenAPI_uri_scheme_http, addr, NULL);
+    ogs_assert(server);
+    ogs_freeaddrinfo(addr);
+
+    ogs_assert(OGS_OK == ogs_sbi_server_start_all(server_cb));
+
+    return server;
+}
+
+static void server_stop(void)
+{
+    ogs_sbi_server_stop_all();
+    ogs_sbi_server_remove_all();
+}
+
+static ogs_sbi_client_t *client_add(void)
+{
+    ogs_sockaddr_t *addr = NULL;
+    ogs_sbi_client_t *client = NULL;
+
+    ogs_assert(OGS_OK == ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1",
+                TEST_PORT, 0));
+    client = ogs_sbi_client_add(OpenAPI_uri_scheme_http, NULL, 0, addr, NULL);
+    ogs_assert(client);
+    ogs_freeaddrinfo(addr);
+
+    return client;
+}
+
+/* Requests one after the other share one connection and one easy handle */
+static void test1_func(abts_case *tc, void *data)
+{
+    ogs_sbi_server_t *server = NULL;
+    ogs_sbi_client_t *client = NULL;
+    int i;
+
+    memset(&test, 0, sizeof(test));
+
+    server = server_start();
+    client = client_add();
+
+    for (i = 0; i < 8; i++) {
+        send_request(client);
+        run(i + 1);
+        ABTS_INT_EQUAL(tc, i + 1, test.num_of_ok);
+
+        ABTS_INT_EQUAL(tc, 1, client->num_of_idle_easy);
+        ABTS_INT_EQUAL(tc, 1, ogs_list_count(&server->session_list));
+    }
+
+    ABTS_INT_EQUAL(tc, 8, test.num_of_request);
+    ABTS_INT_EQUAL(tc, 0, ogs_list_count(&client->connection_list));
+
+    ogs_sbi_client_remove(client);
+    server_stop();
+}
+
+/*
+ * A burst is spread over at most 'max_connections' connections,
+ * and no more than MAX_NUM_OF_IDLE_EASY(16) easy handles are kept.
+ */
+static void test2_func(abts_case *tc, void *data)
+{
+    ogs_sbi_client_connection_config_t *config = NULL;
+    ogs_sbi_server_t *server = NULL;
+    ogs_sbi_client_t *client = NULL;
+    int i, num_of_session;
+
+    memset(&test, 0, sizeof(test));
+
+    config = &ogs_sbi_self()->client_connection_config;
+    config->max_concurrent_streams = 4;
+    config->max_connections = 2;
+
+    server = server_start();
+    client = client_add();
+
+    for (i = 0; i < 32; i++)
+        send_request(client);
+    ABTS_INT_EQUAL(tc, 32, ogs_list_count(&client->connection_list));
+
+    run(32);
+    ABTS_INT_EQUAL(tc, 32, test.num_of_ok);
+    ABTS_INT_EQUAL(tc, 32, test.num_of_request);
+
+    num_of_session = ogs_list_count(&server->session_list);
+    ABTS_TRUE(tc, num_of_session >= 1 && num_of_session <= 2);
+
+    ABTS_INT_EQUAL(tc, 16, client->num_of_idle_easy);
+    ABTS_INT_EQUAL(tc, 0, ogs_list_count(&client->connection_list));
+
+    ogs_sbi_client_remove(client);
+    server_stop();
+
+    memset(config, 0, sizeof(*config));
+}
+
+/* Requests still in flight are failed when the client goes away */
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_sbi_client_t *client = NULL;
+    int i;
+
+    memset(&test, 0, sizeof(test));
+
+    server_start();
+    client = client_add();
+
+    for (i = 0; i < 4; i++)
+        send_request(client);
+
+    ogs_sbi_client_stop(client);
+    ABTS_INT_EQUAL(tc, 4, test.num_of_response);
+    ABTS_INT_EQUAL(tc, 0, test.num_of_ok);
+
+    ogs_sbi_client_remove(client);
+    server_stop();
+}
+
+abts_suite *test_sbi_client(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+
+    return suite;
+}
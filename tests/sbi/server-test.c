@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-sbi.h"
+#include "core/abts.h"
+
+#define TEST_PORT 7782
+#define TEST_URI "http://127.0.0.1:7782/nsbi-test/v1/echo"
+
+static struct {
+    /* Responses are held back until cleared */
+    bool hold;
+
+    int num_of_request;
+    ogs_pool_id_t stream_id[64];
+
+    int num_of_response;
+    int num_of_ok;
+} test;
+
+static int server_cb(ogs_sbi_request_t *request, void *data)
+{
+    ogs_assert(request);
+    ogs_assert(test.num_of_request < OGS_ARRAY_SIZE(test.stream_id));
+
+    test.stream_id[test.num_of_request++] = OGS_POINTER_TO_UINT(data);
+
+    return OGS_OK;
+}
+
+static int client_cb(int status, ogs_sbi_response_t *response, void *data)
+{
+    test.num_of_response++;
+
+    if (status == OGS_OK) {
+        ogs_assert(response);
+        if (response->status == OGS_SBI_HTTP_STATUS_OK)
+            test.num_of_ok++;
+        ogs_sbi_response_free(response);
+    }
+
+    return OGS_OK;
+}
+
+static void respond_all(void)
+{
+    ogs_sbi_stream_t *stream = NULL;
+    ogs_sbi_response_t *response = NULL;
+    int i;
+
+    if (test.hold)
+        return;
+
+    for (i = 0; i < test.num_of_request; i++) {
+        if (!test.stream_id[i])
+            continue;
+
+        stream = ogs_sbi_stream_find_by_id(test.stream_id[i]);
+        test.stream_id[i] = 0;
+        if (!stream)
+            continue;
+
+        response = ogs_sbi_response_new();
+        ogs_assert(response);
+        response->status = OGS_SBI_HTTP_STATUS_OK;
+        ogs_assert(true == ogs_sbi_server_send_response(stream, response));
+    }
+}
+
+static void poll_once(void)
+{
+    ogs_pollset_poll(ogs_app()->pollset, ogs_time_from_msec(10));
+    ogs_timer_mgr_expire(ogs_app()->timer_mgr);
+    respond_all();
+}
+
+#define RUN_UNTIL(cond) do { \
+    ogs_time_t __deadline = \
+        ogs_get_monotonic_time() + ogs_time_from_sec(5); \
+    while (!(cond) && ogs_get_monotonic_time() < __deadline) \
+        poll_once(); \
+} while (0)
+
+static int num_of_stream_left(void)
+{
+    int i, n = 0;
+
+    for (i = 0; i < test.num_of_request; i++)
+        if (ogs_sbi_stream_find_by_id(test.stream_id[i]))
+            n++;
+
+    return n;
+}
+
+static void send_request(ogs_sbi_client_t *client)
+{
+    ogs_sbi_request_t *request = NULL;
+
+    request = ogs_sbi_request_new();
+    ogs_assert(request);
+    request->h.method = ogs_strdup(OGS_SBI_HTTP_METHOD_GET);
+    ogs_assert(request->h.method);
+    request->h.uri = ogs_strdup(TEST_URI);
+    ogs_assert(request->h.uri);
+
+    ogs_assert(true ==
+            ogs_sbi_client_send_request(client, client_cb, request, NULL));
+
+    ogs_sbi_request_free(request);
+}
+
+static void server_start(int num_of_io_thread)
+{
+    ogs_sockaddr_t *addr = NULL;
+    ogs_sbi_server_t *server = NULL;
+
+    ogs_assert(OGS_OK == ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1",
+                TEST_PORT, 0));
+    server = ogs_sbi_server_add(NULL, OpenAPI_uri_scheme_http, addr, NULL);
+    ogs_assert(server);
+    ogs_freeaddrinfo(addr);
+
+    server->num_of_io_thread = num_of_io_thread;
+
+    ogs_assert(OGS_OK == ogs_sbi_server_start_all(server_cb));
+}
+
+static void server_stop(void)
+{
+    ogs_sbi_server_stop_all();
+    ogs_sbi_server_remove_all();
+}
+
+static ogs_sbi_client_t *client_add(void)
+{
+    ogs_sockaddr_t *addr = NULL;
+    ogs_sbi_client_t *client = NULL;
+
+    ogs_assert(OGS_OK == ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1",
+                TEST_PORT, 0));
+    client = ogs_sbi_client_add(OpenAPI_uri_scheme_http, NULL, 0, addr, NULL);
+    ogs_assert(client);
+    ogs_freeaddrinfo(addr);
+
+    memset(&test, 0, sizeof(test));
+
+    /*
+     * libcurl holds the other transfers back (CURLOPT_PIPEWAIT)
+     * until the first one on a new connection is done.
+     */
+    send_request(client);
+    RUN_UNTIL(test.num_of_response == 1);
+    ogs_assert(test.num_of_ok == 1);
+    memset(&test, 0, sizeof(test));
+
+    return client;
+}
+
+/* Every request reaches the callback and is answered */
+static void test1_func(abts_case *tc, void *data)
+{
+    int num_of_io_thread = OGS_POINTER_TO_UINT(data);
+    ogs_sbi_client_t *client = NULL;
+    int i;
+
+    server_start(num_of_io_thread);
+    client = client_add();
+
+    for (i = 0; i < 64; i++)
+        send_request(client);
+
+    RUN_UNTIL(test.num_of_response == 64);
+    ABTS_INT_EQUAL(tc, 64, test.num_of_request);
+    ABTS_INT_EQUAL(tc, 64, test.num_of_ok);
+
+    ogs_sbi_client_remove(client);
+    server_stop();
+}
+
+/* The streams go away when the client closes before the response */
+static void test2_func(abts_case *tc, void *data)
+{
+    int num_of_io_thread = OGS_POINTER_TO_UINT(data);
+    ogs_sbi_client_t *client = NULL;
+    int i;
+
+    server_start(num_of_io_thread);
+    client = client_add();
+    test.hold = true;
+
+    for (i = 0; i < 4; i++)
+        send_request(client);
+
+    RUN_UNTIL(test.num_of_request == 4);
+    ABTS_INT_EQUAL(tc, 4, test.num_of_request);
+    ABTS_INT_EQUAL(tc, 4, num_of_stream_left());
+
+    ogs_sbi_client_remove(client);
+
+    RUN_UNTIL(num_of_stream_left() == 0);
+    ABTS_INT_EQUAL(tc, 0, num_of_stream_left());
+    ABTS_INT_EQUAL(tc, 0, test.num_of_response);
+
+    server_stop();
+}
+
+/* Requests in flight are still answered after a graceful shutdown */
+static void test3_func(abts_case *tc, void *data)
+{
+    int num_of_io_thread = OGS_POINTER_TO_UINT(data);
+    ogs_sbi_client_t *client = NULL;
+    int i;
+
+    server_start(num_of_io_thread);
+    client = client_add();
+    test.hold = true;
+
+    for (i = 0; i < 4; i++)
+        send_request(client);
+
+    RUN_UNTIL(test.num_of_request == 4);
+    ABTS_INT_EQUAL(tc, 4, test.num_of_request);
+
+    ogs_sbi_server_graceful_shutdown_all();
+    for (i = 0; i < 10; i++)
+        poll_once();
+    ABTS_INT_EQUAL(tc, 0, test.num_of_response);
+
+    test.hold = false;
+    RUN_UNTIL(test.num_of_response == 4);
+    ABTS_INT_EQUAL(tc, 4, test.num_of_ok);
+
+    ogs_sbi_client_remove(client);
+    server_stop();
+}
+
+/* Stopping the server with requests in flight leaves no stream behind */
+static void test4_func(abts_case *tc, void *data)
+{
+    int num_of_io_thread = OGS_POINTER_TO_UINT(data);
+    ogs_sbi_client_t *client = NULL;
+    int i;
+
+    server_start(num_of_io_thread);
+    client = client_add();
+    test.hold = true;
+
+    for (i = 0; i < 4; i++)
+        send_request(client);
+
+    RUN_UNTIL(test.num_of_request == 4);
+    ABTS_INT_EQUAL(tc, 4, test.num_of_request);
+
+    ogs_sbi_server_graceful_shutdown_all();
+    server_stop();
+    ABTS_INT_EQUAL(tc, 0, num_of_stream_left());
+
+    ogs_sbi_client_remove(client);
+}
+
+abts_suite *test_sbi_server(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    /* In the NF thread */
+    abts_run_test(suite, test1_func, OGS_UINT_TO_POINTER(0));
+    abts_run_test(suite, test2_func, OGS_UINT_TO_POINTER(0));
+    abts_run_test(suite, test3_func, OGS_UINT_TO_POINTER(0));
+    abts_run_test(suite, test4_func, OGS_UINT_TO_POINTER(0));
+
+    /* With I/O threads */
+    abts_run_test(suite, test1_func, OGS_UINT_TO_POINTER(2));
+    abts_run_test(suite, test2_func, OGS_UINT_TO_POINTER(2));
+    abts_run_test(suite, test3_func, OGS_UINT_TO_POINTER(2));
+    abts_run_test(suite, test4_func, OGS_UINT_TO_POINTER(2));
+
+    return suite;
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-dbi.h"
+#include "core/abts.h"
+
+#define TEST_LATENCY        2000    /* usec */
+#define TEST_NUM_OF_THREAD  4
+#define TEST_NUM_OF_JOB     64
+
+typedef struct test_job_s {
+    ogs_dbi_job_t h;
+
+    abts_case *tc;
+    char supi[32];
+    int rv;
+    ogs_dbi_auth_info_t auth_info;
+} test_job_t;
+
+static int num_of_completed;
+
+static void test_job_handler(ogs_dbi_job_t *job)
+{
+    test_job_t *test_job = (test_job_t *)job;
+
+    test_job->rv = ogs_dbi_auth_info(test_job->supi, &test_job->auth_info);
+    if (test_job->rv == OGS_OK)
+        test_job->rv = ogs_dbi_increment_sqn(test_job->supi);
+}
+
+static void test_job_complete(ogs_dbi_job_t *job)
+{
+    test_job_t *test_job = (test_job_t *)job;
+
+    ABTS_INT_EQUAL(test_job->tc, OGS_OK, test_job->rv);
+    ABTS_INT_EQUAL(test_job->tc, 1, test_job->auth_info.use_opc);
+    ABTS_TRUE(test_job->tc, test_job->auth_info.sqn == 0);
+
+    num_of_completed++;
+}
+
+static test_job_t *test_job_new(abts_case *tc, int i)
+{
+    test_job_t *test_job = ogs_dbi_job_size(
+            sizeof(*test_job), test_job_handler, test_job_complete);
+    ogs_assert(test_job);
+
+    test_job->tc = tc;
+    ogs_snprintf(test_job->supi, sizeof(test_job->supi),
+            "imsi-0010100000%05d", i);
+
+    return test_job;
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    int rv;
+    ogs_dbi_auth_info_t auth_info;
+    ogs_subscription_data_t subscription_data;
+    uint8_t k[OGS_KEY_LEN];
+    char *supi = (char *)"imsi-001010000000001";
+
+    rv = ogs_dbi_init("mock://?amf=9001&k=00112233445566778899aabbccddeeff");
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    rv = ogs_dbi_auth_info(supi, &auth_info);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ogs_ascii_to_hex("00112233445566778899aabbccddeeff",
+            strlen("00112233445566778899aabbccddeeff"), k, sizeof(k));
+    ABTS_TRUE(tc, memcmp(auth_info.k, k, OGS_KEY_LEN) == 0);
+    ABTS_INT_EQUAL(tc, 0x90, auth_info.amf[0]);
+    ABTS_INT_EQUAL(tc, 0x01, auth_info.amf[1]);
+    ABTS_TRUE(tc, auth_info.sqn == 0);
+
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_dbi_increment_sqn(supi));
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_dbi_increment_sqn(supi));
+    rv = ogs_dbi_auth_info(supi, &auth_info);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_TRUE(tc, auth_info.sqn == 64);
+
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_dbi_update_sqn(supi, OGS_MAX_SQN));
+    ABTS_INT_EQUAL(tc, OGS_OK, ogs_dbi_increment_sqn(supi));
+    rv = ogs_dbi_auth_info(supi, &auth_info);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_TRUE(tc, auth_info.sqn == 31);
+
+    rv = ogs_dbi_auth_info((char *)"nai-user@realm", &auth_info);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, rv);
+
+    rv = ogs_dbi_subscription_data(supi, &subscription_data);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, rv);
+
+    ogs_dbi_final();
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    int rv, i;
+    ogs_queue_t *queue = NULL;
+    ogs_event_t *e = NULL;
+    ogs_dbi_auth_info_t auth_info;
+    char supi[32];
+
+    rv = ogs_dbi_init("mock://?latency=" OGS_STRINGIFY(TEST_LATENCY));
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    queue = ogs_queue_create(TEST_NUM_OF_JOB);
+    ogs_assert(queue);
+
+    rv = ogs_dbi_async_init(TEST_NUM_OF_THREAD, queue, NULL);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    num_of_completed = 0;
+
+    for (i = 0; i < TEST_NUM_OF_JOB; i++) {
+        test_job_t *test_job = test_job_new(tc, i);
+        rv = ogs_dbi_job_submit(&test_job->h);
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    }
+
+    /* Nothing is completed before the NF thread handles the event */
+    ABTS_INT_EQUAL(tc, 0, num_of_completed);
+
+    for (i = 0; i < TEST_NUM_OF_JOB; i++) {
+        rv = ogs_queue_pop(queue, (void **)&e);
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+        ABTS_INT_EQUAL(tc, OGS_EVENT_DBI, e->id);
+
+        ogs_dbi_job_complete(e->dbi.job);
+        ogs_event_free(e);
+    }
+
+    ABTS_INT_EQUAL(tc, TEST_NUM_OF_JOB, num_of_completed);
+
+    ogs_dbi_async_final();
+    ogs_queue_destroy(queue);
+
+    /* Every job has run its queries exactly once */
+    for (i = 0; i < TEST_NUM_OF_JOB; i++) {
+        ogs_snprintf(supi, sizeof(supi), "imsi-0010100000%05d", i);
+        rv = ogs_dbi_auth_info(supi, &auth_info);
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+        ABTS_TRUE(tc, auth_info.sqn == 32);
+    }
+
+    ogs_dbi_final();
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    int rv;
+    test_job_t *test_job = NULL;
+
+    rv = ogs_dbi_init("mock://");
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    /* Without DBI threads, the job completes in place */
+    rv = ogs_dbi_async_init(0, NULL, NULL);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    num_of_completed = 0;
+
+    test_job = test_job_new(tc, 0);
+    rv = ogs_dbi_job_submit(&test_job->h);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 1, num_of_completed);
+
+    ogs_dbi_async_final();
+
+    ogs_dbi_final();
+}
+
+static void test_subscription_data_set(
+        ogs_subscription_data_t *subscription_data, const char *dnn)
+{
+    ogs_session_t *session = NULL;
+
+    memset(subscription_data, 0, sizeof(*subscription_data));
+
+    subscription_data->ambr.uplink = 1024;
+    subscription_data->ambr.downlink = 2048;
+    subscription_data->mme_host = ogs_strdup("mme.localdomain");
+    subscription_data->num_of_slice = 1;
+    subscription_data->slice[0].s_nssai.sst = 1;
+    subscription_data->slice[0].num_of_session = 1;
+
+    session = &subscription_data->slice[0].session[0];
+    session->name = ogs_strdup(dnn);
+    session->ipv4_framed_routes = ogs_calloc(
+            OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI,
+            sizeof(session->ipv4_framed_routes[0]));
+    session->ipv4_framed_routes[0] = ogs_strdup("10.45.0.0/16");
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    int rv;
+    ogs_subscription_data_t subscription_data, cached;
+    ogs_dbi_cache_stat_t stat;
+    const char *supi1 = "imsi-001010000000001";
+    const char *supi2 = "imsi-001010000000002";
+    const char *supi3 = "imsi-001010000000003";
+
+    rv = ogs_dbi_cache_init(2, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    ABTS_TRUE(tc, !ogs_dbi_cache_get(supi1, &cached));
+
+    test_subscription_data_set(&subscription_data, "internet");
+    ogs_dbi_cache_put(supi1, &subscription_data);
+    ogs_dbi_cache_put(supi2, &subscription_data);
+    ogs_subscription_data_free(&subscription_data);
+
+    /* The copy does not share memory with the cache */
+    ABTS_TRUE(tc, ogs_dbi_cache_get(supi1, &cached));
+    ABTS_INT_EQUAL(tc, 2048, cached.ambr.downlink);
+    ABTS_STR_EQUAL(tc, "mme.localdomain", cached.mme_host);
+    ABTS_INT_EQUAL(tc, 1, cached.num_of_slice);
+    ABTS_STR_EQUAL(tc, "internet", cached.slice[0].session[0].name);
+    ABTS_STR_EQUAL(tc, "10.45.0.0/16",
+            cached.slice[0].session[0].ipv4_framed_routes[0]);
+    ABTS_PTR_EQUAL(tc, NULL, cached.slice[0].session[0].ipv6_framed_routes);
+    ogs_subscription_data_free(&cached);
+
+    /* SUPI#2 is the least recently used */
+    test_subscription_data_set(&subscription_data, "ims");
+    ogs_dbi_cache_put(supi3, &subscription_data);
+    ogs_subscription_data_free(&subscription_data);
+
+    ABTS_TRUE(tc, !ogs_dbi_cache_get(supi2, &cached));
+    ABTS_TRUE(tc, ogs_dbi_cache_get(supi3, &cached));
+    ABTS_STR_EQUAL(tc, "ims", cached.slice[0].session[0].name);
+    ogs_subscription_data_free(&cached);
+
+    /* Write-through */
+    ogs_dbi_cache_update_mme(supi1, NULL, "localdomain", true);
+    ABTS_TRUE(tc, ogs_dbi_cache_get(supi1, &cached));
+    ABTS_PTR_EQUAL(tc, NULL, cached.mme_host);
+    ABTS_STR_EQUAL(tc, "localdomain", cached.mme_realm);
+    ABTS_TRUE(tc, cached.purge_flag);
+    ogs_subscription_data_free(&cached);
+
+    ogs_dbi_cache_remove(supi1);
+    ABTS_TRUE(tc, !ogs_dbi_cache_get(supi1, &cached));
+
+    ogs_dbi_cache_stat(&stat);
+    ABTS_INT_EQUAL(tc, 3, (int)stat.hit);
+    ABTS_INT_EQUAL(tc, 3, (int)stat.miss);
+    ABTS_INT_EQUAL(tc, 1, (int)stat.eviction);
+    ABTS_INT_EQUAL(tc, 1, (int)stat.invalidation);
+    ABTS_INT_EQUAL(tc, 1, stat.count);
+
+    ogs_dbi_cache_final();
+
+    /* Expired entries are read again */
+    rv = ogs_dbi_cache_init(2, ogs_time_from_msec(1));
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    test_subscription_data_set(&subscription_data, "internet");
+    ogs_dbi_cache_put(supi1, &subscription_data);
+    ogs_subscription_data_free(&subscription_data);
+
+    ogs_msleep(2);
+    ABTS_TRUE(tc, !ogs_dbi_cache_get(supi1, &cached));
+
+    ogs_dbi_cache_stat(&stat);
+    ABTS_INT_EQUAL(tc, 0, stat.count);
+
+    ogs_dbi_cache_final();
+}
+
+abts_suite *test_dbi(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+
+    return suite;
+}
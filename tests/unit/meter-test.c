@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2019 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+#include "core/abts.h"
+
+/* 80 Mbps MBR, 50ms burst */
+#define TEST_RATE       (10 * 1000 * 1000ULL)
+#define TEST_BURST      (TEST_RATE / 20)
+#define TEST_PKT_LEN    1000
+
+#define NUM_OF_THREAD   2
+
+static struct {
+    ogs_pfcp_meter_t meter;
+    ogs_time_t deadline;
+} test;
+
+typedef struct test_thread_s {
+    uint64_t conform;
+    uint64_t drop;
+} test_thread_t;
+
+/* A full bucket lets the burst through, then nothing until it refills */
+static void test1_func(abts_case *tc, void *data)
+{
+    ogs_pfcp_meter_t meter;
+    uint64_t conform = 0;
+
+    memset(&meter, 0, sizeof(meter));
+
+    while (ogs_pfcp_meter_conform(&meter, TEST_RATE, TEST_PKT_LEN))
+        conform += TEST_PKT_LEN;
+
+    ABTS_TRUE(tc, conform >= TEST_BURST);
+    ABTS_TRUE(tc, conform <= TEST_BURST + TEST_RATE / 100);
+}
+
+static void police(void *data)
+{
+    test_thread_t *thread = data;
+
+    while (ogs_get_monotonic_time() < test.deadline) {
+        if (ogs_pfcp_meter_conform(&test.meter, TEST_RATE, TEST_PKT_LEN))
+            thread->conform += TEST_PKT_LEN;
+        else
+            thread->drop += TEST_PKT_LEN;
+    }
+}
+
+/*
+ * Two threads, as two UPF data plane workers, police the same QER
+ * at full speed. Together they never get more than the MBR.
+ */
+static void test2_func(abts_case *tc, void *data)
+{
+    ogs_thread_t *thread[NUM_OF_THREAD];
+    test_thread_t result[NUM_OF_THREAD];
+    ogs_time_t start, elapsed;
+    uint64_t conform = 0, drop = 0;
+    int i;
+
+    memset(&test, 0, sizeof(test));
+    memset(result, 0, sizeof(result));
+
+    start = ogs_get_monotonic_time();
+    test.deadline = start + ogs_time_from_msec(200);
+
+    for (i = 0; i < NUM_OF_THREAD; i++) {
+        thread[i] = ogs_thread_create(police, &result[i]);
+        ogs_assert(thread[i]);
+    }
+    for (i = 0; i < NUM_OF_THREAD; i++)
+        ogs_thread_destroy(thread[i]);
+
+    elapsed = ogs_get_monotonic_time() - start;
+
+    for (i = 0; i < NUM_OF_THREAD; i++) {
+        conform += result[i].conform;
+        drop += result[i].drop;
+    }
+
+    ABTS_TRUE(tc, drop > 0);
+    ABTS_TRUE(tc, conform >= TEST_BURST);
+    ABTS_TRUE(tc, conform <=
+            TEST_BURST + TEST_RATE * (uint64_t)elapsed / 1000000);
+}
+
+abts_suite *test_meter(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+
+    return suite;
+}
@@ -372,6 +372,142 @@ static void ngap_message_test5_issues2934(abts_case *tc, void *data)
     ogs_pkbuf_free(ngapbuf);
 }
 
+/*
+ * Captured NGAP messages decoded into the arena by ogs_ngap_decode()
+ * are encoded back unchanged. The timed version is in tests/benchmark.
+ */
+static void ngap_roundtrip(abts_case *tc, ogs_pkbuf_t *pkbuf)
+{
+    ogs_ngap_message_t message;
+    ogs_pkbuf_t *encoded = NULL;
+    int rv;
+
+    rv = ogs_ngap_decode(&message, pkbuf);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    encoded = ogs_ngap_encode(&message);
+    ABTS_PTR_NOTNULL(tc, encoded);
+    ABTS_INT_EQUAL(tc, pkbuf->len, encoded->len);
+    ABTS_TRUE(tc, memcmp(pkbuf->data, encoded->data, pkbuf->len) == 0);
+    ogs_pkbuf_free(encoded);
+}
+
+static void ngap_message_test6(abts_case *tc, void *data)
+{
+    static const struct {
+        const char *name;
+        const char *payload;
+        int len;
+    } captured[] = {
+        { "NGSetupRequest",
+          "0015004200000500 1b00090009f10728 000800000052400b 0400354720674e42"
+          "2d43550066000d00 000000010009f107 0000000800154001 0001114009403035"
+          "484c41423032", 70 },
+        { "NGSetupRequest",
+          "0015003f00000500 1b00080045f01000 0000040052400903 0035484c41423032"
+          "0066000d00000062 280045f010000000 0800154001400111 4009203035484c41"
+          "423032", 67 },
+        { "NGReset",
+          "0014001300000200 0f400200c0005800 06400160010001", 23 },
+    };
+    const char *payload =
+        "7e005c00 0d0199f9 07f0ff00 00000020"
+        "3190";
+    ogs_pkbuf_t *pkbuf = NULL;
+    char hexbuf[OGS_HUGE_LEN];
+    int i;
+
+    for (i = 0; i < OGS_ARRAY_SIZE(captured); i++) {
+        pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+        ogs_assert(pkbuf);
+        ogs_pkbuf_put_data(pkbuf, ogs_hex_from_string(
+                captured[i].payload, hexbuf, sizeof(hexbuf)), captured[i].len);
+
+        ngap_roundtrip(tc, pkbuf);
+
+        ogs_pkbuf_free(pkbuf);
+    }
+
+    /* UplinkNASTransport(Registration Request) */
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 18);
+
+    pkbuf = build_uplink_nas_transport(1, 2, pkbuf);
+    ogs_assert(pkbuf);
+
+    ngap_roundtrip(tc, pkbuf);
+
+    ogs_pkbuf_free(pkbuf);
+}
+
+/* A message that fails to decode leaves nothing behind to free */
+static void ngap_message_test7(abts_case *tc, void *data)
+{
+    /* NGReset, truncated */
+    const char *payload = "0014001300000200 0f400200c0005800";
+
+    ogs_ngap_message_t message;
+    ogs_pkbuf_t *pkbuf;
+    int result;
+    char hexbuf[OGS_HUGE_LEN];
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 16);
+
+    result = ogs_ngap_decode(&message, pkbuf);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, result);
+    ABTS_INT_EQUAL(tc, NGAP_NGAP_PDU_PR_NOTHING, message.present);
+    ogs_ngap_free(&message);
+
+    ogs_pkbuf_free(pkbuf);
+
+    /* NGReset, freed twice */
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf, ogs_hex_from_string(
+            "0014001300000200 0f400200c0005800 06400160010001",
+            hexbuf, sizeof(hexbuf)), 23);
+
+    result = ogs_ngap_decode(&message, pkbuf);
+    ABTS_INT_EQUAL(tc, OGS_OK, result);
+    ogs_ngap_free(&message);
+    ABTS_INT_EQUAL(tc, NGAP_NGAP_PDU_PR_NOTHING, message.present);
+    ogs_ngap_free(&message);
+
+    ogs_pkbuf_free(pkbuf);
+}
+
+/* An arena takes its first chunk only when something is allocated */
+static void ngap_message_test8(abts_case *tc, void *data)
+{
+    ogs_ngap_message_t message;
+    uint64_t count;
+    void *ptr;
+
+    memset(&message, 0, sizeof(message));
+    message.present = NGAP_NGAP_PDU_PR_initiatingMessage;
+
+    count = ogs_asn_alloc_count();
+    ogs_asn_arena_enter(&message, sizeof(message));
+    ogs_asn_arena_leave();
+    ABTS_TRUE(tc, ogs_asn_alloc_count() == count);
+    ABTS_INT_EQUAL(tc, true, ogs_asn_arena_release(&message));
+    ABTS_INT_EQUAL(tc, NGAP_NGAP_PDU_PR_NOTHING, message.present);
+    ABTS_INT_EQUAL(tc, false, ogs_asn_arena_release(&message));
+
+    ogs_asn_arena_enter(&message, sizeof(message));
+    ptr = CALLOC(1, 16);
+    ABTS_PTR_NOTNULL(tc, ptr);
+    ogs_asn_arena_leave();
+    ABTS_TRUE(tc, ogs_asn_alloc_count() == count + 1);
+    FREEMEM(ptr);
+    ABTS_INT_EQUAL(tc, true, ogs_asn_arena_release(&message));
+    ABTS_INT_EQUAL(tc, false, ogs_asn_arena_release(&message));
+}
+
 abts_suite *test_ngap_message(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -383,6 +519,9 @@ abts_suite *test_ngap_message(abts_suite *suite)
     abts_run_test(suite, ngap_message_test3, NULL);
     abts_run_test(suite, ngap_message_test4, NULL);
     abts_run_test(suite, ngap_message_test5_issues2934, NULL);
+    abts_run_test(suite, ngap_message_test6, NULL);
+    abts_run_test(suite, ngap_message_test7, NULL);
+    abts_run_test(suite, ngap_message_test8, NULL);
 
     return suite;
 }
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2019-2023 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+#include "core/abts.h"
+
+#define NUM_OF_PDR 4
+#define NUM_OF_SDF_FILTER 2
+
+/* Session Establishment Request with a few PDRs and FARs */
+static ogs_pkbuf_t *pfcp_message_test_build(uint64_t seid)
+{
+    ogs_pfcp_message_t *pfcp_message = NULL;
+    ogs_pfcp_session_establishment_request_t *req = NULL;
+    ogs_pfcp_header_t *h = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+    int i, j;
+
+    static uint8_t node_id[] = { 0x00, 0x0a, 0x00, 0x00, 0x01 };
+    static uint8_t f_seid[] = {
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0x0a, 0x00, 0x00, 0x01 };
+    static uint8_t sdf_filter[] =
+        "\x01\x00\x00\x1a" "permit out ip from any to assigned";
+
+    pfcp_message = ogs_calloc(1, sizeof(*pfcp_message));
+    ogs_assert(pfcp_message);
+    req = &pfcp_message->pfcp_session_establishment_request;
+
+    pfcp_message->h.type = OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE;
+
+    req->node_id.presence = 1;
+    req->node_id.data = node_id;
+    req->node_id.len = sizeof(node_id);
+
+    req->cp_f_seid.presence = 1;
+    req->cp_f_seid.data = f_seid;
+    req->cp_f_seid.len = sizeof(f_seid);
+
+    for (i = 0; i < NUM_OF_PDR; i++) {
+        ogs_pfcp_tlv_create_pdr_t *create_pdr = &req->create_pdr[i];
+        ogs_pfcp_tlv_create_far_t *create_far = &req->create_far[i];
+
+        create_pdr->presence = 1;
+        create_pdr->pdr_id.presence = 1;
+        create_pdr->pdr_id.u16 = i + 1;
+        create_pdr->precedence.presence = 1;
+        create_pdr->precedence.u32 = 255 - i;
+        create_pdr->pdi.presence = 1;
+        create_pdr->pdi.source_interface.presence = 1;
+        create_pdr->pdi.source_interface.u8 = i & 1;
+        for (j = 0; j < NUM_OF_SDF_FILTER; j++) {
+            create_pdr->pdi.sdf_filter[j].presence = 1;
+            create_pdr->pdi.sdf_filter[j].data = sdf_filter;
+            create_pdr->pdi.sdf_filter[j].len = sizeof(sdf_filter) - 1;
+        }
+        create_pdr->far_id.presence = 1;
+        create_pdr->far_id.u32 = i + 1;
+
+        create_far->presence = 1;
+        create_far->far_id.presence = 1;
+        create_far->far_id.u32 = i + 1;
+        create_far->apply_action.presence = 1;
+        create_far->apply_action.u16 = OGS_PFCP_APPLY_ACTION_FORW;
+    }
+
+    req->pdn_type.presence = 1;
+    req->pdn_type.u8 = OGS_PDU_SESSION_TYPE_IPV4;
+
+    pkbuf = ogs_pfcp_build_msg(pfcp_message);
+    ogs_assert(pkbuf);
+    ogs_pfcp_message_free(pfcp_message);
+
+    ogs_assert(ogs_pkbuf_push(pkbuf, OGS_PFCP_HEADER_LEN));
+    h = (ogs_pfcp_header_t *)pkbuf->data;
+    memset(h, 0, OGS_PFCP_HEADER_LEN);
+    h->version = OGS_PFCP_VERSION;
+    h->seid_presence = 1;
+    h->type = OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE;
+    h->length = htobe16(pkbuf->len - 4);
+    h->seid = htobe64(seid);
+    h->sqn = OGS_PFCP_XID_TO_SQN(1);
+
+    return pkbuf;
+}
+
+static void pfcp_message_test1(abts_case *tc, void *data)
+{
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_pfcp_message_t *pfcp_message = NULL;
+    ogs_pfcp_session_establishment_request_t *req = NULL;
+    int i, j;
+
+    pkbuf = pfcp_message_test_build(0x1122334455667788ULL);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+
+    pfcp_message = ogs_pfcp_parse_msg(pkbuf);
+    ABTS_PTR_NOTNULL(tc, pfcp_message);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE,
+            pfcp_message->h.type);
+    ABTS_TRUE(tc, pfcp_message->h.seid == 0x1122334455667788ULL);
+
+    req = &pfcp_message->pfcp_session_establishment_request;
+    ABTS_INT_EQUAL(tc, 1, req->node_id.presence);
+    ABTS_INT_EQUAL(tc, 5, req->node_id.len);
+    ABTS_INT_EQUAL(tc, 1, req->cp_f_seid.presence);
+    ABTS_INT_EQUAL(tc, 13, req->cp_f_seid.len);
+    ABTS_INT_EQUAL(tc, 1, req->pdn_type.presence);
+    ABTS_INT_EQUAL(tc, OGS_PDU_SESSION_TYPE_IPV4, req->pdn_type.u8);
+
+    for (i = 0; i < NUM_OF_PDR; i++) {
+        ogs_pfcp_tlv_create_pdr_t *create_pdr = &req->create_pdr[i];
+        ogs_pfcp_tlv_create_far_t *create_far = &req->create_far[i];
+
+        ABTS_INT_EQUAL(tc, 1, create_pdr->presence);
+        ABTS_INT_EQUAL(tc, i + 1, create_pdr->pdr_id.u16);
+        ABTS_INT_EQUAL(tc, 255 - i, create_pdr->precedence.u32);
+        ABTS_INT_EQUAL(tc, i & 1, create_pdr->pdi.source_interface.u8);
+        for (j = 0; j < NUM_OF_SDF_FILTER; j++) {
+            ogs_pfcp_tlv_sdf_filter_t *sdf_filter =
+                &create_pdr->pdi.sdf_filter[j];
+
+            ABTS_INT_EQUAL(tc, 1, sdf_filter->presence);
+            ABTS_INT_EQUAL(tc, 38, sdf_filter->len);
+            ABTS_TRUE(tc, memcmp((uint8_t *)sdf_filter->data + 4,
+                        "permit out ip from any to assigned", 34) == 0);
+
+            /* Octet values are not copied out of the packet */
+            ABTS_TRUE(tc, (uint8_t *)sdf_filter->data >= pkbuf->head);
+            ABTS_TRUE(tc, (uint8_t *)sdf_filter->data < pkbuf->end);
+        }
+        ABTS_INT_EQUAL(tc, 0, create_pdr->pdi.sdf_filter[j].presence);
+        ABTS_INT_EQUAL(tc, i + 1, create_pdr->far_id.u32);
+
+        ABTS_INT_EQUAL(tc, 1, create_far->presence);
+        ABTS_INT_EQUAL(tc, i + 1, create_far->far_id.u32);
+        ABTS_INT_EQUAL(tc, OGS_PFCP_APPLY_ACTION_FORW,
+                create_far->apply_action.u16);
+    }
+    ABTS_INT_EQUAL(tc, 0, req->create_pdr[i].presence);
+
+    ogs_pfcp_message_free(pfcp_message);
+    ogs_pkbuf_free(pkbuf);
+}
+
+/* Truncated or inconsistent IEs are rejected without reading past them */
+static void pfcp_message_test2(abts_case *tc, void *data)
+{
+    ogs_pkbuf_t *pkbuf = NULL, *copy = NULL;
+    ogs_pfcp_message_t *pfcp_message = NULL;
+    ogs_log_level_e tlv_level, pfcp_level;
+    uint8_t *ie = NULL;
+    int len;
+
+    tlv_level = ogs_log_get_domain_level(__ogs_tlv_domain);
+    pfcp_level = ogs_log_get_domain_level(__ogs_pfcp_domain);
+    ogs_log_set_domain_level(__ogs_tlv_domain, OGS_LOG_NONE);
+    ogs_log_set_domain_level(__ogs_pfcp_domain, OGS_LOG_NONE);
+
+    pkbuf = pfcp_message_test_build(1);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+
+    for (len = 1; len < pkbuf->len; len++) {
+        copy = ogs_pkbuf_alloc(NULL, len);
+        ogs_assert(copy);
+        ogs_pkbuf_put_data(copy, pkbuf->data, len);
+
+        pfcp_message = ogs_pfcp_parse_msg(copy);
+        if (pfcp_message)
+            ogs_pfcp_message_free(pfcp_message);
+
+        /* Cut in the middle of the Node ID */
+        if (len > OGS_PFCP_HEADER_LEN && len < OGS_PFCP_HEADER_LEN + 4 + 5)
+            ABTS_PTR_EQUAL(tc, NULL, pfcp_message);
+
+        ogs_pkbuf_free(copy);
+    }
+
+    /* Node ID, F-SEID and then the first Create PDR */
+    ie = pkbuf->data + OGS_PFCP_HEADER_LEN + (4 + 5) + (4 + 13);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CREATE_PDR_TYPE, (ie[0] << 8) | ie[1]);
+
+    /* Create PDR running past the end of the message */
+    ie[2] = 0x7f;
+    copy = ogs_pkbuf_copy(pkbuf);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_parse_msg(copy));
+    ogs_pkbuf_free(copy);
+
+    /* PDR ID running past the end of the Create PDR */
+    ie[2] = 0x00;
+    ie[7] = 0x7f;
+    copy = ogs_pkbuf_copy(pkbuf);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_parse_msg(copy));
+    ogs_pkbuf_free(copy);
+
+    ogs_pkbuf_free(pkbuf);
+
+    ogs_log_set_domain_level(__ogs_tlv_domain, tlv_level);
+    ogs_log_set_domain_level(__ogs_pfcp_domain, pfcp_level);
+}
+
+abts_suite *test_pfcp_message(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, pfcp_message_test1, NULL);
+    abts_run_test(suite, pfcp_message_test2, NULL);
+
+    return suite;
+}
@@ -1330,6 +1330,118 @@ static void s1ap_message_test10(abts_case *tc, void *data)
     ogs_pkbuf_free(s1apbuf);
 }
 
+/*
+ * Cost of decoding and encoding captured S1AP messages, in ns and in
+ * allocations per message. ogs_s1ap_decode() builds the tree in an arena,
+ * while aper_decode() alone builds it from the heap as before.
+ */
+#define S1AP_BENCH_LOOP 10000
+
+static void s1ap_bench(abts_case *tc, const char *name, ogs_pkbuf_t *pkbuf)
+{
+    ogs_s1ap_message_t message, *struct_ptr = &message;
+    ogs_pkbuf_t *encoded = NULL;
+    asn_dec_rval_t dec_ret = {0};
+    ogs_time_t start, usec[3];
+    uint64_t count[3];
+    int i, rv;
+
+    rv = ogs_s1ap_decode(&message, pkbuf);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    encoded = ogs_s1ap_encode(&message);
+    ABTS_PTR_NOTNULL(tc, encoded);
+    ABTS_INT_EQUAL(tc, pkbuf->len, encoded->len);
+    ABTS_TRUE(tc, memcmp(pkbuf->data, encoded->data, pkbuf->len) == 0);
+    ogs_pkbuf_free(encoded);
+
+#define BENCH(__n, __stmt) do { \
+        count[__n] = ogs_asn_alloc_count(); \
+        start = ogs_get_monotonic_time(); \
+        for (i = 0; i < S1AP_BENCH_LOOP; i++) { __stmt; } \
+        usec[__n] = ogs_get_monotonic_time() - start; \
+        count[__n] = ogs_asn_alloc_count() - count[__n]; \
+    } while (0)
+
+    BENCH(0,
+        memset(&message, 0, sizeof(message));
+        dec_ret = aper_decode(NULL, &asn_DEF_S1AP_S1AP_PDU,
+                (void **)&struct_ptr, pkbuf->data, pkbuf->len, 0, 0);
+        ogs_assert(dec_ret.code == RC_OK);
+        ogs_s1ap_free(&message));
+    BENCH(1,
+        rv = ogs_s1ap_decode(&message, pkbuf);
+        ogs_assert(rv == OGS_OK);
+        ogs_s1ap_free(&message));
+    BENCH(2,
+        rv = ogs_s1ap_decode(&message, pkbuf);
+        ogs_assert(rv == OGS_OK);
+        encoded = ogs_s1ap_encode(&message);
+        ogs_assert(encoded);
+        ogs_pkbuf_free(encoded));
+
+#undef BENCH
+
+#define NSEC(__n) ((long long)usec[__n] * 1000 / S1AP_BENCH_LOOP)
+#define ALLOC(__n) ((long long)count[__n] / S1AP_BENCH_LOOP)
+    ogs_info("[%s:%d bytes] decode %lld ns/%lld allocs "
+            "(heap %lld ns/%lld allocs), encode %lld ns/%lld allocs",
+            name, pkbuf->len, NSEC(1), ALLOC(1), NSEC(0), ALLOC(0),
+            NSEC(2) - NSEC(1), ALLOC(2) - ALLOC(1));
+#undef NSEC
+#undef ALLOC
+}
+
+static void s1ap_message_test11(abts_case *tc, void *data)
+{
+    static const struct {
+        const char *name;
+        const char *payload;
+        int len;
+    } captured[] = {
+        { "S1SetupRequest",
+          "0011002d000004003b00090000f11040"
+          "54f64010003c400903004a4c542d3632"
+          "3100400007000c0e4000f11000894001"
+          "00", 49 },
+        { "InitialUEMessage(Attach Request)",
+          "000c406f000006000800020001001a00"
+          "3c3b17df675aa8050741020bf600f110"
+          "000201030003e605f070000010000502"
+          "15d011d15200f11030395c0a003103e5"
+          "e0349011035758a65d0100e0c1004300"
+          "060000f1103039006440080000f1108c"
+          "3378200086400130004b00070000f110"
+          "000201", 115 },
+        { "InitialContextSetupResponse",
+          "2009002500000300004005c0020000bf"
+          "0008400200010033400f000032400a0a"
+          "1f0a0123c601000908", 41 },
+        { "ENBDirectInformationTransfer",
+          "0025004a000001007900432036715489 0164f0000100010002548f0264f00000"
+          "010064f000400000002057974b81054c 84000000204f81005581014d860064f0"
+          "00000280094064f0000100010002", 78 },
+        { "ENBConfigurationTransfer",
+          "0028"
+          "403b000001008140 3440049699000004 3004969900020004 969900001f200496"
+          "9900020000000098 401341f0ac110e02 0000009940070200 f8ac110e02", 63 },
+    };
+
+    ogs_pkbuf_t *pkbuf = NULL;
+    char hexbuf[OGS_HUGE_LEN];
+    int i;
+
+    for (i = 0; i < OGS_ARRAY_SIZE(captured); i++) {
+        pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+        ogs_assert(pkbuf);
+        ogs_pkbuf_put_data(pkbuf, ogs_hex_from_string(
+                captured[i].payload, hexbuf, sizeof(hexbuf)), captured[i].len);
+
+        s1ap_bench(tc, captured[i].name, pkbuf);
+
+        ogs_pkbuf_free(pkbuf);
+    }
+}
+
 abts_suite *test_s1ap_message(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -1346,6 +1458,7 @@ abts_suite *test_s1ap_message(abts_suite *suite)
     abts_run_test(suite, s1ap_message_test8, NULL);
     abts_run_test(suite, s1ap_message_test9, NULL);
     abts_run_test(suite, s1ap_message_test10, NULL);
+    abts_run_test(suite, s1ap_message_test11, NULL);
 
     return suite;
 }
@@ -1021,6 +1021,173 @@ static void sbi_message_test10(abts_case *tc, void *param)
     }
 }
 
+/*
+ * Bodies of the hot SBI messages, converted through the cJSON tree
+ * either on the heap or in the arena used by parse_json()/build_json().
+ * The timed version is in tests/benchmark.
+ */
+static const struct {
+    const char *name;
+    const char *json;
+    void *(*parse)(cJSON *);
+    cJSON *(*convert)(void *);
+    void (*free)(void *);
+} json_model[] = {
+#define JSON_MODEL(__name) \
+    (void *(*)(cJSON *))OpenAPI_##__name##_parseFromJSON, \
+    (cJSON *(*)(void *))OpenAPI_##__name##_convertToJSON, \
+    (void (*)(void *))OpenAPI_##__name##_free
+    { "NFProfile",
+        "{\"nfInstanceId\":\"c2a0f3a8-5b3e-41ee-8a3f-8f0b4d2e7c11\","
+        "\"nfType\":\"SMF\",\"nfStatus\":\"REGISTERED\","
+        "\"heartBeatTimer\":10,"
+        "\"plmnList\":[{\"mcc\":\"999\",\"mnc\":\"70\"}],"
+        "\"sNssais\":[{\"sst\":1},{\"sst\":1,\"sd\":\"000080\"}],"
+        "\"ipv4Addresses\":[\"127.0.0.4\"],"
+        "\"allowedNfTypes\":[\"AMF\",\"SCP\"],"
+        "\"priority\":0,\"capacity\":100,\"load\":0,"
+        "\"nfServiceList\":{\"c2a1d6f4-5b3e-41ee-8a3f-8f0b4d2e7c11\":{"
+        "\"serviceInstanceId\":\"c2a1d6f4-5b3e-41ee-8a3f-8f0b4d2e7c11\","
+        "\"serviceName\":\"nsmf-pdusession\","
+        "\"versions\":[{\"apiVersionInUri\":\"v1\","
+        "\"apiFullVersion\":\"1.0.0\"}],"
+        "\"scheme\":\"http\",\"nfServiceStatus\":\"REGISTERED\","
+        "\"ipEndPoints\":[{\"ipv4Address\":\"127.0.0.4\",\"port\":7777}],"
+        "\"allowedNfTypes\":[\"AMF\"],"
+        "\"priority\":0,\"capacity\":100,\"load\":0}},"
+        "\"smfInfo\":{\"sNssaiSmfInfoList\":[{\"sNssai\":{\"sst\":1},"
+        "\"dnnSmfInfoList\":[{\"dnn\":\"internet\"},{\"dnn\":\"ims\"}]}],"
+        "\"taiList\":[{\"plmnId\":{\"mcc\":\"999\",\"mnc\":\"70\"},"
+        "\"tac\":\"000001\"}]},"
+        "\"nfProfileChangesSupportInd\":true}",
+        JSON_MODEL(nf_profile) },
+    { "SmContextCreateData",
+        "{\"supi\":\"imsi-999700000000001\","
+        "\"pei\":\"imeisv-4370816125816151\","
+        "\"pduSessionId\":1,\"dnn\":\"internet\","
+        "\"sNssai\":{\"sst\":1},"
+        "\"servingNfId\":\"a1b2c3d4-5b3e-41ee-8a3f-8f0b4d2e7c11\","
+        "\"guami\":{\"plmnId\":{\"mcc\":\"999\",\"mnc\":\"70\"},"
+        "\"amfId\":\"020040\"},"
+        "\"servingNetwork\":{\"mcc\":\"999\",\"mnc\":\"70\"},"
+        "\"n1SmMsg\":{\"contentId\":\"5gnas-sm\"},"
+        "\"anType\":\"3GPP_ACCESS\",\"ratType\":\"NR\","
+        "\"ueLocation\":{\"nrLocation\":{\"tai\":{\"plmnId\":{"
+        "\"mcc\":\"999\",\"mnc\":\"70\"},\"tac\":\"000001\"},"
+        "\"ncgi\":{\"plmnId\":{\"mcc\":\"999\",\"mnc\":\"70\"},"
+        "\"nrCellId\":\"000000010\"},"
+        "\"ueLocationTimestamp\":\"2023-03-01T09:21:43.184545Z\"}},"
+        "\"ueTimeZone\":\"+00:00\","
+        "\"smContextStatusUri\":\"http://127.0.0.5:7777/namf-callback/"
+        "v1/imsi-999700000000001/sm-context-status/1\","
+        "\"pcfId\":\"d5e6f7a8-5b3e-41ee-8a3f-8f0b4d2e7c11\"}",
+        JSON_MODEL(sm_context_create_data) },
+    { "UeAuthenticationCtx",
+        "{\"authType\":\"5G_AKA\",\"5gAuthData\":{"
+        "\"rand\":\"4a1ab1a4a3d24c8b9c7a1c7e8c5f3d10\","
+        "\"hxresStar\":\"f1c4a6b12d9f8e2c7b3a4d5e6f708192\","
+        "\"autn\":\"0b2c3d4e5f6a80001e2f3a4b5c6d7e8f\"},"
+        "\"_links\":{\"5g-aka\":{\"href\":\"http://127.0.0.11:7777/"
+        "nausf-auth/v1/ue-authentications/1/5g-aka-confirmation\"}},"
+        "\"servingNetworkName\":\"5G:mnc070.mcc999.3gppnetwork.org\"}",
+        JSON_MODEL(ue_authentication_ctx) },
+    { "PolicyAssociationRequest",
+        "{\"notificationUri\":\"http://127.0.0.5:7777/namf-callback/v1/"
+        "imsi-999700000000001/am-policy-notify/1\","
+        "\"supi\":\"imsi-999700000000001\","
+        "\"pei\":\"imeisv-4370816125816151\","
+        "\"accessType\":\"3GPP_ACCESS\","
+        "\"userLoc\":{\"nrLocation\":{\"tai\":{\"plmnId\":{"
+        "\"mcc\":\"999\",\"mnc\":\"70\"},\"tac\":\"000001\"},"
+        "\"ncgi\":{\"plmnId\":{\"mcc\":\"999\",\"mnc\":\"70\"},"
+        "\"nrCellId\":\"000000010\"}}},"
+        "\"timeZone\":\"+00:00\","
+        "\"servingPlmn\":{\"mcc\":\"999\",\"mnc\":\"70\"},"
+        "\"ratType\":\"NR\","
+        "\"ueAmbr\":{\"uplink\":\"1048576 Kbps\","
+        "\"downlink\":\"1048576 Kbps\"},"
+        "\"allowedSnssais\":[{\"sst\":1}],"
+        "\"guami\":{\"plmnId\":{\"mcc\":\"999\",\"mnc\":\"70\"},"
+        "\"amfId\":\"020040\"},"
+        "\"suppFeat\":\"4000000\"}",
+        JSON_MODEL(policy_association_request) },
+#undef JSON_MODEL
+};
+
+static void *json_parse(int i, const char *json, bool arena)
+{
+    cJSON *item = NULL;
+    void *model = NULL;
+
+    if (arena)
+        OpenAPI_arena_enter(strlen(json) * 4);
+
+    item = cJSON_Parse(json);
+    ogs_assert(item);
+    model = json_model[i].parse(item);
+
+    if (arena)
+        OpenAPI_arena_leave();
+    else
+        cJSON_Delete(item);
+
+    return model;
+}
+
+static char *json_build(int i, void *model, bool arena)
+{
+    cJSON *item = NULL;
+    char *json = NULL, *content = NULL;
+
+    if (arena)
+        OpenAPI_arena_enter(0);
+
+    item = json_model[i].convert(model);
+    ogs_assert(item);
+    json = cJSON_PrintUnformatted(item);
+    ogs_assert(json);
+
+    if (arena) {
+        content = ogs_strdup(json);
+        OpenAPI_arena_leave();
+    } else {
+        content = json;
+        cJSON_Delete(item);
+    }
+
+    return content;
+}
+
+static void sbi_message_test11(abts_case *tc, void *data)
+{
+    void *model1 = NULL, *model2 = NULL;
+    char *json1 = NULL, *json2 = NULL, *json3 = NULL;
+    int i;
+
+    for (i = 0; i < OGS_ARRAY_SIZE(json_model); i++) {
+        model1 = json_parse(i, json_model[i].json, false);
+        ABTS_PTR_NOTNULL(tc, model1);
+        model2 = json_parse(i, json_model[i].json, true);
+        ABTS_PTR_NOTNULL(tc, model2);
+
+        json1 = json_build(i, model1, false);
+        json2 = json_build(i, model2, true);
+        ABTS_STR_EQUAL(tc, json1, json2);
+
+        json_model[i].free(model2);
+        model2 = json_parse(i, json2, true);
+        ABTS_PTR_NOTNULL(tc, model2);
+        json3 = json_build(i, model2, true);
+        ABTS_STR_EQUAL(tc, json2, json3);
+
+        json_model[i].free(model1);
+        json_model[i].free(model2);
+        ogs_free(json1);
+        ogs_free(json2);
+        ogs_free(json3);
+    }
+}
+
 abts_suite *test_sbi_message(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -1035,6 +1202,7 @@ abts_suite *test_sbi_message(abts_suite *suite)
     abts_run_test(suite, sbi_message_test8, NULL);
     abts_run_test(suite, sbi_message_test9, NULL);
     abts_run_test(suite, sbi_message_test10, NULL);
+    abts_run_test(suite, sbi_message_test11, NULL);
 
     return suite;
 }